@@ -0,0 +1,788 @@
+//Parse time and peak memory of OcrResponseReader (the JsonPullReader version) on Google and Microsoft vision responses,
+//and a check that it pulls out exactly what the old cJSON code did.
+//
+//	bench_ocr_parse [--check] <fixtures dir>
+//
+//fixtures/*.json are small hand made responses in the real formats with the awkward bits in them (escapes, \u, a
+//missing x, a block's language coming after its paragraphs, a second page), and *.expected.txt is what the old cJSON
+//code read out of them, worked out separately with Python's json module.  The big ones are generated here with the same
+//layout, pretty printed and with all the parts we skip (textAnnotations, confidences, languages on every symbol) since
+//those are most of a real response.  The generator knows what it put in, so those get checked too.
+//
+//If Proton's cJSON was found (see CMakeLists.txt) the old cJSON walk is also run on everything, timed and compared.
+//--check skips the timing, for ctest.
+
+#include "PlatformPrecomp.h"
+#include "OcrResponseReader.h"
+#include <chrono>
+#include <functional>
+#include <new>
+#include <algorithm>
+
+#ifdef RT_BENCH_CJSON
+#include "util/cJSON.h"
+#endif
+
+extern bool g_bShimQuiet;
+
+//Every allocation goes through these so we can see how much memory a parse needed at its worst
+static size_t g_liveBytes = 0;
+static size_t g_peakBytes = 0;
+const size_t C_ALLOC_HEADER_SIZE = 16; //keeps what we hand out 16 byte aligned
+
+static void * TrackedMalloc(size_t size)
+{
+	byte *p = (byte*)malloc(size + C_ALLOC_HEADER_SIZE);
+	if (!p) return NULL;
+
+	*(size_t*)p = size;
+	g_liveBytes += size;
+	g_peakBytes = rt_max(g_peakBytes, g_liveBytes);
+	return p + C_ALLOC_HEADER_SIZE;
+}
+
+static void TrackedFree(void *pMem)
+{
+	if (!pMem) return;
+
+	byte *p = (byte*)pMem - C_ALLOC_HEADER_SIZE;
+	g_liveBytes -= *(size_t*)p;
+	free(p);
+}
+
+void * operator new(size_t size)
+{
+	void *p = TrackedMalloc(size);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void * operator new[](size_t size)
+{
+	void *p = TrackedMalloc(size);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept { TrackedFree(p); }
+void operator delete[](void *p) noexcept { TrackedFree(p); }
+void operator delete(void *p, size_t) noexcept { TrackedFree(p); }
+void operator delete[](void *p, size_t) noexcept { TrackedFree(p); }
+
+//One line per paragraph, word and symbol, so two parses can be compared as text and a difference is easy to read
+static void DumpParagraph(const OcrParagraph &paragraph, string *pOut)
+{
+	char buff[128];
+
+	auto dumpVerts = [&](const CL_Vec2f *pVerts, int count)
+	{
+		sprintf(buff, " %d verts:", count);
+		*pOut += buff;
+		for (int i = 0; i < count; i++)
+		{
+			sprintf(buff, " %.2f,%.2f", pVerts[i].x, pVerts[i].y);
+			*pOut += buff;
+		}
+	};
+
+	*pOut += "paragraph lang=" + paragraph.m_language + "\n";
+
+	for (auto &word : paragraph.m_words)
+	{
+		*pOut += "  word \"" + word.m_text + "\"";
+		dumpVerts(word.m_verts, word.m_vertCount);
+		*pOut += "\n";
+
+		for (auto &symbol : word.m_symbols)
+		{
+			*pOut += "    symbol \"" + symbol.m_text + "\"";
+			dumpVerts(symbol.m_verts, symbol.m_vertCount);
+			if (symbol.m_bHasBreak)
+			{
+				*pOut += " break=" + symbol.m_breakType;
+			}
+			*pOut += "\n";
+		}
+	}
+}
+
+typedef std::function<bool(const char*, const OcrParagraphCallback&)> OcrReadFunc;
+
+static bool DumpResponse(const OcrReadFunc &readFunc, const string &json, string *pDumpOut)
+{
+	pDumpOut->clear();
+	return readFunc(json.c_str(), [&](const OcrParagraph &paragraph) { DumpParagraph(paragraph, pDumpOut); });
+}
+
+#ifdef RT_BENCH_CJSON
+
+//The old BuildDatabaseGoogleVision/ProcessParagraphGoogleWay walk, minus what it then did with the results
+
+static int ReadVerticesCJSON(const cJSON *pVertices, CL_Vec2f *pVerts)
+{
+	int count = 0;
+	const cJSON *pVert;
+
+	cJSON_ArrayForEach(pVert, pVertices)
+	{
+		if (count >= 4) break;
+
+		cJSON *pX = cJSON_GetObjectItem(pVert, "x");
+		cJSON *pY = cJSON_GetObjectItem(pVert, "y");
+		pVerts[count++] = CL_Vec2f(pX ? (float)pX->valuedouble : 0, pY ? (float)pY->valuedouble : 0);
+	}
+	return count;
+}
+
+static bool ReadGoogleVisionResponseCJSON(const char *pJson, const OcrParagraphCallback &onParagraph)
+{
+	cJSON *root = cJSON_Parse(pJson);
+
+	cJSON *responses = cJSON_GetObjectItem(root, "responses");
+	if (cJSON_GetArraySize(responses) != 1)
+	{
+		cJSON_Delete(root);
+		return false;
+	}
+
+	cJSON *fullTextAnnotation = cJSON_GetObjectItem(cJSON_GetArrayItem(responses, 0), "fullTextAnnotation");
+	cJSON *pages = cJSON_GetObjectItem(fullTextAnnotation, "pages");
+	cJSON *blocks = cJSON_GetObjectItem(cJSON_GetArrayItem(pages, 0), "blocks");
+	const cJSON *block;
+
+	cJSON_ArrayForEach(block, blocks)
+	{
+		const cJSON *property = cJSON_GetObjectItemCaseSensitive(block, "property");
+		const cJSON *detectedLanguages = cJSON_GetObjectItemCaseSensitive(property, "detectedLanguages");
+		const cJSON *detectedLanguage;
+		string language;
+
+		cJSON_ArrayForEach(detectedLanguage, detectedLanguages)
+		{
+			language = cJSON_GetObjectItemCaseSensitive(detectedLanguage, "languageCode")->valuestring;
+			break;
+		}
+
+		const cJSON *paragraphs = cJSON_GetObjectItemCaseSensitive(block, "paragraphs");
+		const cJSON *paragraph;
+
+		cJSON_ArrayForEach(paragraph, paragraphs)
+		{
+			OcrParagraph out;
+			out.m_language = language;
+
+			const cJSON *words = cJSON_GetObjectItemCaseSensitive(paragraph, "words");
+			const cJSON *word;
+
+			cJSON_ArrayForEach(word, words)
+			{
+				out.m_words.push_back(OcrWord());
+				OcrWord &outWord = out.m_words.back();
+
+				const cJSON *boundingBox = cJSON_GetObjectItemCaseSensitive(word, "boundingBox");
+				outWord.m_vertCount = ReadVerticesCJSON(cJSON_GetObjectItemCaseSensitive(boundingBox, "vertices"), outWord.m_verts);
+
+				const cJSON *symbols = cJSON_GetObjectItemCaseSensitive(word, "symbols");
+				const cJSON *symbol;
+
+				cJSON_ArrayForEach(symbol, symbols)
+				{
+					outWord.m_symbols.push_back(OcrSymbol());
+					OcrSymbol &outSymbol = outWord.m_symbols.back();
+
+					outSymbol.m_text = cJSON_GetObjectItemCaseSensitive(symbol, "text")->valuestring;
+					const cJSON *boundingBox2 = cJSON_GetObjectItemCaseSensitive(symbol, "boundingBox");
+					outSymbol.m_vertCount = ReadVerticesCJSON(cJSON_GetObjectItemCaseSensitive(boundingBox2, "vertices"), outSymbol.m_verts);
+
+					const cJSON *symbolProperty = cJSON_GetObjectItemCaseSensitive(symbol, "property");
+					const cJSON *linebreak = cJSON_GetObjectItemCaseSensitive(symbolProperty, "detectedBreak");
+					if (linebreak)
+					{
+						outSymbol.m_bHasBreak = true;
+						const cJSON *detectedBreak = cJSON_GetObjectItemCaseSensitive(linebreak, "type");
+						if (detectedBreak) outSymbol.m_breakType = detectedBreak->valuestring;
+					}
+				}
+			}
+
+			onParagraph(out);
+		}
+	}
+
+	cJSON_Delete(root);
+	return true;
+}
+
+static bool ReadMicrosoftVisionResponseCJSON(const char *pJson, const OcrParagraphCallback &onLine)
+{
+	cJSON *root = cJSON_Parse(pJson);
+	if (!root) return false;
+
+	cJSON *readResult = cJSON_GetObjectItem(root, "readResult");
+	cJSON *blocks = cJSON_GetObjectItem(readResult, "blocks");
+	const cJSON *block;
+
+	cJSON_ArrayForEach(block, blocks)
+	{
+		const cJSON *lines = cJSON_GetObjectItemCaseSensitive(block, "lines");
+		const cJSON *line;
+
+		cJSON_ArrayForEach(line, lines)
+		{
+			OcrParagraph out;
+			out.m_language = "ja";
+
+			const cJSON *words = cJSON_GetObjectItemCaseSensitive(line, "words");
+			const cJSON *word;
+
+			cJSON_ArrayForEach(word, words)
+			{
+				out.m_words.push_back(OcrWord());
+				OcrWord &outWord = out.m_words.back();
+				outWord.m_text = cJSON_GetObjectItemCaseSensitive(word, "text")->valuestring;
+				outWord.m_vertCount = ReadVerticesCJSON(cJSON_GetObjectItemCaseSensitive(word, "boundingPolygon"), outWord.m_verts);
+			}
+
+			onLine(out);
+		}
+	}
+
+	cJSON_Delete(root);
+	return true;
+}
+
+#endif
+
+//Just enough of a pretty printer to make responses that look like the real ones, 2 space indents like Google's
+class JsonWriter
+{
+public:
+
+	void BeginObject() { Value("{"); m_bFirst.push_back(true); }
+	void EndObject() { Close("}"); }
+	void BeginArray() { Value("["); m_bFirst.push_back(true); }
+	void EndArray() { Close("]"); }
+	void Key(const char *pKey) { Separate(); m_text += "\"" + string(pKey) + "\": "; m_bAfterKey = true; }
+	void String(const string &escaped) { Value("\"" + escaped + "\""); }
+	void Number(double value) { char buff[32]; sprintf(buff, "%g", value); Value(buff); }
+
+	string m_text;
+
+protected:
+
+	void Separate()
+	{
+		if (!m_bFirst.empty())
+		{
+			m_text += m_bFirst.back() ? "\n" : ",\n";
+			m_bFirst.back() = false;
+		}
+		m_text.append(m_bFirst.size() * 2, ' ');
+	}
+
+	void Value(const string &text)
+	{
+		if (!m_bAfterKey) Separate();
+		m_bAfterKey = false;
+		m_text += text;
+	}
+
+	void Close(const char *pClose)
+	{
+		bool bEmpty = m_bFirst.back();
+		m_bFirst.pop_back();
+		if (!bEmpty)
+		{
+			m_text += "\n";
+			m_text.append(m_bFirst.size() * 2, ' ');
+		}
+		m_text += pClose;
+	}
+
+	vector<bool> m_bFirst;
+	bool m_bAfterKey = false;
+};
+
+//what goes in the JSON (escaped) and what the reader should give back
+struct GeneratedChar
+{
+	const char *m_pEscaped;
+	const char *m_pText;
+};
+
+static const GeneratedChar g_generatedChars[] =
+{
+	{ "\xe3\x81\x82", "\xe3\x81\x82" }, { "\xe6\x97\xa5", "\xe6\x97\xa5" }, { "\xe8\xaa\x9e", "\xe8\xaa\x9e" }, { "\xe3\x80\x82", "\xe3\x80\x82" },
+	{ "A", "A" }, { "b", "b" }, { "7", "7" }, { "\\\"", "\"" }, { "\\\\", "\\" }, { "\\u00e9", "\xc3\xa9" }, { "\\/", "/" }
+};
+
+static void WriteBox(JsonWriter &w, const char *pKey, const CL_Vec2f *pVerts, bool bWrapInVertices)
+{
+	w.Key(pKey);
+	if (bWrapInVertices)
+	{
+		w.BeginObject();
+		w.Key("vertices");
+	}
+
+	w.BeginArray();
+	for (int i = 0; i < 4; i++)
+	{
+		w.BeginObject();
+		//Google leaves out coordinates that are 0
+		if (pVerts[i].x != 0 || !bWrapInVertices) { w.Key("x"); w.Number(pVerts[i].x); }
+		if (pVerts[i].y != 0 || !bWrapInVertices) { w.Key("y"); w.Number(pVerts[i].y); }
+		w.EndObject();
+	}
+	w.EndArray();
+
+	if (bWrapInVertices) w.EndObject();
+}
+
+static void MakeBox(float x, float y, float width, float height, CL_Vec2f *pVerts)
+{
+	pVerts[0] = CL_Vec2f(x, y);
+	pVerts[1] = CL_Vec2f(x + width, y);
+	pVerts[2] = CL_Vec2f(x + width, y + height);
+	pVerts[3] = CL_Vec2f(x, y + height);
+}
+
+static void WriteLanguages(JsonWriter &w, const char *pLanguage)
+{
+	w.Key("detectedLanguages");
+	w.BeginArray();
+	w.BeginObject();
+	w.Key("languageCode");
+	w.String(pLanguage);
+	w.Key("confidence");
+	w.Number(1);
+	w.EndObject();
+	w.EndArray();
+}
+
+//A DOCUMENT_TEXT_DETECTION response for blockCount text blocks laid out down the screen
+static void MakeGoogleResponse(int blockCount, int paragraphsPerBlock, int wordsPerParagraph, string *pJsonOut, vector<OcrParagraph> *pExpectedOut)
+{
+	const int charCount = sizeof(g_generatedChars) / sizeof(g_generatedChars[0]);
+	const char *languages[] = { "ja", "en", "zh" };
+	uint32 seed = 1;
+	auto random = [&](int range) { seed = seed * 1103515245 + 12345; return (int)((seed >> 16) % range); };
+
+	JsonWriter w;
+	JsonWriter annotations; //textAnnotations, one per word, built alongside and written first
+	annotations.BeginArray();
+
+	pExpectedOut->clear();
+	JsonWriter pages;
+	pages.BeginArray();
+	pages.BeginObject();
+	pages.Key("property");
+	pages.BeginObject();
+	WriteLanguages(pages, "ja");
+	pages.EndObject();
+	pages.Key("width");
+	pages.Number(1920);
+	pages.Key("height");
+	pages.Number(1080);
+	pages.Key("blocks");
+	pages.BeginArray();
+
+	float y = 0;
+	for (int b = 0; b < blockCount; b++)
+	{
+		const char *pLanguage = languages[b % 3];
+		pages.BeginObject();
+
+		//sometimes the language comes after the paragraphs, the reader has to hold onto them until it knows
+		bool bPropertyLast = (b % 4) == 3;
+		if (!bPropertyLast)
+		{
+			pages.Key("property");
+			pages.BeginObject();
+			WriteLanguages(pages, pLanguage);
+			pages.EndObject();
+		}
+
+		CL_Vec2f verts[4];
+		MakeBox(0, y, 1000, 30.0f * paragraphsPerBlock, verts);
+		WriteBox(pages, "boundingBox", verts, true);
+
+		pages.Key("paragraphs");
+		pages.BeginArray();
+		for (int p = 0; p < paragraphsPerBlock; p++)
+		{
+			pExpectedOut->push_back(OcrParagraph());
+			OcrParagraph &expected = pExpectedOut->back();
+			expected.m_language = pLanguage;
+
+			pages.BeginObject();
+			pages.Key("property");
+			pages.BeginObject();
+			WriteLanguages(pages, pLanguage);
+			pages.EndObject();
+			MakeBox(0, y, 1000, 30, verts);
+			WriteBox(pages, "boundingBox", verts, true);
+
+			pages.Key("words");
+			pages.BeginArray();
+			float x = 0;
+			for (int wd = 0; wd < wordsPerParagraph; wd++)
+			{
+				int symbolCount = 1 + random(6);
+				expected.m_words.push_back(OcrWord());
+				OcrWord &expectedWord = expected.m_words.back();
+				expectedWord.m_vertCount = 4;
+				MakeBox(x, y, 12.0f * symbolCount, 24, expectedWord.m_verts);
+
+				pages.BeginObject();
+				pages.Key("property");
+				pages.BeginObject();
+				WriteLanguages(pages, pLanguage);
+				pages.EndObject();
+				WriteBox(pages, "boundingBox", expectedWord.m_verts, true);
+
+				string escapedWord;
+				pages.Key("symbols");
+				pages.BeginArray();
+				for (int s = 0; s < symbolCount; s++)
+				{
+					const GeneratedChar &c = g_generatedChars[random(charCount)];
+					expectedWord.m_symbols.push_back(OcrSymbol());
+					OcrSymbol &expectedSymbol = expectedWord.m_symbols.back();
+					expectedSymbol.m_text = c.m_pText;
+					expectedSymbol.m_vertCount = 4;
+					MakeBox(x, y, 12, 24, expectedSymbol.m_verts);
+					escapedWord += c.m_pEscaped;
+
+					pages.BeginObject();
+					pages.Key("property");
+					pages.BeginObject();
+					WriteLanguages(pages, pLanguage);
+					if (s == symbolCount - 1)
+					{
+						expectedSymbol.m_bHasBreak = true;
+						expectedSymbol.m_breakType = wd == wordsPerParagraph - 1 ? "LINE_BREAK" : "SPACE";
+						pages.Key("detectedBreak");
+						pages.BeginObject();
+						pages.Key("type");
+						pages.String(expectedSymbol.m_breakType);
+						pages.EndObject();
+					}
+					pages.EndObject();
+					WriteBox(pages, "boundingBox", expectedSymbol.m_verts, true);
+					pages.Key("text");
+					pages.String(c.m_pEscaped);
+					pages.Key("confidence");
+					pages.Number(0.99);
+					pages.EndObject();
+					x += 12;
+				}
+				pages.EndArray();
+				pages.Key("confidence");
+				pages.Number(0.98);
+				pages.EndObject();
+
+				annotations.BeginObject();
+				annotations.Key("description");
+				annotations.String(escapedWord);
+				WriteBox(annotations, "boundingPoly", expectedWord.m_verts, true);
+				annotations.EndObject();
+				x += 12;
+			}
+			pages.EndArray();
+			pages.Key("confidence");
+			pages.Number(0.97);
+			pages.EndObject();
+			y += 30;
+		}
+		pages.EndArray();
+
+		pages.Key("blockType");
+		pages.String("TEXT");
+		if (bPropertyLast)
+		{
+			pages.Key("property");
+			pages.BeginObject();
+			WriteLanguages(pages, pLanguage);
+			pages.EndObject();
+		}
+		pages.Key("confidence");
+		pages.Number(0.97);
+		pages.EndObject();
+	}
+	pages.EndArray();
+	pages.EndObject();
+	pages.EndArray();
+	annotations.EndArray();
+
+	//stitch it together, the sub writers were indented from 0 so they're a little flatter than Google's, doesn't matter
+	*pJsonOut = "{\n  \"responses\": [\n    {\n      \"textAnnotations\": " + annotations.m_text + ",\n      \"fullTextAnnotation\": {\n"
+		"        \"pages\": " + pages.m_text + ",\n        \"text\": \"(the whole text again)\"\n      }\n    }\n  ]\n}\n";
+}
+
+//An image analysis read result, lineCount lines of wordsPerLine words
+static void MakeMicrosoftResponse(int blockCount, int linesPerBlock, int wordsPerLine, string *pJsonOut, vector<OcrParagraph> *pExpectedOut)
+{
+	const int charCount = sizeof(g_generatedChars) / sizeof(g_generatedChars[0]);
+	uint32 seed = 2;
+	auto random = [&](int range) { seed = seed * 1103515245 + 12345; return (int)((seed >> 16) % range); };
+
+	JsonWriter w;
+	pExpectedOut->clear();
+
+	w.BeginObject();
+	w.Key("modelVersion");
+	w.String("2023-10-01");
+	w.Key("metadata");
+	w.BeginObject();
+	w.Key("width");
+	w.Number(1920);
+	w.Key("height");
+	w.Number(1080);
+	w.EndObject();
+	w.Key("readResult");
+	w.BeginObject();
+	w.Key("blocks");
+	w.BeginArray();
+
+	float y = 0;
+	for (int b = 0; b < blockCount; b++)
+	{
+		w.BeginObject();
+		w.Key("lines");
+		w.BeginArray();
+		for (int l = 0; l < linesPerBlock; l++)
+		{
+			pExpectedOut->push_back(OcrParagraph());
+			OcrParagraph &expected = pExpectedOut->back();
+			expected.m_language = "ja";
+
+			vector<string> escapedWords;
+			float x = 0;
+			for (int wd = 0; wd < wordsPerLine; wd++)
+			{
+				expected.m_words.push_back(OcrWord());
+				OcrWord &expectedWord = expected.m_words.back();
+				string escaped;
+				int chars = 1 + random(6);
+				for (int c = 0; c < chars; c++)
+				{
+					const GeneratedChar &gc = g_generatedChars[random(charCount)];
+					escaped += gc.m_pEscaped;
+					expectedWord.m_text += gc.m_pText;
+				}
+				escapedWords.push_back(escaped);
+				expectedWord.m_vertCount = 4;
+				MakeBox(x + 0.5f, y + 0.25f, 12.0f * chars, 24, expectedWord.m_verts);
+				x += 12.0f * (chars + 1);
+			}
+
+			CL_Vec2f lineVerts[4];
+			MakeBox(0, y, x, 24, lineVerts);
+
+			w.BeginObject();
+			w.Key("text");
+			string lineText;
+			for (auto &word : escapedWords) lineText += (lineText.empty() ? "" : " ") + word;
+			w.String(lineText);
+			WriteBox(w, "boundingPolygon", lineVerts, false);
+			w.Key("words");
+			w.BeginArray();
+			for (int wd = 0; wd < wordsPerLine; wd++)
+			{
+				w.BeginObject();
+				w.Key("text");
+				w.String(escapedWords[wd]);
+				WriteBox(w, "boundingPolygon", expected.m_words[wd].m_verts, false);
+				w.Key("confidence");
+				w.Number(0.95);
+				w.EndObject();
+			}
+			w.EndArray();
+			w.EndObject();
+			y += 30;
+		}
+		w.EndArray();
+		w.EndObject();
+	}
+
+	w.EndArray();
+	w.EndObject();
+	w.EndObject();
+	*pJsonOut = w.m_text + "\n";
+}
+
+static string LoadTextFile(const string &fileName)
+{
+	FILE *fp = fopen(fileName.c_str(), "rb");
+	if (!fp) return "";
+
+	string text;
+	char buff[4096];
+	size_t bytes;
+	while ((bytes = fread(buff, 1, sizeof(buff), fp)) > 0) text.append(buff, bytes);
+	fclose(fp);
+
+	//the fixtures have CRLF line endings like the rest of the repo, the dumps don't
+	text.erase(std::remove(text.begin(), text.end(), '\r'), text.end());
+	return text;
+}
+
+static int g_failures = 0;
+
+static void CheckDump(const char *pWhat, const string &dump, const string &expected)
+{
+	if (dump == expected) return;
+
+	size_t i = 0;
+	while (i < dump.size() && i < expected.size() && dump[i] == expected[i]) i++;
+	size_t lineStart = expected.rfind('\n', i == 0 ? 0 : i - 1);
+	lineStart = lineStart == string::npos ? 0 : lineStart + 1;
+
+	printf("FAILED %s, first difference at line %d:\n  got:      %s\n  expected: %s\n", pWhat, (int)std::count(expected.begin(),
+		expected.begin() + lineStart, '\n') + 1, dump.substr(lineStart, dump.find('\n', lineStart) - lineStart).c_str(),
+		expected.substr(lineStart, expected.find('\n', lineStart) - lineStart).c_str());
+	g_failures++;
+}
+
+struct ParseStats
+{
+	double m_ms = 0;
+	size_t m_peakBytes = 0;
+	int m_symbols = 0;
+};
+
+static ParseStats MeasureParse(const OcrReadFunc &readFunc, const string &json, int iterations)
+{
+	ParseStats stats;
+
+	//what the app keeps is up to the caller, so this only counts, the memory is what the parse itself needed
+	auto countSymbols = [&](const OcrParagraph &paragraph)
+	{
+		for (auto &word : paragraph.m_words) stats.m_symbols += word.m_symbols.empty() ? 1 : (int)word.m_symbols.size();
+	};
+
+	size_t startBytes = g_liveBytes;
+	g_peakBytes = g_liveBytes;
+	readFunc(json.c_str(), countSymbols);
+	stats.m_peakBytes = g_peakBytes - startBytes;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		readFunc(json.c_str(), [](const OcrParagraph &paragraph) {});
+	}
+	stats.m_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+	return stats;
+}
+
+struct TestResponse
+{
+	string m_name;
+	OcrReadFunc m_readNew;
+	OcrReadFunc m_readOld;
+	string m_json;
+	string m_expectedDump;
+	int m_iterations;
+};
+
+int main(int argc, char **argv)
+{
+	bool bCheckOnly = false;
+	string fixtureDir = "fixtures";
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--check") bCheckOnly = true; else fixtureDir = argv[i];
+	}
+
+	g_bShimQuiet = true;
+
+#ifdef RT_BENCH_CJSON
+	cJSON_Hooks hooks = { TrackedMalloc, TrackedFree };
+	cJSON_InitHooks(&hooks);
+	OcrReadFunc readGoogleOld = ReadGoogleVisionResponseCJSON;
+	OcrReadFunc readMicrosoftOld = ReadMicrosoftVisionResponseCJSON;
+#else
+	printf("Proton's cJSON wasn't found, so only checking against the expected results, not running the old parser\n");
+	OcrReadFunc readGoogleOld, readMicrosoftOld;
+#endif
+
+	vector<TestResponse> responses;
+	responses.push_back({ "google_small.json", ReadGoogleVisionResponse, readGoogleOld, LoadTextFile(fixtureDir + "/google_small.json"),
+		LoadTextFile(fixtureDir + "/google_small.expected.txt"), 2000 });
+	responses.push_back({ "microsoft_small.json", ReadMicrosoftVisionResponse, readMicrosoftOld, LoadTextFile(fixtureDir + "/microsoft_small.json"),
+		LoadTextFile(fixtureDir + "/microsoft_small.expected.txt"), 2000 });
+
+	if (responses[0].m_json.empty() || responses[1].m_json.empty() || responses[0].m_expectedDump.empty() || responses[1].m_expectedDump.empty())
+	{
+		printf("Can't find the fixtures in %s\n", fixtureDir.c_str());
+		return 1;
+	}
+
+	//a dialog box, and a whole busy 1080p desktop
+	struct Layout { const char *m_pName; int m_blocks, m_paragraphs, m_words, m_iterations; };
+	const Layout layouts[] = { { "dialog", 1, 3, 12, 500 }, { "desktop", 40, 4, 20, 10 } };
+
+	for (auto &layout : layouts)
+	{
+		vector<OcrParagraph> expected;
+		TestResponse google = { string("google_") + layout.m_pName, ReadGoogleVisionResponse, readGoogleOld, "", "", layout.m_iterations };
+		MakeGoogleResponse(layout.m_blocks, layout.m_paragraphs, layout.m_words, &google.m_json, &expected);
+		for (auto &paragraph : expected) DumpParagraph(paragraph, &google.m_expectedDump);
+		responses.push_back(google);
+
+		TestResponse microsoft = { string("microsoft_") + layout.m_pName, ReadMicrosoftVisionResponse, readMicrosoftOld, "", "", layout.m_iterations };
+		MakeMicrosoftResponse(layout.m_blocks, layout.m_paragraphs, layout.m_words, &microsoft.m_json, &expected);
+		for (auto &paragraph : expected) DumpParagraph(paragraph, &microsoft.m_expectedDump);
+		responses.push_back(microsoft);
+	}
+
+	for (auto &response : responses)
+	{
+		string dump;
+		if (!DumpResponse(response.m_readNew, response.m_json, &dump))
+		{
+			printf("FAILED %s, OcrResponseReader says it's broken\n", response.m_name.c_str());
+			g_failures++;
+		}
+		CheckDump((response.m_name + ", OcrResponseReader vs expected").c_str(), dump, response.m_expectedDump);
+
+		if (response.m_readOld)
+		{
+			string oldDump;
+			DumpResponse(response.m_readOld, response.m_json, &oldDump);
+			CheckDump((response.m_name + ", OcrResponseReader vs old cJSON").c_str(), dump, oldDump);
+		}
+	}
+
+	//broken JSON and more than one response are errors, like they were
+	if (ReadGoogleVisionResponse("{\"responses\": [{}, {}]}", [](const OcrParagraph &) {})
+		|| ReadGoogleVisionResponse(responses[0].m_json.substr(0, responses[0].m_json.size() / 2).c_str(), [](const OcrParagraph &) {}))
+	{
+		printf("FAILED, a bad Google response was accepted\n");
+		g_failures++;
+	}
+
+	if (!bCheckOnly)
+	{
+		printf("\n%-20s %9s %8s %12s %12s %12s %12s\n", "response", "json KB", "symbols", "pull ms", "pull peak KB", "cJSON ms", "cJSON peak KB");
+
+		for (auto &response : responses)
+		{
+			ParseStats pull = MeasureParse(response.m_readNew, response.m_json, response.m_iterations);
+			printf("%-20s %9.1f %8d %12.3f %12.1f", response.m_name.c_str(), response.m_json.size() / 1024.0f, pull.m_symbols, pull.m_ms,
+				pull.m_peakBytes / 1024.0f);
+
+			if (response.m_readOld)
+			{
+				ParseStats old = MeasureParse(response.m_readOld, response.m_json, response.m_iterations);
+				printf(" %12.3f %12.1f", old.m_ms, old.m_peakBytes / 1024.0f);
+			}
+			printf("\n");
+		}
+	}
+
+	printf(g_failures == 0 ? "\nOCR responses all parsed as expected\n" : "\n%d OCR parse checks FAILED\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
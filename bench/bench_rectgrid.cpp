@@ -0,0 +1,366 @@
+//Times RectGrid against just looking at every rect, the way word hit-testing and AutoGlueTextAreas() used to, and checks
+//both find exactly the same things.
+//
+//	bench_rectgrid [--check]
+//
+//The rects are laid out like OCR results: lines of words in paragraphs, in a few columns down the screen.  Three jobs:
+//	hit test  - which words are under a point, like OcrDocument::FindWordsAt()
+//	neighbors - which rects touch each rect, the O(n^2) all pairs case
+//	glue      - AutoGlueTextAreas()'s merge loop on whole lines, which also takes merged rects out of the grid with
+//	            Remove(), so afterwards the grid must only know about what's left
+//
+//--check only does the smallest and largest sizes once each, for ctest.
+
+#include "PlatformPrecomp.h"
+#include "RectGrid.h"
+#include <algorithm>
+#include <chrono>
+
+extern bool g_bShimQuiet;
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { printf("FAILED: "); printf(__VA_ARGS__); printf("\n"); g_failures++; }
+
+struct ScreenText
+{
+	vector<CL_Rectf> m_words;
+	vector<CL_Rectf> m_lines;
+	CL_Rectf m_bounds;
+};
+
+//About wordCount words, 1920 wide and as tall as it needs to be.  Four columns of paragraphs of 2 to 6 lines.
+static void MakeScreenText(int wordCount, ScreenText *pOut)
+{
+	uint32 seed = 1;
+	auto random = [&](int range) { seed = seed * 1103515245 + 12345; return (int)((seed >> 16) % range); };
+
+	const float columnWidth = 460;
+	const int columns = 4;
+	float columnY[columns] = { 0, 0, 0, 0 };
+
+	pOut->m_words.clear();
+	pOut->m_lines.clear();
+
+	while ((int)pOut->m_words.size() < wordCount)
+	{
+		int column = random(columns);
+		float lineHeight = (float)(16 + random(4) * 4);
+		float x0 = column * (columnWidth + 20) + random(40);
+		float y = columnY[column];
+		int lineCount = 2 + random(5);
+
+		for (int l = 0; l < lineCount; l++)
+		{
+			float x = x0;
+			float right = x0 + columnWidth - random(120);
+			int firstWord = (int)pOut->m_words.size();
+
+			while (true)
+			{
+				float width = lineHeight * (1 + random(6)) * 0.6f;
+				if (x + width > right) break;
+				pOut->m_words.push_back(CL_Rectf(x, y, x + width, y + lineHeight));
+				x += width + lineHeight * 0.4f;
+			}
+
+			if ((int)pOut->m_words.size() == firstWord) continue;
+			pOut->m_lines.push_back(CL_Rectf(x0, y, pOut->m_words.back().right, y + lineHeight));
+			y += lineHeight * 1.3f;
+		}
+
+		columnY[column] = y + lineHeight * 2; //gap between paragraphs, too big to glue across
+	}
+
+	pOut->m_bounds = pOut->m_words[0];
+	for (auto &rect : pOut->m_words) pOut->m_bounds.bounding_rect(rect);
+}
+
+static float WordCellSize(const vector<CL_Rectf> &rects)
+{
+	//same as OcrDocument::BuildWordIndex()
+	float totalHeight = 0;
+	for (auto &rect : rects) totalHeight += rect.get_height();
+	return rt_max(totalHeight / rects.size(), 8.0f) * 3;
+}
+
+static bool SameRect(const CL_Rectf &a, const CL_Rectf &b)
+{
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+//hit testing
+
+static void HitTestBrute(const vector<CL_Rectf> &rects, const vector<CL_Vec2f> &points, vector<vector<int> > *pHitsOut)
+{
+	pHitsOut->resize(points.size());
+	for (int p = 0; p < (int)points.size(); p++)
+	{
+		(*pHitsOut)[p].clear();
+		for (int i = 0; i < (int)rects.size(); i++)
+		{
+			if (rects[i].contains(points[p])) (*pHitsOut)[p].push_back(i);
+		}
+	}
+}
+
+static void HitTestGrid(const vector<CL_Rectf> &rects, const CL_Rectf &bounds, const vector<CL_Vec2f> &points, vector<vector<int> > *pHitsOut)
+{
+	RectGrid grid;
+	grid.Init(bounds, WordCellSize(rects));
+	for (int i = 0; i < (int)rects.size(); i++) grid.Add(i, rects[i]);
+
+	vector<int> candidates;
+	pHitsOut->resize(points.size());
+	for (int p = 0; p < (int)points.size(); p++)
+	{
+		grid.Query(points[p], &candidates);
+		(*pHitsOut)[p].clear();
+		for (int id : candidates)
+		{
+			if (rects[id].contains(points[p])) (*pHitsOut)[p].push_back(id);
+		}
+	}
+}
+
+//all pairs
+
+static CL_Rectf Grow(const CL_Rectf &rect, float amount)
+{
+	return CL_Rectf(rect.left - amount, rect.top - amount, rect.right + amount, rect.bottom + amount);
+}
+
+const float C_NEIGHBOR_DISTANCE = 8;
+
+static void NeighborsBrute(const vector<CL_Rectf> &rects, vector<vector<int> > *pOut)
+{
+	pOut->resize(rects.size());
+	for (int i = 0; i < (int)rects.size(); i++)
+	{
+		CL_Rectf search = Grow(rects[i], C_NEIGHBOR_DISTANCE);
+		(*pOut)[i].clear();
+		for (int j = 0; j < (int)rects.size(); j++)
+		{
+			if (j != i && search.is_overlapped(rects[j])) (*pOut)[i].push_back(j);
+		}
+	}
+}
+
+static void NeighborsGrid(const vector<CL_Rectf> &rects, const CL_Rectf &bounds, vector<vector<int> > *pOut)
+{
+	RectGrid grid;
+	grid.Init(bounds, WordCellSize(rects));
+	for (int i = 0; i < (int)rects.size(); i++) grid.Add(i, rects[i]);
+
+	vector<int> candidates;
+	pOut->resize(rects.size());
+	for (int i = 0; i < (int)rects.size(); i++)
+	{
+		CL_Rectf search = Grow(rects[i], C_NEIGHBOR_DISTANCE);
+		grid.Query(search, &candidates);
+		(*pOut)[i].clear();
+		for (int id : candidates)
+		{
+			if (id != i && search.is_overlapped(rects[id])) (*pOut)[i].push_back(id);
+		}
+	}
+}
+
+//AutoGlueTextAreas() without the TextAreas: glue on whatever line starts just under the bottom and overlaps sideways,
+//the closest one if there's more than one
+
+const float C_GLUE_CELL_SIZE = 128; //C_AUTO_GLUE_GRID_CELL_SIZE
+const float C_GLUE_VERTICAL_TOLERANCE = 0.5f;
+
+static bool CanGlue(const CL_Rectf &upper, const CL_Rectf &lower)
+{
+	return fabs(lower.top - upper.bottom) < lower.get_height() * C_GLUE_VERTICAL_TOLERANCE && lower.left < upper.right && lower.right > upper.left;
+}
+
+static vector<int> TopDownOrder(const vector<CL_Rectf> &rects)
+{
+	vector<int> order(rects.size());
+	for (int i = 0; i < (int)rects.size(); i++) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return rects[a].top < rects[b].top; });
+	return order;
+}
+
+static void GlueBrute(vector<CL_Rectf> &rects, vector<bool> *pGluedOut)
+{
+	vector<bool> &glued = *pGluedOut;
+	glued.assign(rects.size(), false);
+
+	for (int upper : TopDownOrder(rects))
+	{
+		if (glued[upper]) continue;
+
+		while (true)
+		{
+			int best = -1;
+			for (int lower = 0; lower < (int)rects.size(); lower++)
+			{
+				if (lower == upper || glued[lower] || !CanGlue(rects[upper], rects[lower])) continue;
+				if (best == -1 || fabs(rects[lower].top - rects[upper].bottom) < fabs(rects[best].top - rects[upper].bottom)) best = lower;
+			}
+
+			if (best == -1) break;
+			rects[upper].bounding_rect(rects[best]);
+			glued[best] = true;
+		}
+	}
+}
+
+static void GlueGrid(vector<CL_Rectf> &rects, const CL_Rectf &bounds, vector<bool> *pGluedOut, RectGrid *pGridOut)
+{
+	vector<bool> &glued = *pGluedOut;
+	glued.assign(rects.size(), false);
+
+	float maxLineHeight = 0;
+	for (auto &rect : rects) maxLineHeight = rt_max(maxLineHeight, rect.get_height());
+	float reach = maxLineHeight * C_GLUE_VERTICAL_TOLERANCE;
+
+	RectGrid &grid = *pGridOut;
+	grid.Init(bounds, C_GLUE_CELL_SIZE);
+	for (int i = 0; i < (int)rects.size(); i++) grid.Add(i, rects[i]);
+
+	vector<int> candidates;
+
+	for (int upper : TopDownOrder(rects))
+	{
+		if (glued[upper]) continue;
+
+		while (true)
+		{
+			CL_Rectf search(rects[upper].left, rects[upper].bottom - reach, rects[upper].right, rects[upper].bottom + reach);
+			grid.Query(search, &candidates);
+
+			int best = -1;
+			for (int lower : candidates)
+			{
+				if (lower == upper || !CanGlue(rects[upper], rects[lower])) continue;
+				if (best == -1 || fabs(rects[lower].top - rects[upper].bottom) < fabs(rects[best].top - rects[upper].bottom)) best = lower;
+			}
+
+			if (best == -1) break;
+
+			grid.Remove(best, rects[best]);
+			grid.Remove(upper, rects[upper]);
+			rects[upper].bounding_rect(rects[best]);
+			glued[best] = true;
+			grid.Add(upper, rects[upper]);
+		}
+	}
+}
+
+template <typename Func>
+static double TimeMs(int iterations, Func func)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) func();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static void RunSize(int wordCount, bool bCheckOnly)
+{
+	ScreenText text;
+	MakeScreenText(wordCount, &text);
+	const vector<CL_Rectf> &words = text.m_words;
+
+	uint32 seed = 7;
+	auto random = [&](int range) { seed = seed * 1103515245 + 12345; return (int)((seed >> 16) % range); };
+	vector<CL_Vec2f> points(1000);
+	for (auto &pt : points)
+	{
+		pt = CL_Vec2f((float)random((int)text.m_bounds.right), (float)random((int)text.m_bounds.bottom));
+	}
+
+	vector<vector<int> > bruteResult, gridResult;
+
+	HitTestBrute(words, points, &bruteResult);
+	HitTestGrid(words, text.m_bounds, points, &gridResult);
+	int hits = 0;
+	for (auto &hit : bruteResult) hits += (int)hit.size();
+	CHECK(bruteResult == gridResult, "%d words: hit testing found different words", (int)words.size());
+	CHECK(hits > 0, "%d words: the points didn't hit anything, not much of a test", (int)words.size());
+
+	NeighborsBrute(words, &bruteResult);
+	NeighborsGrid(words, text.m_bounds, &gridResult);
+	CHECK(bruteResult == gridResult, "%d words: neighbors differ", (int)words.size());
+
+	vector<CL_Rectf> bruteLines = text.m_lines, gridLines = text.m_lines;
+	vector<bool> bruteGlued, gridGlued;
+	RectGrid grid;
+	GlueBrute(bruteLines, &bruteGlued);
+	GlueGrid(gridLines, text.m_bounds, &gridGlued, &grid);
+
+	int remaining = 0;
+	bool bSame = bruteGlued == gridGlued;
+	for (int i = 0; i < (int)bruteLines.size() && bSame; i++)
+	{
+		if (!bruteGlued[i]) bSame = SameRect(bruteLines[i], gridLines[i]);
+		if (!gridGlued[i]) remaining++;
+	}
+	CHECK(bSame, "%d lines: gluing came out different", (int)text.m_lines.size());
+	CHECK(remaining < (int)text.m_lines.size(), "%d lines: nothing was glued, not much of a test", (int)text.m_lines.size());
+
+	//merged away lines must be gone from every cell, and what's left has to be findable by its whole new rect
+	vector<int> everything;
+	grid.Query(Grow(text.m_bounds, 1), &everything);
+	CHECK((int)everything.size() == remaining, "%d lines: the grid still has %d ids after gluing, should be %d", (int)text.m_lines.size(),
+		(int)everything.size(), remaining);
+	for (int id : everything)
+	{
+		CHECK(!gridGlued[id], "line %d was glued onto another but is still in the grid", id);
+	}
+	for (int i = 0; i < (int)gridLines.size(); i++)
+	{
+		if (gridGlued[i]) continue;
+		vector<int> found;
+		grid.Query(CL_Vec2f(gridLines[i].left, gridLines[i].bottom - 1), &found);
+		CHECK(std::find(found.begin(), found.end(), i) != found.end(), "glued line %d can't be found at its bottom left corner", i);
+	}
+
+	if (bCheckOnly) return;
+
+	int iterations = rt_max(1, 20000 / wordCount);
+	vector<CL_Rectf> scratch;
+
+	printf("%6d words %5d lines | hit test %9.3f %8.3f | neighbors %9.3f %8.3f | glue %9.3f %8.3f\n", (int)words.size(), (int)text.m_lines.size(),
+		TimeMs(iterations, [&]() { HitTestBrute(words, points, &bruteResult); }),
+		TimeMs(iterations, [&]() { HitTestGrid(words, text.m_bounds, points, &gridResult); }),
+		TimeMs(iterations, [&]() { NeighborsBrute(words, &bruteResult); }),
+		TimeMs(iterations, [&]() { NeighborsGrid(words, text.m_bounds, &gridResult); }),
+		TimeMs(iterations, [&]() { scratch = text.m_lines; GlueBrute(scratch, &bruteGlued); }),
+		TimeMs(iterations, [&]() { scratch = text.m_lines; GlueGrid(scratch, text.m_bounds, &gridGlued, &grid); }));
+}
+
+int main(int argc, char **argv)
+{
+	bool bCheckOnly = argc > 1 && string(argv[1]) == "--check";
+	g_bShimQuiet = true;
+
+	//Remove() on its own: an id is gone from every cell it was in, and nothing else goes with it
+	RectGrid grid;
+	grid.Init(CL_Rectf(0, 0, 1000, 1000), 100);
+	grid.Add(1, CL_Rectf(50, 50, 450, 120));
+	grid.Add(2, CL_Rectf(300, 60, 320, 80));
+	grid.Remove(1, CL_Rectf(50, 50, 450, 120));
+	vector<int> found;
+	grid.Query(CL_Rectf(0, 0, 1000, 1000), &found);
+	CHECK(found == vector<int>({ 2 }), "Remove() left %d ids behind", (int)found.size());
+
+	if (!bCheckOnly)
+	{
+		printf("ms per run, brute force then RectGrid (hit test is 1000 points, glue works on whole lines)\n");
+	}
+
+	const int sizes[] = { 250, 1000, 4000, 16000 };
+	for (int size : sizes)
+	{
+		if (bCheckOnly && size != sizes[0] && size != sizes[3]) continue;
+		RunSize(size, bCheckOnly);
+	}
+
+	printf(g_failures == 0 ? "RectGrid matched brute force\n" : "%d RectGrid checks FAILED\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
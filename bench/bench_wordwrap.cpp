@@ -0,0 +1,196 @@
+//Times FreeTypeManager's word wrapping (MeasureTextAndAddByLinesIntoDeque) on 2k to 5k character strings against the
+//way GetNextLine used to do it, re-measuring the whole line with MeasureText for every char added.  It also checks that
+//both give exactly the same lines and width, and fails if they don't.
+//
+//	bench_wordwrap [--check] [font.ttf]
+//
+//--check only does one pass of each, for ctest.  The font defaults to DejaVuSans.
+
+#include "PlatformPrecomp.h"
+#include "FreeTypeManager.h"
+#include <chrono>
+#include <functional>
+
+extern bool g_bShimQuiet;
+
+//GetNextLine as it was before it kept a running pen position, only the wrapping logic, using the public MeasureText
+static wstring GetNextLineOld(FreeTypeManager *pFont, const CL_Vec2f &textBounds, WCHAR **pCur, float pixelHeight, CL_Vec2f &vEnclosingSizeOut,
+	bool bUseActualWidthForSpacing)
+{
+	if ((*pCur)[0] == '\n')
+	{
+		(*pCur) += 1;
+		return L"";
+	}
+
+	rtRectf r(0, 0, 0, 0);
+	wstring text;
+	int lastWrapPoint = 0;
+
+	while (1)
+	{
+		if ((*pCur)[text.length()] == 0)
+		{
+			(*pCur) += text.length();
+			return text;
+		}
+
+		if ((*pCur)[text.length()] == '\n')
+		{
+			(*pCur) += text.length() + 1;
+			return text;
+		}
+
+		text += (*pCur)[text.length()];
+
+		if ((*pCur)[text.length()] == '`')
+		{
+			text += (*pCur)[text.length()];
+			continue;
+		}
+
+		pFont->MeasureText(&r, (*pCur), (int)text.length(), pixelHeight, bUseActualWidthForSpacing);
+
+		if (r.GetWidth() > textBounds.x)
+		{
+			if (lastWrapPoint != 0)
+			{
+				text.erase(lastWrapPoint, text.length() - lastWrapPoint);
+				(*pCur) += 1;
+			}
+
+			(*pCur) += text.length();
+			return text;
+		}
+
+		if (vEnclosingSizeOut.x < r.GetWidth()) vEnclosingSizeOut.x = r.GetWidth();
+
+		if ((*pCur)[text.length()] == ' ')
+		{
+			lastWrapPoint = (int)text.length();
+		}
+	}
+}
+
+static void WrapOld(FreeTypeManager *pFont, const CL_Vec2f &textBounds, const wstring &text, deque<wstring> *pLines, float pixelHeight,
+	CL_Vec2f &vEnclosingSizeOut)
+{
+	vEnclosingSizeOut = CL_Vec2f(0, 0);
+	WCHAR *pCur = (WCHAR*)&text[0];
+	while (pCur[0])
+	{
+		pLines->push_back(GetNextLineOld(pFont, textBounds, &pCur, pixelHeight, vEnclosingSizeOut, false));
+	}
+}
+
+//Made up dialog, words of a few different lengths with the odd hard line break, like a long visual novel text box
+static wstring MakeText(size_t length, bool bSpaces)
+{
+	static const wchar_t *words[] = { L"the", L"lantern", L"flickered", L"as", L"Mirei", L"stepped", L"into", L"an", L"abandoned",
+		L"shrine,", L"whispering", L"something", L"nobody", L"else", L"could", L"hear.", L"\"Wait!\"", L"I", L"called", L"after", L"her." };
+	const int wordCount = sizeof(words) / sizeof(words[0]);
+
+	wstring text;
+	uint32 seed = 12345;
+	while (text.length() < length)
+	{
+		seed = seed * 1103515245 + 12345;
+		text += words[(seed >> 16) % wordCount];
+		if (((seed >> 8) & 63) == 0)
+		{
+			text += L'\n';
+		}
+		else if (bSpaces)
+		{
+			text += L' ';
+		}
+	}
+	text.resize(length);
+	return text;
+}
+
+static double TimeMS(const std::function<void()> &func, int iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		func();
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+	bool bCheckOnly = false;
+	string fontName = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--check") bCheckOnly = true; else fontName = argv[i];
+	}
+
+	g_bShimQuiet = true;
+	FreeTypeManager font;
+	font.SetFontName(fontName);
+	if (!font.Init())
+	{
+		printf("Unable to load %s\n", fontName.c_str());
+		return 1;
+	}
+
+	const size_t lengths[] = { 2000, 3500, 5000 };
+	//text box width and pixel height.  1600 is about the widest box you'd see on a 1080p screen
+	const CL_Vec2f layouts[] = { CL_Vec2f(600, 16), CL_Vec2f(600, 32), CL_Vec2f(1600, 16), CL_Vec2f(1600, 32) };
+	bool bAllMatched = true;
+
+	printf("%-6s %-7s %-6s %-4s %6s %10s %10s %8s\n", "chars", "spaces", "width", "px", "lines", "old ms", "new ms", "speedup");
+
+	for (size_t length : lengths)
+	{
+		for (int spaces = 1; spaces >= 0; spaces--)
+		{
+			for (const CL_Vec2f &layout : layouts)
+			{
+				float width = layout.x;
+				float pixelHeight = layout.y;
+				CL_Vec2f bounds(width, 10000);
+				wstring text = MakeText(length, spaces != 0);
+				deque<wstring> newLines, oldLines;
+				CL_Vec2f newSize, oldSize;
+
+				//also warms up the glyph cache, so both sides are timed with it full
+				font.MeasureTextAndAddByLinesIntoDeque(bounds, text, &newLines, pixelHeight, newSize, false);
+				WrapOld(&font, bounds, text, &oldLines, pixelHeight, oldSize);
+
+				if (newLines != oldLines || newSize.x != oldSize.x)
+				{
+					printf("MISMATCH at %d chars, %.0f wide, %.0fpx: %d lines (width %.0f) vs %d lines (width %.0f) the old way\n", (int)length, width, pixelHeight,
+						(int)newLines.size(), newSize.x, (int)oldLines.size(), oldSize.x);
+					bAllMatched = false;
+				}
+
+				if (bCheckOnly) continue;
+
+				double oldMS = TimeMS([&]()
+				{
+					deque<wstring> lines;
+					CL_Vec2f size;
+					WrapOld(&font, bounds, text, &lines, pixelHeight, size);
+				}, 10);
+
+				double newMS = TimeMS([&]()
+				{
+					deque<wstring> lines;
+					CL_Vec2f size;
+					font.MeasureTextAndAddByLinesIntoDeque(bounds, text, &lines, pixelHeight, size, false);
+				}, 50);
+
+				printf("%-6d %-7s %-6.0f %-4.0f %6d %10.3f %10.3f %7.0fx\n", (int)length, spaces ? "yes" : "none", width, pixelHeight, (int)newLines.size(),
+					oldMS, newMS, oldMS / newMS);
+			}
+		}
+	}
+
+	printf(bAllMatched ? "Line breaks match the old word wrap\n" : "Line breaks DON'T match the old word wrap\n");
+	return bAllMatched ? 0 : 1;
+}
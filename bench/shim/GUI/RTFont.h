@@ -0,0 +1,13 @@
+//Only the FontState struct FreeTypeManager uses for its font change codes
+
+#ifndef RTFont_h__
+#define RTFont_h__
+
+class FontState
+{
+public:
+	WCHAR m_triggerChar = 0;
+	glColorBytes m_color;
+};
+
+#endif // RTFont_h__
@@ -0,0 +1,3 @@
+//JPGMemoryEncoder includes Proton's copy of libjpeg by this path, the system one is the same API
+#include <stdio.h>
+#include <jpeglib.h>
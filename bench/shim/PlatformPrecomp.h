@@ -0,0 +1,126 @@
+//Just enough of Proton's PlatformPrecomp.h for the platform independent parts of UGT (the worker pool, pixel conversion,
+//jpg encoding, OCR parsing, FreeType layout) to build on Linux, so the benchmarks and tests in bench/ can run without
+//Windows or the SDK.  Only what those sources use is here, add to it if a new one needs more.
+
+#ifndef PlatformPrecomp_h__
+#define PlatformPrecomp_h__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <list>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+typedef unsigned char byte;
+typedef uint32_t uint32;
+typedef int32_t int32;
+typedef uint16_t uint16;
+typedef wchar_t WCHAR; //32 bits here instead of 16, FreeTypeManager doesn't care
+
+#define rt_max(a, b) ((a) > (b) ? (a) : (b))
+#define rt_min(a, b) ((a) < (b) ? (a) : (b))
+#define SAFE_DELETE(p) { delete (p); (p) = NULL; }
+#define SAFE_DELETE_ARRAY(p) { delete [] (p); (p) = NULL; }
+
+void LogMsg(const char *pFormat, ...);
+void LogError(const char *pFormat, ...);
+
+class CL_Vec2f
+{
+public:
+	CL_Vec2f() {}
+	CL_Vec2f(float x, float y) : x(x), y(y) {}
+
+	CL_Vec2f operator+(const CL_Vec2f &v) const { return CL_Vec2f(x + v.x, y + v.y); }
+	CL_Vec2f operator-(const CL_Vec2f &v) const { return CL_Vec2f(x - v.x, y - v.y); }
+	CL_Vec2f operator*(float f) const { return CL_Vec2f(x * f, y * f); }
+
+	float x = 0;
+	float y = 0;
+};
+
+class CL_Rectf
+{
+public:
+	CL_Rectf() {}
+	CL_Rectf(float left, float top, float right, float bottom) : left(left), top(top), right(right), bottom(bottom) {}
+
+	float get_width() const { return right - left; }
+	float get_height() const { return bottom - top; }
+	CL_Vec2f get_top_left() const { return CL_Vec2f(left, top); }
+	CL_Vec2f get_center() const { return CL_Vec2f((left + right) / 2, (top + bottom) / 2); }
+
+	bool contains(const CL_Vec2f &p) const { return p.x >= left && p.x < right && p.y >= top && p.y < bottom; }
+	bool is_overlapped(const CL_Rectf &r) const { return r.left < right && r.right > left && r.top < bottom && r.bottom > top; }
+
+	CL_Rectf &bounding_rect(const CL_Rectf &r)
+	{
+		left = rt_min(left, r.left);
+		top = rt_min(top, r.top);
+		right = rt_max(right, r.right);
+		bottom = rt_max(bottom, r.bottom);
+		return *this;
+	}
+
+	float left = 0;
+	float top = 0;
+	float right = 0;
+	float bottom = 0;
+};
+
+class CL_Rect
+{
+public:
+	CL_Rect() {}
+	CL_Rect(int left, int top, int right, int bottom) : left(left), top(top), right(right), bottom(bottom) {}
+
+	int get_width() const { return right - left; }
+	int get_height() const { return bottom - top; }
+
+	int left = 0;
+	int top = 0;
+	int right = 0;
+	int bottom = 0;
+};
+
+class rtRectf
+{
+public:
+	rtRectf() {}
+	rtRectf(float left, float top, float right, float bottom) : left(left), top(top), right(right), bottom(bottom) {}
+
+	float GetWidth() const { return right - left; }
+	float GetHeight() const { return bottom - top; }
+
+	float left = 0;
+	float top = 0;
+	float right = 0;
+	float bottom = 0;
+};
+
+class glColorBytes
+{
+public:
+	glColorBytes() {}
+	glColorBytes(byte r, byte g, byte b, byte a) : r(r), g(g), b(b), a(a) {}
+
+	byte r = 0;
+	byte g = 0;
+	byte b = 0;
+	byte a = 0;
+};
+
+#include "util/MiscUtils.h"
+#include "Renderer/SoftSurface.h"
+
+#endif // PlatformPrecomp_h__
@@ -0,0 +1,139 @@
+#include "PlatformPrecomp.h"
+#include <cstdarg>
+#include <mutex>
+#include <png.h>
+
+static std::mutex g_logMutex;
+bool g_bShimQuiet = false; //the benchmarks turn this on so the numbers aren't buried
+
+void LogMsg(const char *pFormat, ...)
+{
+	if (g_bShimQuiet) return;
+
+	std::lock_guard<std::mutex> lock(g_logMutex);
+	va_list args;
+	va_start(args, pFormat);
+	vprintf(pFormat, args);
+	va_end(args);
+	printf("\n");
+}
+
+void LogError(const char *pFormat, ...)
+{
+	std::lock_guard<std::mutex> lock(g_logMutex);
+	va_list args;
+	va_start(args, pFormat);
+	fprintf(stderr, "ERROR: ");
+	vfprintf(stderr, pFormat, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+}
+
+string toString(int value)
+{
+	return std::to_string(value);
+}
+
+string toString(uint32 value)
+{
+	return std::to_string(value);
+}
+
+string toString(float value)
+{
+	char buff[64];
+	sprintf(buff, "%.3f", value);
+	return buff;
+}
+
+string ToLowerCaseString(const string &s)
+{
+	string out = s;
+	for (size_t i = 0; i < out.length(); i++)
+	{
+		out[i] = (char)tolower((byte)out[i]);
+	}
+	return out;
+}
+
+string GetFileNameFromString(const string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+bool FileExists(const string &fileName)
+{
+	FILE *fp = fopen(fileName.c_str(), "rb");
+	if (!fp) return false;
+	fclose(fp);
+	return true;
+}
+
+bool SoftSurface::Init(int sizeX, int sizeY, eSurfaceType type, bool bRememberOriginalData)
+{
+	if (type != SURFACE_RGB && type != SURFACE_RGBA) return false;
+
+	m_type = type;
+	m_width = sizeX;
+	m_height = sizeY;
+	m_pitch = sizeX * GetBytesPerPixel();
+	m_pixels.resize((size_t)m_pitch * m_height);
+	return true;
+}
+
+void SoftSurface::Kill()
+{
+	m_pixels.clear();
+	m_pixels.shrink_to_fit();
+	m_width = m_height = m_pitch = 0;
+	m_type = SURFACE_NONE;
+}
+
+void SoftSurface::FillColor(glColorBytes color)
+{
+	int bpp = GetBytesPerPixel();
+	const byte rgba[4] = { color.r, color.g, color.b, color.a };
+
+	for (size_t i = 0; i < m_pixels.size(); i += bpp)
+	{
+		memcpy(&m_pixels[i], rgba, bpp);
+	}
+}
+
+void SoftSurface::FlipY()
+{
+	vector<byte> row(m_pitch);
+	for (int y = 0; y < m_height / 2; y++)
+	{
+		byte *pTop = &m_pixels[(size_t)y * m_pitch];
+		byte *pBottom = &m_pixels[(size_t)(m_height - 1 - y) * m_pitch];
+		memcpy(&row[0], pTop, m_pitch);
+		memcpy(pTop, pBottom, m_pitch);
+		memcpy(pBottom, &row[0], m_pitch);
+	}
+}
+
+bool SoftSurface::LoadFile(string fileName, eColorKeyType colorKey, bool bAddBasePath)
+{
+	png_image image;
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (!png_image_begin_read_from_file(&image, fileName.c_str()))
+	{
+		return false;
+	}
+
+	bool bAlpha = (image.format & PNG_FORMAT_FLAG_ALPHA) != 0;
+	image.format = bAlpha ? PNG_FORMAT_RGBA : PNG_FORMAT_RGB;
+	Init(image.width, image.height, bAlpha ? SURFACE_RGBA : SURFACE_RGB);
+
+	if (!png_image_finish_read(&image, NULL, GetPixelData(), m_pitch, NULL))
+	{
+		png_image_free(&image);
+		Kill();
+		return false;
+	}
+	return true;
+}
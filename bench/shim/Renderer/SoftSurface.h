@@ -0,0 +1,55 @@
+//The parts of Proton's SoftSurface the portable sources use, backed by a plain vector.  LoadFile only does PNG (via
+//libpng), which is all the test frames are.  Rows are stored top first, like Proton does for PNGs.
+
+#ifndef SoftSurface_h__
+#define SoftSurface_h__
+
+class SoftSurface
+{
+public:
+
+	enum eSurfaceType
+	{
+		SURFACE_NONE,
+		SURFACE_PALETTE_8BIT,
+		SURFACE_RGBA,
+		SURFACE_RGB
+	};
+
+	enum eColorKeyType
+	{
+		COLOR_KEY_NONE
+	};
+
+	bool Init(int sizeX, int sizeY, eSurfaceType type, bool bRememberOriginalData = false);
+	bool LoadFile(string fileName, eColorKeyType colorKey = COLOR_KEY_NONE, bool bAddBasePath = true);
+	void Kill();
+
+	bool IsActive() { return m_type != SURFACE_NONE; }
+	byte * GetPixelData() { return m_pixels.empty() ? NULL : &m_pixels[0]; }
+	int GetWidth() { return m_width; }
+	int GetHeight() { return m_height; }
+	int GetPitch() { return m_pitch; }
+	int GetBytesPerPixel() { return m_type == SURFACE_RGBA ? 4 : (m_type == SURFACE_RGB ? 3 : 1); }
+	eSurfaceType GetSurfaceType() { return m_type; }
+
+	void FillColor(glColorBytes color);
+	void FlipY();
+
+protected:
+
+	vector<byte> m_pixels;
+	int m_width = 0;
+	int m_height = 0;
+	int m_pitch = 0;
+	eSurfaceType m_type = SURFACE_NONE;
+};
+
+//FreeTypeManager::TextToSurface makes one of these, nothing in bench/ calls it
+class Surface
+{
+public:
+	void InitFromSoftSurface(SoftSurface *pSurf, bool bCreateSurface = true, int mipMaps = 0) {}
+};
+
+#endif // SoftSurface_h__
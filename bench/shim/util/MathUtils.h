@@ -0,0 +1 @@
+//Proton's version has a lot more, nothing in bench/ needs it
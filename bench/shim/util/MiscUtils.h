@@ -0,0 +1,13 @@
+//The few Proton string and file helpers the portable sources use
+
+#ifndef MiscUtils_h__
+#define MiscUtils_h__
+
+string toString(int value);
+string toString(uint32 value);
+string toString(float value);
+string ToLowerCaseString(const string &s);
+string GetFileNameFromString(const string &path);
+bool FileExists(const string &fileName);
+
+#endif // MiscUtils_h__
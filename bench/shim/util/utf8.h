@@ -0,0 +1,36 @@
+//Stands in for the utf8 library Proton ships with, just the one conversion FreeTypeManager does
+
+#ifndef utf8_h__
+#define utf8_h__
+
+namespace utf8
+{
+	template <typename octet_iterator, typename u16bit_iterator>
+	u16bit_iterator utf8to16(octet_iterator start, octet_iterator end, u16bit_iterator result)
+	{
+		while (start != end)
+		{
+			uint32 c = (byte)*start++;
+			int extra = c >= 0xF0 ? 3 : (c >= 0xE0 ? 2 : (c >= 0xC0 ? 1 : 0));
+			c &= 0x3F >> extra;
+			for (int i = 0; i < extra && start != end; i++)
+			{
+				c = (c << 6) | ((byte)*start++ & 0x3F);
+			}
+
+			if (c > 0xFFFF)
+			{
+				c -= 0x10000;
+				*result++ = (uint16)(0xD800 + (c >> 10));
+				*result++ = (uint16)(0xDC00 + (c & 0x3FF));
+			}
+			else
+			{
+				*result++ = (uint16)c;
+			}
+		}
+		return result;
+	}
+}
+
+#endif // utf8_h__
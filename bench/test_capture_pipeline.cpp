@@ -0,0 +1,274 @@
+//Feeds the recorded frames in webmedia/ through the capture side of a scan the way GameLogicComponent does it:
+//FileCaptureSource -> the scan's pooled RGB copy (bottom up, like a desktop DIB) -> FrameChangeDetector/FindChangedRect
+//-> the encode stage's crop -> JPGMemoryEncoder, then decodes the jpg and checks it against the original pixels.
+//
+//	test_capture_pipeline <dir with the png frames>
+
+#include "PlatformPrecomp.h"
+#include "CaptureSource.h"
+#include "FrameChangeDetector.h"
+#include "SoftSurfacePool.h"
+#include "JPGMemoryEncoder.h"
+
+extern "C"
+{
+#include <jpeglib.h>
+}
+
+extern bool g_bShimQuiet;
+
+static int g_failures = 0;
+
+#define CHECK(expr) { if (!(expr)) { printf("FAILED line %d: %s\n", __LINE__, #expr); g_failures++; } }
+
+//Top row first, RGB
+static bool DecodeJPG(const vector<byte> &jpg, vector<byte> *pPixelsOut, int *pWidthOut, int *pHeightOut)
+{
+	if (jpg.empty()) return false;
+
+	jpeg_decompress_struct cinfo;
+	jpeg_error_mgr jerr;
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, (unsigned char*)&jpg[0], (unsigned long)jpg.size());
+	jpeg_read_header(&cinfo, TRUE);
+	cinfo.out_color_space = JCS_RGB;
+	jpeg_start_decompress(&cinfo);
+
+	*pWidthOut = cinfo.output_width;
+	*pHeightOut = cinfo.output_height;
+	pPixelsOut->resize((size_t)cinfo.output_width * cinfo.output_height * 3);
+
+	while (cinfo.output_scanline < cinfo.output_height)
+	{
+		JSAMPROW row = &pPixelsOut->at((size_t)cinfo.output_scanline * cinfo.output_width * 3);
+		jpeg_read_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	return true;
+}
+
+//Average difference per channel between the decoded jpg and this part of a top row first RGB frame
+static float GetJPGError(const vector<byte> &decoded, const CaptureFrame &frame, const CL_Rect &rect)
+{
+	double total = 0;
+	for (int y = 0; y < rect.get_height(); y++)
+	{
+		const byte *pSrc = frame.m_pPixels + (rect.top + y) * frame.m_pitch + rect.left * 3;
+		const byte *pJPG = &decoded[(size_t)y * rect.get_width() * 3];
+		for (int i = 0; i < rect.get_width() * 3; i++)
+		{
+			total += abs((int)pSrc[i] - (int)pJPG[i]);
+		}
+	}
+	return (float)(total / ((double)rect.get_width() * rect.get_height() * 3));
+}
+
+//Does the frame hold exactly this part of a top row first RGB image?
+static bool FrameMatchesImage(const CaptureFrame &frame, SoftSurface *pImage, int x, int y)
+{
+	for (int row = 0; row < frame.m_height; row++)
+	{
+		if (memcmp(frame.m_pPixels + row * frame.m_pitch, pImage->GetPixelData() + (y + row) * pImage->GetPitch() + x * 3, frame.m_width * 3) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void TestFileCaptureSource(const vector<string> &files)
+{
+	FileCaptureSource source;
+	for (auto &file : files) source.AddFile(file);
+	CHECK(source.GetFileCount() == 3);
+
+	SoftSurface image;
+	CHECK(image.LoadFile(files[0]));
+
+	CaptureFrame frame;
+	CHECK(source.Capture(0, 0, image.GetWidth(), image.GetHeight(), &frame));
+	CHECK(frame.m_width == 600 && frame.m_height == 413);
+	CHECK(frame.m_format == PIXEL_FORMAT_RGB);
+	CHECK(FrameMatchesImage(frame, &image, 0, 0));
+
+	//a rect inside the next frame points right at its pixels
+	SoftSurface second;
+	CHECK(second.LoadFile(files[1]));
+	CHECK(source.Capture(100, 50, 200, 120, &frame));
+	CHECK(frame.m_width == 200 && frame.m_height == 120);
+	CHECK(FrameMatchesImage(frame, &second, 100, 50));
+
+	//hanging off the edge gets clipped
+	CHECK(source.Capture(500, 400, 200, 200, &frame));
+	CHECK(frame.m_width == 100 && frame.m_height == 13);
+
+	//that was the third file, so it's back to the first one.  Which doesn't help if the rect isn't on it at all
+	CHECK(!source.Capture(700, 0, 50, 50, &frame));
+	CHECK(source.Capture(0, 0, 600, 413, &frame));
+	CHECK(FrameMatchesImage(frame, &second, 0, 0));
+
+	//told the images are stored bottom row first, the bottom rows of the rect are the first ones in memory
+	FileCaptureSource bottomUp;
+	bottomUp.AddFile(files[0]);
+	bottomUp.SetBottomUp(true);
+	CHECK(bottomUp.Capture(0, 400, 600, 13, &frame));
+	CHECK(frame.m_bBottomUp);
+	CHECK(FrameMatchesImage(frame, &image, 0, 0));
+
+	FileCaptureSource missing;
+	CHECK(missing.AddFilesFromPattern("no_such_frame_%04d.png") == 0);
+	CHECK(!missing.Capture(0, 0, 10, 10, &frame));
+}
+
+//What a scan does with a frame up to the upload: its own bottom up RGB copy from the pool (CopyCaptureForScan, except a
+//desktop DIB is already bottom up and the file isn't, so it's flipped here), then if there was a previous capture only the
+//part that changed is encoded.  Checks the jpg against the frame as captured, so anything upside down or shifted fails.
+static void ScanFrame(const CaptureFrame &frame, SoftSurfacePool *pPool, SoftSurfacePtr *pPrevCapture, vector<byte> *pJPG, CL_Rect *pCropOut)
+{
+	SoftSurfacePtr pCapture = pPool->Get(frame.m_width, frame.m_height, SoftSurface::SURFACE_RGB);
+	CHECK(ConvertPixelsToSurface(frame.m_pPixels, frame.m_pitch, frame.m_format, frame.m_width, frame.m_height, true,
+		pCapture.get(), SoftSurface::SURFACE_RGB));
+
+	CaptureFrame sendFrame;
+	CHECK(sendFrame.InitFromSoftSurface(pCapture.get(), true));
+
+	CL_Rect crop(0, 0, frame.m_width, frame.m_height);
+	if (*pPrevCapture)
+	{
+		//same math as the encode stage
+		CaptureFrame prevFrame;
+		prevFrame.InitFromSoftSurface(pPrevCapture->get(), true);
+		CHECK(FindChangedRect(sendFrame, prevFrame, &crop));
+
+		sendFrame.m_pPixels += (sendFrame.m_height - crop.bottom) * sendFrame.m_pitch + crop.left * 3;
+		sendFrame.m_width = crop.get_width();
+		sendFrame.m_height = crop.get_height();
+	}
+
+	JPGMemoryEncoder jpg;
+	CHECK(jpg.Encode(sendFrame.m_pPixels, sendFrame.m_width, sendFrame.m_height, sendFrame.m_pitch, sendFrame.m_format, true, 95, pJPG));
+	CHECK(jpg.GetBytesCopied() >= pJPG->size());
+
+	vector<byte> decoded;
+	int width = 0, height = 0;
+	CHECK(DecodeJPG(*pJPG, &decoded, &width, &height));
+	CHECK(width == crop.get_width() && height == crop.get_height());
+
+	float error = GetJPGError(decoded, frame, crop);
+	printf("Sent (%d, %d, %d, %d), %d byte jpg, %.2f average error\n", crop.left, crop.top, crop.right, crop.bottom, (int)pJPG->size(), error);
+	CHECK(error < 4);
+
+	*pPrevCapture = pCapture;
+	*pCropOut = crop;
+}
+
+static void TestScanPath(const vector<string> &files)
+{
+	//the first file a few times (it should settle and ask for one scan), then the next one
+	const int frameOrder[] = { 0, 0, 0, 1, 1 };
+	const bool shouldScan[] = { false, true, false, false, true };
+
+	FileCaptureSource source;
+	for (int fileIndex : frameOrder) source.AddFile(files[fileIndex]);
+
+	SoftSurfacePool pool;
+	FrameChangeDetector detector;
+	detector.SetStableFramesRequired(2);
+
+	SoftSurfacePtr pPrevCapture;
+	vector<byte> jpgBuffer; //reused like GameLogicComponent's m_scanJPG
+	CL_Rect crop;
+	CaptureFrame frame;
+
+	for (int i = 0; i < 5; i++)
+	{
+		CHECK(source.Capture(0, 0, 600, 413, &frame));
+
+		bool bScan = detector.AddFrame(frame);
+		CHECK(bScan == shouldScan[i]);
+		if (bScan)
+		{
+			ScanFrame(frame, &pool, &pPrevCapture, &jpgBuffer, &crop);
+		}
+	}
+
+	//completely different screenshots, so all of the second one went
+	CHECK(crop.left == 0 && crop.top == 0 && crop.right == 600 && crop.bottom == 413);
+
+	//the first scan's surface was still held as the previous capture when the second was made, and went back to the pool
+	//when the second one replaced it
+	CHECK(pool.GetCreatedCount() == 2);
+	CHECK(pool.GetFreeCount() == 1);
+
+	//now a dialog box changes on the same screen, only that should be sent
+	SoftSurface changed;
+	CHECK(ConvertPixelsToSurface(frame.m_pPixels, frame.m_pitch, frame.m_format, frame.m_width, frame.m_height, false, &changed,
+		SoftSurface::SURFACE_RGB));
+	for (int y = 40; y < 70; y++)
+	{
+		for (int x = 100; x < 180; x++)
+		{
+			byte *pPixel = changed.GetPixelData() + y * changed.GetPitch() + x * 3;
+			pPixel[0] = 20;
+			pPixel[1] = 30;
+			pPixel[2] = 90;
+		}
+	}
+
+	CaptureFrame changedFrame;
+	CHECK(changedFrame.InitFromSoftSurface(&changed, false));
+	CHECK(detector.AddFrame(changedFrame) == false); //needs to hold still for a frame first
+	CHECK(detector.AddFrame(changedFrame) == true);
+	CHECK(detector.GetChangedTileCount() > 0 && detector.GetChangedTileCount() < detector.GetTileCount() / 10);
+
+	size_t capacity = jpgBuffer.capacity();
+	ScanFrame(changedFrame, &pool, &pPrevCapture, &jpgBuffer, &crop);
+	CHECK(crop.left == 100 && crop.top == 40 && crop.right == 180 && crop.bottom == 70);
+	CHECK(jpgBuffer.capacity() == capacity); //encoding into the same vector again didn't reallocate
+
+	//that one came from the pool too
+	CHECK(pool.GetCreatedCount() == 2);
+	pPrevCapture.reset();
+	CHECK(pool.GetFreeCount() == 2);
+}
+
+static void TestRGBAEncode(const vector<string> &files)
+{
+	//desktop captures come in as 4 bytes a pixel, the encoder converts each row as it goes
+	FileCaptureSource source;
+	source.AddFile(files[2]);
+	CaptureFrame frame;
+	CHECK(source.Capture(0, 0, 600, 413, &frame));
+
+	SoftSurface rgba;
+	CHECK(ConvertPixelsToSurface(frame.m_pPixels, frame.m_pitch, frame.m_format, frame.m_width, frame.m_height, false, &rgba,
+		SoftSurface::SURFACE_RGBA));
+
+	vector<byte> jpgBuffer, decoded;
+	JPGMemoryEncoder jpg;
+	CHECK(jpg.Encode(&rgba, 95, &jpgBuffer));
+	CHECK(jpg.GetBytesCopied() == jpgBuffer.size() + 600 * 413 * 3);
+
+	int width = 0, height = 0;
+	CHECK(DecodeJPG(jpgBuffer, &decoded, &width, &height));
+	CHECK(width == 600 && height == 413);
+	CHECK(GetJPGError(decoded, frame, CL_Rect(0, 0, 600, 413)) < 4);
+}
+
+int main(int argc, char **argv)
+{
+	string dir = argc > 1 ? argv[1] : "webmedia";
+	vector<string> files = { dir + "/drag_test.png", dir + "/ff_export_test.png", dir + "/gamepad_test.png" };
+
+	g_bShimQuiet = true;
+
+	TestFileCaptureSource(files);
+	TestScanPath(files);
+	TestRGBAEncode(files);
+
+	printf(g_failures == 0 ? "All capture pipeline checks passed\n" : "%d capture pipeline checks FAILED\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
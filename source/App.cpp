@@ -18,6 +18,7 @@
 #include <fcntl.h>
 #include "GUIHelp.h"
 #include "AutoPlayManager.h"
+#include "WatchModeManager.h"
 #include "WinDragRect.h"
 #include "ExportToHTML.h"
 
@@ -122,6 +123,7 @@ App::App()
 {
 		m_pExportToHTML = NULL;
 		m_pAutoPlayManager = NULL;
+		m_pWatchModeManager = NULL;
 		m_usedSubAreaScan = false;
 		m_version = "0.76 Beta";
 		m_versionNum = 76;
@@ -143,6 +145,7 @@ App::~App()
 	m_vecFontInfo.clear();
 
 	SAFE_DELETE(m_pAutoPlayManager);
+	SAFE_DELETE(m_pWatchModeManager);
 	SAFE_DELETE(m_pExportToHTML);
 	SAFE_DELETE(m_pWinDragRect);
 }
@@ -382,7 +385,31 @@ bool App::Init()
 	}
 
 	m_pAutoPlayManager = new AutoPlayManager();
+	m_pWatchModeManager = new WatchModeManager();
 	m_pExportToHTML = new ExportToHTML();
+	m_workerPool.Init(0);
+
+	if (m_translation_cache_max_mb > 0)
+	{
+		m_translationCache.Init("translation_cache.dat", (size_t)m_translation_cache_max_mb * 1024 * 1024, C_TRANSLATION_CACHE_MEMORY_ENTRIES);
+	}
+
+	if (m_ocr_cache_max_mb > 0)
+	{
+		m_ocrCache.Init("ocr_cache.dat", (size_t)m_ocr_cache_max_mb * 1024 * 1024, C_OCR_CACHE_MEMORY_ENTRIES, m_ocr_cache_max_hash_distance);
+	}
+
+	if (m_tts_cache_max_mb > 0)
+	{
+		m_ttsCache.Init("tts_cache.dat", (size_t)m_tts_cache_max_mb * 1024 * 1024, C_TTS_CACHE_MEMORY_BYTES);
+	}
+
+	if (m_visionEngine == VISION_ENGINE_TESSERACT)
+	{
+		//each engine is a copy of the models (jpn is ~50 MB of memory), past 4 there isn't much left to split up anyway
+		int threads = m_tesseract_threads > 0 ? m_tesseract_threads : rt_min(m_workerPool.GetThreadCount(), 4);
+		m_tesseractOcr.Init(m_tesseract_data_path, m_tesseract_languages, threads, &m_workerPool);
+	}
 
 	//check for updates?
 	m_updateChecker.CheckForUpdate();
@@ -391,8 +418,16 @@ bool App::Init()
 
 void App::Kill()
 {
+	m_workerPool.Kill(); //jobs can be using the fonts and the GameLogicComponent, so stop them before those go away
 	SAFE_DELETE(m_pAutoPlayManager);
+	SAFE_DELETE(m_pWatchModeManager);
+	m_translationCache.Kill();
+	m_ocrCache.Kill();
+	m_ttsCache.Kill();
+	m_tesseractOcr.Kill();
 	BaseApp::Kill();
+	m_httpReactor.Kill();
+	m_speechPlayer.Kill();
 	SAFE_DELETE(g_pAudioManager);
 }
 
@@ -1178,6 +1213,7 @@ void App::Update()
 			m_hotKeyHandler.RegisterHotkey(m_hotkey_for_active_window);
 			m_hotKeyHandler.RegisterHotkey(m_hotkey_for_draggable_area);
 			m_hotKeyHandler.RegisterHotkey(m_hotkey_for_draggable_area_again);
+			m_hotKeyHandler.RegisterHotkey(m_hotkey_for_watch_mode);
 			//GetApp()->m_hotKeyHandler.OnHideWindow();
 		}
 
@@ -1198,6 +1234,7 @@ void App::Update()
 	g_gamepadManager.Update();
 
 	m_pAutoPlayManager->Update();
+	m_speechPlayer.Update();
 	HidingOverlayUpdate();
 
 
@@ -1206,7 +1243,9 @@ void App::Update()
 		m_pWinDragRect->Update();
 	}
 
-	m_updateChecker.Update();
+	m_httpReactor.Update(); //drives every CurlRequest, their finished callbacks happen in here
+	m_workerPool.Update(); //finished worker stages hand back to the main thread here
+	m_pWatchModeManager->Update();
 
 		if (g_bHasFocus)
 		{
@@ -1351,6 +1390,13 @@ void App::HandleHotKeyPushed(HotKeySetting setting)
 		return;
 	}
 
+	if (setting.hotKeyAction == "hotkey_to_toggle_watch_mode")
+	{
+		//doesn't close what's showing, watch mode will take care of it when the text changes
+		m_pWatchModeManager->Toggle();
+		return;
+	}
+
 	if (GetApp()->GetCaptureMode() == CAPTURE_MODE_SHOWING)
 	{
 		OnTranslateButton(); //toggle it off I guess
@@ -1645,6 +1691,50 @@ bool App::LoadConfigFile()
 		}
 
 		m_jpg_quality_for_scan = StringToInt(ts.GetParmString("jpg_quality_for_scan", 1));
+		if (ts.GetParmString("save_scan_to_temp_jpg", 1) != "")
+		{
+			m_save_scan_to_temp_jpg = ToLowerCaseString(ts.GetParmString("save_scan_to_temp_jpg", 1)) == "enabled";
+		}
+		if (ts.GetParmString("translation_cache_max_mb", 1) != "")
+		{
+			m_translation_cache_max_mb = StringToInt(ts.GetParmString("translation_cache_max_mb", 1));
+		}
+		if (ts.GetParmString("ocr_cache_max_mb", 1) != "")
+		{
+			m_ocr_cache_max_mb = StringToInt(ts.GetParmString("ocr_cache_max_mb", 1));
+		}
+		if (ts.GetParmString("ocr_cache_max_hash_distance", 1) != "")
+		{
+			m_ocr_cache_max_hash_distance = StringToInt(ts.GetParmString("ocr_cache_max_hash_distance", 1));
+		}
+		if (ts.GetParmString("tts_cache_max_mb", 1) != "")
+		{
+			m_tts_cache_max_mb = StringToInt(ts.GetParmString("tts_cache_max_mb", 1));
+		}
+		if (ts.GetParmString("tts_prefetch_count", 1) != "")
+		{
+			m_tts_prefetch_count = StringToInt(ts.GetParmString("tts_prefetch_count", 1));
+		}
+		if (ts.GetParmString("tts_split_sentences", 1) != "")
+		{
+			m_tts_split_sentences = ToLowerCaseString(ts.GetParmString("tts_split_sentences", 1)) == "enabled";
+		}
+		if (ts.GetParmString("watch_mode_interval_ms", 1) != "")
+		{
+			m_watch_mode_interval_ms = StringToInt(ts.GetParmString("watch_mode_interval_ms", 1));
+		}
+		if (ts.GetParmString("watch_mode_stable_frames", 1) != "")
+		{
+			m_watch_mode_stable_frames = StringToInt(ts.GetParmString("watch_mode_stable_frames", 1));
+		}
+		if (ts.GetParmString("ocr_only_changed_area", 1) != "")
+		{
+			m_ocr_only_changed_area = ToLowerCaseString(ts.GetParmString("ocr_only_changed_area", 1)) == "enabled";
+		}
+		if (ts.GetParmString("reuse_text_between_scans", 1) != "")
+		{
+			m_reuse_text_between_scans = ToLowerCaseString(ts.GetParmString("reuse_text_between_scans", 1)) == "enabled";
+		}
 		m_inputMode = ts.GetParmString("input", 1);
 		 
 		m_log_capture_text_to_file = ts.GetParmString("log_capture_text_to_file", 1);
@@ -1714,6 +1804,23 @@ bool App::LoadConfigFile()
 			m_visionEngine = VISION_ENGINE_MICROSOFT;
 			LogMsg("Using Microsoft Vision API for OCR, I hope you set its API key.");
 		}
+		if (visionEngine == "tesseract")
+		{
+			m_visionEngine = VISION_ENGINE_TESSERACT;
+			LogMsg("Using Tesseract for OCR, nothing gets uploaded.");
+		}
+		if (ts.GetParmString("tesseract_data_path", 1) != "")
+		{
+			m_tesseract_data_path = ts.GetParmString("tesseract_data_path", 1);
+		}
+		if (ts.GetParmString("tesseract_languages", 1) != "")
+		{
+			m_tesseract_languages = ts.GetParmString("tesseract_languages", 1);
+		}
+		if (ts.GetParmString("tesseract_threads", 1) != "")
+		{
+			m_tesseract_threads = StringToInt(ts.GetParmString("tesseract_threads", 1));
+		}
 
 		if (ts.GetParmString("source_language_hint", 1) != "")
 		{
@@ -1731,6 +1838,7 @@ bool App::LoadConfigFile()
 		m_hotkey_for_active_window = GetHotKeyDataFromConfig(ts.GetParmString("hotkey_to_scan_active_window", 1), "hotkey_to_scan_active_window");
 		m_hotkey_for_draggable_area = GetHotKeyDataFromConfig(ts.GetParmString("hotkey_to_scan_draggable_area", 1),"hotkey_to_scan_draggable_area");
 		m_hotkey_for_draggable_area_again = GetHotKeyDataFromConfig(ts.GetParmString("hotkey_to_scan_last_draggable_area_again", 1), "hotkey_to_scan_last_draggable_area_again");
+		m_hotkey_for_watch_mode = GetHotKeyDataFromConfig(ts.GetParmString("hotkey_to_toggle_watch_mode", 1), "hotkey_to_toggle_watch_mode");
 		if (ts.GetParmString("kanji_lookup_website", 1) != "")
 			m_kanji_lookup_website = ts.GetParmString("kanji_lookup_website", 1);
 	}
@@ -1745,6 +1853,10 @@ bool App::LoadConfigFile()
 	{
 		m_hotkey_for_draggable_area_again = GetHotKeyDataFromConfig("Control,F9", "hotkey_to_scan_last_draggable_area_again");
 	}
+	if (m_hotkey_for_watch_mode.originalString.empty())
+	{
+		m_hotkey_for_watch_mode = GetHotKeyDataFromConfig("Control,F8", "hotkey_to_toggle_watch_mode");
+	}
 	if (m_gamepad_button_to_scan_active_rect_window == 0)
 	{
 		m_gamepad_button_to_scan_active_rect_window = StringToProtonVirtualKey("left joystick button");
@@ -1795,6 +1907,7 @@ bool App::LoadConfigFile()
 
 	g_pAudioManager->SetPreferOGG(false);
 	GetAudioManager()->SetRequestedDriverByName(audioDevice);
+	m_speechPlayer.Init(audio, audioDevice); //text to speech plays from memory with the same library and device
 	return true;
 }
 
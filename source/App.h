@@ -9,10 +9,18 @@
 #include "BaseApp.h"
 #include "FreeTypeManager.h"
 #include "HotKeyHandler.h"
+#include "HTTPReactor.h"
+#include "WorkerPool.h"
 #include "UpdateChecker.h"
+#include "TranslationCache.h"
+#include "OcrCache.h"
+#include "TTSCache.h"
+#include "SpeechPlayer.h"
+#include "TesseractOcr.h"
 
 class GameLogicComponent;
 class AutoPlayManager;
+class WatchModeManager;
 class WinDragRect;
 class ExportToHTML;
 
@@ -53,6 +61,7 @@ enum eVisionEngine
 {
 	VISION_ENGINE_GOOGLE,
 	VISION_ENGINE_MICROSOFT,
+	VISION_ENGINE_TESSERACT, //local, see TesseractOcr
 
 	//add more above here
 	VISION_ENGINE_COUNT
@@ -146,7 +155,15 @@ public:
 	boost::signals2::signal<void(void)> m_sig_target_language_changed;
 	boost::signals2::signal<void(void)> m_sig_kill_all_text;
 	AutoPlayManager* GetAutoPlayManager() { return m_pAutoPlayManager; }
+	WatchModeManager* GetWatchModeManager() { return m_pWatchModeManager; }
 	ExportToHTML* GetExportToHTML() { return m_pExportToHTML; }
+	TranslationCache* GetTranslationCache() { return &m_translationCache; }
+	OcrCache* GetOcrCache() { return &m_ocrCache; }
+	TTSCache* GetTTSCache() { return &m_ttsCache; }
+	SpeechPlayer* GetSpeechPlayer() { return &m_speechPlayer; }
+	TesseractOcr* GetTesseractOcr() { return &m_tesseractOcr; }
+	HTTPReactor* GetHTTPReactor() { return &m_httpReactor; }
+	WorkerPool* GetWorkerPool() { return &m_workerPool; }
 
 	eVirtualKeys m_gamepad_button_to_scan_active_window;
 	eVirtualKeys m_gamepad_button_to_scan_active_rect_window = VIRTUAL_KEY_NONE;;
@@ -167,6 +184,7 @@ public:
 	HotKeyHandler m_hotKeyHandler;
 	HotKeySetting m_hotkey_for_whole_desktop, m_hotkey_for_active_window, m_hotkey_for_draggable_area;
 	HotKeySetting m_hotkey_for_draggable_area_again;
+	HotKeySetting m_hotkey_for_watch_mode;
 	vector< KeyData> m_keyData;
 	eTextHinting m_globalHinting = HINTING_AUTO;
 	POINT m_cursorPosAtStart;
@@ -186,6 +204,20 @@ public:
 	string m_microsoft_vision_api_key;
 	string m_deepl_api_url = "https://api-free.deepl.com"; //default
 	int m_jpg_quality_for_scan = 95;
+	bool m_save_scan_to_temp_jpg = false;
+	int m_translation_cache_max_mb = 32; //0 to disable
+	int m_ocr_cache_max_mb = 16; //0 to disable
+	int m_ocr_cache_max_hash_distance = 6; //out of 256 bits
+	int m_tts_cache_max_mb = 32; //0 to disable
+	int m_tts_prefetch_count = 2; //how many dialog boxes ahead auto play fetches audio for
+	bool m_tts_split_sentences = true; //ask for each sentence separately so reading starts sooner
+	string m_tesseract_data_path = "tessdata";
+	string m_tesseract_languages = "jpn";
+	int m_tesseract_threads = 0; //0 means pick based on the worker pool
+	int m_watch_mode_interval_ms = 250;
+	int m_watch_mode_stable_frames = 3;
+	bool m_ocr_only_changed_area = true;
+	bool m_reuse_text_between_scans = true;
 	string m_kanji_lookup_website = "https://jisho.org/search/";
 	string m_log_capture_text_to_file = "disabled";
 	string m_place_capture_text_on_clipboard = "disabled";
@@ -230,9 +262,17 @@ public:
 	eCaptureMode m_captureMode = CAPTURE_MODE_WAITING;
 	HotKeySetting GetHotKeyDataFromConfig(string data, string action);
 	AutoPlayManager* m_pAutoPlayManager;
+	WatchModeManager* m_pWatchModeManager;
 	POINT m_hidingOverlayMousePosStart;
 	ExportToHTML* m_pExportToHTML;
+	HTTPReactor m_httpReactor; //must be declared before anything that owns a CurlRequest
+	WorkerPool m_workerPool;
 	UpdateChecker m_updateChecker;
+	TranslationCache m_translationCache;
+	OcrCache m_ocrCache;
+	TTSCache m_ttsCache;
+	SpeechPlayer m_speechPlayer;
+	TesseractOcr m_tesseractOcr;
 	bool m_bHidingOverlays = false;
 };
 
@@ -17,6 +17,12 @@ void AutoPlayManager::OnKillAllText()
 
 void AutoPlayManager::Reset()
 {
+	for (auto itor = m_areas.begin(); itor != m_areas.end(); itor++)
+	{
+		if (itor == m_areas.begin() && m_bHaveStartedPlaying) continue; //that one isn't a prefetch, it's playing
+		(*itor)->CancelAudioPrefetch();
+	}
+
 	m_bHaveStartedPlaying = false;
 	m_areas.clear();
 	m_loadedAreas.clear();
@@ -30,47 +36,80 @@ void AutoPlayManager::OnAddDialog(TextAreaComponent* pEnt)
 	
 }
 
+void AutoPlayManager::OnRemoveDialog(TextAreaComponent* pEnt)
+{
+	if (!m_areas.empty() && m_areas.front() == pEnt)
+	{
+		m_bHaveStartedPlaying = false;
+	}
+
+	m_areas.remove(pEnt);
+	m_loadedAreas.remove(pEnt);
+}
+
 void AutoPlayManager::OnLoadingFinished(TextAreaComponent* pEnt)
 {
 	m_loadedAreas.push_back(pEnt);
 
 }
 
+bool AutoPlayManager::IsReadyToRead(TextAreaComponent* pEnt)
+{
+	if (GetApp()->GetShared()->GetVar("check_src_audio")->GetUINT32() == 0)
+	{
+		//only continue if the translation has been done already
+		return pEnt->FinishedWithTranslation();
+	}
+
+	return true;
+}
+
+const int C_TTS_PREFETCH_MAX_REQUESTS = 8; //a box is a request per sentence, so count those, not boxes
+
+void AutoPlayManager::PrefetchUpcoming()
+{
+	int prefetchCount = GetApp()->m_tts_prefetch_count;
+	if (prefetchCount <= 0) return;
+
+	int requestCount = 0;
+	for (auto countItor = m_areas.begin(); countItor != m_areas.end(); countItor++)
+	{
+		requestCount += (*countItor)->GetAudioRequestsInFlight();
+	}
+
+	auto itor = m_areas.begin();
+	itor++; //the front one is asked for normally
+
+	for (int i = 0; i < prefetchCount && itor != m_areas.end(); i++, itor++)
+	{
+		if ((*itor)->IsAudioPrefetchStarted()) continue;
+		if (!IsReadyToRead(*itor)) continue; //it'll get its turn once it's translated
+		if (requestCount >= C_TTS_PREFETCH_MAX_REQUESTS) return; //plenty going already, try again next frame
+
+		(*itor)->PrefetchAudio();
+		requestCount += (*itor)->GetAudioRequestsInFlight();
+	}
+}
+
 void AutoPlayManager::Update()
 {
 	if (m_areas.empty()) return;
-	
-		if (!m_bHaveStartedPlaying)
-		{
-		
-			if (GetApp()->GetShared()->GetVar("check_src_audio")->GetUINT32() == 0)
-			{
-				//only continue if the translation has been done already
-				if (!m_areas.front()->FinishedWithTranslation()) return; //wait
-			}
-			m_bHaveStartedPlaying = true;
-
-			m_areas.front()->RequestAudio(true, false);
-		}
-		else
-		{
-			if (!m_areas.front()->IsStillPlayingOrPlanningToPlay())
-			{
-				//kill it and move on to the next
-				m_areas.pop_front();
-				if (!m_areas.empty())
-				{
-					if (GetApp()->GetShared()->GetVar("check_src_audio")->GetUINT32() == 0)
-					{
-						//only continue if the translation has been done already
-						if (!m_areas.front()->FinishedWithTranslation()) return; //wait
-					}
-
-					m_areas.front()->RequestAudio(true, false);
-				}
-			}
-		}
 
-	
+	if (m_bHaveStartedPlaying && !m_areas.front()->IsStillPlayingOrPlanningToPlay())
+	{
+		//done with it, move on to the next
+		m_areas.pop_front();
+		m_bHaveStartedPlaying = false;
+		if (m_areas.empty()) return;
+	}
+
+	if (!m_bHaveStartedPlaying && IsReadyToRead(m_areas.front()))
+	{
+		m_bHaveStartedPlaying = true;
+
+		//if it was prefetched this plays right away
+		m_areas.front()->RequestAudio(true, false);
+	}
 
+	PrefetchUpcoming();
 }
@@ -2,6 +2,8 @@
 
 class TextAreaComponent;
 
+//Reads dialog boxes out loud one after the other.  While one is playing, the audio for the next few is fetched (up to
+//tts_prefetch_count of them at once) so there's no round trip of dead air between them.
 class AutoPlayManager
 {
 	public:
@@ -10,13 +12,18 @@ class AutoPlayManager
 
 		void OnKillAllText();
 
-		void Reset();
+		void Reset(); //also cancels anything prefetched
 		void OnAddDialog(TextAreaComponent* pEnt);
+		void OnRemoveDialog(TextAreaComponent* pEnt); //it's being deleted
 		void OnLoadingFinished(TextAreaComponent* pEnt);
 		void Update();
 		bool m_bHaveStartedPlaying = false;
 
 		std::list<TextAreaComponent*> m_areas;
 		std::list<TextAreaComponent*> m_loadedAreas;
-};
 
+	protected:
+
+		bool IsReadyToRead(TextAreaComponent* pEnt);
+		void PrefetchUpcoming();
+};
@@ -0,0 +1,118 @@
+#include "PlatformPrecomp.h"
+#include "Base64Utils.h"
+#include "SIMDUtils.h"
+
+static const char g_base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+size_t Base64EncodeScalar(const byte *pSrc, size_t inputBytes, char *pDest)
+{
+	char *pOut = pDest;
+	size_t i = 0;
+
+	for (; i + 3 <= inputBytes; i += 3)
+	{
+		uint32 triple = (pSrc[i] << 16) | (pSrc[i + 1] << 8) | pSrc[i + 2];
+		*pOut++ = g_base64Chars[(triple >> 18) & 0x3F];
+		*pOut++ = g_base64Chars[(triple >> 12) & 0x3F];
+		*pOut++ = g_base64Chars[(triple >> 6) & 0x3F];
+		*pOut++ = g_base64Chars[triple & 0x3F];
+	}
+
+	size_t left = inputBytes - i;
+	if (left > 0)
+	{
+		uint32 triple = pSrc[i] << 16;
+		if (left == 2) triple |= pSrc[i + 1] << 8;
+
+		*pOut++ = g_base64Chars[(triple >> 18) & 0x3F];
+		*pOut++ = g_base64Chars[(triple >> 12) & 0x3F];
+		*pOut++ = left == 2 ? g_base64Chars[(triple >> 6) & 0x3F] : '=';
+		*pOut++ = '=';
+	}
+
+	return pOut - pDest;
+}
+
+#ifdef RT_SIMD_X86
+
+//12 input bytes -> 16 chars per loop.  Splits the 6 bit fields out with a shuffle and two multiplies, then maps
+//0..63 to ascii with a pshufb lookup of per-range offsets (Wojciech Mula's trick)
+RT_TARGET_SSSE3 static size_t Base64EncodeSSSE3(const byte *pSrc, size_t inputBytes, char *pDest)
+{
+	const __m128i shuf = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	const __m128i maskA = _mm_set1_epi32(0x0fc0fc00);
+	const __m128i mulA = _mm_set1_epi32(0x04000040);
+	const __m128i maskB = _mm_set1_epi32(0x003f03f0);
+	const __m128i mulB = _mm_set1_epi32(0x01000010);
+	const __m128i shiftLUT = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+	char *pOut = pDest;
+	size_t i = 0;
+
+	//the load reads 16 bytes but we only use 12, so stop while there are still 16 left to read
+	for (; i + 16 <= inputBytes; i += 12)
+	{
+		__m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + i)), shuf);
+		__m128i indices = _mm_or_si128(_mm_mulhi_epu16(_mm_and_si128(in, maskA), mulA),
+			_mm_mullo_epi16(_mm_and_si128(in, maskB), mulB));
+
+		__m128i lookup = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+		__m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+		lookup = _mm_or_si128(lookup, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+		_mm_storeu_si128((__m128i*)pOut, _mm_add_epi8(indices, _mm_shuffle_epi8(shiftLUT, lookup)));
+		pOut += 16;
+	}
+
+	return (pOut - pDest) + Base64EncodeScalar(pSrc + i, inputBytes - i, pOut);
+}
+
+#endif
+
+size_t Base64Encode(const byte *pSrc, size_t inputBytes, char *pDest)
+{
+#ifdef RT_SIMD_X86
+	if (CPUHasSSSE3())
+	{
+		return Base64EncodeSSSE3(pSrc, inputBytes, pDest);
+	}
+#endif
+	return Base64EncodeScalar(pSrc, inputBytes, pDest);
+}
+
+static int GetBase64Value(char c)
+{
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+size_t Base64Decoder::Decode(const char *pSrc, size_t length, byte *pDest)
+{
+	byte *pOut = pDest;
+
+	for (size_t i = 0; i < length && !m_bDone; i++)
+	{
+		int value = GetBase64Value(pSrc[i]);
+		if (value < 0)
+		{
+			if (pSrc[i] == '=') m_bDone = true;
+			continue; //whitespace, line breaks, the \ of a JSON escaped /
+		}
+
+		m_bits = (m_bits << 6) | (uint32)value;
+		m_bitCount += 6;
+
+		if (m_bitCount >= 8)
+		{
+			m_bitCount -= 8;
+			*pOut++ = (byte)(m_bits >> m_bitCount);
+		}
+	}
+
+	return pOut - pDest;
+}
@@ -0,0 +1,34 @@
+//Base64 that writes straight into a buffer you give it, the vision requests are multi-megabyte so building a string and
+//then copying it around a few times was showing up.  Uses SSSE3 if the CPU has it, output matches base64_encode() exactly.
+
+#ifndef Base64Utils_h__
+#define Base64Utils_h__
+
+//how many chars Base64Encode will write for this many input bytes (includes the = padding)
+inline size_t Base64EncodedSize(size_t inputBytes) { return ((inputBytes + 2) / 3) * 4; }
+
+//Writes exactly Base64EncodedSize(inputBytes) chars to pDest, no null terminator.  If you are encoding in pieces,
+//make every piece but the last a multiple of 3 bytes so no padding gets stuck in the middle
+size_t Base64Encode(const byte *pSrc, size_t inputBytes, char *pDest);
+size_t Base64EncodeScalar(const byte *pSrc, size_t inputBytes, char *pDest);
+
+//the most bytes Decode can write for this many chars
+inline size_t Base64DecodedMaxSize(size_t inputChars) { return (inputChars / 4) * 3 + 3; }
+
+//Decodes as the text is fed to it, so it can come in pieces, or be read right out of a JSON response without copying the
+//string out first.  Anything that isn't base64 (whitespace, the \ of an escaped /) is skipped, = ends it.
+class Base64Decoder
+{
+public:
+
+	void Reset() { m_bits = 0; m_bitCount = 0; m_bDone = false; }
+	size_t Decode(const char *pSrc, size_t length, byte *pDest); //returns how many bytes it wrote
+
+protected:
+
+	uint32 m_bits = 0;
+	int m_bitCount = 0;
+	bool m_bDone = false;
+};
+
+#endif // Base64Utils_h__
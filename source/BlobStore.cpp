@@ -0,0 +1,288 @@
+#include "PlatformPrecomp.h"
+#include "BlobStore.h"
+#include "WorkerPool.h"
+#include <algorithm>
+
+//file is the header, then records of: uint32 keyLen, uint32 valueLen, key bytes, value bytes
+static const char C_BLOB_STORE_HEADER[] = "RTBLOB01";
+static const size_t C_BLOB_STORE_HEADER_SIZE = 8;
+
+BlobStore::BlobStore()
+{
+}
+
+BlobStore::~BlobStore()
+{
+	Close();
+}
+
+bool BlobStore::Open(string fileName, size_t maxFileBytes)
+{
+	Close();
+	m_fileName = fileName;
+	m_maxFileBytes = maxFileBytes;
+
+	if (!MapFile())
+	{
+		//new or unreadable file, start over
+		UnmapFile();
+		FILE *fp = fopen(m_fileName.c_str(), "wb");
+		if (!fp)
+		{
+			LogMsg("BlobStore: Unable to create %s", m_fileName.c_str());
+			m_fileName.clear();
+			return false;
+		}
+		fwrite(C_BLOB_STORE_HEADER, C_BLOB_STORE_HEADER_SIZE, 1, fp);
+		fclose(fp);
+		MapFile();
+	}
+
+	size_t validBytes = IndexRecords();
+
+	if (validBytes != m_mappedBytes || m_mappedBytes > m_maxFileBytes - m_maxFileBytes / 8)
+	{
+		//either the end got chopped off (crashed mid write?) or it's (nearly) full, rewrite it with the newest stuff
+		if (!Compact(m_maxFileBytes - m_maxFileBytes / 4))
+		{
+			m_fileName.clear();
+			return false;
+		}
+	}
+
+	m_fpAppend = fopen(m_fileName.c_str(), "ab");
+	if (!m_fpAppend)
+	{
+		LogMsg("BlobStore: Unable to write to %s, it will be read only", m_fileName.c_str());
+	}
+
+	LogMsg("BlobStore: %s has %d entries (%d KB)", m_fileName.c_str(), (int)m_index.size(), (int)(m_fileBytes / 1024));
+	return true;
+}
+
+void BlobStore::Close()
+{
+	if (m_fpAppend)
+	{
+		fclose(m_fpAppend);
+		m_fpAppend = NULL;
+	}
+
+	UnmapFile();
+	m_index.clear();
+	m_appended.clear();
+	m_fileBytes = 0;
+	m_bWarnedAboutCap = false;
+	m_fileName.clear();
+}
+
+bool BlobStore::MapFile()
+{
+#ifdef WIN32
+	m_hFile = CreateFileA(m_fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_hFile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart < (LONGLONG)C_BLOB_STORE_HEADER_SIZE) return false;
+
+	m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m_hMapping) return false;
+
+	m_pMapped = (const byte*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_pMapped) return false;
+
+	m_mappedBytes = (size_t)fileSize.QuadPart;
+#else
+	FILE *fp = fopen(m_fileName.c_str(), "rb");
+	if (!fp) return false;
+	fseek(fp, 0, SEEK_END);
+	long fileSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (fileSize < (long)C_BLOB_STORE_HEADER_SIZE)
+	{
+		fclose(fp);
+		return false;
+	}
+	m_fileData.resize(fileSize);
+	size_t bytesRead = fread(&m_fileData[0], 1, fileSize, fp);
+	fclose(fp);
+	if (bytesRead != (size_t)fileSize) return false;
+	m_pMapped = &m_fileData[0];
+	m_mappedBytes = m_fileData.size();
+#endif
+
+	if (memcmp(m_pMapped, C_BLOB_STORE_HEADER, C_BLOB_STORE_HEADER_SIZE) != 0)
+	{
+		LogMsg("BlobStore: %s isn't a cache file we understand, starting over", m_fileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void BlobStore::UnmapFile()
+{
+#ifdef WIN32
+	if (m_pMapped) UnmapViewOfFile(m_pMapped);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+	m_hMapping = NULL;
+	m_hFile = INVALID_HANDLE_VALUE;
+#else
+	m_fileData.clear();
+#endif
+	m_pMapped = NULL;
+	m_mappedBytes = 0;
+}
+
+size_t BlobStore::IndexRecords()
+{
+	m_index.clear();
+	size_t offset = C_BLOB_STORE_HEADER_SIZE;
+
+	while (offset + 8 <= m_mappedBytes)
+	{
+		uint32 keyLen, valueLen;
+		memcpy(&keyLen, m_pMapped + offset, 4);
+		memcpy(&valueLen, m_pMapped + offset + 4, 4);
+
+		if ((uint64_t)offset + 8 + keyLen + valueLen > m_mappedBytes) break; //chopped off
+
+		Location loc;
+		loc.m_pData = m_pMapped + offset + 8 + keyLen;
+		loc.m_size = valueLen;
+		loc.m_fileOffset = offset;
+		m_index[string((const char*)m_pMapped + offset + 8, keyLen)] = loc;
+
+		offset += 8 + keyLen + valueLen;
+	}
+
+	m_fileBytes = offset;
+	return offset;
+}
+
+bool BlobStore::Compact(size_t targetBytes)
+{
+	//keep the newest entries (latest in the file) that fit
+	vector<std::pair<size_t, const string*> > entries;
+	entries.reserve(m_index.size());
+	for (auto itor = m_index.begin(); itor != m_index.end(); itor++)
+	{
+		entries.push_back(std::make_pair(itor->second.m_fileOffset, &itor->first));
+	}
+	std::sort(entries.begin(), entries.end());
+
+	size_t keepBytes = C_BLOB_STORE_HEADER_SIZE;
+	size_t firstToKeep = entries.size();
+	while (firstToKeep > 0)
+	{
+		const Location &loc = m_index[*entries[firstToKeep - 1].second];
+		size_t recordBytes = 8 + entries[firstToKeep - 1].second->length() + loc.m_size;
+		if (keepBytes + recordBytes > targetBytes) break;
+		keepBytes += recordBytes;
+		firstToKeep--;
+	}
+
+	string tempName = m_fileName + ".tmp";
+	FILE *fp = fopen(tempName.c_str(), "wb");
+	if (!fp)
+	{
+		LogMsg("BlobStore: Unable to write %s", tempName.c_str());
+		return false;
+	}
+
+	fwrite(C_BLOB_STORE_HEADER, C_BLOB_STORE_HEADER_SIZE, 1, fp);
+	for (size_t i = firstToKeep; i < entries.size(); i++)
+	{
+		const string &key = *entries[i].second;
+		const Location &loc = m_index[key];
+		uint32 keyLen = (uint32)key.length();
+		uint32 valueLen = (uint32)loc.m_size;
+		fwrite(&keyLen, 4, 1, fp);
+		fwrite(&valueLen, 4, 1, fp);
+		fwrite(key.c_str(), keyLen, 1, fp);
+		if (valueLen > 0) fwrite(loc.m_pData, valueLen, 1, fp);
+	}
+	fclose(fp);
+
+	LogMsg("BlobStore: Compacted %s from %d to %d KB (%d of %d entries kept)", m_fileName.c_str(), (int)(m_mappedBytes / 1024),
+		(int)(keepBytes / 1024), (int)(entries.size() - firstToKeep), (int)entries.size());
+
+	m_index.clear(); //points into the old mapping
+	UnmapFile();
+	remove(m_fileName.c_str());
+	if (rename(tempName.c_str(), m_fileName.c_str()) != 0 || !MapFile())
+	{
+		LogMsg("BlobStore: Unable to replace %s", m_fileName.c_str());
+		UnmapFile();
+		return false;
+	}
+
+	IndexRecords();
+	return true;
+}
+
+bool BlobStore::Get(const string &key, const byte **ppDataOut, size_t *pSizeOut)
+{
+	auto itor = m_index.find(key);
+	if (itor == m_index.end()) return false;
+
+	*ppDataOut = itor->second.m_pData;
+	*pSizeOut = itor->second.m_size;
+	return true;
+}
+
+bool BlobStore::Get(const string &key, string *pValueOut)
+{
+	const byte *pData;
+	size_t size;
+	if (!Get(key, &pData, &size)) return false;
+
+	pValueOut->assign((const char*)pData, size);
+	return true;
+}
+
+void BlobStore::GetKeys(vector<string> *pKeysOut)
+{
+	pKeysOut->reserve(pKeysOut->size() + m_index.size());
+	for (auto itor = m_index.begin(); itor != m_index.end(); itor++)
+	{
+		pKeysOut->push_back(itor->first);
+	}
+}
+
+bool BlobStore::Put(const string &key, const byte *pData, size_t size)
+{
+	if (!m_fpAppend) return false;
+
+	size_t recordBytes = 8 + key.length() + size;
+	if (m_fileBytes + recordBytes > m_maxFileBytes)
+	{
+		if (!m_bWarnedAboutCap)
+		{
+			LogMsgFromAnyThread("BlobStore: %s is full, new entries will be dropped until it gets compacted on the next start", m_fileName.c_str());
+			m_bWarnedAboutCap = true;
+		}
+		return false;
+	}
+
+	uint32 keyLen = (uint32)key.length();
+	uint32 valueLen = (uint32)size;
+	fwrite(&keyLen, 4, 1, m_fpAppend);
+	fwrite(&valueLen, 4, 1, m_fpAppend);
+	fwrite(key.c_str(), keyLen, 1, m_fpAppend);
+	if (size > 0) fwrite(pData, size, 1, m_fpAppend);
+	fflush(m_fpAppend); //so a crash doesn't lose it
+
+	m_appended.push_back(vector<byte>(pData, pData + size));
+
+	Location loc;
+	loc.m_pData = m_appended.back().empty() ? NULL : &m_appended.back()[0];
+	loc.m_size = size;
+	loc.m_fileOffset = m_fileBytes;
+	m_index[key] = loc;
+
+	m_fileBytes += recordBytes;
+	return true;
+}
@@ -0,0 +1,66 @@
+//A dumb append-only key/value file for caching things between runs.  The existing file is memory mapped on Open() and
+//indexed once, so lookups don't touch the disk and values are handed back as pointers into the mapping.  New entries are
+//appended to the end of the file (and kept in memory until the next Open).  If a key is written twice the last one wins.
+//
+//When the file hits the size cap it stops taking new entries, the next Open() rewrites it keeping the newest ones.
+
+#ifndef BlobStore_h__
+#define BlobStore_h__
+
+#include <unordered_map>
+#include <list>
+
+class BlobStore
+{
+public:
+	BlobStore();
+	virtual ~BlobStore();
+
+	bool Open(string fileName, size_t maxFileBytes);
+	void Close();
+	bool IsOpen() { return !m_fileName.empty(); }
+
+	//pointer stays valid until Close(), or until the same key is Put() again
+	bool Get(const string &key, const byte **ppDataOut, size_t *pSizeOut);
+	bool Get(const string &key, string *pValueOut);
+	bool Put(const string &key, const byte *pData, size_t size);
+	bool Put(const string &key, const string &value) { return Put(key, (const byte*)value.c_str(), value.length()); }
+
+	void GetKeys(vector<string> *pKeysOut); //in no particular order
+	size_t GetEntryCount() { return m_index.size(); }
+	size_t GetFileBytes() { return m_fileBytes; }
+
+protected:
+
+	struct Location
+	{
+		const byte *m_pData;
+		size_t m_size;
+		size_t m_fileOffset; //of the record header, so compacting can keep the file order
+	};
+
+	bool MapFile();
+	void UnmapFile();
+	size_t IndexRecords(); //returns how many bytes of the file were valid
+	bool Compact(size_t targetBytes);
+
+	string m_fileName;
+	size_t m_maxFileBytes = 0;
+	size_t m_fileBytes = 0;
+	bool m_bWarnedAboutCap = false;
+
+	const byte *m_pMapped = NULL;
+	size_t m_mappedBytes = 0;
+#ifdef WIN32
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;
+	HANDLE m_hMapping = NULL;
+#else
+	vector<byte> m_fileData; //no mapping, so just load it
+#endif
+
+	FILE *m_fpAppend = NULL;
+	std::unordered_map<string, Location> m_index;
+	std::list<vector<byte> > m_appended; //values added since Open(), the index points into these
+};
+
+#endif // BlobStore_h__
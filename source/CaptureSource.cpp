@@ -0,0 +1,107 @@
+#include "PlatformPrecomp.h"
+#include "CaptureSource.h"
+
+bool CaptureFrame::InitFromSoftSurface(SoftSurface *pSurf, bool bBottomUp)
+{
+	m_format = GetPixelFormatOfSurface(pSurf);
+	if (m_format == PIXEL_FORMAT_COUNT) return false;
+
+	m_pPixels = pSurf->GetPixelData();
+	m_width = pSurf->GetWidth();
+	m_height = pSurf->GetHeight();
+	m_pitch = pSurf->GetPitch();
+	m_bBottomUp = bBottomUp;
+	return true;
+}
+
+FileCaptureSource::FileCaptureSource()
+{
+}
+
+FileCaptureSource::~FileCaptureSource()
+{
+	Kill();
+}
+
+void FileCaptureSource::AddFile(string fileName)
+{
+	m_files.push_back(fileName);
+}
+
+int FileCaptureSource::AddFilesFromPattern(string pattern, int firstIndex)
+{
+	int count = 0;
+	char fileName[512];
+
+	while (true)
+	{
+		sprintf(fileName, pattern.c_str(), firstIndex + count);
+		if (!FileExists(fileName)) break;
+
+		m_files.push_back(fileName);
+		count++;
+	}
+
+	LogMsg("FileCaptureSource: Found %d files with %s", count, pattern.c_str());
+	return count;
+}
+
+bool FileCaptureSource::Capture(int x, int y, int width, int height, CaptureFrame *pFrameOut)
+{
+	if (m_files.empty())
+	{
+		LogMsg("FileCaptureSource: No files to capture from");
+		return false;
+	}
+
+	int fileIndex = m_nextFile;
+	m_nextFile = (m_nextFile + 1) % (int)m_files.size();
+
+	//if it's the same file as last time (only one file, usually) don't bother loading it again
+	if (fileIndex != m_loadedFile)
+	{
+		m_loadedFile = -1;
+		if (!m_image.LoadFile(m_files[fileIndex], SoftSurface::COLOR_KEY_NONE, false))
+		{
+			LogMsg("FileCaptureSource: Unable to load %s", m_files[fileIndex].c_str());
+			return false;
+		}
+		m_loadedFile = fileIndex;
+	}
+
+	ePixelFormat format = GetPixelFormatOfSurface(&m_image);
+	if (format == PIXEL_FORMAT_COUNT)
+	{
+		LogMsg("FileCaptureSource: %s isn't RGB or RGBA", m_files[fileIndex].c_str());
+		return false;
+	}
+
+	//clip the rect to the image
+	int left = rt_max(x, 0);
+	int top = rt_max(y, 0);
+	int right = rt_min(x + width, m_image.GetWidth());
+	int bottom = rt_min(y + height, m_image.GetHeight());
+
+	if (right <= left || bottom <= top)
+	{
+		LogMsg("FileCaptureSource: Capture rect is outside of the image");
+		return false;
+	}
+
+	//which row in memory holds the top of our rect depends on which way up the image is stored
+	int firstRow = m_bBottomUp ? m_image.GetHeight() - bottom : top;
+
+	pFrameOut->m_pPixels = m_image.GetPixelData() + firstRow * m_image.GetPitch() + left * GetPixelFormatBytesPerPixel(format);
+	pFrameOut->m_width = right - left;
+	pFrameOut->m_height = bottom - top;
+	pFrameOut->m_pitch = m_image.GetPitch();
+	pFrameOut->m_format = format;
+	pFrameOut->m_bBottomUp = m_bBottomUp;
+	return true;
+}
+
+void FileCaptureSource::Kill()
+{
+	m_image.Kill();
+	m_loadedFile = -1;
+}
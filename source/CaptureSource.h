@@ -0,0 +1,62 @@
+//Where WinDesktopCapture gets its pixels from.  The desktop one (GDICaptureSource in WinDesktopCapture.h) keeps its DIB
+//section around between captures, FileCaptureSource plays back image files so the capture path can be run without a
+//desktop to grab.
+
+#ifndef CaptureSource_h__
+#define CaptureSource_h__
+
+#include "PixelConvert.h"
+
+//Points into memory owned by the source, only good until its next Capture() or Kill()
+class CaptureFrame
+{
+public:
+
+	bool InitFromSoftSurface(SoftSurface *pSurf, bool bBottomUp); //false if it's not a format we handle
+
+	const byte *m_pPixels = NULL;
+	int m_width = 0;
+	int m_height = 0;
+	int m_pitch = 0; //bytes from one row to the next in memory
+	ePixelFormat m_format = PIXEL_FORMAT_COUNT;
+	bool m_bBottomUp = false; //if true the first row in memory is the bottom of the image
+};
+
+class CaptureSource
+{
+public:
+
+	virtual ~CaptureSource() {}
+
+	//Grabs this rect.  Anything it keeps around to do that is reused until the rect size changes
+	virtual bool Capture(int x, int y, int width, int height, CaptureFrame *pFrameOut) = 0;
+	virtual void Kill() {} //frees whatever it was holding onto
+};
+
+//Plays back a list of image files, the next one each Capture().  Loops when it runs out.  The capture rect is cropped out
+//of the image (and clipped to it), no scaling.
+class FileCaptureSource : public CaptureSource
+{
+public:
+
+	FileCaptureSource();
+	virtual ~FileCaptureSource();
+
+	void AddFile(string fileName);
+	int AddFilesFromPattern(string pattern, int firstIndex = 0); //printf style like "frames/frame_%04d.png", stops at the first missing one
+	int GetFileCount() { return (int)m_files.size(); }
+	void SetBottomUp(bool bBottomUp) { m_bBottomUp = bBottomUp; } //if whatever loads your images leaves them bottom row first
+
+	virtual bool Capture(int x, int y, int width, int height, CaptureFrame *pFrameOut);
+	virtual void Kill();
+
+protected:
+
+	vector<string> m_files;
+	int m_nextFile = 0;
+	int m_loadedFile = -1;
+	SoftSurface m_image;
+	bool m_bBottomUp = false;
+};
+
+#endif // CaptureSource_h__
@@ -0,0 +1,290 @@
+#include "PlatformPrecomp.h"
+#include "CurlRequest.h"
+#include "Base64Utils.h"
+#include "HTTPReactor.h"
+#include "App.h"
+
+CurlRequest::CurlRequest()
+{
+	m_downloaded.push_back(0);
+}
+
+CurlRequest::~CurlRequest()
+{
+	Reset();
+}
+
+void CurlRequest::Reset()
+{
+	if (m_pHandle)
+	{
+		GetApp()->GetHTTPReactor()->RemoveRequest(this, m_pHandle);
+		curl_easy_cleanup(m_pHandle);
+		m_pHandle = NULL;
+	}
+
+	if (m_pHeaderList)
+	{
+		curl_slist_free_all(m_pHeaderList);
+		m_pHeaderList = NULL;
+	}
+
+	m_bodyParts.clear();
+	m_bodySize = 0;
+	m_bodyTextBytes = 0;
+	m_bHasFormFields = false;
+	m_curBodyPart = 0;
+	m_curBodyPartOffset = 0;
+	m_bodyBytesSent = 0;
+	m_downloaded.clear();
+	m_downloaded.push_back(0);
+	m_state = STATE_IDLE;
+	m_error = ERROR_NONE;
+	m_errorString.clear();
+	m_httpResponseCode = 0;
+}
+
+void CurlRequest::Setup(string url)
+{
+	Reset();
+	m_url = url;
+	m_headers.clear();
+	m_finishedCallback.clear();
+}
+
+void CurlRequest::AddBodyPart(const BodyPart &part)
+{
+	m_bodyParts.push_back(part);
+	m_bodySize += part.m_sendSize;
+}
+
+void CurlRequest::AddBodyText(const string &text)
+{
+	BodyPart part;
+	part.m_type = BODY_PART_TEXT;
+	part.m_text = text;
+	part.m_sendSize = text.length();
+	AddBodyPart(part);
+	m_bodyTextBytes += text.length();
+}
+
+void CurlRequest::AddBodyBytes(const byte *pData, size_t size)
+{
+	BodyPart part;
+	part.m_type = BODY_PART_BYTES;
+	part.m_pData = pData;
+	part.m_dataSize = size;
+	part.m_sendSize = size;
+	AddBodyPart(part);
+}
+
+void CurlRequest::AddBodyBytesAsBase64(const byte *pData, size_t size)
+{
+	BodyPart part;
+	part.m_type = BODY_PART_BASE64;
+	part.m_pData = pData;
+	part.m_dataSize = size;
+	part.m_sendSize = Base64EncodedSize(size);
+	AddBodyPart(part);
+}
+
+static string URLEncode(const string &s)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	string out;
+	out.reserve(s.length() * 3);
+
+	for (size_t i = 0; i < s.length(); i++)
+	{
+		unsigned char c = s[i];
+		if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+		{
+			out += c;
+		}
+		else
+		{
+			out += '%';
+			out += hex[c >> 4];
+			out += hex[c & 15];
+		}
+	}
+	return out;
+}
+
+void CurlRequest::AddFormField(const string &name, const string &value)
+{
+	AddBodyText((m_bHasFormFields ? "&" : "") + name + "=" + URLEncode(value));
+	m_bHasFormFields = true;
+}
+
+void CurlRequest::SetError(eError error, string msg)
+{
+	m_error = error;
+	m_errorString = msg;
+	m_state = STATE_IDLE;
+	LogMsg("CurlRequest error: %s", msg.c_str());
+}
+
+size_t CurlRequest::OnWriteResponse(void *pContents, size_t size, size_t nmemb, void *pThisInstance)
+{
+	size_t realSize = size * nmemb;
+	CurlRequest *pMe = (CurlRequest*)pThisInstance;
+
+	//insert before the null at the end
+	pMe->m_downloaded.insert(pMe->m_downloaded.end() - 1, (byte*)pContents, (byte*)pContents + realSize);
+	return realSize;
+}
+
+size_t CurlRequest::OnReadBody(char *pBuffer, size_t size, size_t nitems, void *pThisInstance)
+{
+	return ((CurlRequest*)pThisInstance)->FillBody(pBuffer, size * nitems);
+}
+
+//curl calls this whenever it wants more to send, we write the body right into its buffer.  Base64 parts are encoded in
+//whole 4 char groups so we always restart on a 3 byte boundary of the source data, curl's buffer is way bigger than 4
+//bytes so that never stalls us.
+size_t CurlRequest::FillBody(char *pBuffer, size_t bufferSize)
+{
+	size_t written = 0;
+
+	while (m_curBodyPart < (int)m_bodyParts.size() && written < bufferSize)
+	{
+		BodyPart &part = m_bodyParts[m_curBodyPart];
+		size_t room = bufferSize - written;
+		size_t partLeft = part.m_sendSize - m_curBodyPartOffset;
+		size_t amount = 0;
+
+		switch (part.m_type)
+		{
+		case BODY_PART_TEXT:
+			amount = rt_min(room, partLeft);
+			memcpy(pBuffer + written, part.m_text.c_str() + m_curBodyPartOffset, amount);
+			break;
+
+		case BODY_PART_BYTES:
+			amount = rt_min(room, partLeft);
+			memcpy(pBuffer + written, part.m_pData + m_curBodyPartOffset, amount);
+			break;
+
+		case BODY_PART_BASE64:
+			{
+				size_t groups = rt_min(room, partLeft) / 4;
+				if (groups == 0)
+				{
+					//not enough room for a full group, send what we have and finish next time
+					m_bodyBytesSent += written;
+					return written;
+				}
+				size_t srcOffset = (m_curBodyPartOffset / 4) * 3;
+				size_t srcBytes = rt_min(groups * 3, part.m_dataSize - srcOffset);
+				amount = Base64Encode(part.m_pData + srcOffset, srcBytes, pBuffer + written);
+			}
+			break;
+		}
+
+		written += amount;
+		m_curBodyPartOffset += amount;
+
+		if (m_curBodyPartOffset >= part.m_sendSize)
+		{
+			m_curBodyPart++;
+			m_curBodyPartOffset = 0;
+		}
+	}
+
+	m_bodyBytesSent += written;
+	return written; //returning 0 tells curl we're done
+}
+
+bool CurlRequest::Start()
+{
+	if (m_pHandle)
+	{
+		//already going, start over
+		GetApp()->GetHTTPReactor()->RemoveRequest(this, m_pHandle);
+		curl_easy_cleanup(m_pHandle);
+		m_pHandle = NULL;
+	}
+	if (m_pHeaderList)
+	{
+		curl_slist_free_all(m_pHeaderList);
+		m_pHeaderList = NULL;
+	}
+
+	m_downloaded.clear();
+	m_downloaded.push_back(0);
+	m_curBodyPart = 0;
+	m_curBodyPartOffset = 0;
+	m_bodyBytesSent = 0;
+	m_error = ERROR_NONE;
+	m_errorString.clear();
+
+	m_pHandle = curl_easy_init();
+
+	if (!m_pHandle)
+	{
+		SetError(ERROR_CANT_START, "Unable to init curl");
+		return false;
+	}
+
+	curl_easy_setopt(m_pHandle, CURLOPT_URL, m_url.c_str());
+	curl_easy_setopt(m_pHandle, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(m_pHandle, CURLOPT_WRITEFUNCTION, OnWriteResponse);
+	curl_easy_setopt(m_pHandle, CURLOPT_WRITEDATA, this);
+	curl_easy_setopt(m_pHandle, CURLOPT_PRIVATE, this);
+	//manually set the certs otherwise it can't find it (a windows only issue?)
+	curl_easy_setopt(m_pHandle, CURLOPT_CAINFO, "curl-ca-bundle.crt");
+
+	if (!m_bodyParts.empty())
+	{
+		curl_easy_setopt(m_pHandle, CURLOPT_POST, 1L);
+		curl_easy_setopt(m_pHandle, CURLOPT_READFUNCTION, OnReadBody);
+		curl_easy_setopt(m_pHandle, CURLOPT_READDATA, this);
+		curl_easy_setopt(m_pHandle, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)m_bodySize);
+	}
+
+	for (size_t i = 0; i < m_headers.size(); i++)
+	{
+		m_pHeaderList = curl_slist_append(m_pHeaderList, m_headers[i].c_str());
+	}
+	//otherwise curl waits for a "100 continue" before sending big bodies, which just adds a round trip
+	m_pHeaderList = curl_slist_append(m_pHeaderList, "Expect:");
+	curl_easy_setopt(m_pHandle, CURLOPT_HTTPHEADER, m_pHeaderList);
+
+	m_state = STATE_ACTIVE;
+
+	if (!GetApp()->GetHTTPReactor()->AddRequest(this, m_pHandle))
+	{
+		curl_easy_cleanup(m_pHandle);
+		m_pHandle = NULL;
+		SetError(ERROR_CANT_START, "Unable to add request to the HTTP reactor");
+		return false;
+	}
+
+	return true;
+}
+
+void CurlRequest::OnTransferDone(CURLcode result)
+{
+	//the reactor already took it out of the multi handle
+	if (result != CURLE_OK)
+	{
+		SetError(ERROR_COMMUNICATION, curl_easy_strerror(result));
+	}
+	else
+	{
+		//like NetHTTP, a 400 or whatever still counts as finished, the caller gets the error json from the body
+		curl_easy_getinfo(m_pHandle, CURLINFO_RESPONSE_CODE, &m_httpResponseCode);
+		m_state = STATE_FINISHED;
+	}
+
+	curl_easy_cleanup(m_pHandle);
+	m_pHandle = NULL;
+
+	if (m_finishedCallback)
+	{
+		//copy it, the callback is allowed to Setup() this again, which clears it
+		CurlRequestCallback callback = m_finishedCallback;
+		callback(this);
+	}
+}
@@ -0,0 +1,110 @@
+//A non-blocking HTTPS request like NetHTTP that runs on the app's shared HTTPReactor and calls you back when it's done.
+//A POST body is described as a list of parts that get generated straight into curl's send buffer as it asks for data.
+//Big parts are borrowed (not copied) and can be base64'd on the fly, so a multi-megabyte OCR upload never exists as one
+//big string in memory and starts going out right away.  No body parts means it's a GET.
+
+#ifndef CurlRequest_h__
+#define CurlRequest_h__
+
+#include <curl/curl.h>
+#include <boost/function.hpp>
+
+class CurlRequest;
+typedef boost::function<void(CurlRequest*)> CurlRequestCallback;
+
+class CurlRequest
+{
+public:
+
+	enum eState
+	{
+		STATE_IDLE,
+		STATE_ACTIVE,
+		STATE_FINISHED
+	};
+
+	enum eError
+	{
+		ERROR_NONE,
+		ERROR_CANT_START,
+		ERROR_COMMUNICATION
+	};
+
+	CurlRequest();
+	virtual ~CurlRequest();
+
+	void Setup(string url); //full url, like "https://vision.googleapis.com/v1/images:annotate?key=blah"
+	void SetCustomHeaders(const vector<string> &headers) { m_headers = headers; }
+
+	//The body is sent in the order these are added.  Text is copied (it's small), the byte versions are NOT, the
+	//memory has to stay valid until the request finishes or Reset() is called
+	void AddBodyText(const string &text);
+	void AddBodyBytes(const byte *pData, size_t size);
+	void AddBodyBytesAsBase64(const byte *pData, size_t size);
+	void AddFormField(const string &name, const string &value); //url encoded, like NetHTTP::AddPostData with a name
+
+	//called when it finishes or fails (check GetError()).  It's fine to delete or restart the request from inside it
+	void SetFinishedCallback(CurlRequestCallback callback) { m_finishedCallback = callback; }
+
+	bool Start();
+	void Reset(); //aborts it if it was running, the callback is not called
+
+	void OnTransferDone(CURLcode result); //HTTPReactor calls this
+
+	eState GetState() { return m_state; }
+	eError GetError() { return m_error; }
+	string GetErrorString() { return m_errorString; }
+	long GetHTTPResponseCode() { return m_httpResponseCode; }
+	size_t GetPostDataSize() { return m_bodySize; }
+	size_t GetBytesUploaded() { return m_bodyBytesSent; }
+	size_t GetBodyBytesCopied() { return m_bodyTextBytes + m_bodyBytesSent; } //text parts are copied in, then everything is copied into curl's buffer
+	const byte * GetDownloadedData() { return &m_downloaded[0]; } //always null terminated
+	size_t GetDownloadedBytes() { return m_downloaded.size() - 1; }
+
+protected:
+
+	enum eBodyPartType
+	{
+		BODY_PART_TEXT,
+		BODY_PART_BYTES,
+		BODY_PART_BASE64
+	};
+
+	struct BodyPart
+	{
+		eBodyPartType m_type;
+		string m_text;
+		const byte *m_pData = NULL;
+		size_t m_dataSize = 0;
+		size_t m_sendSize = 0; //how many bytes this part turns into on the wire
+	};
+
+	static size_t OnReadBody(char *pBuffer, size_t size, size_t nitems, void *pThisInstance);
+	static size_t OnWriteResponse(void *pContents, size_t size, size_t nmemb, void *pThisInstance);
+	size_t FillBody(char *pBuffer, size_t bufferSize);
+	void AddBodyPart(const BodyPart &part);
+	void SetError(eError error, string msg);
+
+	CURL *m_pHandle = NULL;
+	struct curl_slist *m_pHeaderList = NULL;
+
+	string m_url;
+	vector<string> m_headers;
+	vector<BodyPart> m_bodyParts;
+	size_t m_bodySize = 0;
+	size_t m_bodyTextBytes = 0;
+	bool m_bHasFormFields = false;
+	CurlRequestCallback m_finishedCallback;
+
+	int m_curBodyPart = 0;
+	size_t m_curBodyPartOffset = 0; //in wire bytes
+	size_t m_bodyBytesSent = 0;
+
+	vector<byte> m_downloaded; //last byte is always a null so it can be parsed as a string
+	eState m_state = STATE_IDLE;
+	eError m_error = ERROR_NONE;
+	string m_errorString;
+	long m_httpResponseCode = 0;
+};
+
+#endif // CurlRequest_h__
@@ -37,9 +37,9 @@ string ExportToHTML::ExportToString(string mode, bool bAddEndingCRs)
 			}
 			else
 			{
-				for (int j = 0; j < comp->m_textArea.m_lines.size(); j++)
+				for (int j = 0; j < comp->m_textArea.GetLineCount(); j++)
 				{
-					preTranslatedText += comp->m_textArea.m_lines[j].m_text+"\r\n";
+					preTranslatedText += comp->m_textArea.GetLineText(j)+"\r\n";
 				}
 			}
 
@@ -98,13 +98,13 @@ void ExportToHTML::AddOverlays(string* pHTML, const string itemTemplate)
 		//if (comp->IsDialog(true)) //uh, I guess we don't actually treat dialog/line by line text differently now here
 		   
 			//we'll need to add our own line feeds
-			for (int j = 0; j < comp->m_textArea.m_lines.size(); j++)
+			for (int j = 0; j < comp->m_textArea.GetLineCount(); j++)
 			{
 				if (j > 0)
 				{
 					finalText += "\n";
 				}
-				finalText += comp->m_textArea.m_lines[j].m_text;
+				finalText += comp->m_textArea.GetLineText(j);
 			}
 		
 		StringReplace("\n", "<br>", finalText);
@@ -123,15 +123,16 @@ bool ExportToHTML::Export()
 	string msg = "Nothing to export";
 	string title = "Export to HTML";
 	
-	if (!FileExists("temp.jpg"))
+	string htmlDir = "htmlexport/";
+	RTCreateDirectory(htmlDir);
+
+	//the scan is kept in memory now, temp.jpg isn't written unless save_scan_to_temp_jpg is enabled
+	if (!GetApp()->GetGameLogicComponent()->SaveLastScanJPG(htmlDir + "background.jpg"))
 	{
-		msg = "Nothing to export, temp.jpg doesn't even exist.";
+		msg = "Nothing to export, nothing has been scanned yet.";
 		MessageBox(g_hWnd, _T(msg.c_str()), title.c_str(), NULL);
 		return false;
 	}
-	string htmlDir = "htmlexport/";
-	RTCreateDirectory(htmlDir);
-	CopyFile("temp.jpg", (htmlDir+"background.jpg").c_str(), false);
 
 	string htmlFile = "index.html";
 	RemoveFile(htmlDir + htmlFile);
@@ -0,0 +1,232 @@
+#include "PlatformPrecomp.h"
+#include "FrameChangeDetector.h"
+#include "SIMDUtils.h"
+
+//Each tile keeps 4 running hashes (lanes), pixel x of the tile goes into lane x%4 as lane = lane*31 + pixel.  That's the
+//same thing an SSE2 register of 4 pixels does with a shift and a subtract, so both versions give identical hashes.
+//Pixels past the right edge count as 0, alpha is ignored (BitBlt leaves junk in it).
+
+const uint32 C_FRAME_CHANGE_RGB_MASK = 0x00FFFFFF;
+
+static uint32 ReadPixel(const byte *pPixel, int bytesPerPixel)
+{
+	if (bytesPerPixel == 4)
+	{
+		uint32 pixel;
+		memcpy(&pixel, pPixel, 4);
+		return pixel & C_FRAME_CHANGE_RGB_MASK;
+	}
+
+	return pPixel[0] | (pPixel[1] << 8) | (pPixel[2] << 16);
+}
+
+static void HashTileScalar(const byte *pPixels, int count, int bytesPerPixel, uint32 *pLanes)
+{
+	for (int i = 0; i < C_FRAME_CHANGE_TILE_SIZE; i++)
+	{
+		uint32 pixel = i < count ? ReadPixel(pPixels + i * bytesPerPixel, bytesPerPixel) : 0;
+		pLanes[i & 3] = pLanes[i & 3] * 31 + pixel;
+	}
+}
+
+void HashTileRowScalar(const byte *pRow, int width, int bytesPerPixel, uint32 *pTileLanes)
+{
+	for (int x = 0; x < width; x += C_FRAME_CHANGE_TILE_SIZE)
+	{
+		HashTileScalar(pRow + x * bytesPerPixel, rt_min(C_FRAME_CHANGE_TILE_SIZE, width - x), bytesPerPixel, pTileLanes);
+		pTileLanes += 4;
+	}
+}
+
+#ifdef RT_SIMD_X86
+
+//4 byte pixels only, a whole tile row is two loads
+RT_TARGET_SSE2 static void HashTileRowSSE2(const byte *pRow, int width, uint32 *pTileLanes)
+{
+	const __m128i rgbMask = _mm_set1_epi32(C_FRAME_CHANGE_RGB_MASK);
+
+	int x = 0;
+	for (; x + C_FRAME_CHANGE_TILE_SIZE <= width; x += C_FRAME_CHANGE_TILE_SIZE)
+	{
+		__m128i lanes = _mm_loadu_si128((const __m128i*)pTileLanes);
+		__m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pRow + x * 4)), rgbMask);
+		__m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pRow + x * 4 + 16)), rgbMask);
+
+		lanes = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(lanes, 5), lanes), a);
+		lanes = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(lanes, 5), lanes), b);
+
+		_mm_storeu_si128((__m128i*)pTileLanes, lanes);
+		pTileLanes += 4;
+	}
+
+	if (x < width)
+	{
+		HashTileScalar(pRow + x * 4, width - x, 4, pTileLanes);
+	}
+}
+
+#endif
+
+bool FindChangedRect(const CaptureFrame &frame, const CaptureFrame &prevFrame, CL_Rect *pRectOut)
+{
+	if (frame.m_width != prevFrame.m_width || frame.m_height != prevFrame.m_height || frame.m_format != prevFrame.m_format
+		|| frame.m_bBottomUp != prevFrame.m_bBottomUp)
+	{
+		return false;
+	}
+
+	int bytesPerPixel = GetPixelFormatBytesPerPixel(frame.m_format);
+	int rowBytes = frame.m_width * bytesPerPixel;
+	int left = frame.m_width;
+	int right = 0;
+	int top = frame.m_height;
+	int bottom = 0;
+
+	for (int y = 0; y < frame.m_height; y++)
+	{
+		const byte *pRow = frame.m_pPixels + y * frame.m_pitch;
+		const byte *pPrevRow = prevFrame.m_pPixels + y * prevFrame.m_pitch;
+
+		//most rows don't change at all, memcmp rips through those
+		if (memcmp(pRow, pPrevRow, rowBytes) == 0) continue;
+
+		int imageY = frame.m_bBottomUp ? frame.m_height - 1 - y : y;
+		top = rt_min(top, imageY);
+		bottom = rt_max(bottom, imageY + 1);
+
+		//only need to look at the columns outside of what we've already found
+		for (int x = 0; x < left; x++)
+		{
+			if (memcmp(pRow + x * bytesPerPixel, pPrevRow + x * bytesPerPixel, bytesPerPixel) != 0)
+			{
+				left = x;
+				break;
+			}
+		}
+
+		for (int x = frame.m_width - 1; x >= right; x--)
+		{
+			if (memcmp(pRow + x * bytesPerPixel, pPrevRow + x * bytesPerPixel, bytesPerPixel) != 0)
+			{
+				right = x + 1;
+				break;
+			}
+		}
+	}
+
+	if (bottom <= top) return false; //nothing changed
+
+	*pRectOut = CL_Rect(left, top, right, bottom);
+	return true;
+}
+
+FrameChangeDetector::FrameChangeDetector()
+{
+}
+
+FrameChangeDetector::~FrameChangeDetector()
+{
+}
+
+void FrameChangeDetector::Reset()
+{
+	m_lastHashes.clear();
+	m_baselineHashes.clear();
+	m_stableFrames = 0;
+	m_changedTileCount = 0;
+}
+
+void FrameChangeDetector::HashFrame(const CaptureFrame &frame, vector<uint32> *pHashesOut)
+{
+	int tilesX = (frame.m_width + C_FRAME_CHANGE_TILE_SIZE - 1) / C_FRAME_CHANGE_TILE_SIZE;
+	int tilesY = (frame.m_height + C_FRAME_CHANGE_TILE_SIZE - 1) / C_FRAME_CHANGE_TILE_SIZE;
+
+	if (tilesX != m_tilesX || tilesY != m_tilesY)
+	{
+		//different size, nothing we had is comparable anymore
+		m_tilesX = tilesX;
+		m_tilesY = tilesY;
+		Reset();
+	}
+
+	int bytesPerPixel = GetPixelFormatBytesPerPixel(frame.m_format);
+	vector<uint32> &lanes = m_tileLanes;
+	lanes.resize(tilesX * 4);
+
+	pHashesOut->resize(tilesX * tilesY);
+
+	for (int tileY = 0; tileY < tilesY; tileY++)
+	{
+		std::fill(lanes.begin(), lanes.end(), 0);
+
+		int rowEnd = rt_min((tileY + 1) * C_FRAME_CHANGE_TILE_SIZE, frame.m_height);
+		for (int y = tileY * C_FRAME_CHANGE_TILE_SIZE; y < rowEnd; y++)
+		{
+			const byte *pRow = frame.m_pPixels + y * frame.m_pitch;
+
+#ifdef RT_SIMD_X86
+			if (bytesPerPixel == 4 && CPUHasSSE2())
+			{
+				HashTileRowSSE2(pRow, frame.m_width, &lanes[0]);
+				continue;
+			}
+#endif
+			HashTileRowScalar(pRow, frame.m_width, bytesPerPixel, &lanes[0]);
+		}
+
+		//fold the 4 lanes into one hash per tile
+		for (int tileX = 0; tileX < tilesX; tileX++)
+		{
+			const uint32 *pLanes = &lanes[tileX * 4];
+			uint32 hash = pLanes[0];
+			hash = hash * 0x9E3779B1 ^ pLanes[1];
+			hash = hash * 0x9E3779B1 ^ pLanes[2];
+			hash = hash * 0x9E3779B1 ^ pLanes[3];
+			pHashesOut->at(tileY * tilesX + tileX) = hash;
+		}
+	}
+}
+
+bool FrameChangeDetector::AddFrame(const CaptureFrame &frame)
+{
+	HashFrame(frame, &m_hashes);
+
+	if (m_hashes == m_lastHashes)
+	{
+		m_stableFrames++;
+	}
+	else
+	{
+		m_stableFrames = 1;
+		m_lastHashes = m_hashes;
+	}
+
+	if (m_baselineHashes.size() != m_hashes.size())
+	{
+		m_changedTileCount = (int)m_hashes.size(); //never scanned at this size, it's all new
+	}
+	else
+	{
+		m_changedTileCount = 0;
+		for (size_t i = 0; i < m_hashes.size(); i++)
+		{
+			if (m_hashes[i] != m_baselineHashes[i]) m_changedTileCount++;
+		}
+	}
+
+	if (m_changedTileCount > 0 && m_stableFrames >= m_stableFramesRequired)
+	{
+		m_baselineHashes = m_hashes;
+		return true;
+	}
+
+	return false;
+}
+
+void FrameChangeDetector::SetBaseline(const CaptureFrame &frame)
+{
+	HashFrame(frame, &m_hashes);
+	m_lastHashes = m_hashes;
+	m_baselineHashes = m_hashes;
+	m_changedTileCount = 0;
+}
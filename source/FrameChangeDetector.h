@@ -0,0 +1,54 @@
+//Decides when a watched area has changed enough to be worth scanning again.  Each frame is hashed in fixed sized tiles
+//(meant to be fed a downsampled frame, it's cheap either way), and we only say "scan" once some tiles differ from what
+//we last scanned AND the frame has stopped changing for a few samples, so text that types itself out letter by letter
+//gets one scan at the end instead of twenty.
+
+#ifndef FrameChangeDetector_h__
+#define FrameChangeDetector_h__
+
+#include "CaptureSource.h"
+
+const int C_FRAME_CHANGE_TILE_SIZE = 8; //in pixels of the frame we're given
+
+class FrameChangeDetector
+{
+public:
+
+	FrameChangeDetector();
+	virtual ~FrameChangeDetector();
+
+	void SetStableFramesRequired(int frames) { m_stableFramesRequired = rt_max(1, frames); }
+	void Reset(); //the next frame is treated as all new
+
+	//Returns true if it's time to scan.  When it does, this frame becomes the new "last scanned" one
+	bool AddFrame(const CaptureFrame &frame);
+
+	//Take this frame as what's on screen now without asking for a scan (like after our own overlay changed things)
+	void SetBaseline(const CaptureFrame &frame);
+
+	int GetChangedTileCount() { return m_changedTileCount; } //vs the last scanned frame, as of the last AddFrame()
+	int GetTileCount() { return (int)m_hashes.size(); }
+
+protected:
+
+	void HashFrame(const CaptureFrame &frame, vector<uint32> *pHashesOut);
+
+	vector<uint32> m_hashes; //the latest frame
+	vector<uint32> m_lastHashes; //the one before it
+	vector<uint32> m_baselineHashes; //the last one we scanned
+	vector<uint32> m_tileLanes; //scratch for one row of tiles
+	int m_tilesX = 0;
+	int m_tilesY = 0;
+	int m_stableFrames = 0;
+	int m_stableFramesRequired = 3;
+	int m_changedTileCount = 0;
+};
+
+//Exact compare of two frames, gives the smallest rect (top-left origin, right/bottom exclusive) holding every pixel that's
+//different.  False if they're identical.  Check they're the same size and format first, if not this also returns false.
+bool FindChangedRect(const CaptureFrame &frame, const CaptureFrame &prevFrame, CL_Rect *pRectOut);
+
+//Hashes one row of pixels into per tile accumulators, exposed so the SIMD version can be checked against this one
+void HashTileRowScalar(const byte *pRow, int width, int bytesPerPixel, uint32 *pTileLanes);
+
+#endif // FrameChangeDetector_h__
@@ -4,6 +4,10 @@
 #include "util/utf8.h"
 #include "util/MathUtils.h"
 #include "util/MiscUtils.h"
+#include "SIMDUtils.h"
+#include "WorkerPool.h"
+
+const int C_MAX_CACHED_FONT_SIZES = 24; //fitting text tries a lot of sizes, but we don't need to keep them all around
 
 FreeTypeManager::FreeTypeManager()
 {
@@ -50,6 +54,7 @@ bool FreeTypeManager::IsLoaded()
 
 void FreeTypeManager::MeasureText(rtRectf *pRectOut, const WCHAR *pText, int len, float pixelHeight, bool bUseActualWidthForSpacing)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
 	rtRectf dst(0, 0, 0, 0);
 	FontStateStack state;
@@ -58,22 +63,17 @@ void FreeTypeManager::MeasureText(rtRectf *pRectOut, const WCHAR *pText, int len
 	if (!IsLoaded())
 	{
 		*pRectOut = dst;
-		LogMsg("Error: Font not loaded!");
+		LogMsgFromAnyThread("Error: Font not loaded!");
 		return;
 	}
 
-	FT_Error error = FT_Set_Pixel_Sizes(
-		m_face,   /* handle to face object */
-		0,      /* pixel_width           */
-		pixelHeight);   /* pixel_height          */
-
-	if (error)
+	if (!SetActiveSize(pixelHeight))
 	{
-		LogMsg("FT_Set_Pixel_Sizes error");
+		*pRectOut = dst;
 		return;
 	}
+
 	use_kerning = FT_HAS_KERNING(m_face);
-	FT_GlyphSlot  slot = m_face->glyph;  /* a small shortcut */
 	int           pen_x, pen_y;
 	pen_x = 0;
 	//pen_y = (m_face->size->metrics.ascender + m_face->size->metrics.descender) / 64;
@@ -82,10 +82,10 @@ void FreeTypeManager::MeasureText(rtRectf *pRectOut, const WCHAR *pText, int len
 	float baseY = pen_y;
 
 	int lines = 1;
+	m_lastLineHeight = m_face->size->metrics.height >> 6; //until we've loaded a glyph to get the real one from
 	
 	for (int i = 0; i < len; i++)
 	{
-		m_lastLineHeight = slot->metrics.vertAdvance >> 6;
 		//OPTIMIZE: We don't really need IsFontCode and to calculate states to simply measure things.. unless later we handle font
 		//changes..
 		if (IsFontCode(&pText[i], &state))
@@ -103,23 +103,23 @@ void FreeTypeManager::MeasureText(rtRectf *pRectOut, const WCHAR *pText, int len
 			continue;
 		}
 
-		//get dimensions of thing
-		error = FT_Load_Char(m_face, pText[i], FT_LOAD_RENDER);
-		if (error)
+		//get dimensions of thing, only renders it if we need the real width
+		const GlyphCacheEntry *pGlyph = GetGlyph(pText[i], bUseActualWidthForSpacing);
+		if (!pGlyph)
 		{
-			LogMsg("Error loading font char");
+			LogMsgFromAnyThread("Error loading font char");
 			continue;  /* ignore errors */
 		}
+		m_lastLineHeight = pGlyph->m_vertAdvance;
+
 		if (bUseActualWidthForSpacing)
 		{
-			pen_x += slot->bitmap.width + 2;
+			pen_x += pGlyph->m_bitmapWidth + 2;
 		}
 		else
 		{
-			pen_x += slot->advance.x / 64;
+			pen_x += pGlyph->m_advanceX;
 		}
-		float letterHeight = slot->metrics.vertAdvance >> 6;
-		float offsetY = slot->metrics.vertAdvance >> 6;
 	
 		dst.bottom = rt_max(dst.bottom, lines* m_lastLineHeight);
 	}
@@ -158,6 +158,198 @@ float FreeTypeManager::GetAscenderAmount()
 	return m_face->size->metrics.ascender / 64;
 }
 
+bool FreeTypeManager::SetActiveSize(float pixelHeight)
+{
+	FT_UInt size = (FT_UInt)pixelHeight; //same truncation we used to get passing the float to FT_Set_Pixel_Sizes
+	if (size < 1) size = 1;
+
+	if (size == m_activeSize) return true;
+
+	std::map<FT_UInt, FT_Size>::iterator itor = m_sizes.find(size);
+
+	if (itor == m_sizes.end())
+	{
+		if (m_sizes.size() >= C_MAX_CACHED_FONT_SIZES)
+		{
+			//forget the size we haven't used in the longest time.  Glyphs cached at that size are still fine, they don't
+			//point to it
+			FT_UInt oldest = m_sizeLRU.back();
+			m_sizeLRU.pop_back();
+			FT_Done_Size(m_sizes[oldest]);
+			m_sizes.erase(oldest);
+		}
+
+		FT_Size ftSize;
+		FT_Error error = FT_New_Size(m_face, &ftSize);
+		if (error)
+		{
+			LogMsgFromAnyThread("FT_New_Size error");
+			return false;
+		}
+
+		FT_Activate_Size(ftSize);
+		error = FT_Set_Pixel_Sizes(m_face, 0, size);
+
+		if (error)
+		{
+			LogMsgFromAnyThread("FT_Set_Pixel_Sizes error");
+			FT_Done_Size(ftSize);
+			m_activeSize = 0;
+			return false;
+		}
+
+		m_sizes[size] = ftSize;
+	}
+	else
+	{
+		FT_Activate_Size(itor->second);
+		m_sizeLRU.remove(size);
+	}
+
+	m_sizeLRU.push_front(size);
+	m_activeSize = size;
+	return true;
+}
+
+size_t FreeTypeManager::GetEntryMemoryUsage(const GlyphCacheEntry &entry)
+{
+	//rough guess of the map and list node overhead too
+	return sizeof(GlyphCacheEntry) + (entry.m_pCoverage ? entry.m_pCoverage->capacity() : 0) + sizeof(uint64_t) * 6;
+}
+
+void FreeTypeManager::CopyBitmapIntoEntry(FT_Bitmap *pBitmap, GlyphCacheEntry *pEntry)
+{
+	pEntry->m_bitmapWidth = pBitmap->width;
+	pEntry->m_bitmapRows = pBitmap->rows;
+	std::shared_ptr<vector<byte> > pCoverage = std::make_shared<vector<byte> >(pBitmap->width * pBitmap->rows);
+	pEntry->m_pCoverage = pCoverage;
+
+	if (pCoverage->empty())
+	{
+		pEntry->m_bRendered = true; //a space or something, nothing to draw
+		return;
+	}
+
+	for (int y = 0; y < (int)pBitmap->rows; y++)
+	{
+		const byte *pSrc = pBitmap->buffer + y * pBitmap->pitch;
+		byte *pDest = &(*pCoverage)[y * pBitmap->width];
+
+		if (pBitmap->pixel_mode == FT_PIXEL_MODE_MONO)
+		{
+			//some fonts have embedded 1 bit bitmaps, turn them into full coverage
+			for (int x = 0; x < (int)pBitmap->width; x++)
+			{
+				pDest[x] = (pSrc[x >> 3] & (0x80 >> (x & 7))) ? 255 : 0;
+			}
+		}
+		else
+		{
+			memcpy(pDest, pSrc, pBitmap->width);
+		}
+	}
+
+	pEntry->m_bRendered = true;
+}
+
+void FreeTypeManager::TrimGlyphCache()
+{
+	//never removes the most recently used one, which is the one we just added
+	while (m_glyphCacheBytes > m_glyphCacheMaxBytes && m_glyphLRU.size() > 1)
+	{
+		std::unordered_map<uint64_t, GlyphCacheEntry>::iterator itor = m_glyphCache.find(m_glyphLRU.back());
+		m_glyphCacheBytes -= GetEntryMemoryUsage(itor->second);
+		m_glyphCache.erase(itor);
+		m_glyphLRU.pop_back();
+	}
+}
+
+const GlyphCacheEntry * FreeTypeManager::GetGlyph(WCHAR c, bool bNeedBitmap)
+{
+	//assumes SetActiveSize has already been called
+	uint64_t key = (uint64_t(m_activeSize) << 32) | uint32(c);
+
+	std::unordered_map<uint64_t, GlyphCacheEntry>::iterator itor = m_glyphCache.find(key);
+
+	if (itor != m_glyphCache.end() && (itor->second.m_bRendered || !bNeedBitmap))
+	{
+		m_glyphCacheHits++;
+		m_glyphLRU.splice(m_glyphLRU.begin(), m_glyphLRU, itor->second.m_lruIt);
+		return &itor->second;
+	}
+
+	m_glyphCacheMisses++;
+
+	//measuring only needs the metrics, so don't bother rendering unless we have to
+	FT_Error error = FT_Load_Char(m_face, c, bNeedBitmap ? FT_LOAD_RENDER : FT_LOAD_DEFAULT);
+	if (error)
+	{
+		return NULL;
+	}
+
+	GlyphCacheEntry *pEntry;
+
+	if (itor == m_glyphCache.end())
+	{
+		pEntry = &m_glyphCache[key];
+		m_glyphLRU.push_front(key);
+		pEntry->m_lruIt = m_glyphLRU.begin();
+	}
+	else
+	{
+		//we had the metrics, now we're adding the bitmap
+		pEntry = &itor->second;
+		m_glyphCacheBytes -= GetEntryMemoryUsage(*pEntry);
+		m_glyphLRU.splice(m_glyphLRU.begin(), m_glyphLRU, pEntry->m_lruIt);
+	}
+
+	FT_GlyphSlot slot = m_face->glyph;
+	pEntry->m_advanceX = slot->advance.x / 64;
+	pEntry->m_vertAdvance = slot->metrics.vertAdvance >> 6;
+
+	if (bNeedBitmap)
+	{
+		pEntry->m_bitmapLeft = slot->bitmap_left;
+		pEntry->m_bitmapTop = slot->bitmap_top;
+		CopyBitmapIntoEntry(&slot->bitmap, pEntry);
+	}
+
+	m_glyphCacheBytes += GetEntryMemoryUsage(*pEntry);
+	TrimGlyphCache();
+	return pEntry;
+}
+
+void FreeTypeManager::LogGlyphCacheStats()
+{
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	uint32 total = m_glyphCacheHits + m_glyphCacheMisses;
+	LogMsg("Glyph cache (%s): %u hits, %u misses (%.1f%% hit rate), %d glyphs using %d KB", GetFileNameFromString(m_fontName).c_str(),
+		m_glyphCacheHits, m_glyphCacheMisses, total == 0 ? 0.0f : float(m_glyphCacheHits) * 100.0f / float(total), 
+		(int)m_glyphCache.size(), (int)(m_glyphCacheBytes / 1024));
+}
+
+int FreeTypeManager::GetGlyphAdvance(WCHAR c, bool bUseActualWidthForSpacing)
+{
+	//assumes SetActiveSize has already been called, we're called once per glyph so don't want to do it here
+
+	//we only need the real bitmap if we're using its width for spacing
+	const GlyphCacheEntry *pGlyph = GetGlyph(c, bUseActualWidthForSpacing);
+	if (!pGlyph)
+	{
+		LogMsgFromAnyThread("Error loading font char");
+		return 0;
+	}
+
+	m_lastLineHeight = pGlyph->m_vertAdvance;
+
+	if (bUseActualWidthForSpacing)
+	{
+		return pGlyph->m_bitmapWidth + 2;
+	}
+	
+	return pGlyph->m_advanceX;
+}
+
 wstring FreeTypeManager::GetNextLine(const CL_Vec2f &textBounds, WCHAR **pCur, float pixelHeight, CL_Vec2f &vEnclosingSizeOut, bool bUseActualWidthForSpacing)
 {
 	//special case to cage a cr at the start
@@ -167,9 +359,15 @@ wstring FreeTypeManager::GetNextLine(const CL_Vec2f &textBounds, WCHAR **pCur, f
 		return L"";
 	}
 
-	rtRectf r(0, 0, 0, 0);
+	//This used to call MeasureText on the whole line again for each letter added, which was O(n^2) and really slow
+	//for long dialogs at big font sizes.  Now we keep a running pen position instead, this gives the exact same widths
+	//(and therefore the same breaks) as long as we skip color codes the same way MeasureText does.
+
 	wstring text;
 	int lastWrapPoint = 0;
+	int penX = 0; //width of everything we've measured so far
+	int measuredCount = 0; //how many chars of *pCur have been added to penX (or skipped as color codes)
+	FontStateStack state;
 
 	while (1)
 	{
@@ -204,9 +402,21 @@ wstring FreeTypeManager::GetNextLine(const CL_Vec2f &textBounds, WCHAR **pCur, f
 			continue;
 		}
 
-		MeasureText(&r, (*pCur), text.length(), pixelHeight, bUseActualWidthForSpacing);
+		//only measure the glyphs we haven't seen yet
+		while (measuredCount < (int)text.length())
+		{
+			if (IsFontCode(&(*pCur)[measuredCount], &state))
+			{
+				if ((*pCur)[measuredCount + 1] != 0) measuredCount++; //also advance past the color control code
+				measuredCount++;
+				continue;
+			}
+
+			penX += GetGlyphAdvance((*pCur)[measuredCount], bUseActualWidthForSpacing);
+			measuredCount++;
+		}
 
-		if (r.GetWidth() > textBounds.x)
+		if (penX > textBounds.x)
 		{
 			if (lastWrapPoint == 0)
 			{
@@ -225,7 +435,7 @@ wstring FreeTypeManager::GetNextLine(const CL_Vec2f &textBounds, WCHAR **pCur, f
 		}
 		else
 		{
-			if (vEnclosingSizeOut.x < r.GetWidth()) vEnclosingSizeOut.x = r.GetWidth();
+			if (vEnclosingSizeOut.x < penX) vEnclosingSizeOut.x = (float)penX;
 
 			if ((*pCur)[text.length()] == ' ')
 			{
@@ -244,6 +454,7 @@ wstring FreeTypeManager::GetNextLine(const CL_Vec2f &textBounds, WCHAR **pCur, f
 void FreeTypeManager::MeasureTextAndAddByLinesIntoDeque(const CL_Vec2f &textBounds, const wstring &text, deque<wstring> * pLines, float pixelHeight, 
 	CL_Vec2f &vEnclosingSizeOut, bool bUseActualWidthForSpacing)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
 	m_lastLineHeight = 0;
 
 	vEnclosingSizeOut = CL_Vec2f(0, 0);
@@ -251,9 +462,21 @@ void FreeTypeManager::MeasureTextAndAddByLinesIntoDeque(const CL_Vec2f &textBoun
 	if (textBounds.x == 0)
 	{
 
-		LogError("MeasureTextAndAddByLinesIntoDeque: Can't word wrap with boundsX being 0!");
+		LogMsgFromAnyThread("Error: MeasureTextAndAddByLinesIntoDeque: Can't word wrap with boundsX being 0!");
+		return;
+	}
+	if (!IsLoaded())
+	{
+		LogMsgFromAnyThread("Error: Font not loaded!");
 		return;
 	}
+
+	//set this once here instead of for every measurement, GetNextLine assumes it's been done
+	if (!SetActiveSize(pixelHeight))
+	{
+		return;
+	}
+
 	WCHAR *pCur = (WCHAR*)&text[0];
 	int lineCount = 0;
 	while (pCur[0])
@@ -269,45 +492,245 @@ void FreeTypeManager::MeasureTextAndAddByLinesIntoDeque(const CL_Vec2f &textBoun
 		lineCount++;
 	}
 
+	if (m_lastLineHeight == 0)
+	{
+		//only had blank lines or color codes, so no glyph was loaded to get it from
+		m_lastLineHeight = m_face->size->metrics.height >> 6;
+	}
+
 	vEnclosingSizeOut.y = float(lineCount)*GetLineHeight(pixelHeight);
 
 	vEnclosingSizeOut.y = rt_max(vEnclosingSizeOut.y, vEnclosingSizeOut.y - GetDescenderAmount());
 
 }
 
-
-void FreeTypeManager::draw_bitmap(FT_Bitmap*  bitmap,
-	FT_Int      x,
-	FT_Int      y, SoftSurface *pSoftSurf, glColorBytes fgColor)
+//Finds the biggest pixel height (up to maxPixelHeight) where the word wrapped text fits in textBounds.  FreeType only uses
+//whole pixel sizes anyway, so we binary search those instead of shrinking a little bit at a time, which could take dozens
+//of full layout passes when the starting size was way too big.  pLinesOut gets the wrapped lines at the size we picked.
+int FreeTypeManager::FitTextToBounds(const CL_Vec2f &textBounds, const wstring &text, deque<wstring> *pLinesOut, float maxPixelHeight, float &pixelHeightOut,
+	CL_Vec2f &vEnclosingSizeOut, bool bUseActualWidthForSpacing)
 {
-	FT_Int  i, j, p, q;
-	FT_Int  x_max = x + bitmap->width;
-	FT_Int  y_max = y + bitmap->rows;
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	int passes = 0;
+	int lo = 1;
+	int hi = rt_max(1, (int)maxPixelHeight);
+	int best = 0;
+	deque<wstring> lines;
+	CL_Vec2f size;
 
+	if (pLinesOut) pLinesOut->clear();
 
-	/* for simplicity, we assume that `bitmap->pixel_mode' */
-	/* is `FT_PIXEL_MODE_GRAY' (i.e., not a bitmap font)   */
-	byte bwvalue = 0;
+	//most of the time it fits at the size we asked for, so try that first
+	passes++;
+	MeasureTextAndAddByLinesIntoDeque(textBounds, text, pLinesOut ? &lines : NULL, (float)hi, size, bUseActualWidthForSpacing);
 
-	for (i = x, p = 0; i < x_max; i++, p++)
+	if (size.y <= textBounds.y)
+	{
+		best = hi;
+		vEnclosingSizeOut = size;
+		if (pLinesOut) pLinesOut->swap(lines);
+	}
+	else
 	{
-		for (j = y, q = 0; j < y_max; j++, q++)
+		hi--;
+
+		while (lo <= hi)
 		{
-			if (i < 0 || j < 0 ||
-				i >= pSoftSurf->GetWidth() || j >= pSoftSurf->GetHeight())
-				continue;
+			int mid = (lo + hi) / 2;
+			passes++;
+			lines.clear();
+			MeasureTextAndAddByLinesIntoDeque(textBounds, text, pLinesOut ? &lines : NULL, (float)mid, size, bUseActualWidthForSpacing);
 			
-			byte bwvalue = bitmap->buffer[q * bitmap->width + p];
-			float alpha = (float)bwvalue / 255.0f;
-
-			if (bwvalue > 0)
+			if (size.y <= textBounds.y)
 			{
-				pSoftSurf->SetPixel(i, j, glColorBytes(fgColor.r*alpha, fgColor.g*alpha, fgColor.b*alpha, 255));
+				//fits, but maybe something bigger does too
+				best = mid;
+				vEnclosingSizeOut = size;
+				if (pLinesOut) pLinesOut->swap(lines);
+				lo = mid + 1;
 			}
+			else
+			{
+				hi = mid - 1;
+			}
+		}
 
-			//image[j][i] |= bitmap->buffer[q * bitmap->width + p];
+		if (best == 0)
+		{
+			//nothing fit, the last thing we tried was the smallest size so just go with that
+			best = 1;
+			vEnclosingSizeOut = size;
+			if (pLinesOut) pLinesOut->swap(lines);
 		}
 	}
+
+	pixelHeightOut = (float)best;
+	return passes;
+}
+
+//The glyph blending below does color = fg*coverage + dest*(1-coverage) so overlapping glyphs blend into each other
+//instead of punching dark boxes in their neighbors.  Anything a glyph touches becomes opaque, same as we've always done,
+//so on a clear background the result is the same as before.
+
+inline byte DivideBy255(uint32 x)
+{
+	//exact rounded x/255 for anything up to 255*255
+	x += 128;
+	return byte((x + (x >> 8)) >> 8);
+}
+
+static void BlendCoverageSpanScalar(byte *pDest, const byte *pCoverage, int count, const glColorBytes &fg)
+{
+	for (int i = 0; i < count; i++, pDest += 4)
+	{
+		uint32 a = pCoverage[i];
+		if (a == 0) continue;
+
+		uint32 inv = 255 - a;
+		pDest[0] = DivideBy255(fg.r * a + pDest[0] * inv);
+		pDest[1] = DivideBy255(fg.g * a + pDest[1] * inv);
+		pDest[2] = DivideBy255(fg.b * a + pDest[2] * inv);
+		pDest[3] = 255;
+	}
+}
+
+#ifdef RT_SIMD_X86
+
+//same math as the scalar version on 16 bit lanes, the 257 multiply high is the same divide by 255 trick as DivideBy255
+static void BlendCoverageSpanSSE2(byte *pDest, const byte *pCoverage, int count, const glColorBytes &fg)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i fgColor = _mm_setr_epi16(fg.r, fg.g, fg.b, 255, fg.r, fg.g, fg.b, 255);
+	const __m128i all255 = _mm_set1_epi16(255);
+	const __m128i round = _mm_set1_epi16(128);
+	const __m128i mul257 = _mm_set1_epi16(257);
+	const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		int coverage4;
+		memcpy(&coverage4, pCoverage + i, 4);
+		if (coverage4 == 0) continue; //the empty space around letters is really common
+
+		//spread each pixel's coverage over its 4 channels
+		__m128i cov = _mm_cvtsi32_si128(coverage4);
+		cov = _mm_unpacklo_epi8(cov, cov);
+		cov = _mm_unpacklo_epi16(cov, cov);
+		__m128i covLo = _mm_unpacklo_epi8(cov, zero);
+		__m128i covHi = _mm_unpackhi_epi8(cov, zero);
+
+		__m128i *pPixels = (__m128i*)(pDest + i * 4);
+		__m128i dest = _mm_loadu_si128(pPixels);
+		__m128i destLo = _mm_unpacklo_epi8(dest, zero);
+		__m128i destHi = _mm_unpackhi_epi8(dest, zero);
+
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(fgColor, covLo), _mm_mullo_epi16(destLo, _mm_sub_epi16(all255, covLo)));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(fgColor, covHi), _mm_mullo_epi16(destHi, _mm_sub_epi16(all255, covHi)));
+		lo = _mm_mulhi_epu16(_mm_add_epi16(lo, round), mul257);
+		hi = _mm_mulhi_epu16(_mm_add_epi16(hi, round), mul257);
+
+		__m128i touched = _mm_andnot_si128(_mm_cmpeq_epi8(cov, zero), alphaMask);
+		_mm_storeu_si128(pPixels, _mm_or_si128(_mm_packus_epi16(lo, hi), touched));
+	}
+
+	BlendCoverageSpanScalar(pDest + i * 4, pCoverage + i, count - i, fg);
+}
+
+RT_TARGET_AVX2 static void BlendCoverageSpanAVX2(byte *pDest, const byte *pCoverage, int count, const glColorBytes &fg)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i fgColor = _mm256_setr_epi16(fg.r, fg.g, fg.b, 255, fg.r, fg.g, fg.b, 255, fg.r, fg.g, fg.b, 255, fg.r, fg.g, fg.b, 255);
+	const __m256i all255 = _mm256_set1_epi16(255);
+	const __m256i round = _mm256_set1_epi16(128);
+	const __m256i mul257 = _mm256_set1_epi16(257);
+	const __m256i alphaMask = _mm256_set1_epi32(0xFF000000);
+	const __m256i spread = _mm256_set1_epi32(0x01010101);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i coverage8 = _mm_loadl_epi64((const __m128i*)(pCoverage + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(coverage8, _mm_setzero_si128())) == 0xFFFF) continue;
+
+		//unpacks work inside each 128 bit half, but since we pack back the same way the pixel order comes out right
+		__m256i cov = _mm256_mullo_epi32(_mm256_cvtepu8_epi32(coverage8), spread);
+		__m256i covLo = _mm256_unpacklo_epi8(cov, zero);
+		__m256i covHi = _mm256_unpackhi_epi8(cov, zero);
+
+		__m256i *pPixels = (__m256i*)(pDest + i * 4);
+		__m256i dest = _mm256_loadu_si256(pPixels);
+		__m256i destLo = _mm256_unpacklo_epi8(dest, zero);
+		__m256i destHi = _mm256_unpackhi_epi8(dest, zero);
+
+		__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(fgColor, covLo), _mm256_mullo_epi16(destLo, _mm256_sub_epi16(all255, covLo)));
+		__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(fgColor, covHi), _mm256_mullo_epi16(destHi, _mm256_sub_epi16(all255, covHi)));
+		lo = _mm256_mulhi_epu16(_mm256_add_epi16(lo, round), mul257);
+		hi = _mm256_mulhi_epu16(_mm256_add_epi16(hi, round), mul257);
+
+		__m256i touched = _mm256_andnot_si256(_mm256_cmpeq_epi8(cov, zero), alphaMask);
+		_mm256_storeu_si256(pPixels, _mm256_or_si256(_mm256_packus_epi16(lo, hi), touched));
+	}
+
+	BlendCoverageSpanSSE2(pDest + i * 4, pCoverage + i, count - i, fg);
+}
+
+#endif
+
+typedef void(*BlendCoverageSpanFunc)(byte *pDest, const byte *pCoverage, int count, const glColorBytes &fg);
+
+static BlendCoverageSpanFunc GetBlendCoverageSpanFunc()
+{
+#ifdef RT_SIMD_X86
+	if (CPUHasAVX2()) return BlendCoverageSpanAVX2;
+	if (CPUHasSSE2()) return BlendCoverageSpanSSE2;
+#endif
+	return BlendCoverageSpanScalar;
+}
+
+void FreeTypeManager::draw_bitmap(const PlacedGlyph &glyph, SoftSurface *pSoftSurf, glColorBytes fgColor)
+{
+	static BlendCoverageSpanFunc blendSpan = GetBlendCoverageSpanFunc();
+
+	assert(pSoftSurf->GetSurfaceType() == SoftSurface::SURFACE_RGBA);
+
+	//clip once for the whole glyph instead of checking every pixel
+	int x = glyph.m_x;
+	int y = glyph.m_y;
+	int srcX = 0;
+	int srcY = 0;
+	int width = glyph.m_width;
+	int rows = glyph.m_rows;
+
+	if (x < 0)
+	{
+		srcX = -x;
+		width += x;
+		x = 0;
+	}
+	if (y < 0)
+	{
+		srcY = -y;
+		rows += y;
+		y = 0;
+	}
+
+	width = rt_min(width, pSoftSurf->GetWidth() - x);
+	rows = rt_min(rows, pSoftSurf->GetHeight() - y);
+
+	if (width <= 0 || rows <= 0) return;
+
+	//row major so we walk memory in order
+	int pitch = pSoftSurf->GetPitch();
+	byte *pDestRow = pSoftSurf->GetPixelData() + y * pitch + x * 4;
+	const byte *pCoverageRow = &(*glyph.m_pCoverage)[srcY * glyph.m_width + srcX];
+
+	for (int j = 0; j < rows; j++)
+	{
+		blendSpan(pDestRow, pCoverageRow, width, fgColor);
+		pDestRow += pitch;
+		pCoverageRow += glyph.m_width;
+	}
 }
 
 template <typename T>
@@ -343,104 +766,144 @@ float FreeTypeManager::GetLineHeight(float pixelHeight)
 Surface * FreeTypeManager::TextToSurface(CL_Vec2f surfaceSizeToCreate, vector<unsigned short> utf16line, float pixelHeight,
 	glColorBytes bgColor, glColorBytes fgColor, bool bUseActualWidthForSpacing, vector<CL_Vec2f> *pOptionalLineStarts,
 	float wordWrapX)
+{
+	SoftSurface softSurf;
+
+	if (!TextToSoftSurface(&softSurf, surfaceSizeToCreate, utf16line, pixelHeight, bgColor, fgColor, bUseActualWidthForSpacing,
+		pOptionalLineStarts, wordWrapX))
+	{
+		return NULL;
+	}
+
+	Surface *pSurf = new Surface();
+	softSurf.FlipY();
+	pSurf->InitFromSoftSurface(&softSurf, true, 0);
+
+	return pSurf;
+}
+
+bool FreeTypeManager::TextToSoftSurface(SoftSurface *pSoftSurfOut, CL_Vec2f surfaceSizeToCreate, const vector<unsigned short> &utf16line,
+	float pixelHeight, glColorBytes bgColor, glColorBytes fgColor, bool bUseActualWidthForSpacing, const vector<CL_Vec2f> *pOptionalLineStarts,
+	float wordWrapX, bool bShrinkToFit)
 {
 	int minSize = 10;
 
-	FT_Bool       use_kerning;
 	if (surfaceSizeToCreate.y < minSize) surfaceSizeToCreate.y = minSize;
 	if (pixelHeight < minSize) pixelHeight = minSize;
 
 	//if (pixelHeight < 16) pixelHeight = 20;
-	
-	FT_Error error = FT_Set_Pixel_Sizes(
-		m_face,   /* handle to face object */
-		0,      /* pixel_width           */
-		pixelHeight);   /* pixel_height          */
 
-	if (error)
+	//Lay everything out while we have the face and the cache, then let go and do the clearing and blending, which is
+	//most of the work, so other workers can be rasterizing at the same time.  The glyphs hold onto their coverage.
+	vector<PlacedGlyph> placed;
+	placed.reserve(utf16line.size());
+	int inkRight = 0;
+	int inkBottom = 0;
+
 	{
-		LogMsg("FT_Set_Pixel_Sizes error");
-		return NULL;
-	}
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
-	use_kerning = FT_HAS_KERNING(m_face);
+		if (!SetActiveSize(pixelHeight))
+		{
+			return false;
+		}
 
-	SoftSurface softSurf;
-	softSurf.Init(surfaceSizeToCreate.x, surfaceSizeToCreate.y, SoftSurface::SURFACE_RGBA);
-	softSurf.FillColor(bgColor);
+		int           pen_x, pen_y;
+		int lastAdvanceX = 0; //of the last glyph we placed
+		int lastVertAdvance = m_face->size->metrics.height >> 6; //until we've placed a glyph to get the real one from
 
-	FT_GlyphSlot  slot = m_face->glyph;  /* a small shortcut */
-	int           pen_x, pen_y;
+		pen_x = 0;
+		//pen_y = (m_face->size->metrics.ascender+ m_face->size->metrics.descender) / 64;
+		pen_y = GetAscenderAmount();
+		float baseY = pen_y;
 
-	pen_x = 0;
-	//pen_y = (m_face->size->metrics.ascender+ m_face->size->metrics.descender) / 64;
-	pen_y = GetAscenderAmount();
-	float baseY = pen_y;
-	
-	FT_UInt lastChar = 0;
-	float kerning = 0;
-	int lineCount = 0;
-
-	if (wordWrapX == 0 && pOptionalLineStarts && pOptionalLineStarts->size() > lineCount)
-	{
-		pen_x = pOptionalLineStarts->at(lineCount).x;
-		pen_y = baseY + pOptionalLineStarts->at(lineCount).y;
-	}
+		int lineCount = 0;
 
-	for (int n = 0; n < utf16line.size(); n++)
-	{
-		/* load glyph image into the slot (erase previous one) */
-	
-		bool bForceCR = (wordWrapX > 0 && pen_x != 0 && pen_x > (wordWrapX - (slot->advance.x / 64)));
+		if (wordWrapX == 0 && pOptionalLineStarts && pOptionalLineStarts->size() > lineCount)
+		{
+			pen_x = pOptionalLineStarts->at(lineCount).x;
+			pen_y = baseY + pOptionalLineStarts->at(lineCount).y;
+		}
 
-		if (utf16line[n] == '\n' || bForceCR)
+		for (int n = 0; n < utf16line.size(); n++)
 		{
+			bool bForceCR = (wordWrapX > 0 && pen_x != 0 && pen_x > (wordWrapX - lastAdvanceX));
 
-			if (bForceCR && utf16line[n] != '\n')
+			if (utf16line[n] == '\n' || bForceCR)
 			{
-				n--; //do this letter again
+
+				if (bForceCR && utf16line[n] != '\n')
+				{
+					n--; //do this letter again
+				}
+				pen_x = 0;
+				pen_y += lastVertAdvance;
+				lineCount++;
+				if (wordWrapX == 0 && pOptionalLineStarts && pOptionalLineStarts->size() > lineCount)
+				{
+					pen_x = pOptionalLineStarts->at(lineCount).x;
+					pen_y = baseY+pOptionalLineStarts->at(lineCount).y;
+				}
+				continue;
 			}
-			pen_x = 0;
-			pen_y += slot->metrics.vertAdvance >> 6;
-			lastChar = 0;
-			lineCount++;
-			if (wordWrapX == 0 && pOptionalLineStarts && pOptionalLineStarts->size() > lineCount)
+
+			const GlyphCacheEntry *pGlyph = GetGlyph(utf16line[n], true);
+			if (!pGlyph)
+				continue;  /* ignore errors */
+
+			inkRight = rt_max(inkRight, pen_x + pGlyph->m_bitmapLeft + pGlyph->m_bitmapWidth);
+			inkBottom = rt_max(inkBottom, pen_y - pGlyph->m_bitmapTop + pGlyph->m_bitmapRows);
+
+			if (pGlyph->m_pCoverage && !pGlyph->m_pCoverage->empty())
 			{
-				pen_x = pOptionalLineStarts->at(lineCount).x;
-				pen_y = baseY+pOptionalLineStarts->at(lineCount).y;
+				placed.push_back(PlacedGlyph());
+				PlacedGlyph &glyph = placed.back();
+				glyph.m_x = pen_x + pGlyph->m_bitmapLeft;
+				glyph.m_y = pen_y - pGlyph->m_bitmapTop;
+				glyph.m_width = pGlyph->m_bitmapWidth;
+				glyph.m_rows = pGlyph->m_bitmapRows;
+				glyph.m_pCoverage = pGlyph->m_pCoverage;
 			}
-			continue;
-		}
 
-		error = FT_Load_Char(m_face, utf16line[n], FT_LOAD_RENDER);
-		if (error)
-			continue;  /* ignore errors */
+			lastAdvanceX = pGlyph->m_advanceX;
+			lastVertAdvance = pGlyph->m_vertAdvance;
 
-		draw_bitmap(&slot->bitmap,
-			pen_x + slot->bitmap_left,
-			pen_y-slot->bitmap_top, &softSurf, fgColor);
-			
-		/* increment pen position */
-		if (bUseActualWidthForSpacing)
-		{
-			pen_x += slot->bitmap.width + 2;
-		}
-		else
-		{
-			pen_x += slot->advance.x / 64;
+			/* increment pen position */
+			if (bUseActualWidthForSpacing)
+			{
+				pen_x += pGlyph->m_bitmapWidth + 2;
+			}
+			else
+			{
+				pen_x += pGlyph->m_advanceX;
+			}
 		}
-		lastChar = utf16line[n];
 	}
 
-	Surface *pSurf = new Surface();
-	softSurf.FlipY();
-	pSurf->InitFromSoftSurface(&softSurf, true, 0);
+	//With bShrinkToFit, surfaceSizeToCreate is only the most it can be.  We only allocate (and clear, and later upload) as
+	//much as the glyphs actually landed on, the guessed sizes are usually way too big.
+	if (bShrinkToFit)
+	{
+		//rounded up to 4 so rows stay aligned for the texture upload
+		surfaceSizeToCreate.x = rt_min(surfaceSizeToCreate.x, (float)((rt_max(inkRight, 1) + 3) & ~3));
+		surfaceSizeToCreate.y = rt_min(surfaceSizeToCreate.y, (float)((rt_max(inkBottom, 1) + 3) & ~3));
+	}
 
-	return pSurf;
+	SoftSurface &softSurf = *pSoftSurfOut;
+	softSurf.Init(surfaceSizeToCreate.x, surfaceSizeToCreate.y, SoftSurface::SURFACE_RGBA);
+	softSurf.FillColor(bgColor);
+
+	for (int i = 0; i < (int)placed.size(); i++)
+	{
+		draw_bitmap(placed[i], &softSurf, fgColor);
+	}
+
+	return true;
 }
 
 int FreeTypeManager::GetKerningOffset(FT_UInt leftGlyph, FT_UInt rightGlyph)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
 	FT_Vector kerning;
 	int error;
 
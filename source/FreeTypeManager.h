@@ -13,10 +13,46 @@
 #include <ft2build.h>
 
 #include FT_FREETYPE_H
+#include FT_SIZES_H
 #include "GUI/RTFont.h"
+#include <unordered_map>
+#include <list>
+#include <mutex>
+#include <memory>
 
 typedef std::deque<FontState> FontStateStack;
 
+//What we remember about a single glyph at a single pixel size.  Measuring only needs the metrics, the coverage bitmap
+//is only rendered the first time something actually wants to draw it (or needs its real width)
+class GlyphCacheEntry
+{
+public:
+
+	int m_advanceX = 0; //in pixels, same as slot->advance.x / 64
+	int m_vertAdvance = 0; //in pixels, same as slot->metrics.vertAdvance >> 6
+	bool m_bRendered = false;
+	int m_bitmapLeft = 0;
+	int m_bitmapTop = 0;
+	int m_bitmapWidth = 0;
+	int m_bitmapRows = 0;
+	//8 bit coverage, m_bitmapWidth*m_bitmapRows, tightly packed, only valid if m_bRendered.  Shared so a draw that's already
+	//let go of the lock can keep using it even if the cache drops this entry
+	std::shared_ptr<const vector<byte> > m_pCoverage;
+	std::list<uint64_t>::iterator m_lruIt;
+};
+
+//Where TextToSoftSurface is going to draw a glyph, laid out while it has the lock and drawn after
+class PlacedGlyph
+{
+public:
+
+	int m_x = 0;
+	int m_y = 0;
+	int m_width = 0;
+	int m_rows = 0;
+	std::shared_ptr<const vector<byte> > m_pCoverage;
+};
+
 class FreeTypeManager
 {
 public:
@@ -28,26 +64,46 @@ public:
 	void MeasureText(rtRectf *pRectOut, const WCHAR *pText, int len, float pixelHeight, bool bUseActualWidthForSpacing);
 	
 	
-	Surface * FreeTypeManager::TextToSurface(CL_Vec2f surfaceSizeToCreate, vector<unsigned short> utf16line, float pixelHeight,
+	Surface * TextToSurface(CL_Vec2f surfaceSizeToCreate, vector<unsigned short> utf16line, float pixelHeight,
 		glColorBytes bgColor, glColorBytes fgColor, bool bUseActualWidthForSpacing, vector<CL_Vec2f> *pOptionalLineStarts, float wordWrapX);
-	Surface * FreeTypeManager::TextToSurface(CL_Vec2f surfaceSizeToCreate, string msg, float pixelHeight,
+	Surface * TextToSurface(CL_Vec2f surfaceSizeToCreate, string msg, float pixelHeight,
 		glColorBytes bgColor, glColorBytes fgColor, bool bUseActualWidthForSpacing, vector<CL_Vec2f> *pOptionalLineStarts, float wordWrapX);
 
+	//Does the CPU part of TextToSurface, safe to call from a worker thread.  The result is not flipped yet, the caller
+	//uploads it to a Surface on the main thread.  bShrinkToFit makes it only as big as the text actually drawn, with
+	//surfaceSizeToCreate as the max
+	bool TextToSoftSurface(SoftSurface *pSoftSurfOut, CL_Vec2f surfaceSizeToCreate, const vector<unsigned short> &utf16line, float pixelHeight,
+		glColorBytes bgColor, glColorBytes fgColor, bool bUseActualWidthForSpacing, const vector<CL_Vec2f> *pOptionalLineStarts, float wordWrapX,
+		bool bShrinkToFit = false);
+
 	int GetKerningOffset(FT_UInt c, FT_UInt pc);
 	bool Init();
 
 	void MeasureTextAndAddByLinesIntoDeque(const CL_Vec2f &textBounds, const wstring &text, deque<wstring> * pLines, float pixelHeight, CL_Vec2f &vEnclosingSizeOut,
 		bool bUseActualWidthForSpacing);
+	int FitTextToBounds(const CL_Vec2f &textBounds, const wstring &text, deque<wstring> *pLinesOut, float maxPixelHeight, float &pixelHeightOut,
+		CL_Vec2f &vEnclosingSizeOut, bool bUseActualWidthForSpacing); //returns how many layout passes it took
 	void SetFontName(string fontName) { m_fontName = fontName; }
 
+	void SetGlyphCacheMaxBytes(size_t maxBytes) { m_glyphCacheMaxBytes = maxBytes; }
+	uint32 GetGlyphCacheHits() { return m_glyphCacheHits; }
+	uint32 GetGlyphCacheMisses() { return m_glyphCacheMisses; }
+	void LogGlyphCacheStats();
+
 protected:
 
 	float GetDescenderAmount();
 	float GetAscenderAmount();
 
+	bool SetActiveSize(float pixelHeight);
+	const GlyphCacheEntry * GetGlyph(WCHAR c, bool bNeedBitmap);
+	void CopyBitmapIntoEntry(FT_Bitmap *pBitmap, GlyphCacheEntry *pEntry);
+	size_t GetEntryMemoryUsage(const GlyphCacheEntry &entry);
+	void TrimGlyphCache();
+	int GetGlyphAdvance(WCHAR c, bool bUseActualWidthForSpacing);
 	wstring GetNextLine(const CL_Vec2f& textBounds, WCHAR** pCur, float pixelHeight, CL_Vec2f& vEnclosingSizeOut, bool bUseActualWidthForSpacing);
 
-	void draw_bitmap(FT_Bitmap* bitmap, FT_Int x, FT_Int y, SoftSurface *pSoftSurf, glColorBytes fgColor);
+	void draw_bitmap(const PlacedGlyph &glyph, SoftSurface *pSoftSurf, glColorBytes fgColor);
 
 	float GetLineHeight(float pixelHeight);
 	FT_Library  m_library = NULL;
@@ -56,6 +112,24 @@ protected:
 	float m_lastLineHeight = 0;
 	string m_fontName;
 
+	//glyph cache, the face is implied as each FreeTypeManager only has one, so the key is (pixel size << 32) | char
+	std::unordered_map<uint64_t, GlyphCacheEntry> m_glyphCache;
+	std::list<uint64_t> m_glyphLRU; //front is most recently used
+	size_t m_glyphCacheBytes = 0;
+	size_t m_glyphCacheMaxBytes = 1024 * 1024 * 8;
+	uint32 m_glyphCacheHits = 0;
+	uint32 m_glyphCacheMisses = 0;
+
+	//one FT_Size per pixel size we use, so switching between them doesn't have to recompute the scaling each time
+	std::map<FT_UInt, FT_Size> m_sizes;
+	std::list<FT_UInt> m_sizeLRU; //front is most recently used
+	FT_UInt m_activeSize = 0;
+
+	//the face, the active size and the glyph cache are all shared state, so the public functions that touch them lock
+	//this.  Recursive because FitTextToBounds and friends call each other.  TextToSoftSurface only holds it while laying
+	//the glyphs out, the clearing and blending (most of the work) happen after, so workers can rasterize at the same time.
+	std::recursive_mutex m_mutex;
+
 private:
 };
 
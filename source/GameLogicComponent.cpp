@@ -7,10 +7,14 @@
 #include "TextAreaComponent.h"
 #include "GUIHelp.h"
 
-#include "Renderer/JPGSurfaceLoader.h"
 #include "util/utf8.h"
 #include "util/TextScanner.h"
 #include "ExportToHTML.h"
+#include "JPGMemoryEncoder.h"
+#include "Base64Utils.h"
+#include "ScanJob.h"
+#include "FrameChangeDetector.h"
+#include <mutex>
  
 #ifdef _DEBUG
 //If g_fileName is set to an image instead of blank, UGT will load and translate when started, makes debugging a test image quicker
@@ -136,6 +140,7 @@ void GameLogicComponent::OnAdd(Entity *pEnt)
 	GetParent()->GetFunction("OnUpdate")->sig_function.connect(1, boost::bind(&GameLogicComponent::OnUpdate, this, _1));
 	GetParent()->GetFunction("OnRender")->sig_function.connect(1, boost::bind(&GameLogicComponent::OnRender, this, _1));
 	GetApp()->m_sig_target_language_changed.connect(1, boost::bind(&GameLogicComponent::OnTargetLanguageChanged, this));
+	GetApp()->m_sig_kill_all_text.connect(1, boost::bind(&GameLogicComponent::OnKillAllText, this));
 
 	//hack to process a file image on startup, used for testing
 	if (!g_fileName.empty())
@@ -184,12 +189,25 @@ void GameLogicComponent::OnAdd(Entity *pEnt)
 	}
 }
 
-bool ProcessParagraphManually(const cJSON* paragraph, TextArea& textArea)
+//Copies a word/symbol's polygon out of the response, moved by offset (non-zero when only part of the capture was sent).
+//Missing verts are left at 0,0
+static void GetVerts(const CL_Vec2f *pSrc, int vertCount, CL_Vec2f offset, CL_Vec2f *pVertsOut)
 {
-	//get words
-	const cJSON* words = cJSON_GetObjectItemCaseSensitive(paragraph, "words");
-	const cJSON* word;
+	for (int i = 0; i < 4; i++)
+	{
+		if (i < vertCount)
+		{
+			pVertsOut[i] = CL_Vec2f(pSrc[i].x + offset.x, pSrc[i].y + offset.y);
+		}
+		else
+		{
+			pVertsOut[i] = CL_Vec2f(0, 0);
+		}
+	}
+}
 
+bool ProcessParagraphManually(const OcrParagraph& paragraph, TextArea& textArea)
+{
 	string finalText;
 
 	CL_Vec2f lastVerts[4];
@@ -208,51 +226,16 @@ bool ProcessParagraphManually(const cJSON* paragraph, TextArea& textArea)
 	float isDialogFuzzyLogic = 0;
 
 	CL_Rect totalRect;
-	vector<WordInfo> wordInfo;
+	int lineFirstWord = textArea.m_pDoc->GetWordCount(); //words go straight in the document, a line gets the ones added since the last line
 
-	cJSON_ArrayForEach(word, words)
+	for (int wordIndex = 0; wordIndex < (int)paragraph.m_words.size(); wordIndex++)
 	{
 		//	LogMsg("Got a word");
-		const cJSON* symbols = cJSON_GetObjectItemCaseSensitive(word, "symbols");
-		const cJSON* symbol;
+		const OcrWord& word = paragraph.m_words[wordIndex];
 
 		//get the bounding box of this word
-		const cJSON* boundingBox = cJSON_GetObjectItemCaseSensitive(word, "boundingBox");
-		const cJSON* vertices = cJSON_GetObjectItemCaseSensitive(boundingBox, "vertices");
-		const cJSON* vert;
-
 		CL_Vec2f verts[4];
-		int vertCount = 0;
-
-		cJSON_ArrayForEach(vert, vertices)
-		{
-			float x, y;
-
-			cJSON* tempObj = cJSON_GetObjectItem(vert, "x");
-			if (tempObj)
-			{
-				x = (float)tempObj->valuedouble;
-			}
-			else
-			{
-				x = 0;
-			}
-
-			tempObj = cJSON_GetObjectItem(vert, "y");
-			if (tempObj)
-			{
-				y = (float)tempObj->valuedouble;
-			}
-			else
-			{
-				y = 0;
-			}
-
-			verts[vertCount] = CL_Vec2f(x, y);
-			assert(verts[vertCount] >= 0);
-
-			vertCount++;
-		}
+		GetVerts(word.m_verts, word.m_vertCount, CL_Vec2f(0, 0), verts);
 
 		if (lastVerts[2].y != 0)
 		{
@@ -269,12 +252,8 @@ bool ProcessParagraphManually(const cJSON* paragraph, TextArea& textArea)
 #ifdef _DEBUG
 				//LogMsg("Rect of %s is %s", lineText.c_str(), PrintRect(rectOfLastLine).c_str());
 #endif
-				LineInfo lineInfo;
-				lineInfo.m_lineRect = rectOfLastLine;
-				lineInfo.m_words = wordInfo; wordInfo.clear();
-				lineInfo.m_text = lineText;
-				textArea.m_lines.push_back(lineInfo);
-				textArea.m_lineStarts.push_back(rectOfLastLine.get_top_left());
+				textArea.AddLine(rectOfLastLine, lineText, lineFirstWord);
+				lineFirstWord = textArea.m_pDoc->GetWordCount();
 				finalText += lineText;
 				finalTextRaw += lineText + " ";
 				lineText = "";
@@ -323,66 +302,24 @@ bool ProcessParagraphManually(const cJSON* paragraph, TextArea& textArea)
 
 		bDidCR = false;
 
-		cJSON_ArrayForEach(symbol, symbols)
+		for (int symbolIndex = 0; symbolIndex < (int)word.m_symbols.size(); symbolIndex++)
 		{
-			const cJSON* text = cJSON_GetObjectItemCaseSensitive(symbol, "text");
-			lineText += text->valuestring;
+			const OcrSymbol& symbol = word.m_symbols[symbolIndex];
+			lineText += symbol.m_text;
 
 			//what about the exact rect of this text?
-
-			const cJSON* boundingBox2 = cJSON_GetObjectItemCaseSensitive(symbol, "boundingBox");
-
-			vertices = cJSON_GetObjectItemCaseSensitive(boundingBox2, "vertices");
-			vertCount = 0;
-
-			cJSON_ArrayForEach(vert, vertices)
+			if (symbol.m_vertCount == 4)
 			{
-				float x, y;
-
-				cJSON* tempObj = cJSON_GetObjectItem(vert, "x");
+				GetVerts(symbol.m_verts, symbol.m_vertCount, CL_Vec2f(0, 0), verts);
 
-				if (tempObj)
-				{
-					x = (float)tempObj->valuedouble;
-				}
-				else
-				{
-					x = 0;
-				}
-
-				tempObj = cJSON_GetObjectItem(vert, "y");
-				if (tempObj)
-				{
-					y = (float)tempObj->valuedouble;
-				}
-				else
-				{
-					y = 0;
-				}
-
-				//assert(x >= 0 && y >= 0);
-				verts[vertCount] = CL_Vec2f(x, y);
-				vertCount++;
-			}
-			if (vertCount == 4)
-			{
-				WordInfo w;
-				w.m_rect = CL_Rectf(verts[0].x, verts[0].y, verts[2].x, verts[2].y);
-				w.m_word = text->valuestring;
-				wordInfo.push_back(w);
+				textArea.m_pDoc->AddWord(CL_Rectf(verts[0].x, verts[0].y, verts[2].x, verts[2].y), symbol.m_text);
 			}
 		}
 
 		wordsProcessed++;
 	}
 
-	LineInfo lineInfo;
-	lineInfo.m_words = wordInfo; wordInfo.clear();
-
-	lineInfo.m_lineRect = rectOfLastLine;
-	lineInfo.m_text = lineText;
-	textArea.m_lines.push_back(lineInfo);
-	textArea.m_lineStarts.push_back(rectOfLastLine.get_top_left());
+	textArea.AddLine(rectOfLastLine, lineText, lineFirstWord);
 	finalText += lineText;
 	finalTextRaw += lineText;
 
@@ -434,15 +371,12 @@ void SetFourVertsFromAARect(CL_Rectf r, CL_Vec2f* verts)
 	verts[3] = r.get_bottom_left();
 }
 
-bool GameLogicComponent::ProcessParagraphGoogleWay(const cJSON* paragraph, TextArea& textArea)
+bool GameLogicComponent::ProcessParagraphGoogleWay(const OcrParagraph& paragraph, TextArea& textArea, vector<TextArea> &textAreas, CL_Vec2f offset)
 {
 	CL_Rect rectOfLastLine;
 	bool bRectSet = false;
 	int wordsProcessed = 0;
 
-	//get words
-	const cJSON* words = cJSON_GetObjectItemCaseSensitive(paragraph, "words");
-	const cJSON* word;
 	string finalText;
 
 	CL_Vec2f lastVerts[4];
@@ -451,58 +385,23 @@ bool GameLogicComponent::ProcessParagraphGoogleWay(const cJSON* paragraph, TextA
 		lastVerts[i] = CL_Vec2f(0, 0);
 	}
 	CL_Rect totalRect;
-	vector<WordInfo> wordInfo;
+	int lineFirstWord = textArea.m_pDoc->GetWordCount(); //words go straight in the document, a line gets the ones added since the last line
 
 	string lineText;
 	string finalTextRaw;
 
 	bool bDidMergeWithPrevious = false;
 
-	cJSON_ArrayForEach(word, words)
+	for (int wordIndex = 0; wordIndex < (int)paragraph.m_words.size(); wordIndex++)
 	{
 		//	LogMsg("Got a word");
-		const cJSON* symbols = cJSON_GetObjectItemCaseSensitive(word, "symbols");
-		const cJSON* symbol;
+		const OcrWord& word = paragraph.m_words[wordIndex];
 
 		//get the bounding box of this word
-		const cJSON* boundingBox = cJSON_GetObjectItemCaseSensitive(word, "boundingBox");
-		const cJSON* vertices = cJSON_GetObjectItemCaseSensitive(boundingBox, "vertices");
-		const cJSON* vert;
-
 		CL_Vec2f verts[4];
-		int vertCount = 0;
 
 		//grab the verts from Google.  They are really a polygon of four verts, wound clockwise.  NOT guaranteed to start on the top left, depends on the orientation of the text.
-
-		cJSON_ArrayForEach(vert, vertices)
-		{
-			float x, y;
-
-			cJSON* tempObj = cJSON_GetObjectItem(vert, "x");
-			if (tempObj)
-			{
-				x = (float)tempObj->valuedouble;
-			}
-			else
-			{
-				x = 0;
-			}
-
-			tempObj = cJSON_GetObjectItem(vert, "y");
-			if (tempObj)
-			{
-				y = (float)tempObj->valuedouble;
-			}
-			else
-			{
-				y = 0;
-			}
-
-			verts[vertCount] = CL_Vec2f(x, y);
-			assert(verts[vertCount] >= 0);
-
-			vertCount++;
-		}
+		GetVerts(word.m_verts, word.m_vertCount, offset, verts);
 
 		//remove any rotations to enforce axis-aligned rects
 		CL_Rectf r = GetAARectFromPoly(verts, 4);
@@ -541,75 +440,35 @@ if (!lineText.empty())
 	//lineText += " ";
 }
 
-cJSON_ArrayForEach(symbol, symbols)
+for (int symbolIndex = 0; symbolIndex < (int)word.m_symbols.size(); symbolIndex++)
 {
-	const cJSON* text = cJSON_GetObjectItemCaseSensitive(symbol, "text");
-	lineText += text->valuestring;
+	const OcrSymbol& symbol = word.m_symbols[symbolIndex];
+	lineText += symbol.m_text;
 
 
 	//what about the exact rect of this text?
-
-	const cJSON* boundingBox2 = cJSON_GetObjectItemCaseSensitive(symbol, "boundingBox");
-
-	vertices = cJSON_GetObjectItemCaseSensitive(boundingBox2, "vertices");
-	vertCount = 0;
-
-	cJSON_ArrayForEach(vert, vertices)
-	{
-		float x, y;
-
-		cJSON* tempObj = cJSON_GetObjectItem(vert, "x");
-
-		if (tempObj)
-		{
-			x = (float)tempObj->valuedouble;
-		}
-		else
-		{
-			x = 0;
-		}
-
-		tempObj = cJSON_GetObjectItem(vert, "y");
-		if (tempObj)
-		{
-			y = (float)tempObj->valuedouble;
-		}
-		else
-		{
-			y = 0;
-		}
-
-		//assert(x >= 0 && y >= 0);
-		verts[vertCount] = CL_Vec2f(x, y);
-		vertCount++;
-	}
-	if (vertCount == 4)
+	if (symbol.m_vertCount == 4)
 	{
-		WordInfo w;
+		GetVerts(symbol.m_verts, symbol.m_vertCount, offset, verts);
 
-		w.m_rect = GetAARectFromPoly(verts, 4);
-		w.m_word = text->valuestring;
-		wordInfo.push_back(w);
+		textArea.m_pDoc->AddWord(GetAARectFromPoly(verts, 4), symbol.m_text);
 	}
 
-	const cJSON* symbolProperty = cJSON_GetObjectItemCaseSensitive(symbol, "property");
-	const cJSON* linebreak = cJSON_GetObjectItemCaseSensitive(symbolProperty, "detectedBreak");
-	if (linebreak != NULL)
+	if (symbol.m_bHasBreak)
 	{
-		const cJSON* detectedBreak = cJSON_GetObjectItemCaseSensitive(linebreak, "type");
 		const string space("SPACE");
 		const string eolspace("EOL_SURE_SPACE");
 		bool bAddCR = false;
 
-		if (space.compare(detectedBreak->valuestring) == 0)
+		if (space.compare(symbol.m_breakType) == 0)
 		{
 			lineText += " ";
 		}
 		else
 		{
-			//LogMsg("Break type: %s", detectedBreak->valuestring);
+			//LogMsg("Break type: %s", symbol.m_breakType.c_str());
 
-			if (eolspace.compare(detectedBreak->valuestring) == 0)
+			if (eolspace.compare(symbol.m_breakType) == 0)
 			{
 
 				//lineText += "\n"; // Seems better if EOL space is treated as a newline? (old behavior)
@@ -657,10 +516,10 @@ cJSON_ArrayForEach(symbol, symbols)
 					//Sometimes it's obvious that two lines of text should be grouped together, but for some reason Google doesn't catch it.
 					//The thing below does some checks and merged them if it notices that.
 
-					if (!m_textareas.empty() && m_textareas[m_textareas.size() - 1].m_lines.size() > 0)
+					if (!textAreas.empty() && textAreas[textAreas.size() - 1].GetLineCount() > 0)
 					{
 						//is this a logical extension of the previous paragraph?  How do we know? We'll have to compare rects I guess.
-						const TextArea& lastTextArea = m_textareas[m_textareas.size() - 1];
+						const TextArea& lastTextArea = textAreas[textAreas.size() - 1];
 						CL_Rect lineRect = rectOfLastLine;
 						//this is very.. uhh.. well, it's tuned to detect for left to right RPG style dialog boxes.
 
@@ -678,18 +537,14 @@ cJSON_ArrayForEach(symbol, symbols)
 							//destroy the old one
 							totalRect = textArea.m_rect.bounding_rect(lineRect);
 
-							m_textareas.erase(m_textareas.begin() + (m_textareas.size() - 1)); //this is slow as it could require some copying.  But because it's the last item in the vector, probably not
+							textAreas.erase(textAreas.begin() + (textAreas.size() - 1)); //this is slow as it could require some copying.  But because it's the last item in the vector, probably not
 							bDidMergeWithPrevious = true;
 						}
 					}
 //***********************************************************************
 
-					LineInfo lineInfo;
-					lineInfo.m_lineRect = rectOfLastLine;
-					lineInfo.m_words = wordInfo; wordInfo.clear();
-					lineInfo.m_text = lineText;
-					textArea.m_lines.push_back(lineInfo);
-					textArea.m_lineStarts.push_back(rectOfLastLine.get_top_left());
+					textArea.AddLine(rectOfLastLine, lineText, lineFirstWord);
+					lineFirstWord = textArea.m_pDoc->GetWordCount();
 					
 					if (bAddCR)
 					{
@@ -714,15 +569,12 @@ cJSON_ArrayForEach(symbol, symbols)
 	return true;
 }
 
-bool GameLogicComponent::ProcessParagraphMicrosoftWay(const cJSON* line, TextArea& textArea)
+bool GameLogicComponent::ProcessParagraphMicrosoftWay(const OcrParagraph& line, TextArea& textArea, CL_Vec2f offset)
 {
 	CL_Rect rectOfLastLine;
 	bool bRectSet = false;
 	int wordsProcessed = 0;
 
-	//get words
-	const cJSON* words = cJSON_GetObjectItemCaseSensitive(line, "words");
-	const cJSON* word;
 	string finalText;
 
 	CL_Vec2f lastVerts[4];
@@ -731,51 +583,20 @@ bool GameLogicComponent::ProcessParagraphMicrosoftWay(const cJSON* line, TextAre
 		lastVerts[i] = CL_Vec2f(0, 0);
 	}
 	CL_Rect totalRect;
-	vector<WordInfo> wordInfo;
+	int lineFirstWord = textArea.m_pDoc->GetWordCount(); //words go straight in the document, a line gets the ones added since the last line
 
 	string lineText;
 	string finalTextRaw;
 
 	bool bDidMergeWithPrevious = false;
 
-	cJSON_ArrayForEach(word, words)
+	for (int wordIndex = 0; wordIndex < (int)line.m_words.size(); wordIndex++)
 	{
-		//get the bounding box of this word
-		const cJSON* vertices = cJSON_GetObjectItemCaseSensitive(word, "boundingPolygon");
-		const cJSON* vert;
+		const OcrWord& word = line.m_words[wordIndex];
 
+		//get the bounding box of this word
 		CL_Vec2f verts[4];
-		int vertCount = 0;
-
-		cJSON_ArrayForEach(vert, vertices)
-		{
-			float x, y;
-
-			cJSON* tempObj = cJSON_GetObjectItem(vert, "x");
-			if (tempObj)
-			{
-				x = (float)tempObj->valuedouble;
-			}
-			else
-			{
-				x = 0;
-			}
-
-			tempObj = cJSON_GetObjectItem(vert, "y");
-			if (tempObj)
-			{
-				y = (float)tempObj->valuedouble;
-			}
-			else
-			{
-				y = 0;
-			}
-
-			verts[vertCount] = CL_Vec2f(x, y);
-			assert(verts[vertCount] >= 0);
-
-			vertCount++;
-		}
+		GetVerts(word.m_verts, word.m_vertCount, offset, verts);
 
 		//remove any rotations to enforce axis-aligned rects
 		CL_Rectf r = GetAARectFromPoly(verts, 4);
@@ -809,55 +630,17 @@ bool GameLogicComponent::ProcessParagraphMicrosoftWay(const cJSON* line, TextAre
 			lastVerts[i] = verts[i];
 		}
 
-		const cJSON* text = cJSON_GetObjectItemCaseSensitive(word, "text");
-		lineText += text->valuestring;
-		vertices = cJSON_GetObjectItemCaseSensitive(word, "boundingPolygon");
-		vertCount = 0;
-
-		cJSON_ArrayForEach(vert, vertices)
-		{
-			float x, y;
-
-			cJSON* tempObj = cJSON_GetObjectItem(vert, "x");
-
-			if (tempObj)
-			{
-				x = (float)tempObj->valuedouble;
-			}
-			else
-			{
-				x = 0;
-			}
-
-			tempObj = cJSON_GetObjectItem(vert, "y");
-			if (tempObj)
-			{
-				y = (float)tempObj->valuedouble;
-			}
-			else
-			{
-				y = 0;
-			}
-
-			verts[vertCount] = CL_Vec2f(x, y);
-			vertCount++;
-		}
+		lineText += word.m_text;
 
-		if (vertCount == 4)
+		if (word.m_vertCount == 4)
 		{
-			WordInfo w;
+			GetVerts(word.m_verts, word.m_vertCount, offset, verts);
 
-			w.m_rect = GetAARectFromPoly(verts, 4);
-			w.m_word = text->valuestring;
-			wordInfo.push_back(w);
+			textArea.m_pDoc->AddWord(GetAARectFromPoly(verts, 4), word.m_text);
 		}
 
-		LineInfo lineInfo;
-		lineInfo.m_lineRect = rectOfLastLine;
-		lineInfo.m_words = wordInfo; wordInfo.clear();
-		lineInfo.m_text = lineText;
-		textArea.m_lines.push_back(lineInfo);
-		textArea.m_lineStarts.push_back(rectOfLastLine.get_top_left());
+		textArea.AddLine(rectOfLastLine, lineText, lineFirstWord);
+		lineFirstWord = textArea.m_pDoc->GetWordCount();
 		finalText += lineText;
 		finalTextRaw += lineText;
 		lineText = "";
@@ -873,25 +656,114 @@ bool GameLogicComponent::ProcessParagraphMicrosoftWay(const cJSON* line, TextAre
 	return true;
 }
 
-bool GameLogicComponent::ReadFromParagraph(const cJSON* paragraph, TextArea& textArea)
+//Before adding lines to a text area, they have to be able to go right after the ones it has
+static void MoveLinesToEndIfNeeded(TextArea &textArea)
+{
+	int lineCount = textArea.m_pDoc->GetLineCount();
+
+	if (textArea.m_lineCount > 0 && textArea.m_firstLine + textArea.m_lineCount != lineCount)
+	{
+		//Other lines were added after ours, happens when a paragraph in between was too small to keep and we got glued onto
+		//the one before it, or when auto-glue puts two areas together.  Move ours to the end so they're together again,
+		//the old entries are just never looked at.
+		for (int i = 0; i < textArea.m_lineCount; i++)
+		{
+			textArea.m_pDoc->CopyLine(textArea.m_firstLine + i);
+		}
+		textArea.m_firstLine = lineCount;
+	}
+}
+
+void TextArea::AddLine(const CL_Rectf &rect, const string &text, int firstWord)
+{
+	MoveLinesToEndIfNeeded(*this);
+
+	int line = m_pDoc->AddLine(rect, text, firstWord);
+	if (m_lineCount == 0) m_firstLine = line;
+	m_lineCount++;
+}
+
+void TextArea::Append(const TextArea &other)
+{
+	assert(m_pDoc == other.m_pDoc);
+
+	MoveLinesToEndIfNeeded(*this);
+
+	for (int i = 0; i < other.m_lineCount; i++)
+	{
+		int line = m_pDoc->CopyLine(other.m_firstLine + i);
+		if (m_lineCount == 0) m_firstLine = line;
+		m_lineCount++;
+	}
+
+	//the same as the Google way's glue does with lines, nothing between them for Asian languages
+	if (!IsAsianLanguage(language) && !rawText.empty() && rawText[rawText.length() - 1] != ' ')
+	{
+		text += " ";
+		rawText += " ";
+		wideText.push_back(' ');
+	}
+
+	text += other.text;
+	rawText += other.rawText;
+	wideText.insert(wideText.end(), other.wideText.begin(), other.wideText.end());
+
+	m_rect.bounding_rect(other.m_rect);
+	m_bIsDialog = m_bIsDialog || other.m_bIsDialog;
+}
+
+bool TextArea::HitTestWord(const CL_Vec2f &pt, int *pLineOut, int *pWordOut) const
+{
+	if (!m_pDoc || m_lineCount == 0) return false;
+
+	//the document's index finds the few words under pt, then we see if any of them are ours
+	vector<int> words;
+	m_pDoc->FindWordsAt(pt, &words);
+
+	for (int l = 0; l < m_lineCount; l++)
+	{
+		int firstWord = m_pDoc->GetLineFirstWord(m_firstLine + l);
+		int wordCount = m_pDoc->GetLineWordCount(m_firstLine + l);
+
+		for (int i = 0; i < (int)words.size(); i++)
+		{
+			if (words[i] >= firstWord && words[i] < firstWord + wordCount)
+			{
+				*pLineOut = l;
+				*pWordOut = words[i] - firstWord;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool GameLogicComponent::ReadFromParagraph(const OcrParagraph& paragraph, TextArea& textArea, vector<TextArea> &textAreas, CL_Vec2f offset)
 {
+	//if only part of the capture was sent, offset puts things back where they really are.  It has to happen as the verts
+	//are read, the auto-glue in the Google way compares against text areas that were already moved
 	if (GetApp()->GetVisionEngine() == VISION_ENGINE_GOOGLE)
 	{
 		//We only need one of these... Google way trusts when google marks things as a wrap around with space or a new line.
-		ProcessParagraphGoogleWay(paragraph, textArea);
+		ProcessParagraphGoogleWay(paragraph, textArea, textAreas, offset);
 	}
 	else
 	{
-		ProcessParagraphMicrosoftWay(paragraph, textArea);
+		ProcessParagraphMicrosoftWay(paragraph, textArea, offset);
 	}
 
-	MergeWithPreviousTextIfNeeded(textArea);
+	GuessTextAreaLayout(textArea);
+	return true;
+}
 
+void GameLogicComponent::GuessTextAreaLayout(TextArea &textArea)
+{
 #ifdef _DEBUG
 	//check for malformed boxes
-	for (int i = 0; i < textArea.m_lines.size(); i++)
+	for (int i = 0; i < textArea.GetLineCount(); i++)
 	{
-		assert(textArea.m_lines[i].m_lineRect.get_height() >= 0);
+		assert(textArea.GetLineRect(i).get_height() >= 0);
 	}
 #endif
 
@@ -912,30 +784,38 @@ bool GameLogicComponent::ReadFromParagraph(const cJSON* paragraph, TextArea& tex
 #ifdef _DEBUG
 	
 		//LogMsg("Fuzzy tests for %s:", finalText.c_str());
-		LogMsg("centeringFactorX: %.2f  centeringFactorY: %.2f", centeringFactorX, centeringFactorY);
-		LogMsg("percentUsedOfScreenWidth : %.2f  percentUsedOfScreenHeight: %.2f", percentUsedOfScreenWidth, percentUsedOfScreenHeight);
+		//these run on a worker thread now
+		LogMsgFromAnyThread("centeringFactorX: %.2f  centeringFactorY: %.2f", centeringFactorX, centeringFactorY);
+		LogMsgFromAnyThread("percentUsedOfScreenWidth : %.2f  percentUsedOfScreenHeight: %.2f", percentUsedOfScreenWidth, percentUsedOfScreenHeight);
 	
 #endif
 		//recompute the rawtext to look better based on how the text is laid out
-	if (textArea.m_lines.size() > 1)
+	if (textArea.GetLineCount() > 1)
 	{
 		string newFinal;
 
 		textArea.m_ySpacingToNextLineAverage = 0;
 		textArea.m_averageTextHeight = 0;
 
-		for (int i = 0; i < textArea.m_lines.size(); i++)
+		for (int i = 0; i < textArea.GetLineCount(); i++)
 		{
+			assert(textArea.GetLineRect(i).get_height() > 0);
+			textArea.m_averageTextHeight += textArea.GetLineRect(i).get_height();
+
+			//the rest is about the gap to the next line.  This used to read past the end for the last one, which with the
+			//lines all in one document would be some other text area's line
+			if (i == textArea.GetLineCount() - 1) break;
+
 			bool bAddCR = false;
 
-			float startingXDifferenceFromNextLine = textArea.m_lines[i + 1].m_lineRect.get_top_left().x - textArea.m_lines[i].m_lineRect.get_top_left().x;
-			float endingXDifferenceFromNextLine = textArea.m_lines[i + 1].m_lineRect.get_top_right().x - textArea.m_lines[i].m_lineRect.get_top_right().x;
+			float startingXDifferenceFromNextLine = textArea.GetLineRect(i + 1).get_top_left().x - textArea.GetLineRect(i).get_top_left().x;
+			float endingXDifferenceFromNextLine = textArea.GetLineRect(i + 1).get_top_right().x - textArea.GetLineRect(i).get_top_right().x;
 			float startingXDiffFromNextLinePercent = startingXDifferenceFromNextLine / textArea.m_rect.get_width();
 			float endingXDiffFromNextLinePercent = endingXDifferenceFromNextLine / textArea.m_rect.get_width();
-			float xPercentUsedOfTotalRect = textArea.m_lines[i].m_lineRect.get_width() / textArea.m_rect.get_width();
-			float ySpacingToNextLine = textArea.m_lines[i + 1].m_lineRect.get_top_left().y -
-				textArea.m_lines[i].m_lineRect.get_bottom_right().y;
-			float ySpacingToNextLinePercent = ySpacingToNextLine / textArea.m_lines[i + 1].m_lineRect.get_height();
+			float xPercentUsedOfTotalRect = textArea.GetLineRect(i).get_width() / textArea.m_rect.get_width();
+			float ySpacingToNextLine = textArea.GetLineRect(i + 1).get_top_left().y -
+				textArea.GetLineRect(i).get_bottom_right().y;
+			float ySpacingToNextLinePercent = ySpacingToNextLine / textArea.GetLineRect(i + 1).get_height();
 
 			if (ySpacingToNextLinePercent > 1.9f)
 			{
@@ -959,7 +839,7 @@ bool GameLogicComponent::ReadFromParagraph(const cJSON* paragraph, TextArea& tex
 				startingXDiffFromNextLinePercent);
 				*/
 #endif
-			//newFinal += textArea.m_lines[i].m_text;
+			//newFinal += textArea.GetLineText(i);
 			//if (bAddCR)
 			//{
 			//	newFinal += "\n";
@@ -970,17 +850,15 @@ bool GameLogicComponent::ReadFromParagraph(const cJSON* paragraph, TextArea& tex
 			//	newFinal += "";
 			//}
 
-			assert(textArea.m_lines[i].m_lineRect.get_height() > 0);
-			textArea.m_averageTextHeight += textArea.m_lines[i].m_lineRect.get_height();
 			textArea.m_ySpacingToNextLineAverage += ySpacingToNextLinePercent;
 		}
 
-		textArea.m_ySpacingToNextLineAverage /= (textArea.m_lines.size() - 1);
-		textArea.m_averageTextHeight /= textArea.m_lines.size();
+		textArea.m_ySpacingToNextLineAverage /= (textArea.GetLineCount() - 1);
+		textArea.m_averageTextHeight /= textArea.GetLineCount();
 		assert(textArea.m_averageTextHeight > 0);
 
 
-		//newFinal += textArea.m_lines[textArea.m_lines.size() - 1].m_text; //the last line
+		//newFinal += textArea.GetLineText(textArea.GetLineCount() - 1); //the last line
 		//textArea.rawText = newFinal;
 		//scan if it's dialog or not
 
@@ -1006,7 +884,6 @@ bool GameLogicComponent::ReadFromParagraph(const cJSON* paragraph, TextArea& tex
 	}
 
 	//LogMsg("Adding text %s to %s.", textArea.text, PrintRect(textArea.m_rect).c_str());
-	return true;
 }
 
 void GameLogicComponent::AddTextBox(TextAreaComponent *p)
@@ -1017,10 +894,12 @@ void GameLogicComponent::AddTextBox(TextAreaComponent *p)
 void GameLogicComponent::RemoveTextBox(TextAreaComponent *p)
 {
 	m_textComps.erase(std::remove(m_textComps.begin(), m_textComps.end(), p), m_textComps.end());
+	m_parkedTextComps.erase(std::remove(m_parkedTextComps.begin(), m_parkedTextComps.end(), p), m_parkedTextComps.end());
+	m_translationBatcher.OnTextBoxRemoved(p);
 
 }
 
-void GameLogicComponent::ConstructEntityFromTextArea(TextArea &textArea)
+void GameLogicComponent::ConstructEntityFromTextArea(const TextArea &textArea)
 {
 	//LogMsg("Constructing %s", textArea.text.c_str());
 
@@ -1030,12 +909,89 @@ void GameLogicComponent::ConstructEntityFromTextArea(TextArea &textArea)
 	pTextAreaComp->Init(textArea);
 }
 
-void GameLogicComponent::ConstructEntitiesFromTextAreas()
+bool GameLogicComponent::ParkTextBox(TextAreaComponent *p)
+{
+	if (!GetApp()->m_reuse_text_between_scans) return false;
+	if (p->IsParked()) return true;
+
+	m_textComps.erase(std::remove(m_textComps.begin(), m_textComps.end(), p), m_textComps.end());
+	m_parkedTextComps.push_back(p);
+	p->Park();
+	return true;
+}
+
+//Scanning the same screen again mostly finds the same text.  Rather than throw away every text box and translate and
+//render it all over again, anything from the last scan with the same text and size is shown again (moved if it has to
+//be), and only what's actually new gets built.  Whatever wasn't wanted is deleted.
+void GameLogicComponent::ReconcileTextAreas()
 {
+	vector<TextAreaComponent*> parked;
+	parked.swap(m_parkedTextComps);
+
+	int reusedCount = 0;
+	int movedCount = 0;
+
 	for (int i = 0; i < m_textareas.size(); i++)
 	{
-		ConstructEntityFromTextArea(m_textareas[i]);
+		const CL_Rectf &rect = m_textareas[i].m_rect;
+
+		//if the same text shows up more than once, take whichever was closest to where this one is
+		int bestIndex = -1;
+		float bestDistance = 0;
+
+		for (int j = 0; j < (int)parked.size(); j++)
+		{
+			if (!parked[j] || !parked[j]->CanReuseFor(m_textareas[i])) continue;
+
+			CL_Vec2f delta = parked[j]->m_textArea.m_rect.get_top_left() - rect.get_top_left();
+			float distance = delta.x * delta.x + delta.y * delta.y;
+
+			if (bestIndex == -1 || distance < bestDistance)
+			{
+				bestIndex = j;
+				bestDistance = distance;
+			}
+		}
+
+		if (bestIndex == -1)
+		{
+			ConstructEntityFromTextArea(m_textareas[i]);
+			continue;
+		}
+
+		TextAreaComponent *pComp = parked[bestIndex];
+		parked[bestIndex] = NULL;
+
+		if (bestDistance > 0) movedCount++;
+		reusedCount++;
+
+		pComp->Unpark(m_textareas[i]);
+		AddTextBox(pComp);
+	}
+
+	for (int i = 0; i < (int)parked.size(); i++)
+	{
+		if (parked[i])
+		{
+			parked[i]->GetParent()->SetTaggedForDeletion();
+		}
+	}
+
+	if (reusedCount > 0)
+	{
+		LogMsg("Reused %d text areas from the last scan (%d moved), built %d new ones", reusedCount, movedCount,
+			(int)m_textareas.size() - reusedCount);
 	}
+}
+
+void GameLogicComponent::ConstructEntitiesFromTextAreas()
+{
+	m_bCalledOnFinishedTranslations = false; //reused ones might all be done already, OnUpdate still needs to see this scan finish
+
+	ReconcileTextAreas();
+
+	//they've all queued their text by now, send it off as one request instead of one per text area
+	m_translationBatcher.Flush();
 
 	if (m_textareas.empty())
 	{
@@ -1043,214 +999,699 @@ void GameLogicComponent::ConstructEntitiesFromTextAreas()
 	}
 }
 
-void GameLogicComponent::MergeWithPreviousTextIfNeeded(TextArea& textArea)
+//Same test the Google way uses to glue a line onto the paragraph before it: does lower's first line start just under upper,
+//and not too far to the left or past its right side?
+bool GameLogicComponent::CanAutoGlue(const TextArea &upper, const TextArea &lower)
 {
-	if (m_textareas.empty()) return;
+	if (lower.GetLineCount() == 0 || upper.language != lower.language) return false;
+
+	const CL_Rectf &lineRect = lower.GetLineRect(0);
+
+	float verticalSpacing = lineRect.top - upper.m_rect.bottom;
+	float allowedVerticalSpacing = lineRect.get_height() * GetApp()->m_auto_glue_vertical_tolerance;
+
+	return fabs(verticalSpacing) < allowedVerticalSpacing
+		&& lineRect.left + upper.m_rect.get_width() * GetApp()->m_auto_glue_horizontal_tolerance >= upper.m_rect.left
+		&& lineRect.left <= upper.m_rect.right;
 }
 
-bool GameLogicComponent::BuildDatabase(char* pJson)
+const float C_AUTO_GLUE_GRID_CELL_SIZE = 128;
+
+//The Google way only ever glues onto the paragraph right before, and the Microsoft one gives us every line as its own
+//paragraph, so text that obviously belongs together can still come out as separate areas.  This goes through them top
+//down and glues on whatever continues right below each one, over and over so a whole stack of lines ends up as one.
+//
+//Areas are put in a grid so each only gets compared to the ones around its bottom edge, not to all the others.
+void GameLogicComponent::AutoGlueTextAreas(vector<TextArea> &textAreas)
 {
-	if (GetApp()->GetVisionEngine() == VISION_ENGINE_GOOGLE)
+	if (textAreas.size() < 2 || GetApp()->m_auto_glue_vertical_tolerance <= 0) return;
+
+	CL_Rectf bounds = textAreas[0].m_rect;
+	float maxLineHeight = 0;
+
+	for (int i = 0; i < (int)textAreas.size(); i++)
 	{
-		return BuildDatabaseGoogleVision(pJson);
+		bounds.bounding_rect(textAreas[i].m_rect);
+		if (textAreas[i].GetLineCount() > 0)
+		{
+			maxLineHeight = rt_max(maxLineHeight, textAreas[i].GetLineRect(0).get_height());
+		}
 	}
-	else
+
+	RectGrid grid;
+	grid.Init(bounds, C_AUTO_GLUE_GRID_CELL_SIZE);
+
+	vector<int> order(textAreas.size());
+	for (int i = 0; i < (int)textAreas.size(); i++)
 	{
-		return BuildDatabaseMicrosoftVision(pJson);
+		grid.Add(i, textAreas[i].m_rect);
+		order[i] = i;
 	}
-}
-
 
-bool GameLogicComponent::BuildDatabaseGoogleVision(char *pJson)
-{
-	LogMsg("Parsing...");
-	UpdateStatusMessage("Parsing...");
-	cJSON *root = cJSON_Parse(pJson);
-	
-	cJSON *responses = cJSON_GetObjectItem(root, "responses");
-	int responseCount = cJSON_GetArraySize(responses);
-	if (responseCount != 1) return false;
-	
-	cJSON *fullTextAnnotation = cJSON_GetObjectItem(cJSON_GetArrayItem(responses, 0), "fullTextAnnotation");
-	int fullTextAnnotationCount = cJSON_GetArraySize(fullTextAnnotation);
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return textAreas[a].m_rect.top < textAreas[b].m_rect.top; });
 
-	cJSON *pages = cJSON_GetObjectItem(fullTextAnnotation, "pages");
-	int pagesCount = cJSON_GetArraySize(pages);
+	vector<bool> glued(textAreas.size(), false); //was stuck onto another one
+	vector<bool> grew(textAreas.size(), false);
+	vector<int> candidates;
 
-	cJSON *blocks = cJSON_GetObjectItem(cJSON_GetArrayItem(pages, 0), "blocks");
-	int blockCount = cJSON_GetArraySize(blocks);
+	//nothing can be farther than this from the bottom and still pass CanAutoGlue()
+	float reach = maxLineHeight * GetApp()->m_auto_glue_vertical_tolerance;
 
-	for (int i = 0; i < blockCount; i++)
+	for (int i = 0; i < (int)order.size(); i++)
 	{
-		cJSON *block = cJSON_GetArrayItem(blocks, i);
-		cJSON *boundingBox = cJSON_GetObjectItem(block, "boundingBox");
-	
-		cJSON *verts = cJSON_GetArrayItem(boundingBox, 0);
-		int vertCount = cJSON_GetArraySize(verts);
-		assert(vertCount == 4);
-		
-		for (int j = 0; j < vertCount; j++)
+		int upper = order[i];
+		if (glued[upper]) continue;
+
+		while (true)
 		{
-			cJSON *vert = cJSON_GetArrayItem(verts, j);
-			float x = 0;
-			float y = 0;
-			cJSON *tempObj = cJSON_GetObjectItem(vert, "x");
-			if (tempObj) x = (float)tempObj->valuedouble;
-			tempObj = cJSON_GetObjectItem(vert, "y");
-			if (tempObj) y = (float)tempObj->valuedouble;
-			//textArea.m_vPoints[j] = CL_Vec2f(x, y);
-	
+			TextArea &upperArea = textAreas[upper];
+			CL_Rectf searchRect(upperArea.m_rect.left - upperArea.m_rect.get_width() * GetApp()->m_auto_glue_horizontal_tolerance,
+				upperArea.m_rect.bottom - reach, upperArea.m_rect.right, upperArea.m_rect.bottom + reach);
 
-			//LogMsg("Block %d, vert %d is X: %f and Y: %f", i, j, (float)x, (float)y);
-		}
-		
-		//textArea.m_rect = CL_Rectf(textArea.m_vPoints[0].x, textArea.m_vPoints[1].y, textArea.m_vPoints[2].x, textArea.m_vPoints[3].y);
-		//LogMsg("Setting final rect to %s", PrintRect(textArea.m_rect).c_str());
-		//note:  Here is where I updated my version of cJSON which has some changes...
+			grid.Query(searchRect, &candidates);
+
+			//if more than one fits, the closest one
+			int best = -1;
+			float bestSpacing = 0;
 
-		//remember what language this block was
-		const cJSON *property = cJSON_GetObjectItemCaseSensitive(block, "property");
-		const cJSON *detectedLanguages = cJSON_GetObjectItemCaseSensitive(property, "detectedLanguages");
-		const cJSON *detectedLanguage;
+			for (int j = 0; j < (int)candidates.size(); j++)
+			{
+				int lower = candidates[j];
+				if (lower == upper) continue;
+				if (!CanAutoGlue(upperArea, textAreas[lower])) continue;
+
+				float spacing = fabs(textAreas[lower].GetLineRect(0).top - upperArea.m_rect.bottom);
+				if (best == -1 || spacing < bestSpacing)
+				{
+					best = lower;
+					bestSpacing = spacing;
+				}
+			}
 
-		string myLanguage = "";
+			if (best == -1) break;
 
-		cJSON_ArrayForEach(detectedLanguage, detectedLanguages)
-		{
-			const cJSON *languageCode = cJSON_GetObjectItemCaseSensitive(detectedLanguage, "languageCode");
-			myLanguage = languageCode->valuestring;
-			//LogMsg("Found language %s", languageCode->valuestring);
-			//We can't really understand or handle more than one language,
-			//can we?  I guess just ignore if multiple languages are set.  Using the first instead of
-			//the last set as per Meerkov's suggestion
-			break;
+			//take both out and put the merged one back, so the cells don't keep pointing at what's gone
+			grid.Remove(best, textAreas[best].m_rect);
+			grid.Remove(upper, upperArea.m_rect);
+
+			upperArea.Append(textAreas[best]);
+			glued[best] = true;
+			grew[upper] = true;
+			grid.Add(upper, upperArea.m_rect);
 		}
-		
-		const cJSON *paragraph;
-		const cJSON *paragraphs = cJSON_GetObjectItemCaseSensitive(block, "paragraphs");
-		
-		int paraCount = 0;
+	}
 
-		cJSON_ArrayForEach(paragraph, paragraphs)
-		{
-			TextArea textArea;
-			textArea.language = myLanguage;
+	int keepCount = 0;
+	for (int i = 0; i < (int)textAreas.size(); i++)
+	{
+		if (glued[i]) continue;
 
-			ReadFromParagraph(paragraph, textArea);
-			if (textArea.m_rect.get_width() > 5 && textArea.m_rect.get_height() > 5)
-				m_textareas.push_back(textArea);
-			paraCount++;
+		if (grew[i])
+		{
+			GuessTextAreaLayout(textAreas[i]); //what we figured out before was only about part of it
 		}
 
-#ifdef _DEBUG
-		//LogMsg("Got %s", textArea.text.c_str());
-#endif
+		if (keepCount != i) textAreas[keepCount] = textAreas[i];
+		keepCount++;
 	}
 
-	ConstructEntitiesFromTextAreas();
-	cJSON_Delete(root);
-	return true; //ok
+	textAreas.resize(keepCount);
 }
 
-bool GameLogicComponent::BuildDatabaseMicrosoftVision(char* pJson)
+bool GameLogicComponent::BuildDatabase(char* pJson, vector<TextArea> *pTextAreasOut, CL_Vec2f offset)
 {
-	LogMsg("Parsing...");
-	UpdateStatusMessage("Parsing...");
-	cJSON* root = cJSON_Parse(pJson);
+	//everything this scan finds goes in one document, the text areas just point into it
+	OcrDocumentPtr pDoc = std::make_shared<OcrDocument>();
+	pDoc->Reserve((int)strlen(pJson));
 
-	cJSON* readResult = cJSON_GetObjectItem(root, "readResult");
-	cJSON* blocks = cJSON_GetObjectItem(readResult, "blocks");
-	int blockCount = cJSON_GetArraySize(blocks);
+	bool bOk;
 
-	for (int i = 0; i < blockCount; i++)
+	if (GetApp()->GetVisionEngine() == VISION_ENGINE_GOOGLE)
 	{
-		cJSON* block = cJSON_GetArrayItem(blocks, i);
-		const cJSON* line;
-		const cJSON* lines = cJSON_GetObjectItemCaseSensitive(block, "lines");
-
-		cJSON_ArrayForEach(line, lines)
-		{
-			TextArea textArea;
-			textArea.language = "ja";
+		bOk = BuildDatabaseGoogleVision(pJson, pTextAreasOut, offset, pDoc);
+	}
+	else
+	{
+		bOk = BuildDatabaseMicrosoftVision(pJson, pTextAreasOut, offset, pDoc);
+	}
 
-			ReadFromParagraph(line, textArea);
-			if (textArea.m_rect.get_width() > 5 && textArea.m_rect.get_height() > 5)
-				m_textareas.push_back(textArea);
-		}
+	if (bOk)
+	{
+		AutoGlueTextAreas(*pTextAreasOut);
+		pDoc->BuildWordIndex(); //for finding the word that was clicked
 	}
 
-	ConstructEntitiesFromTextAreas();
-	cJSON_Delete(root);
-	return true; //ok
+	return bOk;
 }
 
-void GameLogicComponent::StartProcessingFrameForText()
+
+bool GameLogicComponent::BuildDatabaseGoogleVision(char *pJson, vector<TextArea> *pTextAreasOut, CL_Vec2f offset, const OcrDocumentPtr &pDoc)
 {
-	GetApp()->m_sig_kill_all_text();
-	m_textareas.clear();
-	unsigned int originalFileSize = 0;
-	byte * fileData = NULL;
-	
+	//each paragraph comes with the language of its block.  We can't really understand or handle more than one language,
+	//can we?  I guess just ignore if multiple languages are set.  Using the first instead of the last set as per Meerkov's suggestion
+	return ReadGoogleVisionResponse(pJson, [&](const OcrParagraph& paragraph)
+	{
+		TextArea textArea;
+		textArea.language = paragraph.m_language;
+		textArea.m_pDoc = pDoc;
+
+		ReadFromParagraph(paragraph, textArea, *pTextAreasOut, offset);
+		if (textArea.m_rect.get_width() > 5 && textArea.m_rect.get_height() > 5)
+			pTextAreasOut->push_back(textArea);
+	});
+}
+
+bool GameLogicComponent::BuildDatabaseMicrosoftVision(char* pJson, vector<TextArea> *pTextAreasOut, CL_Vec2f offset, const OcrDocumentPtr &pDoc)
+{
+	return ReadMicrosoftVisionResponse(pJson, [&](const OcrParagraph& line)
+	{
+		TextArea textArea;
+		textArea.language = line.m_language;
+		textArea.m_pDoc = pDoc;
+
+		ReadFromParagraph(line, textArea, *pTextAreasOut, offset);
+		if (textArea.m_rect.get_width() > 5 && textArea.m_rect.get_height() > 5)
+			pTextAreasOut->push_back(textArea);
+	});
+}
+
+void GameLogicComponent::OnKillAllText()
+{
+	//the overlay is going away or a new scan is starting, either way the one in flight is stale now
+	CancelScan();
+}
+
+void GameLogicComponent::CancelScan()
+{
+	if (m_pActiveScan)
+	{
+		m_pActiveScan->Cancel();
+		m_pActiveScan.reset();
+	}
+
+	m_ocrHTTP.Reset(); //an upload in progress would still be reading m_scanJPG
+}
+
+bool GameLogicComponent::IsActiveScan(const ScanJobPtr &pJob)
+{
+	return !pJob->IsCanceled() && pJob == m_pActiveScan;
+}
+
+//The scan gets its own copy of the frame (from the pool, so rescans reuse the buffer), converted to RGB in the same pass
+//if it isn't already.  Row order is left alone, the desktop and camera frames are both bottom up and the encoder deals with that
+static bool CopyCaptureForScan(SoftSurface *pSrc, SoftSurfacePool *pPool, SoftSurfacePtr *pDestOut)
+{
+	ePixelFormat format = GetPixelFormatOfSurface(pSrc);
+	if (format == PIXEL_FORMAT_COUNT)
+	{
+		LogMsg("Don't know how to scan this surface type");
+		return false;
+	}
+
+	*pDestOut = pPool->Get(pSrc->GetWidth(), pSrc->GetHeight(), SoftSurface::SURFACE_RGB);
+	return ConvertPixelsToSurface(pSrc->GetPixelData(), pSrc->GetPitch(), format, pSrc->GetWidth(), pSrc->GetHeight(), false,
+		pDestOut->get(), SoftSurface::SURFACE_RGB);
+}
+
+const int C_SCAN_CROP_MIN_PADDING = 32; //around the changed pixels, so the OCR has a bit of context
+const int C_SCAN_CROP_MIN_SIZE = 64;
+const int C_SCAN_CROP_TEXT_MARGIN = 4; //OCR boxes can be a little tight on the glyphs
+const float C_SCAN_CROP_MAX_AREA_PERCENT = 0.75f; //any bigger than this and we may as well send the whole thing
+
+static bool RectsOverlap(const CL_Rect &a, const CL_Rectf &b)
+{
+	return b.left < a.right && b.right > a.left && b.top < a.bottom && b.bottom > a.top;
+}
+
+//Compares the new capture with the last scan of the same area and works out how much of it actually needs to go to the
+//OCR.  Any old text the change touches gets sent again whole (a word changing in the middle of a sentence changes the
+//whole sentence), everything else keeps what the last scan found.
+static void FindScanCrop(ScanJob *pJob)
+{
+	CaptureFrame frame, prevFrame;
+	if (!frame.InitFromSoftSurface(pJob->m_pCapture.get(), true)) return;
+	if (!prevFrame.InitFromSoftSurface(pJob->m_pPrevCapture.get(), true)) return;
+	if (frame.m_width != prevFrame.m_width || frame.m_height != prevFrame.m_height) return;
+
+	CL_Rect crop;
+	if (!FindChangedRect(frame, prevFrame, &crop))
+	{
+		pJob->m_bUnchanged = true;
+		return;
+	}
+
+	//pad by about a line of text, bigger text needs more room for the OCR to make sense of it
+	float averageTextHeight = 0;
+	for (int i = 0; i < (int)pJob->m_prevTextAreas.size(); i++)
+	{
+		averageTextHeight += pJob->m_prevTextAreas[i].m_averageTextHeight;
+	}
+	if (!pJob->m_prevTextAreas.empty()) averageTextHeight /= pJob->m_prevTextAreas.size();
+
+	int padding = rt_max(C_SCAN_CROP_MIN_PADDING, (int)averageTextHeight);
+	crop.left -= padding;
+	crop.top -= padding;
+	crop.right += padding;
+	crop.bottom += padding;
+
+	if (crop.get_width() < C_SCAN_CROP_MIN_SIZE)
+	{
+		crop.left -= (C_SCAN_CROP_MIN_SIZE - crop.get_width()) / 2;
+		crop.right = crop.left + C_SCAN_CROP_MIN_SIZE;
+	}
+
+	if (crop.get_height() < C_SCAN_CROP_MIN_SIZE)
+	{
+		crop.top -= (C_SCAN_CROP_MIN_SIZE - crop.get_height()) / 2;
+		crop.bottom = crop.top + C_SCAN_CROP_MIN_SIZE;
+	}
+
+	//keep growing it until it doesn't cut through any of the old text, taking in one can make it touch another
+	bool bGrew = true;
+	while (bGrew)
+	{
+		bGrew = false;
+		for (int i = 0; i < (int)pJob->m_prevTextAreas.size(); i++)
+		{
+			const CL_Rectf &r = pJob->m_prevTextAreas[i].m_rect;
+			if (!RectsOverlap(crop, r)) continue;
+
+			CL_Rect grown(rt_min(crop.left, (int)floor(r.left) - C_SCAN_CROP_TEXT_MARGIN),
+				rt_min(crop.top, (int)floor(r.top) - C_SCAN_CROP_TEXT_MARGIN),
+				rt_max(crop.right, (int)ceil(r.right) + C_SCAN_CROP_TEXT_MARGIN),
+				rt_max(crop.bottom, (int)ceil(r.bottom) + C_SCAN_CROP_TEXT_MARGIN));
+
+			if (grown.left != crop.left || grown.top != crop.top || grown.right != crop.right || grown.bottom != crop.bottom)
+			{
+				crop = grown;
+				bGrew = true;
+			}
+		}
+	}
+
+	crop.left = rt_max(crop.left, 0);
+	crop.top = rt_max(crop.top, 0);
+	crop.right = rt_min(crop.right, frame.m_width);
+	crop.bottom = rt_min(crop.bottom, frame.m_height);
+
+	if ((float)crop.get_width() * crop.get_height() > (float)frame.m_width * frame.m_height * C_SCAN_CROP_MAX_AREA_PERCENT)
+	{
+		return;
+	}
+
+	pJob->m_cropRect = crop;
+	pJob->m_bCropped = true;
+}
+
+//The OCR only saw the crop, and BuildDatabase already moved what it found back to where it is in the full capture.  The
+//old text outside of the crop didn't change, so it goes back in as is.  Order is kept roughly top to bottom.
+static void MergeCroppedScan(ScanJob *pJob)
+{
+	vector<TextArea> merged;
+	merged.reserve(pJob->m_prevTextAreas.size() + pJob->m_textAreas.size());
+
+	for (int i = 0; i < (int)pJob->m_prevTextAreas.size(); i++)
+	{
+		const TextArea &area = pJob->m_prevTextAreas[i];
+		if (!RectsOverlap(pJob->m_cropRect, area.m_rect) && area.m_rect.top < pJob->m_cropRect.top) merged.push_back(area);
+	}
+
+	merged.insert(merged.end(), pJob->m_textAreas.begin(), pJob->m_textAreas.end());
+
+	for (int i = 0; i < (int)pJob->m_prevTextAreas.size(); i++)
+	{
+		const TextArea &area = pJob->m_prevTextAreas[i];
+		if (!RectsOverlap(pJob->m_cropRect, area.m_rect) && area.m_rect.top >= pJob->m_cropRect.top) merged.push_back(area);
+	}
+
+	pJob->m_textAreas.swap(merged);
+}
+
+bool GameLogicComponent::CanCropToLastScan(const CL_Rect &captureRect)
+{
+	if (!GetApp()->m_ocr_only_changed_area || !m_pLastScanCapture) return false;
+
+	//the old text is only any good if it was read from the same spot, the same way
+	return captureRect.left == m_lastScanCaptureRect.left && captureRect.top == m_lastScanCaptureRect.top
+		&& captureRect.right == m_lastScanCaptureRect.right && captureRect.bottom == m_lastScanCaptureRect.bottom
+		&& m_lastScanHinting == (int)GetApp()->GetGlobalTextHinting()
+		&& m_lastScanVisionEngine == (int)GetApp()->GetVisionEngine();
+}
+
+//A scan goes capture (here) -> encode (worker) -> OCR (network) -> parse (worker) -> build entities (here), and then each
+//TextAreaComponent does translate (network) -> rasterize (worker) -> upload (main thread) on its own
+void GameLogicComponent::StartProcessingFrameForText()
+{
+	GetApp()->m_sig_kill_all_text(); //also cancels the last scan if it was still going
+	m_textareas.clear();
+	
 	bool bPlayHide = GetApp()->GetVar("check_hide_overlay")->GetUINT32() != 0;
 	if (bPlayHide)
 	{
 		GetApp()->StartHidingOverlays();
 	}
 
+	ScanJobPtr pJob(new ScanJob(++m_scanCount));
+	m_pActiveScan = pJob;
+
 	if (!g_fileName.empty())
 	{
-		fileData = LoadFileIntoMemoryBasic(g_fileName, &originalFileSize);
+		unsigned int originalFileSize = 0;
+		byte *fileData = LoadFileIntoMemoryBasic(g_fileName, &originalFileSize);
+		if (!fileData)
+		{
+			LogMsg("Can't load %s", g_fileName.c_str());
+			m_pActiveScan.reset();
+			return;
+		}
+		pJob->m_jpg.assign(fileData, fileData + originalFileSize);
+		SAFE_DELETE_ARRAY(fileData);
+		OnScanEncoded(pJob);
+		return;
+	}
+
+	//normal handling.  Grab the pixels here, but take our own copy so the encode can happen on a worker while the
+	//capture surface is free to be reused
+	pJob->StartStage(SCAN_STAGE_CAPTURE);
 
+	if (GetApp()->IsInputDesktop())
+	{
+		pJob->m_captureRect = CL_Rect(GetApp()->m_window_pos_x, GetApp()->m_window_pos_y,
+			GetApp()->m_window_pos_x + GetApp()->m_capture_width, GetApp()->m_window_pos_y + GetApp()->m_capture_height);
+
+		if (!m_desktopCapture.Capture(GetApp()->m_window_pos_x, GetApp()->m_window_pos_y, GetApp()->m_capture_width, GetApp()->m_capture_height))
+		{
+			ShowQuickMessage("Unable to capture the screen");
+			m_pActiveScan.reset();
+			return;
+		}
+		if (m_desktopCapture.GetSoftSurface()->GetSurfaceType() == SoftSurface::SURFACE_NONE)
+		{
+			assert(!"Huh?");
+		}
+		if (!CopyCaptureForScan(m_desktopCapture.GetSoftSurface(), &m_scanSurfacePool, &pJob->m_pCapture))
+		{
+			ShowQuickMessage("Unable to read the screen capture");
+			m_pActiveScan.reset();
+			return;
+		}
+		pJob->AddBytesCopied(SCAN_STAGE_CAPTURE, pJob->m_pCapture->GetPitch() * pJob->m_pCapture->GetHeight());
+
+		if (CanCropToLastScan(pJob->m_captureRect))
+		{
+			pJob->m_pPrevCapture = m_pLastScanCapture;
+			pJob->m_prevTextAreas = m_lastScanTextAreas;
+		}
 	}
 	else
 	{
-		//normal handling
+		if (!m_escapiManager.GetSurface()->IsLoaded())
+		{
+			LogMsg("Can't process, no frame loaded");
+			ShowQuickMessage("Can't process, no frame loaded");
+			m_pActiveScan.reset();
+			return;
+		}
 
-		if (GetApp()->IsInputDesktop())
+		if (!CopyCaptureForScan(m_escapiManager.GetSoftSurface(), &m_scanSurfacePool, &pJob->m_pCapture))
 		{
-			m_desktopCapture.Capture(GetApp()->m_window_pos_x, GetApp()->m_window_pos_y, GetApp()->m_capture_width, GetApp()->m_capture_height);
-			if (m_desktopCapture.GetSoftSurface()->GetSurfaceType() == SoftSurface::SURFACE_NONE)
+			ShowQuickMessage("Unable to read the camera frame");
+			m_pActiveScan.reset();
+			return;
+		}
+		pJob->AddBytesCopied(SCAN_STAGE_CAPTURE, pJob->m_pCapture->GetPitch() * pJob->m_pCapture->GetHeight());
+	}
+
+	pJob->EndStage(SCAN_STAGE_CAPTURE);
+
+	int quality = GetApp()->m_jpg_quality_for_scan;
+	int visionEngine = (int)GetApp()->GetVisionEngine();
+	string detectionCommand = GetApp()->m_google_text_detection_command;
+	string languageHint = GetApp()->m_source_language_hint;
+
+	if (visionEngine == VISION_ENGINE_TESSERACT)
+	{
+		languageHint = GetApp()->m_tesseract_languages; //so switching its models doesn't give back old results from the cache
+	}
+
+	GetApp()->GetWorkerPool()->AddJob([this, pJob, quality, visionEngine, detectionCommand, languageHint]()
+	{
+		//what we'd send, the whole capture or just the part that changed
+		CaptureFrame sendFrame;
+
+		pJob->StartStage(SCAN_STAGE_ENCODE);
+		if (!pJob->IsCanceled() && pJob->m_pCapture)
+		{
+			if (pJob->m_pPrevCapture)
+			{
+				FindScanCrop(pJob.get());
+				pJob->m_pPrevCapture.reset();
+			}
+
+			sendFrame.InitFromSoftSurface(pJob->m_pCapture.get(), true);
+
+			if (pJob->m_bCropped)
+			{
+				//bottom up, so the crop's bottom row is the first one in memory
+				const CL_Rect &crop = pJob->m_cropRect;
+				sendFrame.m_pPixels += (sendFrame.m_height - crop.bottom) * sendFrame.m_pitch + crop.left * GetPixelFormatBytesPerPixel(sendFrame.m_format);
+				sendFrame.m_width = crop.get_width();
+				sendFrame.m_height = crop.get_height();
+			}
+
+			if (!pJob->m_bUnchanged && GetApp()->GetOcrCache()->IsEnabled())
+			{
+				//seen this before?  Then we already know what the OCR will say
+				pJob->m_ocrSignature.Compute(sendFrame);
+				pJob->m_ocrCacheContext = OcrCache::MakeContext(sendFrame.m_width, sendFrame.m_height, visionEngine, detectionCommand, languageHint);
+				pJob->m_bOcrCacheHit = GetApp()->GetOcrCache()->Get(pJob->m_ocrCacheContext, pJob->m_ocrSignature, &pJob->m_ocrResponse);
+				if (pJob->m_bOcrCacheHit)
+				{
+					pJob->m_ocrResponse.push_back(0); //the parser wants it null terminated
+				}
+			}
+
+			if (!pJob->m_bUnchanged && !pJob->m_bOcrCacheHit && visionEngine != VISION_ENGINE_TESSERACT)
 			{
-				assert(!"Huh?");
+				//We encode straight into memory now, writing temp.jpg and loading it back in was a waste of time
+				//The capture is bottom up, the encoder can read it that way so no FlipY needed
+				JPGMemoryEncoder jpg;
+				jpg.Encode(sendFrame.m_pPixels, sendFrame.m_width, sendFrame.m_height, sendFrame.m_pitch, sendFrame.m_format, true, quality,
+					&pJob->m_jpg);
+				pJob->AddBytesCopied(SCAN_STAGE_ENCODE, jpg.GetBytesCopied());
 			}
-			m_desktopCapture.GetSoftSurface()->FlipY();
-			JPGSurfaceLoader jpg;
-			jpg.SaveToFile(m_desktopCapture.GetSoftSurface(), "temp.jpg", GetApp()->m_jpg_quality_for_scan);
-			m_desktopCapture.GetSoftSurface()->FlipY();
 		}
-		else
+		//m_pCapture is held onto, if this scan finishes it's what the next one gets compared against
+		pJob->EndStage(SCAN_STAGE_ENCODE);
+
+		if (visionEngine == VISION_ENGINE_TESSERACT && !pJob->m_bUnchanged && !pJob->m_bOcrCacheHit && !pJob->IsCanceled()
+			&& pJob->m_pCapture)
 		{
-			if (!m_escapiManager.GetSurface()->IsLoaded())
+			//local OCR, no jpg or upload.  It's already on a worker thread, so it just happens here
+			pJob->StartStage(SCAN_STAGE_OCR);
+			if (GetApp()->GetTesseractOcr()->Recognize(sendFrame, pJob->m_cancelToken, &pJob->m_ocrResponse))
 			{
-				LogMsg("Can't process, no frame loaded");
-				ShowQuickMessage("Can't process, no frame loaded");
-				return;
+				pJob->m_ocrResponse.push_back(0); //the parser wants it null terminated
 			}
+			pJob->EndStage(SCAN_STAGE_OCR);
+		}
+
+		GetApp()->GetWorkerPool()->PostToMainThread(boost::bind(&GameLogicComponent::OnScanEncoded, this, pJob));
+	});
+}
+
+void GameLogicComponent::OnScanEncoded(ScanJobPtr pJob)
+{
+	if (!IsActiveScan(pJob)) return;
+
+	if (pJob->m_bUnchanged)
+	{
+		//not a pixel changed since the last scan, no reason to ask the OCR again
+		LogMsg("Capture is the same as the last scan, reusing its text");
+		pJob->m_textAreas = pJob->m_prevTextAreas;
+		pJob->m_bParsedOk = true;
+		OnScanParsed(pJob);
+		return;
+	}
 
-			JPGSurfaceLoader jpg;
-			SoftSurface temp;
-			temp.Init(m_escapiManager.GetSoftSurface()->GetWidth(), m_escapiManager.GetSoftSurface()->GetHeight(),
-				SoftSurface::SURFACE_RGB);
-			temp.Blit(0, 0, m_escapiManager.GetSoftSurface());
-			temp.FlipY();
-			jpg.SaveToFile(&temp, "temp.jpg", GetApp()->m_jpg_quality_for_scan);
+	if (pJob->m_bOcrCacheHit)
+	{
+		LogMsg("OCR cache hit, no need to send it");
+		StartParsing(pJob);
+		return;
+	}
+
+	if (GetApp()->GetVisionEngine() == VISION_ENGINE_TESSERACT)
+	{
+		if (pJob->m_ocrResponse.empty())
+		{
+			TesseractOcr *pTesseract = GetApp()->GetTesseractOcr();
+			if (pTesseract->HasFailed())
+			{
+				ShowQuickMessage("Tesseract couldn't load its language data, check log.txt");
+			}
+			else if (!pTesseract->IsReady())
+			{
+				ShowQuickMessage("Tesseract is still loading, try again in a second");
+			}
+			else
+			{
+				ShowQuickMessage("Tesseract OCR failed");
+			}
+			m_pActiveScan.reset();
+			return;
 		}
 
-		//****************
-		fileData = LoadFileIntoMemoryBasic("temp.jpg", &originalFileSize);
+		StartParsing(pJob);
+		return;
 	}
 
+	if (pJob->m_jpg.empty())
+	{
+		ShowQuickMessage("Error encoding the capture as a jpg");
+		m_pActiveScan.reset();
+		return;
+	}
+
+	//keep it around, the upload borrows it and the screenshot stuff can save it later
+	m_scanJPG.swap(pJob->m_jpg);
+	
+	if (GetApp()->m_save_scan_to_temp_jpg && g_fileName.empty())
+	{
+		//nothing needs this anymore, but it's handy for debugging
+		SaveLastScanJPGAsync("temp.jpg");
+	}
+
+	if (pJob->m_bCropped)
+	{
+		LogMsg("Only sending the changed area of the capture (%d, %d, %d, %d)", pJob->m_cropRect.left, pJob->m_cropRect.top,
+			pJob->m_cropRect.right, pJob->m_cropRect.bottom);
+	}
+
+	pJob->StartStage(SCAN_STAGE_OCR);
+
 	if (GetApp()->GetVisionEngine() == VISION_ENGINE_GOOGLE)
 	{
-		InvokeGoogleVisionAPI(fileData, originalFileSize);
+		InvokeGoogleVisionAPI(&m_scanJPG[0], (unsigned int)m_scanJPG.size());
 	}
 	else
 	{
-		InvokeMicrosoftVisionAPI(fileData, originalFileSize);
+		InvokeMicrosoftVisionAPI(&m_scanJPG[0], (unsigned int)m_scanJPG.size());
+	}
+}
+
+void GameLogicComponent::OnScanParsed(ScanJobPtr pJob)
+{
+	if (!IsActiveScan(pJob)) return;
+
+	if (!pJob->m_bParsedOk)
+	{
+		TextScanner s;
+		s.AppendFromMemoryAddressRaw((char*)&pJob->m_ocrResponse[0], pJob->m_ocrResponse.size() - 1);
+		s.StripLeadingSpaces();
+
+		string error = s.GetParmString("\"message\"", 1, ":");
+		
+		string msg = "Error.txt written: " + error;
+
+		UpdateStatusMessage(msg);
+		LogMsg(msg.c_str());
+		
+		FILE *fp = fopen("error.txt", "wb");
+		fwrite(&pJob->m_ocrResponse[0], pJob->m_ocrResponse.size() - 1, 1, fp);
+		fclose(fp);
+		m_pActiveScan.reset();
+		return;
+	}
+
+	pJob->StartStage(SCAN_STAGE_BUILD);
+	m_textareas.swap(pJob->m_textAreas);
+
+	//remember what this scan saw, if the next one is of the same area it'll only send what changed
+	m_pLastScanCapture = pJob->m_pCapture;
+	m_lastScanTextAreas = m_textareas;
+	m_lastScanCaptureRect = pJob->m_captureRect;
+	m_lastScanHinting = (int)GetApp()->GetGlobalTextHinting();
+	m_lastScanVisionEngine = (int)GetApp()->GetVisionEngine();
+
+	ConstructEntitiesFromTextAreas();
+	pJob->EndStage(SCAN_STAGE_BUILD);
+
+	if (m_textareas.empty())
+	{
+		//nothing to translate, so this is as far as it goes
+		pJob->LogTimings();
+		m_pActiveScan.reset();
+		return;
 	}
+
+	//ends when OnUpdate notices every text area is translated and showing
+	pJob->StartStage(SCAN_STAGE_TRANSLATE);
 }
 
-void GameLogicComponent::InvokeGoogleVisionAPI(byte* fileData, unsigned int originalFileSize)
+static bool SaveBottomUpSurfaceAsJPG(SoftSurface *pSurf, string fileName)
+{
+	JPGMemoryEncoder jpg;
+	vector<byte> data;
+	if (!jpg.Encode(pSurf, GetApp()->m_jpg_quality_for_scan, &data, true)) return false;
+
+	FILE *fp = fopen(fileName.c_str(), "wb");
+	if (!fp)
+	{
+		LogMsg("Unable to write %s", fileName.c_str());
+		return false;
+	}
+
+	fwrite(&data[0], data.size(), 1, fp);
+	fclose(fp);
+	return true;
+}
+
+bool GameLogicComponent::SaveLastScanJPG(string fileName)
+{
+	if (m_pLastScanCapture)
+	{
+		//m_scanJPG might only be the part that changed, this has the whole thing
+		return SaveBottomUpSurfaceAsJPG(m_pLastScanCapture.get(), fileName);
+	}
+
+	if (m_scanJPG.empty()) return false;
+
+	FILE *fp = fopen(fileName.c_str(), "wb");
+	if (!fp)
+	{
+		LogMsg("Unable to write %s", fileName.c_str());
+		return false;
+	}
+
+	fwrite(&m_scanJPG[0], m_scanJPG.size(), 1, fp);
+	fclose(fp);
+	return true;
+}
+
+void GameLogicComponent::SaveLastScanJPGAsync(string fileName)
+{
+	if (m_scanJPG.empty()) return;
+
+	static std::mutex writeMutex; //if scans come quick, don't let two of these write the same file at once
+
+	//the job gets its own copy, m_scanJPG gets reused by the next scan.  It doesn't touch us, so it's fine to still be
+	//running it while shutting down, App::Kill() waits for it
+	std::shared_ptr<vector<byte> > pData = std::make_shared<vector<byte> >(m_scanJPG);
+
+	GetApp()->GetWorkerPool()->AddJobMustFinish([pData, fileName]()
+	{
+		std::lock_guard<std::mutex> lock(writeMutex);
+		FILE *fp = fopen(fileName.c_str(), "wb");
+		if (fp)
+		{
+			fwrite(&pData->at(0), pData->size(), 1, fp);
+			fclose(fp);
+		}
+	});
+}
+
+void GameLogicComponent::InvokeGoogleVisionAPI(const byte* fileData, unsigned int originalFileSize)
 {
 	string postDataOCR_a = R"({
       'requests': [
@@ -1291,16 +1732,17 @@ void GameLogicComponent::InvokeGoogleVisionAPI(byte* fileData, unsigned int orig
     }
 )";
 
-	string encodedImage = base64_encode(fileData, originalFileSize);
+	//The image isn't base64'd or glued into one big string anymore, the body parts get written directly into curl's
+	//send buffer (base64 encoding on the fly) as the upload goes.  m_scanJPG sticks around until the next scan.
+	m_ocrHTTP.Setup("https://vision.googleapis.com/v1/images:annotate?key=" + GetApp()->GetGoogleKey());
+	m_ocrHTTP.SetFinishedCallback(boost::bind(&GameLogicComponent::OnOCRRequestFinished, this, _1));
+	m_ocrHTTP.AddBodyText(postDataOCR_a);
+	m_ocrHTTP.AddBodyBytesAsBase64(fileData, originalFileSize);
+	m_ocrHTTP.AddBodyText(postDataOCR_b + postDataOCR_c + postDataOCR_d);
 
-	SAFE_DELETE_ARRAY(fileData);
+	LogMsg("OCR upload is %d KB", (int)(m_ocrHTTP.GetPostDataSize() / 1024));
 
-	string requestWithEmbeddedFile = postDataOCR_a + encodedImage + postDataOCR_b + postDataOCR_c + postDataOCR_d;
-	string url = "https://vision.googleapis.com";
-	string urlappend = "/v1/images:annotate?key=" + GetApp()->GetGoogleKey();
-	m_netHTTP.Setup(url, 80, urlappend, NetHTTP::END_OF_DATA_SIGNAL_HTTP);
-	m_netHTTP.AddPostData("", (const byte*)requestWithEmbeddedFile.c_str(), (int)requestWithEmbeddedFile.length());
-	m_netHTTP.Start();
+	m_ocrHTTP.Start();
 
 	UpdateStatusMessage("Sending image to google for OCR processing...");
 }
@@ -1323,24 +1765,90 @@ std::vector<unsigned char> readFile(const std::string& filePath) {
 	return buffer;
 }
 
-byte* lastFileData = NULL;
-void GameLogicComponent::InvokeMicrosoftVisionAPI(byte* fileData, unsigned int originalFileSize)
+void GameLogicComponent::InvokeMicrosoftVisionAPI(const byte* fileData, unsigned int originalFileSize)
 {
-	string url = "https://uat-ocr.cognitiveservices.azure.com";
-	string urlappend = "/computervision/imageanalysis:analyze?features=read&model-version=latest&language=ja&api-version=2024-02-01";
-	m_netHTTP.Setup(url, 80, urlappend, NetHTTP::END_OF_DATA_SIGNAL_HTTP);
+	m_ocrHTTP.Setup("https://uat-ocr.cognitiveservices.azure.com/computervision/imageanalysis:analyze?features=read&model-version=latest&language=ja&api-version=2024-02-01");
 	vector<string> headers;
 	headers.push_back("Content-Type: application/octet-stream");
 	headers.push_back("Ocp-Apim-Subscription-Key: " + GetApp()->GetMicrosoftVisionKey());
-	m_netHTTP.SetCustomHeaders(headers);
-	m_netHTTP.StartPostImage(fileData, originalFileSize);
-
-	SAFE_DELETE_ARRAY(lastFileData);
-	lastFileData = fileData;
+	m_ocrHTTP.SetCustomHeaders(headers);
+	m_ocrHTTP.SetFinishedCallback(boost::bind(&GameLogicComponent::OnOCRRequestFinished, this, _1));
+	m_ocrHTTP.AddBodyBytes(fileData, originalFileSize); //not copied, m_scanJPG sticks around until the next scan
+	m_ocrHTTP.Start();
 
 	UpdateStatusMessage("Sending image to Microsoft for OCR processing...");
 }
 
+void GameLogicComponent::OnOCRRequestFinished(CurlRequest *pRequest)
+{
+	ScanJobPtr pJob = m_pActiveScan;
+	if (!pJob) return;
+	pJob->EndStage(SCAN_STAGE_OCR);
+	pJob->AddBytesCopied(SCAN_STAGE_OCR, pRequest->GetBodyBytesCopied());
+
+	if (pRequest->GetError() != CurlRequest::ERROR_NONE)
+	{
+		//Big error, show message
+		string msg = string("OCR request error: ") + pRequest->GetErrorString();
+		UpdateStatusMessage(msg);
+		LogMsg(msg.c_str());
+		m_pActiveScan.reset();
+		return;
+	}
+
+#ifdef _DEBUG
+	FILE *fp = fopen("ocr_response_from_google.json", "wb");
+	fwrite(pRequest->GetDownloadedData(), pRequest->GetDownloadedBytes(), 1, fp);
+	fclose(fp);
+#endif
+
+	if (GetApp()->GetCaptureMode() == CAPTURE_MODE_WAITING)
+	{
+		CancelScan(); //ignore it, was apparently canceled mid download
+		return;
+	}
+
+	//the request gets reused by the next scan, so the parser gets its own copy (null included)
+	pJob->m_ocrResponse.assign(pRequest->GetDownloadedData(), pRequest->GetDownloadedData() + pRequest->GetDownloadedBytes() + 1);
+	StartParsing(pJob);
+
+	// Hack: Hide settings icon
+	//CreateExamineOverlay();
+}
+
+void GameLogicComponent::StartParsing(ScanJobPtr pJob)
+{
+	LogMsg("Parsing...");
+	UpdateStatusMessage("Parsing...");
+
+	GetApp()->GetWorkerPool()->AddJob([this, pJob]()
+	{
+		pJob->StartStage(SCAN_STAGE_PARSE);
+		if (!pJob->IsCanceled())
+		{
+			CL_Vec2f offset(0, 0);
+			if (pJob->m_bCropped) offset = CL_Vec2f((float)pJob->m_cropRect.left, (float)pJob->m_cropRect.top);
+
+			pJob->m_bParsedOk = BuildDatabase((char*)&pJob->m_ocrResponse[0], &pJob->m_textAreas, offset);
+
+			//Only remember responses that actually found something, an error body can parse "fine" as no text
+			if (pJob->m_bParsedOk && !pJob->m_bOcrCacheHit && !pJob->m_textAreas.empty() && pJob->m_ocrSignature.IsValid())
+			{
+				GetApp()->GetOcrCache()->Put(pJob->m_ocrCacheContext, pJob->m_ocrSignature, &pJob->m_ocrResponse[0],
+					pJob->m_ocrResponse.size() - 1);
+			}
+
+			if (pJob->m_bParsedOk && pJob->m_bCropped)
+			{
+				MergeCroppedScan(pJob.get());
+			}
+		}
+		pJob->EndStage(SCAN_STAGE_PARSE);
+
+		GetApp()->GetWorkerPool()->PostToMainThread(boost::bind(&GameLogicComponent::OnScanParsed, this, pJob));
+	});
+}
+
 extern bool g_bHasFocus;
 
 void GameLogicComponent::UpdateStatusMessage(string msg)
@@ -1366,30 +1874,17 @@ void GameLogicComponent::OnUpdate(VariantList *pVList)
 		bDidFirstTime = true;
 	}
 
-	m_netHTTP.Update();
-
-	if (m_netHTTP.GetError() != NetHTTP::ERROR_NONE)
-	{
-		//Big error, show message
-	
-		string msg = string("NetHTTP error: ") + toString(m_netHTTP.GetError());
-		UpdateStatusMessage(msg);
-		LogMsg(msg.c_str());
-
-	}
-
-	if (m_netHTTP.GetState() == NetHTTP::STATE_ACTIVE)
+	if (m_ocrHTTP.GetState() == CurlRequest::STATE_ACTIVE)
 	{
 		string s = "Sending image to google for OCR processing... ";
 
-		int uploadedBytes = m_netHTTP.GetBytesUploaded();
+		int uploadedBytes = (int)m_ocrHTTP.GetBytesUploaded();
 
-		int bytes = m_netHTTP.GetDownloadedBytes();
-		int expectedBytes = m_netHTTP.GetExpectedBytes();
+		int bytes = (int)m_ocrHTTP.GetDownloadedBytes();
 
-		if (uploadedBytes < m_netHTTP.GetPostDataSize())
+		if (uploadedBytes < (int)m_ocrHTTP.GetPostDataSize())
 		{
-			s += " Uploading: (" + toString(uploadedBytes/1024) + "kb /" + toString(m_netHTTP.GetPostDataSize()/1024) + "kb)";
+			s += " Uploading: (" + toString(uploadedBytes/1024) + "kb /" + toString((int)m_ocrHTTP.GetPostDataSize()/1024) + "kb)";
 		}
 		else
 		{
@@ -1398,43 +1893,7 @@ void GameLogicComponent::OnUpdate(VariantList *pVList)
 		UpdateStatusMessage(s);
 	}
 
-	if (m_netHTTP.GetState() == NetHTTP::STATE_FINISHED)
-	{
-#ifdef _DEBUG
-		FILE *fp = fopen("ocr_response_from_google.json", "wb");
-		fwrite(m_netHTTP.GetDownloadedData(), m_netHTTP.GetDownloadedBytes(), 1, fp);
-		fclose(fp);
-#endif
-
-		if (GetApp()->GetCaptureMode() == CAPTURE_MODE_WAITING)
-		{
-			return; //ignore it, was apparently canceled mid download
-		}
-
-		if (!BuildDatabase((char*)m_netHTTP.GetDownloadedData()))
-		{
-			TextScanner s;
-			s.AppendFromMemoryAddressRaw((char*)m_netHTTP.GetDownloadedData(), m_netHTTP.GetDownloadedBytes());
-			s.StripLeadingSpaces();
-
-			string error = s.GetParmString("\"message\"", 1, ":");
-			
-			string msg = "Error.txt written: " + error;
-
-			UpdateStatusMessage(msg);
-			LogMsg(msg.c_str());
-			
-			FILE *fp = fopen("error.txt", "wb");
-			fwrite(m_netHTTP.GetDownloadedData(), m_netHTTP.GetDownloadedBytes(), 1, fp);
-			fclose(fp);
-		}
-
-		m_netHTTP.Reset(true);
-
-		// Hack: Hide settings icon
-		//CreateExamineOverlay();
-	}
-
+	m_translationBatcher.Update();
 
 	if (m_textComps.size() > 0)
 	{
@@ -1470,6 +1929,14 @@ void GameLogicComponent::OnUpdate(VariantList *pVList)
 			OnFinishedTranslations(); //good time to log to disk or whatever
 			m_bCalledOnFinishedTranslations = true;  //don't call this again unless we translate something else too
 
+			if (m_pActiveScan)
+			{
+				//that's the last stage, see where the time went
+				m_pActiveScan->EndStage(SCAN_STAGE_TRANSLATE);
+				m_pActiveScan->LogTimings();
+				m_pActiveScan.reset();
+			}
+
 			if (GetApp()->GetShared()->GetVar("check_invisible_mode")->GetUINT32() != 0)
 			{
 				//artificially close the window which was hidden already
@@ -1584,9 +2051,7 @@ void GameLogicComponent::OnTakeScreenshot()
 		SoftSurface crap;
 		crap.Init(GetScreenSizeX(), GetScreenSizeY(), SoftSurface::SURFACE_RGB, false);
 		crap.BlitFromScreen(0, 0, 0, 0, GetScreenSizeX(), GetScreenSizeY());
-		crap.FlipY();
-		JPGSurfaceLoader jpg;
-		jpg.SaveToFile(&crap, fileName, GetApp()->m_jpg_quality_for_scan);
+		SaveBottomUpSurfaceAsJPG(&crap, fileName);
 	}
 	else
 	{
@@ -1601,13 +2066,8 @@ void GameLogicComponent::OnTakeScreenshot()
 				return;
 			}
 
-			JPGSurfaceLoader jpg;
-			SoftSurface temp;
-			temp.Init(m_escapiManager.GetSoftSurface()->GetWidth(), m_escapiManager.GetSoftSurface()->GetHeight(),
-				SoftSurface::SURFACE_RGB);
-			temp.Blit(0, 0, m_escapiManager.GetSoftSurface());
-			temp.FlipY();
-			jpg.SaveToFile(&temp, fileName, GetApp()->m_jpg_quality_for_scan);
+			//no need to copy and flip it first, the encoder can read it as is
+			SaveBottomUpSurfaceAsJPG(m_escapiManager.GetSoftSurface(), fileName);
 		}
 	}
 
@@ -1617,6 +2077,10 @@ void GameLogicComponent::OnTakeScreenshot()
 void GameLogicComponent::OnFinishedTranslations()
 {
 	LogMsg("Finished all translations, let's do any logging if needed");
+	GetApp()->GetFreeTypeManager(GetApp()->m_target_language)->GetFont()->LogGlyphCacheStats();
+	GetApp()->GetTranslationCache()->LogStats();
+	GetApp()->GetOcrCache()->LogStats();
+	GetApp()->GetTTSCache()->LogStats();
 
 	if (GetApp()->m_log_capture_text_to_file != "disabled")
 	{
@@ -11,29 +11,19 @@
 #define GameLogicComponent_h__
 
 #include "Entity/Component.h"
-#include "Network/NetHTTP.h"
+#include "CurlRequest.h"
+#include "TranslationBatcher.h"
 #include "util/cJSON.h"
+#include "OcrResponseReader.h"
+#include "OcrDocument.h"
 #include "EscapiManager.h"
 #include "WinDesktopCapture.h"
+#include "SoftSurfacePool.h"
 
 class TextAreaComponent;
+class ScanJob;
 
 
-class WordInfo
-{
-public:
-	CL_Rectf m_rect;
-	string m_word;
-};
-
-class LineInfo
-{
-public:
-	CL_Rectf m_lineRect;
-	string m_text;
-	vector<WordInfo> m_words;
-};
-
 class TextArea
 {
 public:
@@ -45,11 +35,24 @@ public:
 
 	string language;
 	CL_Rectf m_rect = CL_Rectf(0,0,0,0);
-	vector<CL_Vec2f> m_lineStarts; //top left position of each line start
-	vector<LineInfo> m_lines;
 	float m_ySpacingToNextLineAverage = 0;
 	float m_averageTextHeight = 0;
 
+	//our lines are m_firstLine to m_firstLine + m_lineCount in the scan's document, the words are in there too
+	OcrDocumentPtr m_pDoc;
+	int m_firstLine = 0;
+	int m_lineCount = 0;
+
+	void AddLine(const CL_Rectf &rect, const string &text, int firstWord); //only while parsing
+	void Append(const TextArea &other); //auto-glue, other's lines go after ours.  Only while parsing, and only from the same document
+	bool HitTestWord(const CL_Vec2f &pt, int *pLineOut, int *pWordOut) const;
+	int GetLineCount() const { return m_lineCount; }
+	const CL_Rectf & GetLineRect(int line) const { return m_pDoc->GetLineRect(m_firstLine + line); }
+	CL_Vec2f GetLineStart(int line) const { return GetLineRect(line).get_top_left(); } //top left position of the line
+	string GetLineText(int line) const { return m_pDoc->GetLineText(m_firstLine + line); }
+	int GetWordCount(int line) const { return m_pDoc->GetLineWordCount(m_firstLine + line); }
+	const CL_Rectf & GetWordRect(int line, int word) const { return m_pDoc->GetWordRect(m_pDoc->GetLineFirstWord(m_firstLine + line) + word); }
+	string GetWordText(int line, int word) const { return m_pDoc->GetWordText(m_pDoc->GetLineFirstWord(m_firstLine + line) + word); }
 };
 
 
@@ -80,32 +83,64 @@ public:
 
 	Entity *m_pScreenShot;
 
-	NetHTTP m_netHTTP;
+	CurlRequest m_ocrHTTP;
 	std::vector<TextArea> m_textareas;
 	void StartProcessingFrameForText();
-	void InvokeGoogleVisionAPI(byte* fileData, unsigned int originalFileSize);
-	void InvokeMicrosoftVisionAPI(byte* fileData, unsigned int originalFileSize);
+	void CancelScan(); //drops whatever stage the current scan was in, nothing from it will show up
+	bool IsScanning() { return m_pActiveScan != NULL; } //true until the last text area from it is showing
+	void InvokeGoogleVisionAPI(const byte* fileData, unsigned int originalFileSize);
+	void InvokeMicrosoftVisionAPI(const byte* fileData, unsigned int originalFileSize);
+	void OnOCRRequestFinished(CurlRequest *pRequest);
+	bool SaveLastScanJPG(string fileName);
+	void SaveLastScanJPGAsync(string fileName);
 	EscapiManager m_escapiManager;
 	WinDesktopCapture m_desktopCapture;
+	SoftSurfacePool m_scanSurfacePool; //the copy each scan takes of the capture
 	string m_status;
 
 	std::vector<TextAreaComponent*> m_textComps;
 	void AddTextBox(TextAreaComponent *p);
 	void RemoveTextBox(TextAreaComponent *p);
+	bool ParkTextBox(TextAreaComponent *p); //false if we're not keeping them, then it should just delete itself
+	TranslationBatcher* GetTranslationBatcher() { return &m_translationBatcher; }
 
 private:
 
-	bool ProcessParagraphGoogleWay(const cJSON* paragraph, TextArea& textArea);
-	bool ProcessParagraphMicrosoftWay(const cJSON* line, TextArea& textArea);
-	bool ReadFromParagraph(const cJSON *paragraph, TextArea &textArea);
-	void ConstructEntityFromTextArea(TextArea &textArea);
+	//The parsing ones run on a worker thread, they only fill in the vector they're given and read the config
+	bool ProcessParagraphGoogleWay(const OcrParagraph& paragraph, TextArea& textArea, vector<TextArea> &textAreas, CL_Vec2f offset);
+	bool ProcessParagraphMicrosoftWay(const OcrParagraph& line, TextArea& textArea, CL_Vec2f offset);
+	bool ReadFromParagraph(const OcrParagraph& paragraph, TextArea &textArea, vector<TextArea> &textAreas, CL_Vec2f offset);
+	void ConstructEntityFromTextArea(const TextArea &textArea);
 	void ConstructEntitiesFromTextAreas();
-	void MergeWithPreviousTextIfNeeded(TextArea& textArea);
-	bool BuildDatabase(char* pJson);
-	bool BuildDatabaseGoogleVision(char *pJson);
-	bool BuildDatabaseMicrosoftVision(char* pJson);
+	void ReconcileTextAreas(); //reuses parked text boxes that match, only builds the ones that are new
+	std::vector<TextAreaComponent*> m_parkedTextComps; //from the last scan, hidden until we know if this one wants them
+	void GuessTextAreaLayout(TextArea &textArea); //dialog or not, average line height and spacing
+	bool CanAutoGlue(const TextArea &upper, const TextArea &lower);
+	void AutoGlueTextAreas(vector<TextArea> &textAreas);
+	//offset is added to every box the OCR gives back, for when we only sent part of the capture
+	bool BuildDatabase(char* pJson, vector<TextArea> *pTextAreasOut, CL_Vec2f offset = CL_Vec2f(0, 0));
+	bool BuildDatabaseGoogleVision(char *pJson, vector<TextArea> *pTextAreasOut, CL_Vec2f offset, const OcrDocumentPtr &pDoc);
+	bool BuildDatabaseMicrosoftVision(char* pJson, vector<TextArea> *pTextAreasOut, CL_Vec2f offset, const OcrDocumentPtr &pDoc);
+
+	void OnKillAllText();
+	void OnScanEncoded(std::shared_ptr<ScanJob> pJob);
+	void StartParsing(std::shared_ptr<ScanJob> pJob); //m_ocrResponse -> m_textAreas on a worker
+	void OnScanParsed(std::shared_ptr<ScanJob> pJob);
+	bool IsActiveScan(const std::shared_ptr<ScanJob> &pJob);
 	Entity* m_pSettingsIcon = NULL;
 	bool m_bCalledOnFinishedTranslations = false;
+	TranslationBatcher m_translationBatcher;
+	vector<byte> m_scanJPG; //the last thing we sent to be OCR'd, reused each scan
+	std::shared_ptr<ScanJob> m_pActiveScan; //whatever scan is still working its way through the stages
+
+	//The last scan that made it all the way through.  If the next one is of the same area, it only sends what changed
+	bool CanCropToLastScan(const CL_Rect &captureRect);
+	SoftSurfacePtr m_pLastScanCapture;
+	vector<TextArea> m_lastScanTextAreas;
+	CL_Rect m_lastScanCaptureRect;
+	int m_lastScanHinting = -1; //eTextHinting
+	int m_lastScanVisionEngine = -1; //eVisionEngine
+	uint32 m_scanCount = 0;
 
 };
 
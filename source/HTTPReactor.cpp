@@ -0,0 +1,130 @@
+#include "PlatformPrecomp.h"
+#include "HTTPReactor.h"
+#include "CurlRequest.h"
+
+void InitCURLIfNeeded(); //in NetHTTP_libCURL.cpp
+
+HTTPReactor::HTTPReactor()
+{
+}
+
+HTTPReactor::~HTTPReactor()
+{
+	Kill();
+}
+
+bool HTTPReactor::InitIfNeeded()
+{
+	if (m_pMultiHandle) return true;
+
+	InitCURLIfNeeded();
+
+	m_pMultiHandle = curl_multi_init();
+	if (!m_pMultiHandle)
+	{
+		LogMsg("HTTPReactor: Unable to init curl");
+		return false;
+	}
+
+	//let requests to the same host share one HTTP/2 connection instead of each opening their own
+	curl_multi_setopt(m_pMultiHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+	curl_multi_setopt(m_pMultiHandle, CURLMOPT_MAX_HOST_CONNECTIONS, 6L);
+
+	//we're single threaded, so no lock functions needed.  Connections themselves are already pooled by the multi handle,
+	//sharing those through here too would stop HTTP/2 multiplexing from working
+	m_pShareHandle = curl_share_init();
+	if (m_pShareHandle)
+	{
+		curl_share_setopt(m_pShareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(m_pShareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	}
+
+	return true;
+}
+
+bool HTTPReactor::AddRequest(CurlRequest *pRequest, CURL *pHandle)
+{
+	if (!InitIfNeeded()) return false;
+
+	if (m_pShareHandle)
+	{
+		curl_easy_setopt(pHandle, CURLOPT_SHARE, m_pShareHandle);
+	}
+
+	//use HTTP/2 over https if the server can, and wait for an existing connection to multiplex on rather than making
+	//a new one when a bunch of these start at once
+	curl_easy_setopt(pHandle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+	curl_easy_setopt(pHandle, CURLOPT_PIPEWAIT, 1L);
+
+	CURLMcode result = curl_multi_add_handle(m_pMultiHandle, pHandle);
+	if (result != CURLM_OK)
+	{
+		LogMsg("HTTPReactor: %s", curl_multi_strerror(result));
+		return false;
+	}
+
+	m_activeRequests.insert(pRequest);
+	return true;
+}
+
+void HTTPReactor::RemoveRequest(CurlRequest *pRequest, CURL *pHandle)
+{
+	if (m_activeRequests.erase(pRequest) == 0) return;
+	curl_multi_remove_handle(m_pMultiHandle, pHandle);
+}
+
+void HTTPReactor::Update()
+{
+	if (m_activeRequests.empty()) return;
+
+	int stillRunning = 0;
+	CURLMcode mc = curl_multi_perform(m_pMultiHandle, &stillRunning);
+
+	if (mc != CURLM_OK)
+	{
+		LogMsg("HTTPReactor: %s", curl_multi_strerror(mc));
+	}
+
+	CURLMsg *pMsg;
+	int msgsLeft = 0;
+
+	while ((pMsg = curl_multi_info_read(m_pMultiHandle, &msgsLeft)))
+	{
+		if (pMsg->msg != CURLMSG_DONE) continue;
+
+		CurlRequest *pRequest = NULL;
+		curl_easy_getinfo(pMsg->easy_handle, CURLINFO_PRIVATE, (char**)&pRequest);
+		CURLcode result = pMsg->data.result;
+
+		RemoveRequest(pRequest, pMsg->easy_handle);
+
+		//this calls its callback, which may well delete it, so don't touch it after
+		if (pRequest)
+		{
+			pRequest->OnTransferDone(result);
+		}
+	}
+}
+
+void HTTPReactor::Kill()
+{
+	//copy, as aborting removes them from the set
+	std::set<CurlRequest*> requests = m_activeRequests;
+	for (auto itor = requests.begin(); itor != requests.end(); itor++)
+	{
+		(*itor)->Reset();
+	}
+	m_activeRequests.clear();
+
+	if (m_pMultiHandle)
+	{
+		curl_multi_cleanup(m_pMultiHandle);
+		m_pMultiHandle = NULL;
+	}
+
+	if (m_pShareHandle)
+	{
+		curl_share_cleanup(m_pShareHandle);
+		m_pShareHandle = NULL;
+	}
+}
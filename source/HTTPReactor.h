@@ -0,0 +1,38 @@
+//One curl multi handle that every CurlRequest in the app runs on, pumped once per frame from App::Update().  They all use
+//the same connection pool, and a curl share handle gives them the same DNS cache and TLS sessions.  HTTP/2 is used where
+//the server supports it, so a scan with 25 text boxes doesn't mean 25 TLS handshakes anymore.  Requests get a callback when they
+//finish, nothing needs to poll.
+
+#ifndef HTTPReactor_h__
+#define HTTPReactor_h__
+
+#include <curl/curl.h>
+#include <set>
+
+class CurlRequest;
+
+class HTTPReactor
+{
+public:
+	HTTPReactor();
+	virtual ~HTTPReactor();
+
+	void Update();
+	void Kill(); //aborts anything still running
+
+	//CurlRequest calls these, you shouldn't need to
+	bool AddRequest(CurlRequest *pRequest, CURL *pHandle);
+	void RemoveRequest(CurlRequest *pRequest, CURL *pHandle);
+
+	int GetActiveRequestCount() { return (int)m_activeRequests.size(); }
+
+protected:
+
+	bool InitIfNeeded();
+
+	CURLM *m_pMultiHandle = NULL;
+	CURLSH *m_pShareHandle = NULL;
+	std::set<CurlRequest*> m_activeRequests;
+};
+
+#endif // HTTPReactor_h__
@@ -128,7 +128,7 @@ void HotKeyHandler::OnHideWindow()
 	if (GetApp()->m_audio_stop_when_window_is_closed)
 	{
 
-		GetAudioManager()->Stop(g_lastAudioHandle);
+		GetApp()->GetSpeechPlayer()->Stop(g_lastAudioHandle);
 	}
 } 
 
@@ -0,0 +1,172 @@
+#include "PlatformPrecomp.h"
+#include "JPGMemoryEncoder.h"
+#include "Renderer/SoftSurface.h"
+#include "WorkerPool.h"
+
+#ifdef RT_JPG_SUPPORT
+
+#include <setjmp.h>
+
+extern "C"
+{
+#include "Irrlicht/source/Irrlicht/jpeglib/jpeglib.h"
+}
+
+const size_t C_JPG_BUFFER_START_SIZE = 1024 * 256;
+
+//libjpeg writes into this, we grow the vector when it runs out of room
+struct JPGMemoryDestination
+{
+	jpeg_destination_mgr m_pub; //must be first
+	vector<byte> *m_pBuffer;
+	size_t m_grownBytes; //what resizing moved over to the new memory
+};
+
+static void InitMemoryDestination(j_compress_ptr cinfo)
+{
+	JPGMemoryDestination *pDest = (JPGMemoryDestination*)cinfo->dest;
+	
+	//use whatever room the vector already has from last time
+	pDest->m_pBuffer->resize(rt_max(pDest->m_pBuffer->capacity(), C_JPG_BUFFER_START_SIZE));
+	pDest->m_pub.next_output_byte = &pDest->m_pBuffer->at(0);
+	pDest->m_pub.free_in_buffer = pDest->m_pBuffer->size();
+}
+
+static boolean EmptyMemoryDestination(j_compress_ptr cinfo)
+{
+	//libjpeg only calls this when the whole buffer is full
+	JPGMemoryDestination *pDest = (JPGMemoryDestination*)cinfo->dest;
+	size_t used = pDest->m_pBuffer->size();
+
+	pDest->m_pBuffer->resize(used * 2);
+	pDest->m_grownBytes += used;
+	pDest->m_pub.next_output_byte = &pDest->m_pBuffer->at(used);
+	pDest->m_pub.free_in_buffer = pDest->m_pBuffer->size() - used;
+	return TRUE;
+}
+
+static void TermMemoryDestination(j_compress_ptr cinfo)
+{
+	JPGMemoryDestination *pDest = (JPGMemoryDestination*)cinfo->dest;
+	pDest->m_pBuffer->resize(pDest->m_pBuffer->size() - pDest->m_pub.free_in_buffer);
+}
+
+//the default libjpeg error handler calls exit(), which is a bit much
+struct JPGEncodeErrorManager
+{
+	jpeg_error_mgr m_pub; //must be first
+	jmp_buf m_setjmpBuffer;
+};
+
+static void OnJPGEncodeError(j_common_ptr cinfo)
+{
+	char msg[JMSG_LENGTH_MAX];
+	(*cinfo->err->format_message)(cinfo, msg);
+	LogMsgFromAnyThread("Error encoding jpg: %s", msg);
+	longjmp(((JPGEncodeErrorManager*)cinfo->err)->m_setjmpBuffer, 1);
+}
+
+#endif
+
+JPGMemoryEncoder::JPGMemoryEncoder()
+{
+}
+
+JPGMemoryEncoder::~JPGMemoryEncoder()
+{
+}
+
+bool JPGMemoryEncoder::Encode(SoftSurface *pSurf, int quality, vector<byte> *pBufferOut, bool bBottomUp)
+{
+	ePixelFormat format = GetPixelFormatOfSurface(pSurf);
+	if (format == PIXEL_FORMAT_COUNT)
+	{
+		LogMsgFromAnyThread("JPGMemoryEncoder: Only RGB and RGBA surfaces are supported");
+		return false;
+	}
+
+	return Encode(pSurf->GetPixelData(), pSurf->GetWidth(), pSurf->GetHeight(), pSurf->GetPitch(), format, bBottomUp, quality, pBufferOut);
+}
+
+bool JPGMemoryEncoder::Encode(const byte *pPixels, int width, int height, int pitch, ePixelFormat format, bool bBottomUp, int quality,
+	vector<byte> *pBufferOut)
+{
+#ifdef RT_JPG_SUPPORT
+
+	jpeg_compress_struct cinfo;
+	JPGEncodeErrorManager jerr;
+	JPGMemoryDestination dest;
+
+	m_bytesCopied = 0;
+	cinfo.err = jpeg_std_error(&jerr.m_pub);
+	jerr.m_pub.error_exit = OnJPGEncodeError;
+
+	if (setjmp(jerr.m_setjmpBuffer))
+	{
+		jpeg_destroy_compress(&cinfo);
+		pBufferOut->clear();
+		return false;
+	}
+
+	jpeg_create_compress(&cinfo);
+
+	dest.m_pBuffer = pBufferOut;
+	dest.m_grownBytes = 0;
+	dest.m_pub.init_destination = InitMemoryDestination;
+	dest.m_pub.empty_output_buffer = EmptyMemoryDestination;
+	dest.m_pub.term_destination = TermMemoryDestination;
+	cinfo.dest = &dest.m_pub;
+
+	cinfo.image_width = width;
+	cinfo.image_height = height;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, quality, TRUE);
+	jpeg_start_compress(&cinfo, TRUE);
+
+	bool bNeedsConverting = format != PIXEL_FORMAT_RGB;
+	
+	//RGB rows can go straight in, anything else gets converted into this first.  Allocated from libjpeg's pool so
+	//there is nothing for us to clean up if it longjmps out
+	JSAMPARRAY rgbRow = NULL;
+	if (bNeedsConverting)
+	{
+		rgbRow = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.image_width * 3, 1);
+	}
+
+	while (cinfo.next_scanline < cinfo.image_height)
+	{
+		int srcY = bBottomUp ? (height - 1 - (int)cinfo.next_scanline) : (int)cinfo.next_scanline;
+		const byte *pSrc = pPixels + srcY * pitch;
+		JSAMPROW row;
+
+		if (bNeedsConverting)
+		{
+			ConvertPixelRow(pSrc, format, rgbRow[0], PIXEL_FORMAT_RGB, width);
+			row = rgbRow[0];
+		}
+		else
+		{
+			row = (JSAMPROW)pSrc; //libjpeg doesn't write to it, it just isn't const correct
+		}
+
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	m_bytesCopied = pBufferOut->size() + dest.m_grownBytes;
+	if (bNeedsConverting)
+	{
+		m_bytesCopied += (size_t)width * height * 3;
+	}
+	return true;
+
+#else
+	LogMsgFromAnyThread("JPGMemoryEncoder: Not compiled with RT_JPG_SUPPORT");
+	return false;
+#endif
+}
@@ -0,0 +1,34 @@
+//Like JPGSurfaceLoader::SaveToFile but writes into memory, so scans don't have to do a disk round trip before uploading
+
+#ifndef JPGMemoryEncoder_h__
+#define JPGMemoryEncoder_h__
+
+#include "PixelConvert.h"
+
+class JPGMemoryEncoder
+{
+public:
+
+	JPGMemoryEncoder();
+	virtual ~JPGMemoryEncoder();
+
+	//Works with RGB or RGBA surfaces.  pBufferOut is resized to the exact size of the jpg, but its capacity sticks around,
+	//so if you pass the same vector each time it stops allocating after the first scan.
+	//Set bBottomUp if the first row in memory is the bottom of the image (GetDIBits, glReadPixels), saves doing a FlipY first
+	bool Encode(SoftSurface *pSurf, int quality, vector<byte> *pBufferOut, bool bBottomUp = false);
+
+	//Raw pixels in any of the ePixelFormats, each row gets converted to RGB as libjpeg asks for it
+	bool Encode(const byte *pPixels, int width, int height, int pitch, ePixelFormat format, bool bBottomUp, int quality,
+		vector<byte> *pBufferOut);
+
+	//How much the last Encode() wrote into memory: the jpg, plus rows it had to convert and copies made growing the buffer
+	size_t GetBytesCopied() { return m_bytesCopied; }
+
+protected:
+
+	size_t m_bytesCopied = 0;
+
+private:
+};
+
+#endif // JPGMemoryEncoder_h__
@@ -0,0 +1,282 @@
+#include "PlatformPrecomp.h"
+#include "JsonPullReader.h"
+
+JsonPullReader::JsonPullReader(const char *pJson) : m_p(pJson)
+{
+	if (!m_p) m_bError = true;
+}
+
+bool JsonPullReader::Fail()
+{
+	m_bError = true;
+	return false;
+}
+
+void JsonPullReader::SkipWhitespace()
+{
+	while (*m_p == ' ' || *m_p == '\n' || *m_p == '\r' || *m_p == '\t') m_p++;
+}
+
+bool JsonPullReader::BeginObject()
+{
+	if (m_bError) return false;
+	SkipWhitespace();
+	if (*m_p != '{') return false;
+	m_p++;
+	return true;
+}
+
+bool JsonPullReader::NextKey()
+{
+	if (m_bError) return false;
+
+	//not tracking whether this is the first one, so a comma is just skipped if it's there
+	SkipWhitespace();
+	if (*m_p == ',')
+	{
+		m_p++;
+		SkipWhitespace();
+	}
+
+	if (*m_p == '}')
+	{
+		m_p++;
+		return false;
+	}
+
+	if (*m_p != '"') return Fail();
+
+	m_pKey = m_p + 1;
+	if (!SkipString()) return false;
+	m_keyLength = (int)(m_p - 1 - m_pKey);
+
+	SkipWhitespace();
+	if (*m_p != ':') return Fail();
+	m_p++;
+	return true;
+}
+
+bool JsonPullReader::IsKey(const char *pKey) const
+{
+	return m_pKey && strncmp(m_pKey, pKey, m_keyLength) == 0 && pKey[m_keyLength] == 0;
+}
+
+bool JsonPullReader::BeginArray()
+{
+	if (m_bError) return false;
+	SkipWhitespace();
+	if (*m_p != '[') return false;
+	m_p++;
+	return true;
+}
+
+bool JsonPullReader::NextElement()
+{
+	if (m_bError) return false;
+
+	SkipWhitespace();
+	if (*m_p == ',')
+	{
+		m_p++;
+		SkipWhitespace();
+	}
+
+	if (*m_p == ']')
+	{
+		m_p++;
+		return false;
+	}
+
+	if (*m_p == 0) return Fail();
+	return true;
+}
+
+bool JsonPullReader::SkipString()
+{
+	m_p++; //the opening quote
+
+	while (*m_p != '"')
+	{
+		if (*m_p == 0) return Fail();
+		if (*m_p == '\\')
+		{
+			m_p++;
+			if (*m_p == 0) return Fail();
+		}
+		m_p++;
+	}
+
+	m_p++; //closing quote
+	return true;
+}
+
+static int ReadHex4(const char *p)
+{
+	int value = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		char c = p[i];
+		value <<= 4;
+		if (c >= '0' && c <= '9') value |= c - '0';
+		else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+		else return -1;
+	}
+	return value;
+}
+
+static void AppendUTF8(string *pOut, uint32 codePoint)
+{
+	if (codePoint < 0x80)
+	{
+		*pOut += (char)codePoint;
+	}
+	else if (codePoint < 0x800)
+	{
+		*pOut += (char)(0xC0 | (codePoint >> 6));
+		*pOut += (char)(0x80 | (codePoint & 0x3F));
+	}
+	else if (codePoint < 0x10000)
+	{
+		*pOut += (char)(0xE0 | (codePoint >> 12));
+		*pOut += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+		*pOut += (char)(0x80 | (codePoint & 0x3F));
+	}
+	else
+	{
+		*pOut += (char)(0xF0 | (codePoint >> 18));
+		*pOut += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+		*pOut += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+		*pOut += (char)(0x80 | (codePoint & 0x3F));
+	}
+}
+
+bool JsonPullReader::ReadRawString(const char **ppStartOut, int *pLengthOut)
+{
+	if (m_bError) return false;
+	SkipWhitespace();
+	if (*m_p != '"') return Fail();
+
+	const char *pStart = m_p + 1;
+	if (!SkipString()) return false;
+
+	*ppStartOut = pStart;
+	*pLengthOut = (int)(m_p - 1 - pStart);
+	return true;
+}
+
+bool JsonPullReader::ReadString(string *pOut)
+{
+	if (m_bError) return false;
+	SkipWhitespace();
+	if (*m_p != '"') return Fail();
+	m_p++;
+
+	pOut->clear();
+
+	while (*m_p != '"')
+	{
+		//copy runs of plain chars in one go, escapes are rare in what we read
+		const char *pRun = m_p;
+		while (*m_p != '"' && *m_p != '\\' && *m_p != 0) m_p++;
+		pOut->append(pRun, m_p - pRun);
+
+		if (*m_p == 0) return Fail();
+		if (*m_p != '\\') break;
+
+		m_p++;
+		switch (*m_p)
+		{
+		case '"': *pOut += '"'; break;
+		case '\\': *pOut += '\\'; break;
+		case '/': *pOut += '/'; break;
+		case 'b': *pOut += '\b'; break;
+		case 'f': *pOut += '\f'; break;
+		case 'n': *pOut += '\n'; break;
+		case 'r': *pOut += '\r'; break;
+		case 't': *pOut += '\t'; break;
+		case 'u':
+		{
+			int codePoint = ReadHex4(m_p + 1);
+			if (codePoint < 0) return Fail();
+			m_p += 4;
+
+			//the ones outside the BMP come as a surrogate pair
+			if (codePoint >= 0xD800 && codePoint <= 0xDBFF && m_p[1] == '\\' && m_p[2] == 'u')
+			{
+				int low = ReadHex4(m_p + 3);
+				if (low >= 0xDC00 && low <= 0xDFFF)
+				{
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					m_p += 6;
+				}
+			}
+
+			AppendUTF8(pOut, (uint32)codePoint);
+			break;
+		}
+		default:
+			return Fail();
+		}
+		m_p++;
+	}
+
+	m_p++; //closing quote
+	return true;
+}
+
+bool JsonPullReader::ReadNumber(double *pOut)
+{
+	if (m_bError) return false;
+	SkipWhitespace();
+
+	char *pEnd;
+	*pOut = strtod(m_p, &pEnd);
+	if (pEnd == m_p) return Fail();
+	m_p = pEnd;
+	return true;
+}
+
+bool JsonPullReader::ReadFloat(float *pOut)
+{
+	double value;
+	if (!ReadNumber(&value)) return false;
+	*pOut = (float)value;
+	return true;
+}
+
+bool JsonPullReader::SkipValue()
+{
+	if (m_bError) return false;
+	SkipWhitespace();
+
+	if (*m_p == '"') return SkipString();
+
+	if (*m_p == '{' || *m_p == '[')
+	{
+		//don't need to check they match up, just count the nesting and step over strings so brackets in them don't count
+		int depth = 0;
+		do
+		{
+			if (*m_p == 0) return Fail();
+
+			if (*m_p == '"')
+			{
+				if (!SkipString()) return false;
+				continue;
+			}
+
+			if (*m_p == '{' || *m_p == '[') depth++;
+			else if (*m_p == '}' || *m_p == ']') depth--;
+			m_p++;
+		} while (depth > 0);
+
+		return true;
+	}
+
+	//number, true, false or null
+	const char *pStart = m_p;
+	while (*m_p != 0 && *m_p != ',' && *m_p != '}' && *m_p != ']' && *m_p != ' ' && *m_p != '\n' && *m_p != '\r' && *m_p != '\t') m_p++;
+	if (m_p == pStart) return Fail();
+	return true;
+}
@@ -0,0 +1,53 @@
+//Walks a JSON document in place, front to back, without building a tree.  You ask for what you expect next and skip
+//whatever you don't care about, so a several MB OCR response costs one pass over the text and no allocations beyond the
+//strings you actually read out.
+//
+//	JsonPullReader r(pJson);
+//	if (r.BeginObject())
+//	{
+//		while (r.NextKey())
+//		{
+//			if (r.IsKey("name")) r.ReadString(&name); else r.SkipValue();
+//		}
+//	}
+//
+//BeginObject()/BeginArray() return false (and don't move) if the next value isn't one, so you can SkipValue() it instead.
+//Once anything is malformed every call returns false, check HasError() at the end.  The text must be null terminated.
+
+#ifndef JsonPullReader_h__
+#define JsonPullReader_h__
+
+class JsonPullReader
+{
+public:
+
+	JsonPullReader(const char *pJson);
+
+	bool BeginObject();
+	bool NextKey(); //false when the object ends, the } is eaten
+	bool IsKey(const char *pKey) const; //the key NextKey() just read, compared raw (escapes aren't decoded)
+
+	bool BeginArray();
+	bool NextElement(); //false when the array ends, the ] is eaten
+
+	bool ReadString(string *pOut); //decodes escapes, \u ones come out as UTF8
+	bool ReadRawString(const char **ppStartOut, int *pLengthOut); //points into the JSON between the quotes, escapes left as is
+	bool ReadNumber(double *pOut);
+	bool ReadFloat(float *pOut);
+	bool SkipValue(); //any type, nested ones included
+
+	bool HasError() { return m_bError; }
+
+protected:
+
+	void SkipWhitespace();
+	bool Fail();
+	bool SkipString(); //m_p is on the opening quote
+
+	const char *m_p;
+	const char *m_pKey = NULL;
+	int m_keyLength = 0;
+	bool m_bError = false;
+};
+
+#endif // JsonPullReader_h__
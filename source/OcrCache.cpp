@@ -0,0 +1,300 @@
+#include "PlatformPrecomp.h"
+#include "OcrCache.h"
+#include "util/MiscUtils.h"
+
+const int C_OCR_CACHE_GRID_WIDTH = 17;
+const int C_OCR_CACHE_GRID_HEIGHT = 16;
+const int C_OCR_CACHE_THUMB_TOLERANCE = 24; //a thumbnail pixel off by more than this means the text is different
+
+static int CountBits(uint64_t v)
+{
+	v = v - ((v >> 1) & 0x5555555555555555ULL);
+	v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+	v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((v * 0x0101010101010101ULL) >> 56);
+}
+
+void OcrImageSignature::Compute(const CaptureFrame &frame)
+{
+	m_thumb.clear();
+	memset(m_hash, 0, sizeof(m_hash));
+	if (frame.m_width <= 0 || frame.m_height <= 0) return;
+
+	int bytesPerPixel = GetPixelFormatBytesPerPixel(frame.m_format);
+	bool bBGR = frame.m_format == PIXEL_FORMAT_BGR || frame.m_format == PIXEL_FORMAT_BGRA;
+	int redIndex = bBGR ? 2 : 0;
+	int blueIndex = bBGR ? 0 : 2;
+
+	float scale = rt_min(1.0f, (float)C_OCR_CACHE_THUMB_SIZE / (float)rt_max(frame.m_width, frame.m_height));
+	m_thumbWidth = rt_max(1, (int)(frame.m_width * scale + 0.5f));
+	m_thumbHeight = rt_max(1, (int)(frame.m_height * scale + 0.5f));
+
+	//one pass over the pixels fills both the thumbnail and the hash grid, each cell is the average of what lands in it
+	vector<int> thumbX(frame.m_width);
+	vector<int> gridX(frame.m_width);
+	for (int x = 0; x < frame.m_width; x++)
+	{
+		thumbX[x] = x * m_thumbWidth / frame.m_width;
+		gridX[x] = x * C_OCR_CACHE_GRID_WIDTH / frame.m_width;
+	}
+
+	vector<uint32> thumbSums(m_thumbWidth * m_thumbHeight, 0);
+	vector<uint32> thumbCounts(m_thumbWidth * m_thumbHeight, 0);
+	uint32 gridSums[C_OCR_CACHE_GRID_WIDTH * C_OCR_CACHE_GRID_HEIGHT] = { 0 };
+	uint32 gridCounts[C_OCR_CACHE_GRID_WIDTH * C_OCR_CACHE_GRID_HEIGHT] = { 0 };
+
+	for (int y = 0; y < frame.m_height; y++)
+	{
+		const byte *pRow = frame.m_pPixels + y * frame.m_pitch;
+		int imageY = frame.m_bBottomUp ? frame.m_height - 1 - y : y;
+		uint32 *pThumbSums = &thumbSums[(imageY * m_thumbHeight / frame.m_height) * m_thumbWidth];
+		uint32 *pThumbCounts = &thumbCounts[(imageY * m_thumbHeight / frame.m_height) * m_thumbWidth];
+		uint32 *pGridSums = &gridSums[(imageY * C_OCR_CACHE_GRID_HEIGHT / frame.m_height) * C_OCR_CACHE_GRID_WIDTH];
+		uint32 *pGridCounts = &gridCounts[(imageY * C_OCR_CACHE_GRID_HEIGHT / frame.m_height) * C_OCR_CACHE_GRID_WIDTH];
+
+		for (int x = 0; x < frame.m_width; x++)
+		{
+			const byte *pPixel = pRow + x * bytesPerPixel;
+			uint32 gray = (pPixel[redIndex] * 77 + pPixel[1] * 150 + pPixel[blueIndex] * 29) >> 8;
+
+			pThumbSums[thumbX[x]] += gray;
+			pThumbCounts[thumbX[x]]++;
+			pGridSums[gridX[x]] += gray;
+			pGridCounts[gridX[x]]++;
+		}
+	}
+
+	m_thumb.resize(m_thumbWidth * m_thumbHeight);
+	for (int i = 0; i < (int)m_thumb.size(); i++)
+	{
+		m_thumb[i] = (byte)(thumbSums[i] / rt_max(thumbCounts[i], (uint32)1));
+	}
+
+	//dHash: one bit per cell, is it darker than the one to its right
+	float grid[C_OCR_CACHE_GRID_WIDTH * C_OCR_CACHE_GRID_HEIGHT];
+	for (int i = 0; i < C_OCR_CACHE_GRID_WIDTH * C_OCR_CACHE_GRID_HEIGHT; i++)
+	{
+		grid[i] = gridCounts[i] ? (float)gridSums[i] / (float)gridCounts[i] : 0;
+	}
+
+	int bit = 0;
+	for (int y = 0; y < C_OCR_CACHE_GRID_HEIGHT; y++)
+	{
+		for (int x = 0; x < C_OCR_CACHE_GRID_WIDTH - 1; x++, bit++)
+		{
+			if (grid[y * C_OCR_CACHE_GRID_WIDTH + x] < grid[y * C_OCR_CACHE_GRID_WIDTH + x + 1])
+			{
+				m_hash[bit / 64] |= 1ULL << (bit % 64);
+			}
+		}
+	}
+}
+
+int OcrImageSignature::GetHashDistance(const uint64_t *pHash) const
+{
+	int distance = 0;
+	for (int i = 0; i < C_OCR_CACHE_HASH_WORDS; i++)
+	{
+		distance += CountBits(m_hash[i] ^ pHash[i]);
+	}
+	return distance;
+}
+
+bool OcrImageSignature::IsThumbSimilar(const byte *pThumb, int width, int height) const
+{
+	if (width != m_thumbWidth || height != m_thumbHeight) return false;
+
+	for (int i = 0; i < (int)m_thumb.size(); i++)
+	{
+		if (abs((int)m_thumb[i] - (int)pThumb[i]) > C_OCR_CACHE_THUMB_TOLERANCE) return false;
+	}
+
+	return true;
+}
+
+OcrCache::OcrCache()
+{
+}
+
+OcrCache::~OcrCache()
+{
+	Kill();
+}
+
+bool OcrCache::Init(string fileName, size_t maxDiskBytes, int maxMemoryEntries, int maxHashDistance)
+{
+	Kill();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_maxMemoryEntries = maxMemoryEntries;
+	m_maxHashDistance = maxHashDistance;
+	if (!m_diskStore.Open(fileName, maxDiskBytes)) return false;
+
+	//index the hashes of what's already on disk, the key has them as hex on the end
+	vector<string> keys;
+	m_diskStore.GetKeys(&keys);
+
+	for (int i = 0; i < (int)keys.size(); i++)
+	{
+		size_t separator = keys[i].rfind('|');
+		if (separator == string::npos || keys[i].length() - separator - 1 != C_OCR_CACHE_HASH_WORDS * 16) continue;
+
+		DiskEntry entry;
+		entry.m_key = keys[i];
+		entry.m_context = keys[i].substr(0, separator);
+		for (int j = 0; j < C_OCR_CACHE_HASH_WORDS; j++)
+		{
+			entry.m_hash[j] = strtoull(keys[i].substr(separator + 1 + j * 16, 16).c_str(), NULL, 16);
+		}
+		m_diskEntries.push_back(entry);
+	}
+
+	return true;
+}
+
+void OcrCache::Kill()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_diskStore.Close();
+	m_diskEntries.clear();
+	m_memory.clear();
+}
+
+string OcrCache::MakeContext(int width, int height, int engine, const string &detectionCommand, const string &languageHint)
+{
+	return toString(width) + "x" + toString(height) + "|" + toString(engine) + "|" + detectionCommand + "|" + languageHint;
+}
+
+string OcrCache::MakeKey(const string &context, const uint64_t *pHash)
+{
+	char hex[C_OCR_CACHE_HASH_WORDS * 16 + 1];
+	for (int i = 0; i < C_OCR_CACHE_HASH_WORDS; i++)
+	{
+		sprintf(hex + i * 16, "%08X%08X", (uint32)(pHash[i] >> 32), (uint32)pHash[i]);
+	}
+	return context + "|" + hex;
+}
+
+//on disk it's the thumbnail size (two uint16s), the thumbnail, then the response
+bool OcrCache::ReadDiskEntry(const DiskEntry &entry, const OcrImageSignature &sig, vector<byte> *pResponseOut)
+{
+	const byte *pData;
+	size_t size;
+	if (!m_diskStore.Get(entry.m_key, &pData, &size) || size < 4) return false;
+
+	uint16 thumbWidth, thumbHeight;
+	memcpy(&thumbWidth, pData, 2);
+	memcpy(&thumbHeight, pData + 2, 2);
+
+	size_t thumbBytes = (size_t)thumbWidth * thumbHeight;
+	if (size < 4 + thumbBytes) return false;
+	if (!sig.IsThumbSimilar(pData + 4, thumbWidth, thumbHeight)) return false;
+
+	pResponseOut->assign(pData + 4 + thumbBytes, pData + size);
+	return true;
+}
+
+void OcrCache::AddToMemory(const string &context, const OcrImageSignature &sig, const byte *pResponse, size_t size)
+{
+	if (m_maxMemoryEntries <= 0) return;
+
+	m_memory.push_front(MemoryEntry());
+	m_memory.front().m_context = context;
+	m_memory.front().m_sig = sig;
+	m_memory.front().m_response.assign(pResponse, pResponse + size);
+
+	while ((int)m_memory.size() > m_maxMemoryEntries)
+	{
+		m_memory.pop_back();
+	}
+}
+
+bool OcrCache::Get(const string &context, const OcrImageSignature &sig, vector<byte> *pResponseOut)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_diskStore.IsOpen() || !sig.IsValid()) return false; //disabled
+
+	for (auto itor = m_memory.begin(); itor != m_memory.end(); itor++)
+	{
+		if (itor->m_context != context || sig.GetHashDistance(itor->m_sig.m_hash) > m_maxHashDistance) continue;
+		if (!sig.IsThumbSimilar(&itor->m_sig.m_thumb[0], itor->m_sig.m_thumbWidth, itor->m_sig.m_thumbHeight)) continue;
+
+		*pResponseOut = itor->m_response;
+		m_memory.splice(m_memory.begin(), m_memory, itor);
+		m_hits++;
+		return true;
+	}
+
+	//a few on disk could be in range, take the closest
+	int bestIndex = -1;
+	int bestDistance = 0;
+	vector<byte> response;
+
+	for (int i = 0; i < (int)m_diskEntries.size(); i++)
+	{
+		if (m_diskEntries[i].m_context != context) continue;
+
+		int distance = sig.GetHashDistance(m_diskEntries[i].m_hash);
+		if (distance > m_maxHashDistance || (bestIndex != -1 && distance >= bestDistance)) continue;
+		if (!ReadDiskEntry(m_diskEntries[i], sig, &response)) continue;
+
+		bestIndex = i;
+		bestDistance = distance;
+		pResponseOut->swap(response);
+		if (distance == 0) break;
+	}
+
+	if (bestIndex != -1)
+	{
+		AddToMemory(context, sig, &pResponseOut->at(0), pResponseOut->size());
+		m_hits++;
+		m_diskHits++;
+		return true;
+	}
+
+	m_misses++;
+	return false;
+}
+
+void OcrCache::Put(const string &context, const OcrImageSignature &sig, const byte *pResponse, size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_diskStore.IsOpen() || !sig.IsValid() || size == 0) return;
+
+	AddToMemory(context, sig, pResponse, size);
+
+	vector<byte> value(4 + sig.m_thumb.size() + size);
+	uint16 thumbWidth = (uint16)sig.m_thumbWidth;
+	uint16 thumbHeight = (uint16)sig.m_thumbHeight;
+	memcpy(&value[0], &thumbWidth, 2);
+	memcpy(&value[2], &thumbHeight, 2);
+	memcpy(&value[4], &sig.m_thumb[0], sig.m_thumb.size());
+	memcpy(&value[4 + sig.m_thumb.size()], pResponse, size);
+
+	DiskEntry entry;
+	entry.m_context = context;
+	memcpy(entry.m_hash, sig.m_hash, sizeof(entry.m_hash));
+	entry.m_key = MakeKey(context, sig.m_hash);
+
+	bool bAlreadyIndexed = false;
+	for (int i = 0; i < (int)m_diskEntries.size(); i++)
+	{
+		if (m_diskEntries[i].m_key == entry.m_key) bAlreadyIndexed = true;
+	}
+
+	if (m_diskStore.Put(entry.m_key, value.data(), value.size()) && !bAlreadyIndexed)
+	{
+		m_diskEntries.push_back(entry);
+	}
+}
+
+void OcrCache::LogStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uint32 total = m_hits + m_misses;
+	if (total == 0) return;
+
+	LogMsg("OCR cache: %d hits (%d from disk), %d misses, %.1f%% hit rate, %d OCR calls saved.  %d entries on disk (%d KB)", m_hits,
+		m_diskHits, m_misses, 100.0f * (float)m_hits / (float)total, m_hits, (int)m_diskEntries.size(),
+		(int)(m_diskStore.GetFileBytes() / 1024));
+}
@@ -0,0 +1,85 @@
+//Remembers what the OCR engine said about images we've already sent, so scanning the same menu or title screen again
+//doesn't upload it and pay for it again.  Images are matched by a perceptual hash (a 256 bit dHash of a grayscale
+//copy) so a few pixels of noise still hit, then double checked against a small thumbnail so a different line of text in
+//the same dialog box doesn't.  We keep the raw response, the parse runs on it like it just came off the network.
+//
+//A few recent entries are kept in memory, everything else lives in a BlobStore on disk so hits survive restarts.
+//Get() is called from the encode worker and Put() from the parse worker, which can run at the same time, so this one locks.
+
+#ifndef OcrCache_h__
+#define OcrCache_h__
+
+#include "BlobStore.h"
+#include "CaptureSource.h"
+#include <mutex>
+
+const int C_OCR_CACHE_HASH_WORDS = 4; //256 bits, a 17x16 grid compared left to right
+const int C_OCR_CACHE_THUMB_SIZE = 128; //long side of the thumbnail in pixels
+const int C_OCR_CACHE_MEMORY_ENTRIES = 32;
+
+class OcrImageSignature
+{
+public:
+
+	void Compute(const CaptureFrame &frame);
+	bool IsValid() const { return !m_thumb.empty(); }
+	int GetHashDistance(const uint64_t *pHash) const; //how many bits differ
+	bool IsThumbSimilar(const byte *pThumb, int width, int height) const;
+
+	uint64_t m_hash[C_OCR_CACHE_HASH_WORDS];
+	int m_thumbWidth = 0;
+	int m_thumbHeight = 0;
+	vector<byte> m_thumb; //grayscale, top row first
+};
+
+class OcrCache
+{
+public:
+	OcrCache();
+	virtual ~OcrCache();
+
+	bool Init(string fileName, size_t maxDiskBytes, int maxMemoryEntries, int maxHashDistance);
+	void Kill();
+	bool IsEnabled() { return m_diskStore.IsOpen(); }
+
+	//Everything besides the pixels that changes what the engine sends back.  engine is an eVisionEngine
+	static string MakeContext(int width, int height, int engine, const string &detectionCommand, const string &languageHint);
+
+	bool Get(const string &context, const OcrImageSignature &sig, vector<byte> *pResponseOut);
+	void Put(const string &context, const OcrImageSignature &sig, const byte *pResponse, size_t size);
+
+	void LogStats();
+
+protected:
+
+	struct MemoryEntry
+	{
+		string m_context;
+		OcrImageSignature m_sig;
+		vector<byte> m_response;
+	};
+
+	struct DiskEntry
+	{
+		string m_key;
+		string m_context;
+		uint64_t m_hash[C_OCR_CACHE_HASH_WORDS];
+	};
+
+	static string MakeKey(const string &context, const uint64_t *pHash);
+	bool ReadDiskEntry(const DiskEntry &entry, const OcrImageSignature &sig, vector<byte> *pResponseOut);
+	void AddToMemory(const string &context, const OcrImageSignature &sig, const byte *pResponse, size_t size);
+
+	std::mutex m_mutex;
+	std::list<MemoryEntry> m_memory; //front is most recently used
+	int m_maxMemoryEntries = 0;
+	int m_maxHashDistance = 0;
+	BlobStore m_diskStore;
+	vector<DiskEntry> m_diskEntries; //hashes of everything on disk, so near matches can be found without reading it all
+
+	uint32 m_hits = 0;
+	uint32 m_diskHits = 0;
+	uint32 m_misses = 0;
+};
+
+#endif // OcrCache_h__
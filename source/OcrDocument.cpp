@@ -0,0 +1,100 @@
+#include "PlatformPrecomp.h"
+#include "OcrDocument.h"
+
+void OcrDocument::Reserve(int responseBytes)
+{
+	//Very rough, from looking at some real responses.  Google spends around 1K of JSON per word (a box for every symbol),
+	//Microsoft less, so this is on the generous side for Google and a bit short for Microsoft.  Either way it saves
+	//most of the regrowing.
+	int words = responseBytes / 512;
+	int lines = words / 4;
+
+	m_lineRects.reserve(lines);
+	m_lineTextStart.reserve(lines);
+	m_lineTextLength.reserve(lines);
+	m_lineFirstWord.reserve(lines);
+	m_lineWordCount.reserve(lines);
+
+	m_wordRects.reserve(words);
+	m_wordTextStart.reserve(words);
+	m_wordTextLength.reserve(words);
+
+	m_text.reserve(words * 8); //a word's text, then its line's copy of it
+}
+
+int OcrDocument::AddWord(const CL_Rectf &rect, const string &text)
+{
+	m_wordRects.push_back(rect);
+	m_wordTextStart.push_back((uint32)m_text.size());
+	m_wordTextLength.push_back((uint32)text.size());
+	m_text += text;
+
+	return (int)m_wordRects.size() - 1;
+}
+
+int OcrDocument::AddLine(const CL_Rectf &rect, const string &text, int firstWord)
+{
+	assert(firstWord >= 0 && firstWord <= GetWordCount());
+
+	m_lineRects.push_back(rect);
+	m_lineTextStart.push_back((uint32)m_text.size());
+	m_lineTextLength.push_back((uint32)text.size());
+	m_lineFirstWord.push_back((uint32)firstWord);
+	m_lineWordCount.push_back((uint32)(GetWordCount() - firstWord));
+	m_text += text;
+
+	return (int)m_lineRects.size() - 1;
+}
+
+void OcrDocument::BuildWordIndex()
+{
+	m_wordGrid.Clear();
+	if (m_wordRects.empty()) return;
+
+	CL_Rectf bounds = m_wordRects[0];
+	float totalHeight = 0;
+
+	for (int i = 0; i < (int)m_wordRects.size(); i++)
+	{
+		bounds.bounding_rect(m_wordRects[i]);
+		totalHeight += m_wordRects[i].get_height();
+	}
+
+	//a few words to a cell.  These are symbols for Google, so about as wide as they are tall
+	float cellSize = rt_max(totalHeight / m_wordRects.size(), 8.0f) * 3;
+	m_wordGrid.Init(bounds, cellSize);
+
+	for (int i = 0; i < (int)m_wordRects.size(); i++)
+	{
+		m_wordGrid.Add(i, m_wordRects[i]);
+	}
+}
+
+void OcrDocument::FindWordsAt(const CL_Vec2f &pt, vector<int> *pWordsOut) const
+{
+	m_wordGrid.Query(pt, pWordsOut);
+
+	for (int i = 0; i < (int)pWordsOut->size();)
+	{
+		if (m_wordRects[(*pWordsOut)[i]].contains(pt))
+		{
+			i++;
+		}
+		else
+		{
+			pWordsOut->erase(pWordsOut->begin() + i);
+		}
+	}
+}
+
+int OcrDocument::CopyLine(int line)
+{
+	//the text and words can stay where they are, only the line entry has to move
+	m_lineRects.push_back(m_lineRects[line]);
+	m_lineTextStart.push_back(m_lineTextStart[line]);
+	m_lineTextLength.push_back(m_lineTextLength[line]);
+	m_lineFirstWord.push_back(m_lineFirstWord[line]);
+	m_lineWordCount.push_back(m_lineWordCount[line]);
+
+	return (int)m_lineRects.size() - 1;
+}
@@ -0,0 +1,57 @@
+//Every line and word one scan found, stored flat: the rects in their own arrays, and all the UTF8 text back to back in
+//one string that things point into by offset.  A TextArea is just a range of lines in here.
+//
+//It used to be a vector of lines per TextArea, each with a vector of words, each with its own string, all copied by value
+//whenever a TextArea was.  A dense screen was thousands of little allocations per scan, now it's a handful.
+//
+//Both vision engines fill one in on the parse worker.  After that it's only read, and it lives for as long as some
+//TextArea still points at it (the last scan's are kept around for rescans and parked text boxes).
+
+#ifndef OcrDocument_h__
+#define OcrDocument_h__
+
+#include "RectGrid.h"
+
+class OcrDocument
+{
+public:
+
+	void Reserve(int responseBytes); //guesses how much we'll need from the size of the OCR response
+
+	int AddWord(const CL_Rectf &rect, const string &text);
+	int AddLine(const CL_Rectf &rect, const string &text, int firstWord); //the line gets words firstWord to the last one added
+	int CopyLine(int line); //adds a duplicate at the end, used to keep a TextArea's lines together
+
+	int GetLineCount() const { return (int)m_lineRects.size(); }
+	const CL_Rectf & GetLineRect(int line) const { return m_lineRects[line]; }
+	string GetLineText(int line) const { return m_text.substr(m_lineTextStart[line], m_lineTextLength[line]); }
+	int GetLineFirstWord(int line) const { return m_lineFirstWord[line]; }
+	int GetLineWordCount(int line) const { return m_lineWordCount[line]; }
+
+	int GetWordCount() const { return (int)m_wordRects.size(); }
+	const CL_Rectf & GetWordRect(int word) const { return m_wordRects[word]; }
+	string GetWordText(int word) const { return m_text.substr(m_wordTextStart[word], m_wordTextLength[word]); }
+
+	void BuildWordIndex(); //once everything has been added
+	void FindWordsAt(const CL_Vec2f &pt, vector<int> *pWordsOut) const; //only the ones that really contain pt, in order
+
+private:
+
+	vector<CL_Rectf> m_lineRects;
+	vector<uint32> m_lineTextStart;
+	vector<uint32> m_lineTextLength;
+	vector<uint32> m_lineFirstWord;
+	vector<uint32> m_lineWordCount;
+
+	vector<CL_Rectf> m_wordRects;
+	vector<uint32> m_wordTextStart;
+	vector<uint32> m_wordTextLength;
+
+	string m_text;
+
+	RectGrid m_wordGrid;
+};
+
+typedef std::shared_ptr<OcrDocument> OcrDocumentPtr;
+
+#endif // OcrDocument_h__
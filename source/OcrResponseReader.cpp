@@ -0,0 +1,422 @@
+#include "PlatformPrecomp.h"
+#include "OcrResponseReader.h"
+#include "JsonPullReader.h"
+
+//[{"x": 1, "y": 2}, ...]  A missing x or y is 0, Google leaves them out when they are
+static int ReadVertices(JsonPullReader &r, CL_Vec2f *pVerts)
+{
+	int count = 0;
+	if (!r.BeginArray())
+	{
+		r.SkipValue();
+		return 0;
+	}
+
+	while (r.NextElement())
+	{
+		if (count >= 4 || !r.BeginObject())
+		{
+			r.SkipValue();
+			continue;
+		}
+
+		CL_Vec2f &vert = pVerts[count++];
+		vert.x = 0;
+		vert.y = 0;
+
+		while (r.NextKey())
+		{
+			if (r.IsKey("x")) r.ReadFloat(&vert.x);
+			else if (r.IsKey("y")) r.ReadFloat(&vert.y);
+			else r.SkipValue();
+		}
+	}
+
+	return count;
+}
+
+//{"vertices": [...]}
+static int ReadGoogleBoundingBox(JsonPullReader &r, CL_Vec2f *pVerts)
+{
+	int count = 0;
+	if (!r.BeginObject())
+	{
+		r.SkipValue();
+		return 0;
+	}
+
+	while (r.NextKey())
+	{
+		if (r.IsKey("vertices")) count = ReadVertices(r, pVerts);
+		else r.SkipValue();
+	}
+
+	return count;
+}
+
+//{"property": {"detectedBreak": {"type": "SPACE"}}, "text": "a", "boundingBox": {...}}
+static void ReadGoogleSymbol(JsonPullReader &r, OcrSymbol *pSymbol)
+{
+	if (!r.BeginObject())
+	{
+		r.SkipValue();
+		return;
+	}
+
+	while (r.NextKey())
+	{
+		if (r.IsKey("text"))
+		{
+			r.ReadString(&pSymbol->m_text);
+		}
+		else if (r.IsKey("boundingBox"))
+		{
+			pSymbol->m_vertCount = ReadGoogleBoundingBox(r, pSymbol->m_verts);
+		}
+		else if (r.IsKey("property") && r.BeginObject())
+		{
+			while (r.NextKey())
+			{
+				if (r.IsKey("detectedBreak") && r.BeginObject())
+				{
+					pSymbol->m_bHasBreak = true;
+					while (r.NextKey())
+					{
+						if (r.IsKey("type")) r.ReadString(&pSymbol->m_breakType);
+						else r.SkipValue();
+					}
+				}
+				else
+				{
+					r.SkipValue();
+				}
+			}
+		}
+		else
+		{
+			r.SkipValue();
+		}
+	}
+}
+
+static void ReadGoogleWord(JsonPullReader &r, OcrWord *pWord)
+{
+	if (!r.BeginObject())
+	{
+		r.SkipValue();
+		return;
+	}
+
+	while (r.NextKey())
+	{
+		if (r.IsKey("boundingBox"))
+		{
+			pWord->m_vertCount = ReadGoogleBoundingBox(r, pWord->m_verts);
+		}
+		else if (r.IsKey("symbols") && r.BeginArray())
+		{
+			while (r.NextElement())
+			{
+				pWord->m_symbols.push_back(OcrSymbol());
+				ReadGoogleSymbol(r, &pWord->m_symbols.back());
+			}
+		}
+		else
+		{
+			r.SkipValue();
+		}
+	}
+}
+
+static void ReadGoogleParagraph(JsonPullReader &r, OcrParagraph *pParagraph)
+{
+	if (!r.BeginObject())
+	{
+		r.SkipValue();
+		return;
+	}
+
+	while (r.NextKey())
+	{
+		if (r.IsKey("words") && r.BeginArray())
+		{
+			while (r.NextElement())
+			{
+				pParagraph->m_words.push_back(OcrWord());
+				ReadGoogleWord(r, &pParagraph->m_words.back());
+			}
+		}
+		else
+		{
+			r.SkipValue();
+		}
+	}
+}
+
+//{"detectedLanguages": [{"languageCode": "ja", ...}, ...]}, only the first one counts
+static void ReadGoogleBlockLanguage(JsonPullReader &r, string *pLanguageOut)
+{
+	if (!r.BeginObject())
+	{
+		r.SkipValue();
+		return;
+	}
+
+	while (r.NextKey())
+	{
+		if (r.IsKey("detectedLanguages") && r.BeginArray())
+		{
+			bool bFirst = true;
+			while (r.NextElement())
+			{
+				if (!bFirst || !r.BeginObject())
+				{
+					r.SkipValue();
+					continue;
+				}
+
+				bFirst = false;
+				while (r.NextKey())
+				{
+					if (r.IsKey("languageCode")) r.ReadString(pLanguageOut);
+					else r.SkipValue();
+				}
+			}
+		}
+		else
+		{
+			r.SkipValue();
+		}
+	}
+}
+
+static void ReadGoogleBlock(JsonPullReader &r, vector<OcrParagraph> &paragraphs, const OcrParagraphCallback &onParagraph)
+{
+	if (!r.BeginObject())
+	{
+		r.SkipValue();
+		return;
+	}
+
+	//the language comes from the block's property, which could come after its paragraphs, so hold them until the end
+	paragraphs.clear();
+	string language;
+
+	while (r.NextKey())
+	{
+		if (r.IsKey("property"))
+		{
+			ReadGoogleBlockLanguage(r, &language);
+		}
+		else if (r.IsKey("paragraphs") && r.BeginArray())
+		{
+			while (r.NextElement())
+			{
+				paragraphs.push_back(OcrParagraph());
+				ReadGoogleParagraph(r, &paragraphs.back());
+			}
+		}
+		else
+		{
+			r.SkipValue();
+		}
+	}
+
+	if (r.HasError()) return;
+
+	for (int i = 0; i < (int)paragraphs.size(); i++)
+	{
+		paragraphs[i].m_language = language;
+		onParagraph(paragraphs[i]);
+	}
+}
+
+//responses[0].fullTextAnnotation.pages[0].blocks[]
+static void ReadGoogleResponse(JsonPullReader &r, const OcrParagraphCallback &onParagraph)
+{
+	if (!r.BeginObject())
+	{
+		r.SkipValue();
+		return;
+	}
+
+	vector<OcrParagraph> paragraphs;
+
+	while (r.NextKey())
+	{
+		if (!r.IsKey("fullTextAnnotation") || !r.BeginObject())
+		{
+			r.SkipValue(); //textAnnotations is most of the response, and we don't need any of it
+			continue;
+		}
+
+		while (r.NextKey())
+		{
+			if (!r.IsKey("pages") || !r.BeginArray())
+			{
+				r.SkipValue();
+				continue;
+			}
+
+			bool bFirstPage = true;
+			while (r.NextElement())
+			{
+				if (!bFirstPage || !r.BeginObject())
+				{
+					r.SkipValue();
+					continue;
+				}
+
+				bFirstPage = false;
+				while (r.NextKey())
+				{
+					if (r.IsKey("blocks") && r.BeginArray())
+					{
+						while (r.NextElement())
+						{
+							ReadGoogleBlock(r, paragraphs, onParagraph);
+						}
+					}
+					else
+					{
+						r.SkipValue();
+					}
+				}
+			}
+		}
+	}
+}
+
+bool ReadGoogleVisionResponse(const char *pJson, const OcrParagraphCallback &onParagraph)
+{
+	JsonPullReader r(pJson);
+	if (!r.BeginObject()) return false;
+
+	int responseCount = 0;
+
+	while (r.NextKey())
+	{
+		if (!r.IsKey("responses") || !r.BeginArray())
+		{
+			r.SkipValue();
+			continue;
+		}
+
+		while (r.NextElement())
+		{
+			responseCount++;
+			if (responseCount == 1)
+			{
+				ReadGoogleResponse(r, onParagraph);
+			}
+			else
+			{
+				r.SkipValue();
+			}
+		}
+	}
+
+	return !r.HasError() && responseCount == 1;
+}
+
+//{"text": "...", "boundingPolygon": [...], "confidence": 0.9}
+static void ReadMicrosoftWord(JsonPullReader &r, OcrWord *pWord)
+{
+	if (!r.BeginObject())
+	{
+		r.SkipValue();
+		return;
+	}
+
+	while (r.NextKey())
+	{
+		if (r.IsKey("text")) r.ReadString(&pWord->m_text);
+		else if (r.IsKey("boundingPolygon")) pWord->m_vertCount = ReadVertices(r, pWord->m_verts);
+		else r.SkipValue();
+	}
+}
+
+//readResult.blocks[].lines[].words[]
+bool ReadMicrosoftVisionResponse(const char *pJson, const OcrParagraphCallback &onLine)
+{
+	JsonPullReader r(pJson);
+	if (!r.BeginObject()) return false;
+
+	OcrParagraph line;
+	string language = "ja"; //the read API doesn't say, and this is what we always assumed
+
+	while (r.NextKey())
+	{
+		if (!r.IsKey("readResult") || !r.BeginObject())
+		{
+			r.SkipValue();
+			continue;
+		}
+
+		while (r.NextKey())
+		{
+			if (r.IsKey("language"))
+			{
+				//not from Microsoft, TesseractOcr adds it (before the blocks, so it's known by the time we get there)
+				r.ReadString(&language);
+				continue;
+			}
+
+			if (!r.IsKey("blocks") || !r.BeginArray())
+			{
+				r.SkipValue();
+				continue;
+			}
+
+			while (r.NextElement())
+			{
+				if (!r.BeginObject())
+				{
+					r.SkipValue();
+					continue;
+				}
+
+				while (r.NextKey())
+				{
+					if (!r.IsKey("lines") || !r.BeginArray())
+					{
+						r.SkipValue();
+						continue;
+					}
+
+					while (r.NextElement())
+					{
+						if (!r.BeginObject())
+						{
+							r.SkipValue();
+							continue;
+						}
+
+						line.m_words.clear();
+						line.m_language = language;
+
+						while (r.NextKey())
+						{
+							if (r.IsKey("words") && r.BeginArray())
+							{
+								while (r.NextElement())
+								{
+									line.m_words.push_back(OcrWord());
+									ReadMicrosoftWord(r, &line.m_words.back());
+								}
+							}
+							else
+							{
+								r.SkipValue();
+							}
+						}
+
+						if (!r.HasError()) onLine(line);
+					}
+				}
+			}
+		}
+	}
+
+	return !r.HasError();
+}
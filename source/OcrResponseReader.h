@@ -0,0 +1,45 @@
+//Pulls just the parts of the Google/Microsoft OCR responses we use straight out of the JSON text with a JsonPullReader,
+//one paragraph at a time.  A DOCUMENT_TEXT_DETECTION response for a whole desktop is several MB (a box for every
+//symbol), building a cJSON tree of all that and then searching it key by key was most of the parse time.
+//
+//Everything else in there (textAnnotations, confidences, block boxes...) is skipped without being looked at.
+
+#ifndef OcrResponseReader_h__
+#define OcrResponseReader_h__
+
+#include <functional>
+
+class OcrSymbol
+{
+public:
+	string m_text;
+	CL_Vec2f m_verts[4]; //the polygon the engine gave, not always starting top left
+	int m_vertCount = 0;
+	bool m_bHasBreak = false; //Google's property.detectedBreak
+	string m_breakType; //SPACE, EOL_SURE_SPACE, LINE_BREAK...
+};
+
+class OcrWord
+{
+public:
+	string m_text; //Microsoft only, Google's words are made of m_symbols
+	CL_Vec2f m_verts[4];
+	int m_vertCount = 0;
+	vector<OcrSymbol> m_symbols;
+};
+
+//A Google paragraph or a Microsoft line
+class OcrParagraph
+{
+public:
+	string m_language;
+	vector<OcrWord> m_words;
+};
+
+typedef std::function<void(const OcrParagraph&)> OcrParagraphCallback;
+
+//False if the JSON is broken, or for Google, if there isn't exactly one response in it (same as the old cJSON version)
+bool ReadGoogleVisionResponse(const char *pJson, const OcrParagraphCallback &onParagraph);
+bool ReadMicrosoftVisionResponse(const char *pJson, const OcrParagraphCallback &onLine);
+
+#endif // OcrResponseReader_h__
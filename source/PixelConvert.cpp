@@ -0,0 +1,240 @@
+#include "PlatformPrecomp.h"
+#include "PixelConvert.h"
+#include "SIMDUtils.h"
+#include "WorkerPool.h"
+
+//where each channel lives in a pixel, -1 if it doesn't have it
+template <int BPP, int R, int G, int B, int A>
+struct PixelLayout
+{
+	enum { C_BPP = BPP, C_R = R, C_G = G, C_B = B, C_A = A };
+};
+
+typedef PixelLayout<3, 0, 1, 2, -1> LayoutRGB;
+typedef PixelLayout<3, 2, 1, 0, -1> LayoutBGR;
+typedef PixelLayout<4, 0, 1, 2, 3> LayoutRGBA;
+typedef PixelLayout<4, 2, 1, 0, 3> LayoutBGRA;
+
+typedef void(*PixelRowFunc)(const byte *pSrc, byte *pDest, int width);
+
+int GetPixelFormatBytesPerPixel(ePixelFormat format)
+{
+	switch (format)
+	{
+	case PIXEL_FORMAT_RGB:
+	case PIXEL_FORMAT_BGR:
+		return 3;
+	case PIXEL_FORMAT_RGBA:
+	case PIXEL_FORMAT_BGRA:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+ePixelFormat GetPixelFormatOfSurface(SoftSurface *pSurf)
+{
+	switch (pSurf->GetSurfaceType())
+	{
+	case SoftSurface::SURFACE_RGB:
+		return PIXEL_FORMAT_RGB;
+	case SoftSurface::SURFACE_RGBA:
+		return PIXEL_FORMAT_RGBA;
+	default:
+		return PIXEL_FORMAT_COUNT;
+	}
+}
+
+template <int BPP>
+static void CopyPixelRow(const byte *pSrc, byte *pDest, int width)
+{
+	memmove(pDest, pSrc, width * BPP);
+}
+
+template <class Src, class Dest>
+static void ConvertPixelRowScalar(const byte *pSrc, byte *pDest, int width)
+{
+	for (int x = 0; x < width; x++)
+	{
+		//read them all first so a same sized in-place swap works
+		byte r = pSrc[Src::C_R];
+		byte g = pSrc[Src::C_G];
+		byte b = pSrc[Src::C_B];
+		byte a = Src::C_A >= 0 ? pSrc[Src::C_A & 3] : 255;
+
+		pDest[Dest::C_R] = r;
+		pDest[Dest::C_G] = g;
+		pDest[Dest::C_B] = b;
+		if (Dest::C_A >= 0) pDest[Dest::C_A & 3] = a;
+
+		pSrc += Src::C_BPP;
+		pDest += Dest::C_BPP;
+	}
+}
+
+#ifdef RT_SIMD_X86
+
+//pshufb mask that moves 4 source pixels into dest order, bytes past the 4 dest pixels are zeroed (0x80)
+template <class Src, class Dest>
+static void BuildShuffleMask(byte *pMask)
+{
+	memset(pMask, 0x80, 16);
+
+	for (int p = 0; p < 4; p++)
+	{
+		pMask[p * Dest::C_BPP + Dest::C_R] = (byte)(p * Src::C_BPP + Src::C_R);
+		pMask[p * Dest::C_BPP + Dest::C_G] = (byte)(p * Src::C_BPP + Src::C_G);
+		pMask[p * Dest::C_BPP + Dest::C_B] = (byte)(p * Src::C_BPP + Src::C_B);
+		if (Dest::C_A >= 0) pMask[p * Dest::C_BPP + (Dest::C_A & 3)] = (byte)(p * Src::C_BPP + (Src::C_A & 3));
+	}
+}
+
+//4 byte -> 3 byte, 16 pixels per loop.  Each shuffle packs 4 pixels into the low 12 bytes, then they get stitched
+//together into three full stores
+template <class Src, class Dest>
+RT_TARGET_SSSE3 static void ConvertPixelRow4To3SSSE3(const byte *pSrc, byte *pDest, int width)
+{
+	byte maskBytes[16];
+	BuildShuffleMask<Src, Dest>(maskBytes);
+	const __m128i mask = _mm_loadu_si128((const __m128i*)maskBytes);
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		__m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + 0)), mask);
+		__m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + 16)), mask);
+		__m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + 32)), mask);
+		__m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + 48)), mask);
+
+		_mm_storeu_si128((__m128i*)(pDest + 0), _mm_or_si128(a, _mm_slli_si128(b, 12)));
+		_mm_storeu_si128((__m128i*)(pDest + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+		_mm_storeu_si128((__m128i*)(pDest + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+
+		pSrc += 64;
+		pDest += 48;
+	}
+
+	ConvertPixelRowScalar<Src, Dest>(pSrc, pDest, width - x);
+}
+
+//4 byte -> 4 byte, just a shuffle, 4 pixels per loop
+template <class Src, class Dest>
+RT_TARGET_SSSE3 static void ConvertPixelRow4To4SSSE3(const byte *pSrc, byte *pDest, int width)
+{
+	byte maskBytes[16];
+	BuildShuffleMask<Src, Dest>(maskBytes);
+	const __m128i mask = _mm_loadu_si128((const __m128i*)maskBytes);
+
+	int x = 0;
+	for (; x + 4 <= width; x += 4)
+	{
+		_mm_storeu_si128((__m128i*)pDest, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)pSrc), mask));
+		pSrc += 16;
+		pDest += 16;
+	}
+
+	ConvertPixelRowScalar<Src, Dest>(pSrc, pDest, width - x);
+}
+
+#endif
+
+template <class Src>
+static void FillPixelRowFuncs(PixelRowFunc *pFuncs)
+{
+	pFuncs[PIXEL_FORMAT_RGB] = ConvertPixelRowScalar<Src, LayoutRGB>;
+	pFuncs[PIXEL_FORMAT_BGR] = ConvertPixelRowScalar<Src, LayoutBGR>;
+	pFuncs[PIXEL_FORMAT_RGBA] = ConvertPixelRowScalar<Src, LayoutRGBA>;
+	pFuncs[PIXEL_FORMAT_BGRA] = ConvertPixelRowScalar<Src, LayoutBGRA>;
+}
+
+//picked once, the first time anybody converts anything
+struct PixelRowFuncTable
+{
+	PixelRowFuncTable()
+	{
+		FillPixelRowFuncs<LayoutRGB>(m_funcs[PIXEL_FORMAT_RGB]);
+		FillPixelRowFuncs<LayoutBGR>(m_funcs[PIXEL_FORMAT_BGR]);
+		FillPixelRowFuncs<LayoutRGBA>(m_funcs[PIXEL_FORMAT_RGBA]);
+		FillPixelRowFuncs<LayoutBGRA>(m_funcs[PIXEL_FORMAT_BGRA]);
+
+#ifdef RT_SIMD_X86
+		if (CPUHasSSSE3())
+		{
+			m_funcs[PIXEL_FORMAT_BGRA][PIXEL_FORMAT_RGB] = ConvertPixelRow4To3SSSE3<LayoutBGRA, LayoutRGB>;
+			m_funcs[PIXEL_FORMAT_BGRA][PIXEL_FORMAT_BGR] = ConvertPixelRow4To3SSSE3<LayoutBGRA, LayoutBGR>;
+			m_funcs[PIXEL_FORMAT_RGBA][PIXEL_FORMAT_RGB] = ConvertPixelRow4To3SSSE3<LayoutRGBA, LayoutRGB>;
+			m_funcs[PIXEL_FORMAT_RGBA][PIXEL_FORMAT_BGR] = ConvertPixelRow4To3SSSE3<LayoutRGBA, LayoutBGR>;
+			m_funcs[PIXEL_FORMAT_BGRA][PIXEL_FORMAT_RGBA] = ConvertPixelRow4To4SSSE3<LayoutBGRA, LayoutRGBA>;
+			m_funcs[PIXEL_FORMAT_RGBA][PIXEL_FORMAT_BGRA] = ConvertPixelRow4To4SSSE3<LayoutRGBA, LayoutBGRA>;
+		}
+#endif
+
+		//no conversion at all, just copy the bytes
+		m_funcs[PIXEL_FORMAT_RGB][PIXEL_FORMAT_RGB] = CopyPixelRow<3>;
+		m_funcs[PIXEL_FORMAT_BGR][PIXEL_FORMAT_BGR] = CopyPixelRow<3>;
+		m_funcs[PIXEL_FORMAT_RGBA][PIXEL_FORMAT_RGBA] = CopyPixelRow<4>;
+		m_funcs[PIXEL_FORMAT_BGRA][PIXEL_FORMAT_BGRA] = CopyPixelRow<4>;
+	}
+
+	PixelRowFunc m_funcs[PIXEL_FORMAT_COUNT][PIXEL_FORMAT_COUNT];
+};
+
+static PixelRowFunc GetPixelRowFunc(ePixelFormat srcFormat, ePixelFormat destFormat)
+{
+	static PixelRowFuncTable table; //the workers call this too, but function statics are thread safe to init
+	return table.m_funcs[srcFormat][destFormat];
+}
+
+void ConvertPixelRow(const byte *pSrc, ePixelFormat srcFormat, byte *pDest, ePixelFormat destFormat, int width)
+{
+	assert(srcFormat < PIXEL_FORMAT_COUNT && destFormat < PIXEL_FORMAT_COUNT);
+	GetPixelRowFunc(srcFormat, destFormat)(pSrc, pDest, width);
+}
+
+void ConvertPixels(const byte *pSrc, int srcPitch, ePixelFormat srcFormat, byte *pDest, int destPitch, ePixelFormat destFormat,
+	int width, int height, bool bFlipY)
+{
+	assert(srcFormat < PIXEL_FORMAT_COUNT && destFormat < PIXEL_FORMAT_COUNT);
+	PixelRowFunc pFunc = GetPixelRowFunc(srcFormat, destFormat);
+
+	if (bFlipY)
+	{
+		pDest += (height - 1) * destPitch;
+		destPitch = -destPitch;
+	}
+
+	for (int y = 0; y < height; y++)
+	{
+		pFunc(pSrc, pDest, width);
+		pSrc += srcPitch;
+		pDest += destPitch;
+	}
+}
+
+bool ConvertPixelsToSurface(const byte *pSrc, int srcPitch, ePixelFormat srcFormat, int width, int height, bool bFlipY,
+	SoftSurface *pDest, SoftSurface::eSurfaceType destType)
+{
+	ePixelFormat destFormat;
+
+	switch (destType)
+	{
+	case SoftSurface::SURFACE_RGB:
+		destFormat = PIXEL_FORMAT_RGB;
+		break;
+	case SoftSurface::SURFACE_RGBA:
+		destFormat = PIXEL_FORMAT_RGBA;
+		break;
+	default:
+		LogMsgFromAnyThread("ConvertPixelsToSurface: Only RGB and RGBA surfaces are supported");
+		return false;
+	}
+
+	//reallocating a screen sized buffer every scan adds up, reuse it if we can
+	if (pDest->GetWidth() != width || pDest->GetHeight() != height || pDest->GetSurfaceType() != destType)
+	{
+		pDest->Init(width, height, destType);
+	}
+
+	ConvertPixels(pSrc, srcPitch, srcFormat, pDest->GetPixelData(), pDest->GetPitch(), destFormat, width, height, bFlipY);
+	return true;
+}
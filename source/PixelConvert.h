@@ -0,0 +1,39 @@
+//Converts between the handful of 8 bit per channel layouts we deal with (GetDIBits gives BGRA, the jpg encoder and GL
+//want RGB) in a single pass, optionally flipping the row order at the same time.  Saves doing a Blit, then
+//FlipRedAndBlue, then FlipY, each one walking the whole image again.  Uses SSSE3 for the 4 byte sources if it can.
+
+#ifndef PixelConvert_h__
+#define PixelConvert_h__
+
+#include "Renderer/SoftSurface.h"
+
+enum ePixelFormat
+{
+	PIXEL_FORMAT_RGB,
+	PIXEL_FORMAT_BGR,
+	PIXEL_FORMAT_RGBA,
+	PIXEL_FORMAT_BGRA, //what GetDIBits gives us
+
+	//add more above here
+	PIXEL_FORMAT_COUNT
+};
+
+int GetPixelFormatBytesPerPixel(ePixelFormat format);
+
+//PIXEL_FORMAT_COUNT if it's a type we don't handle (paletted, 16 bit, etc)
+ePixelFormat GetPixelFormatOfSurface(SoftSurface *pSurf);
+
+//One row of width pixels, alpha is set to 255 if the source doesn't have any.  pSrc and pDest shouldn't overlap
+//unless they're the same size format
+void ConvertPixelRow(const byte *pSrc, ePixelFormat srcFormat, byte *pDest, ePixelFormat destFormat, int width);
+
+//A whole image.  If bFlipY is set, the first source row ends up as the last dest row
+void ConvertPixels(const byte *pSrc, int srcPitch, ePixelFormat srcFormat, byte *pDest, int destPitch, ePixelFormat destFormat,
+	int width, int height, bool bFlipY);
+
+//Same thing but into a SoftSurface, which only gets re-initted if the size or type is different from last time.
+//destType must be SURFACE_RGB or SURFACE_RGBA
+bool ConvertPixelsToSurface(const byte *pSrc, int srcPitch, ePixelFormat srcFormat, int width, int height, bool bFlipY,
+	SoftSurface *pDest, SoftSurface::eSurfaceType destType);
+
+#endif // PixelConvert_h__
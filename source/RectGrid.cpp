@@ -0,0 +1,105 @@
+#include "PlatformPrecomp.h"
+#include "RectGrid.h"
+#include <algorithm>
+
+const int C_RECT_GRID_MAX_CELLS_PER_SIDE = 256; //so a silly cell size can't eat all our memory
+
+void RectGrid::Init(const CL_Rectf &bounds, float cellSize)
+{
+	m_bounds = bounds;
+	m_cellSize = rt_max(cellSize, 1.0f);
+
+	m_cellsX = (int)(bounds.get_width() / m_cellSize) + 1;
+	m_cellsY = (int)(bounds.get_height() / m_cellSize) + 1;
+
+	if (m_cellsX > C_RECT_GRID_MAX_CELLS_PER_SIDE || m_cellsY > C_RECT_GRID_MAX_CELLS_PER_SIDE)
+	{
+		m_cellSize = rt_max(bounds.get_width(), bounds.get_height()) / (C_RECT_GRID_MAX_CELLS_PER_SIDE - 1);
+		m_cellsX = rt_min((int)(bounds.get_width() / m_cellSize) + 1, C_RECT_GRID_MAX_CELLS_PER_SIDE);
+		m_cellsY = rt_min((int)(bounds.get_height() / m_cellSize) + 1, C_RECT_GRID_MAX_CELLS_PER_SIDE);
+	}
+
+	m_cells.clear();
+	m_cells.resize(m_cellsX * m_cellsY);
+}
+
+void RectGrid::Clear()
+{
+	m_cells.clear();
+	m_cellsX = 0;
+	m_cellsY = 0;
+}
+
+void RectGrid::GetCellRange(const CL_Rectf &rect, int *pX1, int *pY1, int *pX2, int *pY2) const
+{
+	int x1 = (int)floor((rect.left - m_bounds.left) / m_cellSize);
+	int y1 = (int)floor((rect.top - m_bounds.top) / m_cellSize);
+	int x2 = (int)floor((rect.right - m_bounds.left) / m_cellSize);
+	int y2 = (int)floor((rect.bottom - m_bounds.top) / m_cellSize);
+
+	*pX1 = rt_min(rt_max(x1, 0), m_cellsX - 1);
+	*pY1 = rt_min(rt_max(y1, 0), m_cellsY - 1);
+	*pX2 = rt_min(rt_max(x2, 0), m_cellsX - 1);
+	*pY2 = rt_min(rt_max(y2, 0), m_cellsY - 1);
+}
+
+void RectGrid::Add(int id, const CL_Rectf &rect)
+{
+	if (m_cells.empty()) return;
+
+	int x1, y1, x2, y2;
+	GetCellRange(rect, &x1, &y1, &x2, &y2);
+
+	for (int y = y1; y <= y2; y++)
+	{
+		for (int x = x1; x <= x2; x++)
+		{
+			vector<int> &cell = m_cells[y * m_cellsX + x];
+			if (cell.empty() || cell.back() != id) cell.push_back(id);
+		}
+	}
+}
+
+void RectGrid::Remove(int id, const CL_Rectf &rect)
+{
+	if (m_cells.empty()) return;
+
+	int x1, y1, x2, y2;
+	GetCellRange(rect, &x1, &y1, &x2, &y2);
+
+	for (int y = y1; y <= y2; y++)
+	{
+		for (int x = x1; x <= x2; x++)
+		{
+			vector<int> &cell = m_cells[y * m_cellsX + x];
+			cell.erase(std::remove(cell.begin(), cell.end(), id), cell.end());
+		}
+	}
+}
+
+void RectGrid::Query(const CL_Rectf &rect, vector<int> *pIdsOut) const
+{
+	pIdsOut->clear();
+	if (m_cells.empty()) return;
+
+	int x1, y1, x2, y2;
+	GetCellRange(rect, &x1, &y1, &x2, &y2);
+
+	for (int y = y1; y <= y2; y++)
+	{
+		for (int x = x1; x <= x2; x++)
+		{
+			const vector<int> &cell = m_cells[y * m_cellsX + x];
+			pIdsOut->insert(pIdsOut->end(), cell.begin(), cell.end());
+		}
+	}
+
+	//big rects are in more than one cell
+	std::sort(pIdsOut->begin(), pIdsOut->end());
+	pIdsOut->erase(std::unique(pIdsOut->begin(), pIdsOut->end()), pIdsOut->end());
+}
+
+void RectGrid::Query(const CL_Vec2f &pt, vector<int> *pIdsOut) const
+{
+	Query(CL_Rectf(pt.x, pt.y, pt.x, pt.y), pIdsOut);
+}
@@ -0,0 +1,35 @@
+//A uniform grid of buckets for finding which of a lot of rects are near a point or another rect without looking at all
+//of them.  You add rects by id (whatever index you use for them), each goes in every cell it touches.  A query gives back
+//the ids in the cells it touches, which are only candidates, check the real rects yourself.
+//
+//Screen text is all about the same size, so plain cells a few words big work about as well as anything fancier would.
+//Anything outside the bounds goes in the edge cells, so it still works (just slower) if the bounds were off.
+
+#ifndef RectGrid_h__
+#define RectGrid_h__
+
+class RectGrid
+{
+public:
+
+	void Init(const CL_Rectf &bounds, float cellSize);
+	void Clear();
+
+	void Add(int id, const CL_Rectf &rect); //adding an id again with a bigger rect is fine, queries only give it once
+	void Remove(int id, const CL_Rectf &rect); //rect has to be the one it was last added with, or bigger
+
+	void Query(const CL_Rectf &rect, vector<int> *pIdsOut) const; //sorted, no duplicates
+	void Query(const CL_Vec2f &pt, vector<int> *pIdsOut) const;
+
+private:
+
+	void GetCellRange(const CL_Rectf &rect, int *pX1, int *pY1, int *pX2, int *pY2) const;
+
+	CL_Rectf m_bounds;
+	float m_cellSize = 1;
+	int m_cellsX = 0;
+	int m_cellsY = 0;
+	vector<vector<int> > m_cells;
+};
+
+#endif // RectGrid_h__
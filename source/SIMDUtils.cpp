@@ -0,0 +1,94 @@
+#include "PlatformPrecomp.h"
+#include "SIMDUtils.h"
+#include "WorkerPool.h"
+
+#ifdef RT_SIMD_X86
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+class CPUFeatures
+{
+public:
+
+	CPUFeatures()
+	{
+#ifdef RT_SIMD_X86
+		int regs[4]; //eax, ebx, ecx, edx
+
+		GetCPUID(regs, 0, 0);
+		int maxLeaf = regs[0];
+
+		GetCPUID(regs, 1, 0);
+		m_bSSE2 = (regs[3] & (1 << 26)) != 0;
+		m_bSSSE3 = (regs[2] & (1 << 9)) != 0;
+
+		//AVX2 also needs the OS to save the ymm registers for us
+		bool bOSXSave = (regs[2] & (1 << 27)) != 0;
+		bool bAVX = (regs[2] & (1 << 28)) != 0;
+
+		if (maxLeaf >= 7 && bOSXSave && bAVX && (GetXCR0() & 6) == 6)
+		{
+			GetCPUID(regs, 7, 0);
+			m_bAVX2 = (regs[1] & (1 << 5)) != 0;
+		}
+
+		//the first SIMD call makes this, which can be on a worker
+		LogMsgFromAnyThread("CPU features: SSE2: %d SSSE3: %d AVX2: %d", (int)m_bSSE2, (int)m_bSSSE3, (int)m_bAVX2);
+#endif
+	}
+
+	bool m_bSSE2 = false;
+	bool m_bSSSE3 = false;
+	bool m_bAVX2 = false;
+
+private:
+
+#ifdef RT_SIMD_X86
+	void GetCPUID(int *pRegs, int leaf, int subLeaf)
+	{
+#ifdef _MSC_VER
+		__cpuidex(pRegs, leaf, subLeaf);
+#else
+		unsigned int a, b, c, d;
+		__cpuid_count(leaf, subLeaf, a, b, c, d);
+		pRegs[0] = a; pRegs[1] = b; pRegs[2] = c; pRegs[3] = d;
+#endif
+	}
+
+	uint64_t GetXCR0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int a, d;
+		__asm__ volatile("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+		return (uint64_t(d) << 32) | a;
+#endif
+	}
+#endif
+};
+
+static CPUFeatures & GetCPUFeatures()
+{
+	static CPUFeatures features; //only check once
+	return features;
+}
+
+bool CPUHasSSE2()
+{
+	return GetCPUFeatures().m_bSSE2;
+}
+
+bool CPUHasSSSE3()
+{
+	return GetCPUFeatures().m_bSSSE3;
+}
+
+bool CPUHasAVX2()
+{
+	return GetCPUFeatures().m_bAVX2;
+}
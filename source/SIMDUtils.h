@@ -0,0 +1,28 @@
+//Runtime CPU feature checks so the hot loops can pick an SSE2/SSSE3/AVX2 version and still run on anything
+
+#ifndef SIMDUtils_h__
+#define SIMDUtils_h__
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define RT_SIMD_X86
+	#include <emmintrin.h> //SSE2
+	#include <tmmintrin.h> //SSSE3
+	#include <immintrin.h> //AVX2
+#endif
+
+//MSVC lets you use any intrinsic anywhere, gcc/clang need to be told which functions can use what
+#if defined(_MSC_VER) || !defined(RT_SIMD_X86)
+	#define RT_TARGET_SSE2
+	#define RT_TARGET_SSSE3
+	#define RT_TARGET_AVX2
+#else
+	#define RT_TARGET_SSE2 __attribute__((target("sse2")))
+	#define RT_TARGET_SSSE3 __attribute__((target("ssse3")))
+	#define RT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+bool CPUHasSSE2();
+bool CPUHasSSSE3();
+bool CPUHasAVX2();
+
+#endif // SIMDUtils_h__
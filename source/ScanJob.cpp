@@ -0,0 +1,60 @@
+#include "PlatformPrecomp.h"
+#include "ScanJob.h"
+
+static const char *g_scanStageNames[SCAN_STAGE_COUNT] =
+{
+	"capture", "encode", "ocr", "parse", "build", "translate"
+};
+
+ScanJob::ScanJob(uint32 scanID)
+{
+	m_scanID = scanID;
+	m_created = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < SCAN_STAGE_COUNT; i++)
+	{
+		m_stageMS[i] = -1; //never ran
+		m_bytesCopied[i] = 0;
+	}
+}
+
+ScanJob::~ScanJob()
+{
+}
+
+void ScanJob::StartStage(eScanStage stage)
+{
+	m_stageStart[stage] = std::chrono::steady_clock::now();
+}
+
+void ScanJob::EndStage(eScanStage stage)
+{
+	m_stageMS[stage] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_stageStart[stage]).count();
+}
+
+void ScanJob::LogTimings()
+{
+	string msg = "Scan " + toString(m_scanID) + " timings:";
+
+	for (int i = 0; i < SCAN_STAGE_COUNT; i++)
+	{
+		if (m_stageMS[i] < 0) continue;
+		msg += string(" ") + g_scanStageNames[i] + " " + toString((int)m_stageMS[i]) + "ms";
+	}
+
+	float totalMS = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_created).count();
+	msg += " (total " + toString((int)totalMS) + "ms)";
+	LogMsg(msg.c_str());
+
+	//the image's trip from the capture to the upload, so we can see what the copies cost
+	size_t totalBytes = 0;
+	msg = "Scan " + toString(m_scanID) + " bytes copied:";
+	for (int i = 0; i < SCAN_STAGE_COUNT; i++)
+	{
+		if (m_bytesCopied[i] == 0) continue;
+		msg += string(" ") + g_scanStageNames[i] + " " + toString((int)(m_bytesCopied[i] / 1024)) + "KB";
+		totalBytes += m_bytesCopied[i];
+	}
+	msg += " (total " + toString((int)(totalBytes / 1024)) + "KB)";
+	LogMsg(msg.c_str());
+}
@@ -0,0 +1,72 @@
+//Everything about one scan as it moves through the stages.  Each stage fills in the input for the next one, so whoever
+//holds the job (a worker thread or the main thread) owns that data for the moment and nothing else touches it.
+//Pressing the hotkey again cancels it, the stages check that and just drop it on the floor.
+
+#ifndef ScanJob_h__
+#define ScanJob_h__
+
+#include "GameLogicComponent.h"
+#include "WorkerPool.h"
+#include "SoftSurfacePool.h"
+#include "OcrCache.h"
+#include <chrono>
+
+enum eScanStage
+{
+	SCAN_STAGE_CAPTURE, //main thread
+	SCAN_STAGE_ENCODE, //worker
+	SCAN_STAGE_OCR, //network, or a worker for Tesseract
+	SCAN_STAGE_PARSE, //worker
+	SCAN_STAGE_BUILD, //main thread, creating the TextAreaComponents
+	SCAN_STAGE_TRANSLATE, //network plus the text rasterizing on the workers, until the last one is showing
+
+	SCAN_STAGE_COUNT
+};
+
+class ScanJob
+{
+public:
+	ScanJob(uint32 scanID);
+	virtual ~ScanJob();
+
+	void Cancel() { m_cancelToken.Cancel(); }
+	bool IsCanceled() { return m_cancelToken.IsCanceled(); }
+
+	void StartStage(eScanStage stage);
+	void EndStage(eScanStage stage);
+	void LogTimings(); //and how many bytes each stage copied around
+	void AddBytesCopied(eScanStage stage, size_t bytes) { m_bytesCopied[stage] += bytes; }
+
+	uint32 m_scanID;
+	CancelToken m_cancelToken;
+
+	SoftSurfacePtr m_pCapture; //capture -> encode, kept after that so it can be diffed against by the next scan
+	CL_Rect m_captureRect; //where on the desktop it came from
+
+	//Only set if the last finished scan was of the same area, then the encode just sends the part that changed
+	SoftSurfacePtr m_pPrevCapture;
+	vector<TextArea> m_prevTextAreas;
+	CL_Rect m_cropRect; //the part of m_pCapture that got sent, top-left origin
+	bool m_bCropped = false;
+	bool m_bUnchanged = false; //exactly the same as m_pPrevCapture, so nothing was sent
+
+	string m_ocrCacheContext;
+	OcrImageSignature m_ocrSignature; //of what we'd send, so the response can be cached
+	bool m_bOcrCacheHit = false; //m_ocrResponse came from the OcrCache, nothing was encoded or sent
+
+	vector<byte> m_jpg; //encode -> ocr
+	vector<byte> m_ocrResponse; //ocr -> parse, null terminated
+	vector<TextArea> m_textAreas; //parse -> build
+	bool m_bParsedOk = false;
+
+protected:
+
+	std::chrono::steady_clock::time_point m_stageStart[SCAN_STAGE_COUNT];
+	float m_stageMS[SCAN_STAGE_COUNT];
+	size_t m_bytesCopied[SCAN_STAGE_COUNT];
+	std::chrono::steady_clock::time_point m_created;
+};
+
+typedef std::shared_ptr<ScanJob> ScanJobPtr;
+
+#endif // ScanJob_h__
@@ -0,0 +1,106 @@
+#include "PlatformPrecomp.h"
+#include "SoftSurfacePool.h"
+
+SoftSurfacePool::FreeList::~FreeList()
+{
+	for (int i = 0; i < (int)m_surfaces.size(); i++)
+	{
+		delete m_surfaces[i];
+	}
+}
+
+void SoftSurfacePool::FreeList::Return(SoftSurface *pSurf)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if ((int)m_surfaces.size() < m_maxFree)
+		{
+			m_surfaces.push_back(pSurf);
+			return;
+		}
+	}
+
+	delete pSurf; //we have enough spares
+}
+
+SoftSurfacePool::SoftSurfacePool(int maxFree) : m_pFreeList(std::make_shared<FreeList>()), m_createdCount(0)
+{
+	m_pFreeList->m_maxFree = maxFree;
+}
+
+SoftSurfacePool::~SoftSurfacePool()
+{
+}
+
+SoftSurfacePtr SoftSurfacePool::Get(int width, int height, SoftSurface::eSurfaceType type)
+{
+	SoftSurface *pSurf = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pFreeList->m_mutex);
+		vector<SoftSurface*> &surfaces = m_pFreeList->m_surfaces;
+
+		for (int i = 0; i < (int)surfaces.size(); i++)
+		{
+			if (surfaces[i]->GetWidth() == width && surfaces[i]->GetHeight() == height && surfaces[i]->GetSurfaceType() == type)
+			{
+				pSurf = surfaces[i];
+				surfaces.erase(surfaces.begin() + i);
+				break;
+			}
+		}
+
+		if (!pSurf)
+		{
+			//the capture rect must have changed, the old sized ones aren't going to get used again
+			for (int i = 0; i < (int)surfaces.size(); i++)
+			{
+				delete surfaces[i];
+			}
+			surfaces.clear();
+		}
+	}
+
+	if (!pSurf)
+	{
+		pSurf = new SoftSurface;
+		pSurf->Init(width, height, type);
+		m_createdCount++;
+	}
+
+	std::weak_ptr<FreeList> pWeakFreeList = m_pFreeList;
+
+	return SoftSurfacePtr(pSurf, [pWeakFreeList](SoftSurface *p)
+	{
+		std::shared_ptr<FreeList> pFreeList = pWeakFreeList.lock();
+		if (pFreeList)
+		{
+			pFreeList->Return(p);
+		}
+		else
+		{
+			delete p;
+		}
+	});
+}
+
+void SoftSurfacePool::Clear()
+{
+	vector<SoftSurface*> surfaces;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pFreeList->m_mutex);
+		surfaces.swap(m_pFreeList->m_surfaces);
+	}
+
+	for (int i = 0; i < (int)surfaces.size(); i++)
+	{
+		delete surfaces[i];
+	}
+}
+
+int SoftSurfacePool::GetFreeCount()
+{
+	std::lock_guard<std::mutex> lock(m_pFreeList->m_mutex);
+	return (int)m_pFreeList->m_surfaces.size();
+}
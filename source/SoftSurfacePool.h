@@ -0,0 +1,47 @@
+//Keeps a few screen sized SoftSurfaces around so quick rescans (holding down the gamepad button, say) aren't
+//allocating and freeing a big buffer every time.  Thread safe, the scan's copy gets let go of on a worker.
+
+#ifndef SoftSurfacePool_h__
+#define SoftSurfacePool_h__
+
+#include "Renderer/SoftSurface.h"
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+typedef std::shared_ptr<SoftSurface> SoftSurfacePtr;
+
+class SoftSurfacePool
+{
+public:
+
+	SoftSurfacePool(int maxFree = 2);
+	virtual ~SoftSurfacePool();
+
+	//A surface of exactly this size and type, contents are whatever was left in it.  It comes back to the pool
+	//when the last SoftSurfacePtr to it goes away (or just gets deleted if the pool is gone by then)
+	SoftSurfacePtr Get(int width, int height, SoftSurface::eSurfaceType type);
+	void Clear(); //frees the surfaces not being used right now
+
+	int GetFreeCount();
+	int GetCreatedCount() { return m_createdCount; } //how many times we had to make a new one, for seeing if it's working
+
+protected:
+
+	//the deleters hang onto this instead of the pool itself, so surfaces are safe to let go of after the pool is gone
+	class FreeList
+	{
+	public:
+		~FreeList();
+		void Return(SoftSurface *pSurf);
+
+		std::mutex m_mutex;
+		vector<SoftSurface*> m_surfaces;
+		int m_maxFree;
+	};
+
+	std::shared_ptr<FreeList> m_pFreeList;
+	std::atomic<int> m_createdCount;
+};
+
+#endif // SoftSurfacePool_h__
@@ -0,0 +1,391 @@
+#include "PlatformPrecomp.h"
+#include "SpeechPlayer.h"
+#include "util/MiscUtils.h"
+#include <algorithm>
+
+//these bring in the audio libraries the same way App.cpp gets them
+#ifdef RT_ENABLE_FMOD
+#include "Audio/AudioManagerFMODStudio.h"
+#endif
+#include "Audio/AudioManagerAudiere.h"
+
+const int C_SPEECH_MAX_FREE_BUFFERS = 8; //a line split into sentences, plus a couple prefetched ones
+
+class SpeechDevice
+{
+public:
+	bool m_bFMOD = false;
+#ifdef RT_ENABLE_FMOD
+	FMOD::System *m_pSystem = NULL;
+#endif
+	audiere::AudioDevicePtr m_pAudiere;
+};
+
+class SpeechVoice
+{
+public:
+	AudioHandle m_handle = AUDIO_HANDLE_BLANK;
+#ifdef RT_ENABLE_FMOD
+	FMOD::Sound *m_pSound = NULL;
+	FMOD::Channel *m_pChannel = NULL;
+#endif
+	audiere::OutputStreamPtr m_pStream;
+
+	SpeechBufferPtr m_pPlaying; //FMOD reads from this while it plays
+	std::list<SpeechBufferPtr> m_queued; //mp3s to play after this one
+	bool m_bMoreToCome = false;
+
+	std::chrono::steady_clock::time_point m_readyTime;
+	float m_openMS = 0;
+	bool m_bHeard = false;
+};
+
+SpeechPlayer::BufferFreeList::~BufferFreeList()
+{
+	for (int i = 0; i < (int)m_buffers.size(); i++)
+	{
+		delete m_buffers[i];
+	}
+}
+
+SpeechPlayer::SpeechPlayer() : m_pBufferFreeList(std::make_shared<BufferFreeList>())
+{
+}
+
+SpeechPlayer::~SpeechPlayer()
+{
+	Kill();
+}
+
+void SpeechPlayer::Init(string audioSystem, string audioDevice)
+{
+	Kill();
+
+	if (audioSystem != "fmod" && audioSystem != "sdl" && audioSystem != "audiere")
+	{
+		return; //audio is off
+	}
+
+	m_pDevice = new SpeechDevice();
+
+#ifdef RT_ENABLE_FMOD
+	if (audioSystem != "audiere")
+	{
+		if (FMOD::System_Create(&m_pDevice->m_pSystem) == FMOD_OK)
+		{
+			SelectFMODDriver(audioDevice); //has to be before init, same one the AudioManager got
+
+			if (m_pDevice->m_pSystem->init(8, FMOD_INIT_NORMAL, NULL) == FMOD_OK)
+			{
+				m_pDevice->m_bFMOD = true;
+				return;
+			}
+		}
+
+		LogMsg("SpeechPlayer: Couldn't start FMOD, trying Audiere");
+		if (m_pDevice->m_pSystem)
+		{
+			m_pDevice->m_pSystem->release();
+			m_pDevice->m_pSystem = NULL;
+		}
+	}
+#endif
+
+	//Audiere has no way to pick an output device, the AudioManager's Audiere one ignores audio_device too
+	m_pDevice->m_pAudiere = audiere::OpenDevice();
+	if (!m_pDevice->m_pAudiere.get())
+	{
+		LogMsg("SpeechPlayer: Couldn't open an Audiere device, speech is off");
+		SAFE_DELETE(m_pDevice);
+	}
+}
+
+//Same matching the audio_device config option gets: a full or partial name, "default" (or nothing) leaves it alone
+void SpeechPlayer::SelectFMODDriver(string audioDevice)
+{
+#ifdef RT_ENABLE_FMOD
+	audioDevice = ToLowerCaseString(audioDevice);
+	if (audioDevice.empty() || audioDevice == "default") return;
+
+	int driverCount = 0;
+	if (m_pDevice->m_pSystem->getNumDrivers(&driverCount) != FMOD_OK) return;
+
+	for (int i = 0; i < driverCount; i++)
+	{
+		char name[256];
+		if (m_pDevice->m_pSystem->getDriverInfo(i, name, sizeof(name), NULL, NULL, NULL, NULL) != FMOD_OK) continue;
+
+		if (ToLowerCaseString(name).find(audioDevice) != string::npos)
+		{
+			m_pDevice->m_pSystem->setDriver(i);
+			return;
+		}
+	}
+
+	LogMsg("SpeechPlayer: No audio device matching %s, using the default", audioDevice.c_str());
+#endif
+}
+
+void SpeechPlayer::Kill()
+{
+	for (int i = 0; i < (int)m_voices.size(); i++)
+	{
+		FreeVoice(m_voices[i]);
+	}
+	m_voices.clear();
+
+	if (m_pDevice)
+	{
+#ifdef RT_ENABLE_FMOD
+		if (m_pDevice->m_pSystem)
+		{
+			m_pDevice->m_pSystem->close();
+			m_pDevice->m_pSystem->release();
+		}
+#endif
+		SAFE_DELETE(m_pDevice);
+	}
+}
+
+SpeechBufferPtr SpeechPlayer::GetBuffer()
+{
+	vector<byte> *pBuffer = NULL;
+
+	if (!m_pBufferFreeList->m_buffers.empty())
+	{
+		pBuffer = m_pBufferFreeList->m_buffers.back();
+		m_pBufferFreeList->m_buffers.pop_back();
+		pBuffer->clear(); //keeps its capacity, that's the point
+	}
+	else
+	{
+		pBuffer = new vector<byte>;
+	}
+
+	std::weak_ptr<BufferFreeList> pWeakFreeList = m_pBufferFreeList;
+
+	return SpeechBufferPtr(pBuffer, [pWeakFreeList](vector<byte> *p)
+	{
+		std::shared_ptr<BufferFreeList> pFreeList = pWeakFreeList.lock();
+		if (pFreeList && (int)pFreeList->m_buffers.size() < C_SPEECH_MAX_FREE_BUFFERS)
+		{
+			pFreeList->m_buffers.push_back(p);
+		}
+		else
+		{
+			delete p;
+		}
+	});
+}
+
+bool SpeechPlayer::StartSegment(SpeechVoice *pVoice, SpeechBufferPtr pMP3)
+{
+	pVoice->m_pPlaying = pMP3;
+
+#ifdef RT_ENABLE_FMOD
+	if (m_pDevice->m_bFMOD)
+	{
+		FMOD_CREATESOUNDEXINFO info;
+		memset(&info, 0, sizeof(info));
+		info.cbsize = sizeof(info);
+		info.length = (unsigned int)pMP3->size();
+
+		//POINT means FMOD plays it right out of our buffer instead of copying it, m_pPlaying keeps it alive until the
+		//sound is released.  Compressed means it decodes as it plays instead of all up front
+		if (m_pDevice->m_pSystem->createSound((const char*)&(*pMP3)[0], FMOD_OPENMEMORY_POINT | FMOD_CREATECOMPRESSEDSAMPLE | FMOD_LOOP_OFF,
+			&info, &pVoice->m_pSound) != FMOD_OK)
+		{
+			return false;
+		}
+
+		return m_pDevice->m_pSystem->playSound(pVoice->m_pSound, NULL, false, &pVoice->m_pChannel) == FMOD_OK;
+	}
+#endif
+
+	if (!m_pDevice->m_pAudiere.get()) return false;
+
+	//the memory file is a copy.  No file name to guess the format from, so tell it
+	audiere::FilePtr pFile = audiere::CreateMemoryFile(&(*pMP3)[0], (int)pMP3->size());
+	pVoice->m_pStream = audiere::OpenSound(m_pDevice->m_pAudiere, pFile, true, audiere::FF_MP3);
+	if (!pVoice->m_pStream.get()) return false;
+
+	pVoice->m_pStream->play();
+	return true;
+}
+
+void SpeechPlayer::StopSegment(SpeechVoice *pVoice)
+{
+#ifdef RT_ENABLE_FMOD
+	if (pVoice->m_pChannel) pVoice->m_pChannel->stop();
+	if (pVoice->m_pSound) pVoice->m_pSound->release();
+	pVoice->m_pChannel = NULL;
+	pVoice->m_pSound = NULL;
+#endif
+
+	if (pVoice->m_pStream.get()) pVoice->m_pStream->stop();
+	pVoice->m_pStream = NULL;
+
+	pVoice->m_pPlaying.reset(); //only after FMOD is done with it
+}
+
+AudioHandle SpeechPlayer::Play(SpeechBufferPtr pMP3, std::chrono::steady_clock::time_point readyTime, bool bMoreToCome)
+{
+	if (!m_pDevice || !pMP3 || pMP3->empty()) return AUDIO_HANDLE_BLANK;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	SpeechVoice *pVoice = new SpeechVoice();
+	pVoice->m_readyTime = readyTime;
+	pVoice->m_bMoreToCome = bMoreToCome;
+
+	if (!StartSegment(pVoice, pMP3))
+	{
+		LogMsg("SpeechPlayer: Couldn't play the mp3 from memory");
+		FreeVoice(pVoice);
+		return AUDIO_HANDLE_BLANK;
+	}
+
+	pVoice->m_openMS = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	pVoice->m_handle = m_nextHandle++;
+	if (m_nextHandle == AUDIO_HANDLE_BLANK) m_nextHandle++;
+
+	m_voices.push_back(pVoice);
+	return pVoice->m_handle;
+}
+
+bool SpeechPlayer::Append(AudioHandle handle, SpeechBufferPtr pMP3, bool bMoreToCome)
+{
+	SpeechVoice *pVoice = GetVoice(handle);
+	if (!pVoice) return false;
+
+	pVoice->m_bMoreToCome = bMoreToCome;
+	if (!pMP3 || pMP3->empty()) return true;
+
+	if (pVoice->m_queued.empty() && !IsSegmentPlaying(pVoice))
+	{
+		//it was waiting on this one, no reason to wait for Update()
+		StopSegment(pVoice);
+		if (StartSegment(pVoice, pMP3)) return true;
+		StopSegment(pVoice);
+		return true; //skip it, the rest can still play
+	}
+
+	pVoice->m_queued.push_back(pMP3);
+	return true;
+}
+
+void SpeechPlayer::EndAppending(AudioHandle handle)
+{
+	SpeechVoice *pVoice = GetVoice(handle);
+	if (pVoice) pVoice->m_bMoreToCome = false;
+}
+
+bool SpeechPlayer::IsSegmentPlaying(SpeechVoice *pVoice)
+{
+#ifdef RT_ENABLE_FMOD
+	if (pVoice->m_pChannel)
+	{
+		bool bPlaying = false;
+		if (pVoice->m_pChannel->isPlaying(&bPlaying) != FMOD_OK) return false; //the channel got stolen or finished
+		return bPlaying;
+	}
+#endif
+
+	if (pVoice->m_pStream.get()) return pVoice->m_pStream->isPlaying();
+	return false;
+}
+
+//the first Update() where it's past the start, so this is only as exact as the frame rate
+void SpeechPlayer::LogIfJustHeard(SpeechVoice *pVoice)
+{
+	if (pVoice->m_bHeard) return;
+
+	bool bHeard = false;
+
+#ifdef RT_ENABLE_FMOD
+	if (pVoice->m_pChannel)
+	{
+		unsigned int positionMS = 0;
+		bHeard = pVoice->m_pChannel->getPosition(&positionMS, FMOD_TIMEUNIT_MS) == FMOD_OK && positionMS > 0;
+	}
+#endif
+
+	if (pVoice->m_pStream.get()) bHeard = pVoice->m_pStream->getPosition() > 0;
+	if (!bHeard) return;
+
+	pVoice->m_bHeard = true;
+	float totalMS = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - pVoice->m_readyTime).count();
+	LogMsg("TTS audio heard %.1f ms after we had it (%.1f ms of that opening it)", totalMS, pVoice->m_openMS);
+}
+
+void SpeechPlayer::Update()
+{
+#ifdef RT_ENABLE_FMOD
+	if (m_pDevice && m_pDevice->m_pSystem)
+	{
+		m_pDevice->m_pSystem->update();
+	}
+#endif
+
+	for (int i = 0; i < (int)m_voices.size();)
+	{
+		SpeechVoice *pVoice = m_voices[i];
+		LogIfJustHeard(pVoice);
+
+		if (IsSegmentPlaying(pVoice))
+		{
+			i++;
+			continue;
+		}
+
+		if (!pVoice->m_queued.empty())
+		{
+			//on to the next sentence.  If it won't play it's dropped and we try the one after next time
+			StopSegment(pVoice);
+			if (!StartSegment(pVoice, pVoice->m_queued.front())) StopSegment(pVoice);
+			pVoice->m_queued.pop_front();
+			i++;
+			continue;
+		}
+
+		if (pVoice->m_bMoreToCome)
+		{
+			i++; //whoever is playing it is still waiting on the rest to download
+			continue;
+		}
+
+		FreeVoice(pVoice);
+		m_voices.erase(m_voices.begin() + i);
+	}
+}
+
+SpeechVoice * SpeechPlayer::GetVoice(AudioHandle handle)
+{
+	for (int i = 0; i < (int)m_voices.size(); i++)
+	{
+		if (m_voices[i]->m_handle == handle) return m_voices[i];
+	}
+
+	return NULL;
+}
+
+bool SpeechPlayer::IsPlaying(AudioHandle handle)
+{
+	SpeechVoice *pVoice = GetVoice(handle);
+	return pVoice && (IsSegmentPlaying(pVoice) || !pVoice->m_queued.empty() || pVoice->m_bMoreToCome);
+}
+
+void SpeechPlayer::Stop(AudioHandle handle)
+{
+	SpeechVoice *pVoice = GetVoice(handle);
+	if (!pVoice) return;
+
+	m_voices.erase(std::find(m_voices.begin(), m_voices.end(), pVoice));
+	FreeVoice(pVoice);
+}
+
+void SpeechPlayer::FreeVoice(SpeechVoice *pVoice)
+{
+	StopSegment(pVoice);
+	delete pVoice;
+}
@@ -0,0 +1,70 @@
+//Plays the text to speech mp3s straight from memory.  Proton's AudioManager only plays files, so every line used to be
+//written to temp_audio_N.mp3 on the main thread, played, then deleted.  This opens its own device/system with the same
+//library and output device the audio config picked (FMOD if we were built with it, otherwise Audiere) and hands it the
+//bytes.  Nothing touches the disk, if the library won't take it from memory that line just doesn't play.
+//
+//The mp3s live in SpeechBuffers from GetBuffer(), which get recycled when the last user lets go, so decoding the next
+//line reuses an old allocation.  FMOD reads the buffer in place while it plays, Audiere makes its own copy.
+//
+//One handle can play several mp3s back to back (a long line split into sentences), pass bMoreToCome and Append() the
+//rest as they show up.  The next one starts on the Update() after the last one ends, so there can be a frame of gap.
+//Each Play() logs how long it was from having the mp3 to it actually being heard.
+
+#ifndef SpeechPlayer_h__
+#define SpeechPlayer_h__
+
+#include <chrono>
+#include <memory>
+
+class SpeechVoice;
+class SpeechDevice;
+
+typedef std::shared_ptr<vector<byte> > SpeechBufferPtr;
+
+class SpeechPlayer
+{
+public:
+	SpeechPlayer();
+	virtual ~SpeechPlayer();
+
+	void Init(string audioSystem, string audioDevice); //what the audio config says: fmod, sdl, audiere or none, and audio_device
+	void Kill();
+	void Update(); //once a frame, cleans up finished voices and keeps FMOD going
+
+	//An empty buffer to decode an mp3 into, it goes back to the pool when the last SpeechBufferPtr to it is gone
+	SpeechBufferPtr GetBuffer();
+
+	//We hang onto the buffer while it's queued or playing, don't change it after.  readyTime is when we had the mp3 in
+	//hand (response came in, cache hit)
+	AudioHandle Play(SpeechBufferPtr pMP3, std::chrono::steady_clock::time_point readyTime, bool bMoreToCome = false);
+	bool Append(AudioHandle handle, SpeechBufferPtr pMP3, bool bMoreToCome); //false if it was stopped or is over
+	void EndAppending(AudioHandle handle); //nothing else is coming after all, it ends after what it has
+	bool IsPlaying(AudioHandle handle); //true while waiting on more too
+	void Stop(AudioHandle handle);
+
+protected:
+
+	void SelectFMODDriver(string audioDevice);
+	bool StartSegment(SpeechVoice *pVoice, SpeechBufferPtr pMP3);
+	void StopSegment(SpeechVoice *pVoice);
+	bool IsSegmentPlaying(SpeechVoice *pVoice);
+	void LogIfJustHeard(SpeechVoice *pVoice);
+	void FreeVoice(SpeechVoice *pVoice);
+	SpeechVoice * GetVoice(AudioHandle handle);
+
+	SpeechDevice *m_pDevice = NULL; //NULL means audio is off
+	vector<SpeechVoice*> m_voices;
+	AudioHandle m_nextHandle = 1;
+
+	//the buffers hang onto this instead of the player, so they're safe to let go of after it's gone
+	class BufferFreeList
+	{
+	public:
+		vector<vector<byte>*> m_buffers;
+		~BufferFreeList();
+	};
+
+	std::shared_ptr<BufferFreeList> m_pBufferFreeList;
+};
+
+#endif // SpeechPlayer_h__
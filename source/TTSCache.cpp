@@ -0,0 +1,120 @@
+#include "PlatformPrecomp.h"
+#include "TTSCache.h"
+
+TTSCache::TTSCache()
+{
+}
+
+TTSCache::~TTSCache()
+{
+	Kill();
+}
+
+bool TTSCache::Init(string fileName, size_t maxDiskBytes, size_t maxMemoryBytes)
+{
+	Kill();
+	m_maxMemoryBytes = maxMemoryBytes;
+	return m_diskStore.Open(fileName, maxDiskBytes);
+}
+
+void TTSCache::Kill()
+{
+	m_diskStore.Close();
+	m_lru.clear();
+	m_memoryIndex.clear();
+	m_memoryBytes = 0;
+}
+
+string TTSCache::MakeKey(const string &text, const string &languageCode, const string &voiceName, const string &voiceGender,
+	float speakingRate, const string &audioEncoding)
+{
+	char rate[32];
+	sprintf(rate, "%.2f", speakingRate);
+
+	//a null between each so two fields can't run together into the same bytes
+	string fields[] = { languageCode, voiceName, voiceGender, rate, audioEncoding, text };
+
+	//FNV-1a, 64 bits is plenty for the number of lines anybody will ever hear
+	uint64_t hash = 14695981039346656037ULL;
+	for (int i = 0; i < (int)(sizeof(fields) / sizeof(fields[0])); i++)
+	{
+		const string &field = fields[i];
+		for (size_t j = 0; j <= field.length(); j++)
+		{
+			hash ^= (byte)field.c_str()[j];
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	char hex[17];
+	sprintf(hex, "%08X%08X", (uint32)(hash >> 32), (uint32)hash);
+	return hex;
+}
+
+void TTSCache::AddToMemory(const string &key, const byte *pAudio, size_t size)
+{
+	if (size > m_maxMemoryBytes) return;
+
+	auto itor = m_memoryIndex.find(key);
+	if (itor != m_memoryIndex.end())
+	{
+		m_memoryBytes -= itor->second->second.size();
+		m_lru.erase(itor->second);
+		m_memoryIndex.erase(itor);
+	}
+
+	m_lru.push_front(std::make_pair(key, vector<byte>(pAudio, pAudio + size)));
+	m_memoryIndex[key] = m_lru.begin();
+	m_memoryBytes += size;
+
+	while (m_memoryBytes > m_maxMemoryBytes)
+	{
+		m_memoryBytes -= m_lru.back().second.size();
+		m_memoryIndex.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+}
+
+bool TTSCache::Get(const string &key, vector<byte> *pAudioOut)
+{
+	if (!m_diskStore.IsOpen()) return false; //disabled
+
+	auto itor = m_memoryIndex.find(key);
+	if (itor != m_memoryIndex.end())
+	{
+		m_lru.splice(m_lru.begin(), m_lru, itor->second);
+		*pAudioOut = itor->second->second;
+		m_hits++;
+		return true;
+	}
+
+	const byte *pData;
+	size_t size;
+	if (m_diskStore.Get(key, &pData, &size) && size > 0)
+	{
+		pAudioOut->assign(pData, pData + size);
+		AddToMemory(key, pData, size);
+		m_hits++;
+		m_diskHits++;
+		return true;
+	}
+
+	m_misses++;
+	return false;
+}
+
+void TTSCache::Put(const string &key, const byte *pAudio, size_t size)
+{
+	if (!m_diskStore.IsOpen() || size == 0) return;
+	AddToMemory(key, pAudio, size);
+	m_diskStore.Put(key, pAudio, size);
+}
+
+void TTSCache::LogStats()
+{
+	uint32 total = m_hits + m_misses;
+	if (total == 0) return;
+
+	LogMsg("TTS cache: %d hits (%d from disk), %d misses, %.1f%% hit rate.  %d entries on disk (%d KB)", m_hits, m_diskHits, m_misses,
+		100.0f * (float)m_hits / (float)total, (int)m_diskStore.GetEntryCount(), (int)(m_diskStore.GetFileBytes() / 1024));
+}
@@ -0,0 +1,50 @@
+//Remembers the decoded mp3s we got back from Google's text to speech, so hearing the same line again (replaying it, or
+//the same NPC greeting every time you walk by) plays right away instead of doing another round trip and paying for it.
+//
+//Keyed by a hash of everything that changes how it sounds: the text, language/region, voice, gender and speaking rate.
+//A few MB of recent ones are kept in memory, the rest live in a BlobStore on disk so hits survive restarts.  Main
+//thread only.
+
+#ifndef TTSCache_h__
+#define TTSCache_h__
+
+#include "BlobStore.h"
+
+const size_t C_TTS_CACHE_MEMORY_BYTES = 8 * 1024 * 1024; //a line is usually 20-100 KB of mp3
+
+class TTSCache
+{
+public:
+	TTSCache();
+	virtual ~TTSCache();
+
+	bool Init(string fileName, size_t maxDiskBytes, size_t maxMemoryBytes);
+	void Kill();
+	bool IsEnabled() { return m_diskStore.IsOpen(); }
+
+	static string MakeKey(const string &text, const string &languageCode, const string &voiceName, const string &voiceGender,
+		float speakingRate, const string &audioEncoding);
+
+	bool Get(const string &key, vector<byte> *pAudioOut);
+	void Put(const string &key, const byte *pAudio, size_t size);
+
+	void LogStats();
+
+protected:
+
+	typedef std::list<std::pair<string, vector<byte> > > LRUList;
+
+	void AddToMemory(const string &key, const byte *pAudio, size_t size);
+
+	LRUList m_lru; //front is most recently used
+	std::unordered_map<string, LRUList::iterator> m_memoryIndex;
+	size_t m_memoryBytes = 0;
+	size_t m_maxMemoryBytes = 0;
+	BlobStore m_diskStore;
+
+	uint32 m_hits = 0;
+	uint32 m_diskHits = 0;
+	uint32 m_misses = 0;
+};
+
+#endif // TTSCache_h__
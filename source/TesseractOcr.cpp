@@ -0,0 +1,383 @@
+#include "PlatformPrecomp.h"
+#include "TesseractOcr.h"
+#include "GameLogicComponent.h"
+
+#ifdef RT_TESSERACT_SUPPORT
+#include <tesseract/baseapi.h>
+#include <tesseract/resultiterator.h>
+#endif
+
+const int C_TESSERACT_BAND_HEIGHT = 400; //captures taller than this get split up
+const int C_TESSERACT_BAND_OVERLAP = 96; //each band sees this much of its neighbors, so a line on the edge is whole in one of them
+const int C_TESSERACT_MIN_WORD_CONFIDENCE = 40; //under this it's usually a button or a bit of border, not text
+const int C_TESSERACT_ASSUMED_DPI = 96; //it's a screen.  If we don't say, it guesses 70 and complains
+
+TesseractOcr::TesseractOcr() : m_bReady(false), m_bFailed(false), m_bQuit(false)
+{
+}
+
+TesseractOcr::~TesseractOcr()
+{
+	Kill();
+}
+
+string TesseractOcr::GetLanguageCode(string languages)
+{
+	//the first one is the one we care about
+	string first = languages.substr(0, languages.find('+'));
+
+	if (first == "jpn" || first == "jpn_vert") return "ja";
+	if (first == "chi_sim" || first == "chi_sim_vert") return "zh-CN";
+	if (first == "chi_tra" || first == "chi_tra_vert") return "zh-TW";
+	if (first == "kor" || first == "kor_vert") return "ko";
+	if (first == "eng") return "en";
+	if (first == "fra") return "fr";
+	if (first == "deu") return "de";
+	if (first == "spa") return "es";
+	if (first == "ita") return "it";
+	if (first == "por") return "pt";
+	if (first == "rus") return "ru";
+
+	return first.substr(0, 2); //good enough for most of the rest
+}
+
+bool TesseractOcr::Init(string dataPath, string languages, int engineCount, WorkerPool *pWorkerPool)
+{
+	Kill();
+
+#ifndef RT_TESSERACT_SUPPORT
+	LogMsg("Can't use Tesseract for OCR, this build doesn't have it (RT_TESSERACT_SUPPORT)");
+	m_bFailed = true;
+	return false;
+#else
+	m_dataPath = dataPath;
+	m_languages = languages;
+	m_languageCode = GetLanguageCode(languages);
+	m_engineCount = rt_max(engineCount, 1);
+	m_pWorkerPool = pWorkerPool;
+	m_bReady = false;
+	m_bFailed = false;
+	m_bQuit = false;
+
+	LogMsg("Loading Tesseract %s models from %s for %d threads...", languages.c_str(), dataPath.c_str(), m_engineCount);
+	m_loadThread = std::thread(&TesseractOcr::LoadThreadProc, this);
+	return true;
+#endif
+}
+
+void TesseractOcr::LoadThreadProc()
+{
+#ifdef RT_TESSERACT_SUPPORT
+	for (int i = 0; i < m_engineCount && !m_bQuit; i++)
+	{
+		tesseract::TessBaseAPI *pEngine = new tesseract::TessBaseAPI();
+
+		if (pEngine->Init(m_dataPath.c_str(), m_languages.c_str(), tesseract::OEM_LSTM_ONLY) != 0)
+		{
+			delete pEngine;
+
+			if (i == 0)
+			{
+				m_bFailed = true;
+				string msg = "Tesseract couldn't load " + m_languages + " from " + m_dataPath + ", are the .traineddata files there?";
+				LogMsgFromAnyThread("%s", msg.c_str());
+			}
+			return; //if the first few loaded we just run with those
+		}
+
+		pEngine->SetPageSegMode(tesseract::PSM_AUTO);
+
+		{
+			std::lock_guard<std::mutex> lock(m_engineMutex);
+			m_engines.push_back(pEngine);
+			m_freeEngines.push_back(pEngine);
+		}
+		m_engineCondition.notify_one();
+
+		if (i == 0)
+		{
+			m_bReady = true; //good enough to start scanning, just less in parallel until the rest are in
+			LogMsgFromAnyThread("Tesseract is ready");
+		}
+	}
+#endif
+}
+
+void TesseractOcr::Kill()
+{
+	m_bQuit = true;
+	if (m_loadThread.joinable())
+	{
+		m_loadThread.join(); //can't stop it mid model, but it'll quit after the one it's on
+	}
+
+#ifdef RT_TESSERACT_SUPPORT
+	//nothing is using them, the worker pool was stopped first
+	for (int i = 0; i < (int)m_engines.size(); i++)
+	{
+		m_engines[i]->End();
+		delete m_engines[i];
+	}
+#endif
+
+	m_engines.clear();
+	m_freeEngines.clear();
+	m_bReady = false;
+}
+
+tesseract::TessBaseAPI * TesseractOcr::GetEngine()
+{
+	std::unique_lock<std::mutex> lock(m_engineMutex);
+	m_engineCondition.wait(lock, [this]() { return !m_freeEngines.empty(); });
+
+	tesseract::TessBaseAPI *pEngine = m_freeEngines.back();
+	m_freeEngines.pop_back();
+	return pEngine;
+}
+
+void TesseractOcr::ReturnEngine(tesseract::TessBaseAPI *pEngine)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_engineMutex);
+		m_freeEngines.push_back(pEngine);
+	}
+	m_engineCondition.notify_one();
+}
+
+static void AppendJsonString(string *pOut, const char *pText)
+{
+	*pOut += '"';
+	for (const char *p = pText; *p; p++)
+	{
+		switch (*p)
+		{
+		case '"': *pOut += "\\\""; break;
+		case '\\': *pOut += "\\\\"; break;
+		case '\n': *pOut += "\\n"; break;
+		case '\r': *pOut += "\\r"; break;
+		case '\t': *pOut += "\\t"; break;
+		default:
+			if ((unsigned char)*p < 0x20) break; //other control chars, don't want them anyway
+			*pOut += *p;
+		}
+	}
+	*pOut += '"';
+}
+
+static void AppendJsonPolygon(string *pOut, int left, int top, int right, int bottom)
+{
+	char buff[160];
+	sprintf(buff, "[{\"x\":%d,\"y\":%d},{\"x\":%d,\"y\":%d},{\"x\":%d,\"y\":%d},{\"x\":%d,\"y\":%d}]",
+		left, top, right, top, right, bottom, left, bottom);
+	*pOut += buff;
+}
+
+//Tesseract wants the text dark on light, which a lot of games don't do.  Gray, top down, and flipped if it's mostly dark
+static void MakeTesseractImage(const CaptureFrame &frame, int top, int bottom, vector<byte> *pGrayOut)
+{
+	int width = frame.m_width;
+	int height = bottom - top;
+	int bytesPerPixel = GetPixelFormatBytesPerPixel(frame.m_format);
+	bool bBGR = frame.m_format == PIXEL_FORMAT_BGR || frame.m_format == PIXEL_FORMAT_BGRA;
+	int redIndex = bBGR ? 2 : 0;
+	int blueIndex = bBGR ? 0 : 2;
+
+	pGrayOut->resize(width * height);
+	uint64_t total = 0;
+
+	for (int y = 0; y < height; y++)
+	{
+		int imageY = top + y;
+		int memoryY = frame.m_bBottomUp ? frame.m_height - 1 - imageY : imageY;
+		const byte *pSrc = frame.m_pPixels + memoryY * frame.m_pitch;
+		byte *pDest = &(*pGrayOut)[y * width];
+
+		for (int x = 0; x < width; x++)
+		{
+			pDest[x] = (byte)((pSrc[redIndex] * 77 + pSrc[1] * 150 + pSrc[blueIndex] * 29) >> 8);
+			total += pDest[x];
+			pSrc += bytesPerPixel;
+		}
+	}
+
+	if (total < (uint64_t)128 * width * height)
+	{
+		for (int i = 0; i < (int)pGrayOut->size(); i++)
+		{
+			(*pGrayOut)[i] = 255 - (*pGrayOut)[i];
+		}
+	}
+}
+
+//Recognizes rows top to bottom of the frame, but only keeps lines whose middle is between keepTop and keepBottom, the
+//neighboring bands get the rest.  Writes the lines (comma separated) in the read API format, in frame coordinates.
+bool TesseractOcr::RecognizeBand(const CaptureFrame &frame, int top, int bottom, int keepTop, int keepBottom, string *pLinesOut)
+{
+#ifndef RT_TESSERACT_SUPPORT
+	return false;
+#else
+	vector<byte> gray;
+	MakeTesseractImage(frame, top, bottom, &gray);
+
+	tesseract::TessBaseAPI *pEngine = GetEngine();
+	pEngine->SetImage(&gray[0], frame.m_width, bottom - top, 1, frame.m_width);
+	pEngine->SetSourceResolution(C_TESSERACT_ASSUMED_DPI);
+
+	if (pEngine->Recognize(NULL) != 0)
+	{
+		pEngine->Clear();
+		ReturnEngine(pEngine);
+		return false;
+	}
+
+	bool bSpaceBetweenWords = !IsAsianLanguage(m_languageCode);
+	tesseract::ResultIterator *pIt = pEngine->GetIterator();
+
+	if (pIt && !pIt->Empty(tesseract::RIL_TEXTLINE))
+	{
+		do
+		{
+			int left, lineTop, right, lineBottom;
+			if (!pIt->BoundingBox(tesseract::RIL_TEXTLINE, &left, &lineTop, &right, &lineBottom)) continue;
+
+			int middle = top + (lineTop + lineBottom) / 2;
+			if (middle < keepTop || middle >= keepBottom) continue;
+
+			string words;
+			do
+			{
+				if (pIt->Empty(tesseract::RIL_WORD)) continue;
+				if (pIt->Confidence(tesseract::RIL_WORD) < C_TESSERACT_MIN_WORD_CONFIDENCE) continue;
+
+				char *pText = pIt->GetUTF8Text(tesseract::RIL_WORD);
+				if (!pText) continue;
+
+				string text = pText;
+				delete[] pText;
+
+				if (bSpaceBetweenWords && !pIt->IsAtFinalElement(tesseract::RIL_TEXTLINE, tesseract::RIL_WORD)) text += " ";
+
+				int wordLeft, wordTop, wordRight, wordBottom;
+				pIt->BoundingBox(tesseract::RIL_WORD, &wordLeft, &wordTop, &wordRight, &wordBottom);
+
+				if (!words.empty()) words += ",";
+				words += "{\"text\":";
+				AppendJsonString(&words, text.c_str());
+				words += ",\"boundingPolygon\":";
+				AppendJsonPolygon(&words, wordLeft, top + wordTop, wordRight, top + wordBottom);
+				words += "}";
+
+			} while (!pIt->IsAtFinalElement(tesseract::RIL_TEXTLINE, tesseract::RIL_WORD) && pIt->Next(tesseract::RIL_WORD));
+
+			if (words.empty()) continue;
+
+			if (!pLinesOut->empty()) *pLinesOut += ",";
+			*pLinesOut += "{\"words\":[" + words + "]}";
+
+		} while (pIt->Next(tesseract::RIL_TEXTLINE));
+	}
+
+	delete pIt;
+	pEngine->Clear();
+	ReturnEngine(pEngine);
+	return true;
+#endif
+}
+
+//what the bands share while they're being worked on, helpers that start late find nothing left and just leave
+class TesseractBandWork
+{
+public:
+	CaptureFrame m_frame;
+	CancelToken m_cancelToken;
+	int m_bandCount = 0;
+	std::atomic<int> m_nextBand;
+	vector<string> m_lines;
+	vector<char> m_bandOk; //not vector<bool>, bands are written from different threads and that packs them into the same bytes
+
+	int m_doneCount = 0;
+	std::mutex m_doneMutex;
+	std::condition_variable m_doneCondition;
+};
+
+bool TesseractOcr::Recognize(const CaptureFrame &frame, const CancelToken &cancelToken, vector<byte> *pResponseOut)
+{
+	pResponseOut->clear();
+	if (!m_bReady || frame.m_width <= 0 || frame.m_height <= 0) return false;
+
+	std::shared_ptr<TesseractBandWork> pWork = std::make_shared<TesseractBandWork>();
+	pWork->m_frame = frame;
+	pWork->m_cancelToken = cancelToken;
+	pWork->m_bandCount = 1;
+	pWork->m_nextBand = 0;
+
+	if (frame.m_height > C_TESSERACT_BAND_HEIGHT + C_TESSERACT_BAND_OVERLAP && m_engineCount > 1)
+	{
+		pWork->m_bandCount = (frame.m_height + C_TESSERACT_BAND_HEIGHT - 1) / C_TESSERACT_BAND_HEIGHT;
+	}
+
+	pWork->m_lines.resize(pWork->m_bandCount);
+	pWork->m_bandOk.resize(pWork->m_bandCount, 0);
+
+	auto doBands = [this, pWork]()
+	{
+		while (true)
+		{
+			int band = pWork->m_nextBand++;
+			if (band >= pWork->m_bandCount) return;
+
+			if (!pWork->m_cancelToken.IsCanceled())
+			{
+				const CaptureFrame &frame = pWork->m_frame;
+				int keepTop = band * C_TESSERACT_BAND_HEIGHT;
+				int keepBottom = band == pWork->m_bandCount - 1 ? frame.m_height : keepTop + C_TESSERACT_BAND_HEIGHT;
+				int top = rt_max(keepTop - C_TESSERACT_BAND_OVERLAP, 0);
+				int bottom = rt_min(keepBottom + C_TESSERACT_BAND_OVERLAP, frame.m_height);
+
+				pWork->m_bandOk[band] = RecognizeBand(frame, top, bottom, keepTop, keepBottom, &pWork->m_lines[band]);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(pWork->m_doneMutex);
+				pWork->m_doneCount++;
+			}
+			pWork->m_doneCondition.notify_all();
+		}
+	};
+
+	//we do bands on this thread too, so even if every worker is busy it still gets done
+	int helperCount = rt_min(pWork->m_bandCount, m_engineCount) - 1;
+	for (int i = 0; i < helperCount; i++)
+	{
+		m_pWorkerPool->AddJob(doBands);
+	}
+
+	doBands();
+
+	{
+		std::unique_lock<std::mutex> lock(pWork->m_doneMutex);
+		pWork->m_doneCondition.wait(lock, [pWork]() { return pWork->m_doneCount == pWork->m_bandCount; });
+	}
+
+	if (cancelToken.IsCanceled()) return false;
+
+	string response = "{\"readResult\":{\"language\":";
+	AppendJsonString(&response, m_languageCode.c_str());
+	response += ",\"blocks\":[{\"lines\":[";
+
+	bool bFirst = true;
+	for (int i = 0; i < pWork->m_bandCount; i++)
+	{
+		if (!pWork->m_bandOk[i]) return false;
+		if (pWork->m_lines[i].empty()) continue;
+
+		if (!bFirst) response += ",";
+		response += pWork->m_lines[i];
+		bFirst = false;
+	}
+
+	response += "]}]}}";
+
+	pResponseOut->assign(response.begin(), response.end());
+	return true;
+}
@@ -0,0 +1,73 @@
+//Local OCR with Tesseract, for vision_engine|tesseract.  Nothing leaves the machine and there's no per-call cost, the
+//price is worse results than the cloud engines on fancy game fonts.
+//
+//Loading the models takes a second or more (jpn is big), so it happens on its own thread and the app comes up right away.
+//A scan before the first one is loaded just says so.  A TessBaseAPI can't be shared between threads, so there's one per
+//thread that can be recognizing at once, handed out as they're free.
+//
+//Recognize() writes its result out as a Microsoft read API style response, so it goes through the same parser, OcrCache
+//and TextArea building as the cloud engines.  Tall captures are cut into overlapping bands that run on the worker pool
+//at the same time.
+//
+//It only needs a CaptureFrame and a WorkerPool, nothing from the GUI, so it can be driven without a window (feed it
+//images with a FileCaptureSource) for testing.
+//
+//Needs RT_TESSERACT_SUPPORT defined and tesseract/leptonica linked, without that Init() just fails and logs why.
+
+#ifndef TesseractOcr_h__
+#define TesseractOcr_h__
+
+#include "CaptureSource.h"
+#include "WorkerPool.h"
+
+namespace tesseract
+{
+	class TessBaseAPI;
+}
+
+class TesseractOcr
+{
+public:
+
+	TesseractOcr();
+	virtual ~TesseractOcr();
+
+	//languages is how Tesseract names them, jpn or jpn+eng etc.  engineCount is how many bands can be recognized at once.
+	//Returns right away, the models load on another thread
+	bool Init(string dataPath, string languages, int engineCount, WorkerPool *pWorkerPool);
+	void Kill(); //the worker pool must already be stopped
+
+	bool IsReady() { return m_bReady; } //at least one engine is loaded
+	bool HasFailed() { return m_bFailed; } //couldn't load at all, the reason is in the log
+
+	//Call from a worker thread, the other workers help out with the bands.  False if nothing is loaded yet, it failed, or it
+	//got canceled.  The response is not null terminated
+	bool Recognize(const CaptureFrame &frame, const CancelToken &cancelToken, vector<byte> *pResponseOut);
+
+	static string GetLanguageCode(string languages); //jpn+eng -> ja, what the rest of UGT calls it
+
+protected:
+
+	void LoadThreadProc();
+	tesseract::TessBaseAPI * GetEngine(); //waits until one is free
+	void ReturnEngine(tesseract::TessBaseAPI *pEngine);
+	bool RecognizeBand(const CaptureFrame &frame, int top, int bottom, int keepTop, int keepBottom, string *pLinesOut);
+
+	string m_dataPath;
+	string m_languages;
+	string m_languageCode;
+	int m_engineCount = 0;
+	WorkerPool *m_pWorkerPool = NULL;
+
+	std::thread m_loadThread;
+	std::atomic<bool> m_bReady;
+	std::atomic<bool> m_bFailed;
+	std::atomic<bool> m_bQuit;
+
+	vector<tesseract::TessBaseAPI*> m_engines; //all of them, so Kill() can delete them
+	vector<tesseract::TessBaseAPI*> m_freeEngines;
+	std::mutex m_engineMutex;
+	std::condition_variable m_engineCondition;
+};
+
+#endif // TesseractOcr_h__
@@ -9,9 +9,11 @@
 #include "AutoPlayManager.h"
 #include "Gamepad/GamepadManager.h"
 #include "util/TextScanner.h"
+#include "JsonPullReader.h"
+#include "Base64Utils.h"
 
-int g_counter = 0;
- 
+const int C_TTS_MIN_SENTENCE_BYTES = 4; //shorter than this (a lone "!" or "...") just goes with the next one
+const int C_TTS_MAX_SENTENCES = 8; //past this the rest all goes in the last request
 
 AudioHandle g_lastAudioHandle = AUDIO_HANDLE_BLANK;
 
@@ -27,13 +29,18 @@ TextAreaComponent::TextAreaComponent()
 
 bool TextAreaComponent::FinishedWithTranslation()
 {
-	return !m_bWaitingForTranslation;
+	return !m_bWaitingForTranslation && !m_bDestRasterPending;
 }
 
 
 
 TextAreaComponent::~TextAreaComponent()
 {
+	for (int i = 0; i < RASTER_TARGET_COUNT; i++)
+	{
+		m_rasterTokens[i].Cancel(); //anything a worker is still rendering for us gets thrown away
+	}
+
 	SAFE_DELETE(m_pSourceLanguageSurf);
 	SAFE_DELETE(m_pDestLanguageSurf);
 
@@ -49,13 +56,10 @@ TextAreaComponent::~TextAreaComponent()
 		m_pSpeakerIconSrc = NULL;
 	}
 
-	if (!m_fileNameToRemove.empty())
-	{
-		RemoveFile(m_fileNameToRemove);
-	}
-
 	if (IsBaseAppInitted())
 	{
+		ResetAudioChunks(); //otherwise the player would keep waiting on sentences that are never coming
+		if (GetApp()->GetAutoPlayManager()) GetApp()->GetAutoPlayManager()->OnRemoveDialog(this);
 		GetApp()->m_pGameLogicComp->RemoveTextBox(this);
 	}
 	
@@ -63,23 +67,116 @@ TextAreaComponent::~TextAreaComponent()
 
 void TextAreaComponent::StopSoundIfItWasPlaying()
 {
-	if (g_lastAudioHandle != AUDIO_HANDLE_BLANK)
+	//only if it's still ours, another box could have started talking since
+	if (m_audioHandle != AUDIO_HANDLE_BLANK && g_lastAudioHandle == m_audioHandle)
 	{
-		GetAudioManager()->Stop(g_lastAudioHandle);
-		m_audioHandle = AUDIO_HANDLE_BLANK;
+		GetApp()->GetSpeechPlayer()->Stop(g_lastAudioHandle);
 		g_lastAudioHandle = AUDIO_HANDLE_BLANK;
 	}
+
+	m_audioHandle = AUDIO_HANDLE_BLANK;
+	m_bPlayAudioWhenItArrives = false; //the rest of the sentences too
+}
+
+static bool IsSentenceEnd(const string &text, size_t i, size_t *pLengthOut)
+{
+	//the full width ones are what Japanese and Chinese use, they don't need a space after
+	static const char *fullWidth[] = { "\xE3\x80\x82", "\xEF\xBC\x81", "\xEF\xBC\x9F" }; //。！？
+	for (int j = 0; j < 3; j++)
+	{
+		if (text.compare(i, 3, fullWidth[j]) == 0)
+		{
+			*pLengthOut = 3;
+			return true;
+		}
+	}
+
+	*pLengthOut = 1;
+	return text[i] == '.' || text[i] == '!' || text[i] == '?';
+}
+
+static bool IsClosingQuote(const string &text, size_t i, size_t *pLengthOut)
+{
+	static const char *fullWidth[] = { "\xE3\x80\x8D", "\xE3\x80\x8F", "\xEF\xBC\x89" }; //」』）
+	for (int j = 0; j < 3; j++)
+	{
+		if (text.compare(i, 3, fullWidth[j]) == 0)
+		{
+			*pLengthOut = 3;
+			return true;
+		}
+	}
+
+	*pLengthOut = 1;
+	return text[i] == '"' || text[i] == '\'' || text[i] == ')';
 }
 
-void TextAreaComponent::RequestAudio(bool bUseSrcLanguage, bool bShowMessage)
+static void AddSentence(const string &text, size_t start, size_t end, vector<string> *pOut)
+{
+	while (start < end && isspace((unsigned char)text[start])) start++;
+	while (end > start && isspace((unsigned char)text[end - 1])) end--;
+	if (end > start) pOut->push_back(text.substr(start, end - start));
+}
+
+//Cuts after . ! ? (with a space or the end after them) and 。！？, keeping any closing quotes with the sentence.  Not at
+//line breaks, a dialog box wraps mid sentence.  "Mr. Smith" gets cut too, it still sounds fine.
+static void SplitIntoSentences(const string &text, vector<string> *pOut)
+{
+	pOut->clear();
+	size_t start = 0;
+	size_t i = 0;
+
+	while (i < text.length() && (int)pOut->size() < C_TTS_MAX_SENTENCES - 1)
+	{
+		size_t length;
+		if (!IsSentenceEnd(text, i, &length))
+		{
+			i++;
+			continue;
+		}
+
+		bool bNeedsSpace = length == 1;
+
+		//take all of "!?" or "。」"
+		size_t end = i + length;
+		while (end < text.length() && (IsSentenceEnd(text, end, &length) || IsClosingQuote(text, end, &length)))
+		{
+			end += length;
+		}
+
+		i = end;
+		if (bNeedsSpace && end < text.length() && !isspace((unsigned char)text[end]))
+		{
+			continue; //3.14 or an URL, not the end of anything
+		}
+
+		if (end - start < C_TTS_MIN_SENTENCE_BYTES) continue; //too short to bother, it goes with the next one
+
+		size_t before = pOut->size();
+		AddSentence(text, start, end, pOut);
+		if (pOut->size() > before) start = end;
+	}
+
+	size_t before = pOut->size();
+	AddSentence(text, start, text.length(), pOut);
+
+	if (pOut->size() > 1 && pOut->size() > before && pOut->back().length() < C_TTS_MIN_SENTENCE_BYTES)
+	{
+		//a tiny leftover bit, put it on the one before
+		string leftover = pOut->back();
+		pOut->pop_back();
+		pOut->back() += " " + leftover;
+	}
+}
+
+void TextAreaComponent::RequestAudio(bool bUseSrcLanguage, bool bShowMessage, bool bPlay)
 {
 	if (GetApp()->GetShared()->GetVar("check_src_audio")->GetUINT32() == 0)
 	{
 		bUseSrcLanguage = !bUseSrcLanguage;
 	}
 
-	string url = "https://texttospeech.googleapis.com";
-	string urlappend = "/v1/text:synthesize?key=" + GetApp()->GetGoogleKey();
+	string url = "https://texttospeech.googleapis.com/v1/text:synthesize?key=" + GetApp()->GetGoogleKey();
 
 	unsigned int originalFileSize = 0;
 
@@ -164,6 +261,7 @@ void TextAreaComponent::RequestAudio(bool bUseSrcLanguage, bool bShowMessage)
 	string languageCode = language +"-"+ToUpperCaseString(languageRegion);
 	string languageLetter = "A";
 	string audioEncoding = "MP3";
+	float speakingRate = 1.0f; //Google's default
 
 	//voice overrides for better sounding voices given the state of WaveNet on 9/12/2019
 	if (languageCode == "en-US") languageLetter = "F";
@@ -173,12 +271,6 @@ void TextAreaComponent::RequestAudio(bool bUseSrcLanguage, bool bShowMessage)
 	
 	m_lastTTSLanguageTarget = languageCode;
 
-	//create json
-	cJSON* root = cJSON_CreateObject();
-	cJSON* pInput = cJSON_AddObjectToObject(root, "input");
-	cJSON_AddItemToObject(pInput, "text", cJSON_CreateString(textToTranslate.c_str()));
-	cJSON* pVoice = cJSON_AddObjectToObject(root, "voice");
-
 	if (bShowMessage)
 	{
 		if (bGuessedAtLanguage)
@@ -191,246 +283,215 @@ void TextAreaComponent::RequestAudio(bool bUseSrcLanguage, bool bShowMessage)
 		}
 	}
 
-	cJSON_AddItemToObject(pVoice, "languageCode", cJSON_CreateString(languageCode.c_str()));
-	cJSON_AddItemToObject(pVoice, "name", cJSON_CreateString(finalVoice.c_str()));
-	cJSON_AddItemToObject(pVoice, "ssmlGender", cJSON_CreateString(voiceGender.c_str()));
-
-	cJSON* pAudioConfig = cJSON_AddObjectToObject(root, "audioConfig");
-	cJSON_AddItemToObject(pAudioConfig, "audioEncoding", cJSON_CreateString(audioEncoding.c_str()));
-
-	string postData(cJSON_Print(root));
-
-#ifdef _DEBUG
-	//LogMsg(postData.c_str());
-#endif
-
-	m_netAudioHTTP.Setup(url, 80, urlappend, NetHTTP::END_OF_DATA_SIGNAL_HTTP);
-	m_netAudioHTTP.AddPostData("", (const byte*)postData.c_str(), (int)postData.length());
-	m_netAudioHTTP.Start();
-}
-
-bool TextAreaComponent::IsStillPlayingOrPlanningToPlay()
-{
-	if (m_netAudioHTTP.GetState() == NetHTTP::STATE_ACTIVE || m_netAudioHTTP.GetState() == NetHTTP::STATE_FORWARD)
+	vector<string> sentences;
+	if (GetApp()->m_tts_split_sentences)
 	{
-		//waiting on data
-		return true;
+		//the first sentence comes back a lot sooner than a whole paragraph would, so we can start talking
+		SplitIntoSentences(textToTranslate, &sentences);
 	}
-	
-	return GetAudioManager()->IsPlaying(m_audioHandle);
-}
-
-bool TextAreaComponent::IsDownloadingAudio()
-{
-	if (m_netAudioHTTP.GetState() == NetHTTP::STATE_ACTIVE || m_netAudioHTTP.GetState() == NetHTTP::STATE_FORWARD)
+	else
 	{
-		//waiting on data
-		return true;
+		sentences.push_back(textToTranslate);
 	}
 
-	return false;
-}
+	vector<string> keys(sentences.size());
+	string audioKey;
+	for (int i = 0; i < (int)sentences.size(); i++)
+	{
+		keys[i] = TTSCache::MakeKey(sentences[i], languageCode, finalVoice, voiceGender, speakingRate, audioEncoding);
+		audioKey += keys[i];
+	}
 
-void TextAreaComponent::RequestTranslationGoogleBasic()
-{
-	string url = "https://translation.googleapis.com";
-	string urlappend = "language/translate/v2?key=" + GetApp()->GetGoogleKey();
+	if (audioKey == m_audioKey && !HasFailedAudioChunk())
+	{
+		//already asked for (AutoPlayManager prefetched it), maybe it's even here already
+		if (bPlay) StartPlayingAudioChunks();
+		return;
+	}
 
-	unsigned int originalFileSize = 0;
+	ResetAudioChunks(); //in case an older request of ours is still going, it would play over this
+	m_audioKey = audioKey;
 
-	string sourceLanguage = m_textArea.language;
-	string destLanguage = GetApp()->m_target_language;
+	vector<string> headers;
+	headers.push_back("Content-Type: application/json; charset=utf-8");
 
-	string textToTranslate;
-	
-	if (IsDialog(true))
-	{
-		textToTranslate = m_textArea.rawText;
-	}
-	else
+	for (int i = 0; i < (int)sentences.size(); i++)
 	{
-		for (int i = 0; i < m_textArea.m_lines.size(); i++)
+		std::shared_ptr<TTSChunk> pChunk = std::make_shared<TTSChunk>();
+		pChunk->m_key = keys[i];
+		m_audioChunks.push_back(pChunk);
+
+		SpeechBufferPtr pAudio = GetApp()->GetSpeechPlayer()->GetBuffer();
+		if (GetApp()->GetTTSCache()->Get(pChunk->m_key, pAudio.get()))
 		{
-			textToTranslate += m_textArea.m_lines[i].m_text + "\n";
+			pChunk->m_pAudio = pAudio;
+			pChunk->m_readyTime = std::chrono::steady_clock::now();
+			continue; //heard it before, no need to ask again
 		}
-	}
 
-	//create json
-	cJSON *root = cJSON_CreateObject();
-	cJSON_AddItemToObject(root, "q", cJSON_CreateString(textToTranslate.c_str()));
-	//cJSON_AddItemToObject(root, "source", cJSON_CreateString(sourceLanguage.c_str()));
-	cJSON_AddItemToObject(root, "target", cJSON_CreateString(destLanguage.c_str()));
-	cJSON_AddItemToObject(root, "format", cJSON_CreateString("text"));
+		//create json
+		cJSON* root = cJSON_CreateObject();
+		cJSON* pInput = cJSON_AddObjectToObject(root, "input");
+		cJSON_AddItemToObject(pInput, "text", cJSON_CreateString(sentences[i].c_str()));
+		cJSON* pVoice = cJSON_AddObjectToObject(root, "voice");
+
+		cJSON_AddItemToObject(pVoice, "languageCode", cJSON_CreateString(languageCode.c_str()));
+		cJSON_AddItemToObject(pVoice, "name", cJSON_CreateString(finalVoice.c_str()));
+		cJSON_AddItemToObject(pVoice, "ssmlGender", cJSON_CreateString(voiceGender.c_str()));
+
+		cJSON* pAudioConfig = cJSON_AddObjectToObject(root, "audioConfig");
+		cJSON_AddItemToObject(pAudioConfig, "audioEncoding", cJSON_CreateString(audioEncoding.c_str()));
+		cJSON_AddItemToObject(pAudioConfig, "speakingRate", cJSON_CreateNumber(speakingRate));
+
+		char *pPostData = cJSON_Print(root);
+		string postData(pPostData);
+		free(pPostData);
+		cJSON_Delete(root);
 
-	string postData(cJSON_Print(root));
-	 
 #ifdef _DEBUG
-	//LogMsg(postData.c_str());
-	//let's see what we're sending, write it to a txt file so notepad can read the kanji or whatever right
-	FILE* fp = fopen("translation_request.txt", "wb");
-	fwrite(postData.c_str(), postData.length(), 1, fp);
-	fclose(fp);
+		//LogMsg(postData.c_str());
 #endif
 
-	m_netHTTP.Setup(url, 80, urlappend, NetHTTP::END_OF_DATA_SIGNAL_HTTP);
-	m_netHTTP.AddPostData("", (const byte*)postData.c_str(), (int)postData.length());
-	m_netHTTP.Start();
-	m_bWaitingForTranslation = true;
-}
+		//all at once, they each take about as long so the first is usually back first
+		pChunk->m_request.Setup(url);
+		pChunk->m_request.SetCustomHeaders(headers);
+		pChunk->m_request.AddBodyText(postData);
+		pChunk->m_request.SetFinishedCallback(boost::bind(&TextAreaComponent::OnAudioRequestFinished, this, _1, i));
+		pChunk->m_request.Start();
+	}
 
+	if (bPlay) StartPlayingAudioChunks();
+}
 
-// Advanced
-void TextAreaComponent::RequestTranslationGoogleAdvanced()
+bool TextAreaComponent::HasFailedAudioChunk()
 {
-	string url = "https://translation.googleapis.com";
-	string urlappend = "/v3/projects/compact-lacing-260204:translateText";
-	string destLanguage = GetApp()->m_target_language;
-	string textToTranslate;
-
-	if (IsDialog(true))
+	for (int i = 0; i < (int)m_audioChunks.size(); i++)
 	{
-		textToTranslate = m_textArea.rawText;
-	}
-	else
-	{
-		for (int i = 0; i < m_textArea.m_lines.size(); i++)
-		{
-			textToTranslate += m_textArea.m_lines[i].m_text + "\n";
-		}
+		if (m_audioChunks[i]->m_bFailed) return true;
 	}
 
-	// reate json
-	cJSON* contents = cJSON_CreateArray();
-	cJSON_AddItemToArray(contents, cJSON_CreateString(textToTranslate.c_str()));
-	cJSON* root = cJSON_CreateObject();
-	cJSON_AddItemToObject(root, "contents", contents);
-	cJSON_AddItemToObject(root, "sourceLanguageCode", cJSON_CreateString("ja"));
-	cJSON_AddItemToObject(root, "targetLanguageCode", cJSON_CreateString(destLanguage.c_str()));
-	cJSON_AddItemToObject(root, "mimeType", cJSON_CreateString("text/plain"));
+	return false;
+}
 
-	string postData(cJSON_Print(root));
+void TextAreaComponent::ResetAudioChunks()
+{
+	for (int i = 0; i < (int)m_audioChunks.size(); i++)
+	{
+		m_audioChunks[i]->m_request.Reset();
+	}
 
-#ifdef _DEBUG
-	//LogMsg(postData.c_str());
-	//let's see what we're sending, write it to a txt file so notepad can read the kanji or whatever right
-	FILE* fp = fopen("translation_request.txt", "wb");
-	fwrite(postData.c_str(), postData.length(), 1, fp);
-	fclose(fp);
-#endif
+	//whatever already made it to the player can finish, it just shouldn't wait on the rest
+	GetApp()->GetSpeechPlayer()->EndAppending(m_audioHandle);
 
-	m_netHTTP.Setup(url, 80, urlappend, NetHTTP::END_OF_DATA_SIGNAL_HTTP);
-	vector<string> headers;
-	headers.push_back("Content-Type: application/json");
-	headers.push_back("x-goog-user-project: compact-lacing-260204");
-	headers.push_back("Authorization: Bearer " + GetApp()->GetGoogleToken());
-	m_netHTTP.SetCustomHeaders(headers);
-	m_netHTTP.AddPostData("", (const byte*)postData.c_str(), (int)postData.length());
-	m_netHTTP.Start();
-	m_bWaitingForTranslation = true;
+	m_audioChunks.clear();
+	m_audioKey.clear();
+	m_audioChunksQueued = 0;
+	m_bPlayAudioWhenItArrives = false;
 }
 
-void TextAreaComponent::RequestTranslationDeepL()
+void TextAreaComponent::StartPlayingAudioChunks()
 {
-	if (GetApp()->GetDeepLKey().empty())
+	//only one box talks at a time, cut off whoever was
+	if (g_lastAudioHandle != AUDIO_HANDLE_BLANK)
 	{
-		string error = "Can't do deepl translation, API key missing";
-		
-		ShowQuickMessage(error);
-
-		return;
+		GetApp()->GetSpeechPlayer()->Stop(g_lastAudioHandle);
+		g_lastAudioHandle = AUDIO_HANDLE_BLANK;
 	}
 
-	unsigned int originalFileSize = 0;
+	StopSoundIfItWasPlaying();
+	m_audioChunksQueued = 0;
+	m_bPlayAudioWhenItArrives = true;
+	m_audioPlayRequestTime = std::chrono::steady_clock::now();
+	QueueArrivedAudioChunks();
+}
 
-	string sourceLanguage = m_textArea.language;
-	string destLanguage = GetApp()->m_target_language;
+//hands the player whatever is here, in order.  Stops at the first one still downloading so they can't play out of order
+void TextAreaComponent::QueueArrivedAudioChunks()
+{
+	if (!m_bPlayAudioWhenItArrives) return;
 
-	string textToTranslate;
+	SpeechPlayer *pPlayer = GetApp()->GetSpeechPlayer();
 
-	if (IsDialog(true))
+	while (m_audioChunksQueued < (int)m_audioChunks.size())
 	{
-		textToTranslate = m_textArea.rawText;
-	}
-	else
-	{
-	
-		for (int i = 0; i < m_textArea.m_lines.size(); i++)
+		TTSChunk *pChunk = m_audioChunks[m_audioChunksQueued].get();
+
+		if (!pChunk->m_bFailed)
 		{
-			if (i > 0)
+			if (!pChunk->m_pAudio) return; //not here yet
+
+			bool bMoreToCome = m_audioChunksQueued + 1 < (int)m_audioChunks.size();
+
+			if (m_audioHandle == AUDIO_HANDLE_BLANK)
 			{
-				textToTranslate += "\n";
+				g_lastAudioHandle = m_audioHandle = pPlayer->Play(pChunk->m_pAudio, pChunk->m_readyTime, bMoreToCome);
+				if (m_audioHandle == AUDIO_HANDLE_BLANK)
+				{
+					m_bPlayAudioWhenItArrives = false; //audio is off or it's broken, either way no point waiting on more
+					return;
+				}
+
+				float firstMS = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_audioPlayRequestTime).count();
+				LogMsg("TTS: first of %d sentences started %.1f ms after asking", (int)m_audioChunks.size(), firstMS);
+			}
+			else if (!pPlayer->Append(m_audioHandle, pChunk->m_pAudio, bMoreToCome))
+			{
+				m_bPlayAudioWhenItArrives = false; //somebody stopped it
+				return;
 			}
-			textToTranslate += m_textArea.m_lines[i].m_text;
 		}
+
+		m_audioChunksQueued++;
 	}
-	string urlappend = "v2/translate";
 
-#ifdef _DEBUG
-	//LogMsg(textToTranslate.c_str());
-	//let's see what we're sending, write it to a txt file so notepad can read the kanji or whatever right
-	FILE* fp = fopen("translation_request.txt", "wb");
-	fwrite(textToTranslate.c_str(), textToTranslate.length(), 1, fp);
-	fclose(fp);
+	//everything is handed over (the last ones may have failed, so the player might still think more is coming)
+	pPlayer->EndAppending(m_audioHandle);
+	m_bPlayAudioWhenItArrives = false;
+}
 
-#endif
-		
-	m_netHTTP.Setup(GetApp()->m_deepl_api_url, 80, urlappend, NetHTTP::END_OF_DATA_SIGNAL_HTTP);
-	m_netHTTP.AddPostData("auth_key", (const byte*)GetApp()->GetDeepLKey().c_str(), (int)GetApp()->GetDeepLKey().length());
-	m_netHTTP.AddPostData("text", (const byte*)textToTranslate.c_str(), (int)textToTranslate.length());
-	m_netHTTP.AddPostData("target_lang", (const byte*)ToUpperCaseString(destLanguage).c_str(), (int)destLanguage.length());
+bool TextAreaComponent::IsStillPlayingOrPlanningToPlay()
+{
+	if (m_bPlayAudioWhenItArrives && m_audioChunksQueued < (int)m_audioChunks.size())
+	{
+		//waiting on data
+		return true;
+	}
+	
+	return GetApp()->GetSpeechPlayer()->IsPlaying(m_audioHandle);
+}
 
-	m_netHTTP.Start();
-	m_bWaitingForTranslation = true;
+bool TextAreaComponent::IsDownloadingAudio()
+{
+	return GetAudioRequestsInFlight() > 0;
 }
 
-void TextAreaComponent::RequestTranslationGpt()
+int TextAreaComponent::GetAudioRequestsInFlight()
 {
-	string url = "https://api.openai.com";
-	string urlappend = "v1/chat/completions";
-	string textToTranslate;
+	int count = 0;
+	for (int i = 0; i < (int)m_audioChunks.size(); i++)
+	{
+		if (m_audioChunks[i]->m_request.GetState() == CurlRequest::STATE_ACTIVE)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
 
+string TextAreaComponent::GetTextToTranslate()
+{
 	if (IsDialog(true))
 	{
-		textToTranslate = m_textArea.rawText;
+		return m_textArea.rawText;
 	}
-	else
+
+	string text;
+	for (int i = 0; i < m_textArea.GetLineCount(); i++)
 	{
-		for (int i = 0; i < m_textArea.m_lines.size(); i++)
-		{
-			textToTranslate += m_textArea.m_lines[i].m_text + "\n";
-		}
+		text += m_textArea.GetLineText(i) + "\n";
 	}
-
-	//create json
-	textToTranslate = "Translate the following texts to English. Only response with translated texts.\n\n" + textToTranslate;
-	cJSON* userMessage = cJSON_CreateObject();
-	cJSON_AddItemToObject(userMessage, "role", cJSON_CreateString("user"));
-	cJSON_AddItemToObject(userMessage, "content", cJSON_CreateString(textToTranslate.c_str()));
-	cJSON* messages = cJSON_CreateArray();
-	cJSON_AddItemToArray(messages, userMessage);
-	cJSON* root = cJSON_CreateObject();
-	cJSON_AddItemToObject(root, "model", cJSON_CreateString("gpt-4o-mini-2024-07-18"));
-	cJSON_AddItemToObject(root, "n", cJSON_CreateNumber(1));
-	cJSON_AddItemToObject(root, "messages", messages);
-	cJSON_AddItemToObject(root, "temperature", cJSON_CreateNumber(1));
-	cJSON_AddItemToObject(root, "max_tokens", cJSON_CreateNumber(256));
-	cJSON_AddItemToObject(root, "top_p", cJSON_CreateNumber(1));
-	cJSON_AddItemToObject(root, "frequency_penalty", cJSON_CreateNumber(0));
-	cJSON_AddItemToObject(root, "presence_penalty", cJSON_CreateNumber(0));
-	cJSON* response_format = cJSON_CreateObject();
-	cJSON_AddItemToObject(response_format, "type", cJSON_CreateString("text"));
-	cJSON_AddItemToObject(root, "response_format", response_format);
-	char* postData = cJSON_Print(root);
-
-	m_netHTTP.Setup(url, 80, urlappend, NetHTTP::END_OF_DATA_SIGNAL_HTTP);
-	vector<string> headers;
-	headers.push_back("Content-Type: application/json; charset=utf-8");
-	headers.push_back("Authorization: Bearer " + GetApp()->GetGptKey());
-	headers.push_back("Accept: application/json, text/plain");
-	m_netHTTP.SetCustomHeaders(headers);
-	m_netHTTP.AddPostData("", (const byte*)postData, (int)strlen(postData));
-	m_netHTTP.Start();
-	m_bWaitingForTranslation = true;
+	return text;
 }
 
 void TextAreaComponent::RequestTranslation()
@@ -441,22 +502,20 @@ void TextAreaComponent::RequestTranslation()
 		return;
 	}
 
-	if (GetApp()->GetTranslationEngine() == TRANSLATION_ENGINE_GOOGLE)
-	{
-		RequestTranslationGoogleBasic();
-	}
-	else if (GetApp()->GetTranslationEngine() == TRANSLATION_ENGINE_DEEPL)
-	{
-		RequestTranslationDeepL();
-	}
-	else if(GetApp()->GetTranslationEngine() == TRANSLATION_ENGINE_GPT)
-	{
-		RequestTranslationGpt();
-	}
-	else if (GetApp()->GetTranslationEngine() == TRANSLATION_ENGINE_GOOGLE_ADVANCED)
+	m_translationCacheKey = TranslationCache::MakeKey(GetApp()->GetTranslationEngine(), m_textArea.language, GetApp()->m_target_language,
+		GetTextToTranslate());
+
+	string cachedTranslation;
+	if (GetApp()->GetTranslationCache()->Get(m_translationCacheKey, &cachedTranslation))
 	{
-		RequestTranslationGoogleAdvanced();
+		//seen this exact text before, no need to wait on the network, it shows up this frame
+		OnTranslationReceived(cachedTranslation, false);
+		return;
 	}
+
+	//gets sent along with every other text area from this scan in one request
+	m_bWaitingForTranslation = true;
+	GetApp()->GetGameLogicComponent()->GetTranslationBatcher()->Add(this, GetTextToTranslate());
 }
 
 glColorBytes TextAreaComponent::GetTextColor(bool bIsDialog)
@@ -497,7 +556,7 @@ void TextAreaComponent::OnSelected(VariantList* pVList) //0=vec2 point of click,
 	if (pEntClicked->GetName() == "SrcSpeakerIcon")
 	{
 
-		if (GetAudioManager()->IsPlaying(m_audioHandle))
+		if (GetApp()->GetSpeechPlayer()->IsPlaying(m_audioHandle))
 		{
 			StopSoundIfItWasPlaying();
 			return;
@@ -518,27 +577,19 @@ void TextAreaComponent::OnSelected(VariantList* pVList) //0=vec2 point of click,
 	//GetEntityRoot()->PrintTreeAsText(); //useful for debugging
 }
 
-void TextAreaComponent::Init(TextArea textArea)
+void TextAreaComponent::Init(const TextArea &textArea)
 {
 	m_textArea = textArea;
 	//assert(m_textArea.m_rect.left >= 0);
 
 	SetSize2DEntity(GetParent(), textArea.m_rect.get_size_vec2());
 	SetPos2DEntity(GetParent(), m_textArea.m_rect.get_top_left());
-	if (m_textArea.language != GetApp()->m_target_language)
-	{
-		RequestTranslation();
-	}
-	else
-	{
-		//no need to translation, languages are the same
-		m_bWaitingForTranslation = false;
-	}
 
 	float extraPaddingForHighlightBottom = 7;
 	float extraPaddingForHighlightRight = 7;
 
 	m_textAreaRect = textArea.m_rect;
+	m_hintingWhenBuilt = (int)GetApp()->GetGlobalTextHinting();
 
 	/*
 	unsigned int color = MAKE_RGBA(0, 0, 0, 200);
@@ -549,6 +600,17 @@ void TextAreaComponent::Init(TextArea textArea)
 	*/
 	BuildSourceLanguageSurface();
 
+	//done after m_textAreaRect is set, a translation cache hit renders right away
+	if (m_textArea.language != GetApp()->m_target_language)
+	{
+		RequestTranslation();
+	}
+	else
+	{
+		//no need to translation, languages are the same
+		m_bWaitingForTranslation = false;
+	}
+
 	if (m_textArea.m_bIsDialog && GetApp()->GetVar("check_autoplay_audio")->GetUINT32() != 0)
 	{
 		GetApp()->GetAutoPlayManager()->OnAddDialog(this);
@@ -592,15 +654,95 @@ void TextAreaComponent::BuildSourceLanguageSurface()
 
 	//rebuild version with line feeds as we're just displaying this as close as to the original as possible, no translation here as this is the source
 	string versionWithLineFeeds;
-	for (int i = 0; i < m_textArea.m_lines.size(); i++)
+	for (int i = 0; i < m_textArea.GetLineCount(); i++)
+	{
+		versionWithLineFeeds += m_textArea.GetLineText(i) + "\n";
+	}
+
+	TextRasterJobPtr pJob(new TextRasterJob);
+	pJob->m_pFont = GetApp()->GetFreeTypeManager(m_textArea.language)->GetFont();
+	utf8::utf8to16(versionWithLineFeeds.begin(), versionWithLineFeeds.end(), back_inserter(pJob->m_text));
+	pJob->m_surfaceSize = tempRect.get_size_vec2();
+	pJob->m_pixelHeight = height;
+	pJob->m_fgColor = GetTextColor(IsDialog(true));
+	pJob->m_bUseActualWidthForSpacing = m_textArea.language == "ja";
+	pJob->m_lineStarts = offsets;
+	pJob->m_bUseLineStarts = true;
+	pJob->m_wordWrapX = wordWrapX;
+	RasterizeAsync(RASTER_TARGET_SOURCE, pJob);
+}
+
+void TextAreaComponent::RasterizeAsync(eRasterTarget target, TextRasterJobPtr pJob)
+{
+	//if an older version of this surface is still being rendered, we don't want it anymore
+	m_rasterTokens[target].Cancel();
+	m_rasterTokens[target] = CancelToken();
+	CancelToken token = m_rasterTokens[target];
+
+	if (target == RASTER_TARGET_DEST)
+	{
+		m_bDestRasterPending = true;
+	}
+
+	//the worker only touches the job, we only get touched back on the main thread, and only if we still want it
+	GetApp()->GetWorkerPool()->AddJob([this, target, pJob, token]()
+	{
+		if (token.IsCanceled()) return;
+		RunRasterJob(pJob.get());
+
+		GetApp()->GetWorkerPool()->PostToMainThread([this, target, pJob, token]()
+		{
+			if (token.IsCanceled()) return;
+			OnRasterFinished(target, pJob);
+		});
+	});
+}
+
+void TextAreaComponent::RunRasterJob(TextRasterJob *pJob)
+{
+	if (pJob->m_bFitToBoundsFirst)
+	{
+		deque<wstring> wlines;
+		wstring wtext(pJob->m_text.begin(), pJob->m_text.end());
+		CL_Vec2f wrappedSize;
+
+		pJob->m_pFont->FitTextToBounds(pJob->m_fitBounds, wtext, &wlines, pJob->m_pixelHeight, pJob->m_pixelHeight, wrappedSize,
+			pJob->m_bUseActualWidthForSpacing);
+
+		//move deque into a single wide string
+		pJob->m_text.clear();
+		for (int i = 0; i < wlines.size(); i++)
+		{
+			pJob->m_text.insert(pJob->m_text.end(), wlines[i].begin(), wlines[i].end());
+			pJob->m_text.push_back('\n');
+		}
+	}
+
+	pJob->m_bOk = pJob->m_pFont->TextToSoftSurface(&pJob->m_result, pJob->m_surfaceSize, pJob->m_text, pJob->m_pixelHeight,
+		glColorBytes(0, 0, 0, 0), pJob->m_fgColor, pJob->m_bUseActualWidthForSpacing, pJob->m_bUseLineStarts ? &pJob->m_lineStarts : NULL,
+		pJob->m_wordWrapX, true);
+
+	if (pJob->m_bOk)
+	{
+		pJob->m_result.FlipY();
+	}
+}
+
+void TextAreaComponent::OnRasterFinished(eRasterTarget target, TextRasterJobPtr pJob)
+{
+	Surface **ppSurf = target == RASTER_TARGET_SOURCE ? &m_pSourceLanguageSurf : &m_pDestLanguageSurf;
+
+	if (target == RASTER_TARGET_DEST)
 	{
-		versionWithLineFeeds += m_textArea.m_lines[i].m_text + "\n";
+		m_bDestRasterPending = false;
 	}
 
-	m_pSourceLanguageSurf = GetApp()->GetFreeTypeManager(m_textArea.language)->GetFont()->TextToSurface(tempRect.get_size_vec2(), versionWithLineFeeds,
-		height, glColorBytes(0, 0, 0, 0), GetTextColor(IsDialog(true)), m_textArea.language == "ja", &offsets,
-		wordWrapX);
+	SAFE_DELETE(*ppSurf);
+	if (!pJob->m_bOk) return;
 
+	//the only part that has to happen on the main thread
+	*ppSurf = new Surface();
+	(*ppSurf)->InitFromSoftSurface(&pJob->m_result, true, 0);
 }
 
 void TextAreaComponent::OnAdd(Entity *pEnt)
@@ -623,6 +765,8 @@ extern void TurnOffRenderDisplay(VariantList* pVList);
 
 void TextAreaComponent::OnTouchStart(VariantList *pVList)
 {
+	if (m_bParked) return;
+
 	// Hack: Turn off overlay on click
 	GetMessageManager()->CallStaticFunction(TurnOffRenderDisplay, 200, NULL);
 	return;
@@ -650,7 +794,7 @@ void TextAreaComponent::OnTouchStart(VariantList *pVList)
 			}
 		}
 
-		if (GetAudioManager()->IsPlaying(m_audioHandle))
+		if (GetApp()->GetSpeechPlayer()->IsPlaying(m_audioHandle))
 		{
 			StopSoundIfItWasPlaying();
 			return;
@@ -689,33 +833,28 @@ void TextAreaComponent::OnTouchStart(VariantList *pVList)
 	{
 		//LogMsg("Clicked %s", PrintVector2(pTouch->GetPos()).c_str());
 
-		//scroll through our letters?
-		for (int l = 0; l < m_textArea.m_lines.size(); l++)
+		//which of our letters was it?  The scan's document has them indexed
+		int l, i;
+		if (m_textArea.HitTestWord(pTouch->GetPos(), &l, &i))
 		{
-			for (int i = 0; i < m_textArea.m_lines[l].m_words.size(); i++)
-			{
-				if (m_textArea.m_lines[l].m_words[i].m_rect.contains(pTouch->GetPos()))
-				{
-					//m_textArea.m_lines[l].m_words[i].m_word.c_str()
-					//LogMsg("Clicked something at %s", PrintVector2(pTouch->GetPos()).c_str());
-
-					vector<unsigned short> utf16line;
+			//m_textArea.GetWordText(l, i).c_str()
+			//LogMsg("Clicked something at %s", PrintVector2(pTouch->GetPos()).c_str());
 
-					string url = GetApp()->m_kanji_lookup_website + m_textArea.m_lines[l].m_words[i].m_word;
+			vector<unsigned short> utf16line;
 
-					utf8::utf8to16(url.begin(), url.end(), back_inserter(utf16line));
+			string url = GetApp()->m_kanji_lookup_website + m_textArea.GetWordText(l, i);
 
-					utf16line.push_back(0);
+			utf8::utf8to16(url.begin(), url.end(), back_inserter(utf16line));
 
-					if (GetApp()->m_oldHWND != 0)
-					{
-						GetApp()->m_forceHWND = GetApp()->m_oldHWND;
-					}
-					LaunchURLW((uint16*)& utf16line[0]);
+			utf16line.push_back(0);
 
-					return;
-				}
+			if (GetApp()->m_oldHWND != 0)
+			{
+				GetApp()->m_forceHWND = GetApp()->m_oldHWND;
 			}
+			LaunchURLW((uint16*)& utf16line[0]);
+
+			return;
 		}
 	}
 
@@ -723,6 +862,8 @@ void TextAreaComponent::OnTouchStart(VariantList *pVList)
 
 void TextAreaComponent::OnTargetLanguageChanged()
 {
+	m_rasterTokens[RASTER_TARGET_DEST].Cancel();
+	m_bDestRasterPending = false;
 	SAFE_DELETE(m_pDestLanguageSurf);
 	SAFE_DELETE(m_pSourceLanguageSurf);
 	BuildSourceLanguageSurface();
@@ -731,9 +872,65 @@ void TextAreaComponent::OnTargetLanguageChanged()
 
 void TextAreaComponent::OnKillAllText()
 {
+	if (GetApp()->GetGameLogicComponent()->ParkTextBox(this)) return; //the next scan might want us again
+
 	GetParent()->SetTaggedForDeletion();
 }
 
+void TextAreaComponent::Park()
+{
+	if (m_bParked) return;
+
+	m_bParked = true;
+	ResetAudioChunks(); //nobody wants to hear text that isn't showing
+	m_bAudioPrefetchStarted = false; //so it gets prefetched again if it's unparked
+}
+
+const float C_TEXT_REUSE_SIZE_TOLERANCE = 2.0f; //OCR boxes of the same text wobble by a pixel or so between scans
+
+bool TextAreaComponent::CanReuseFor(const TextArea &textArea)
+{
+	if (m_textArea.text != textArea.text || m_textArea.rawText != textArea.rawText) return false;
+	if (m_textArea.language != textArea.language || m_textArea.m_bIsDialog != textArea.m_bIsDialog) return false;
+	if (m_textArea.GetLineCount() != textArea.GetLineCount()) return false;
+
+	//our surfaces were sized and laid out for our rect, if it's grown or shrunk they'd be wrong
+	if (fabs(m_textArea.m_rect.get_width() - textArea.m_rect.get_width()) > C_TEXT_REUSE_SIZE_TOLERANCE) return false;
+	if (fabs(m_textArea.m_rect.get_height() - textArea.m_rect.get_height()) > C_TEXT_REUSE_SIZE_TOLERANCE) return false;
+
+	return m_hintingWhenBuilt == (int)GetApp()->GetGlobalTextHinting();
+}
+
+void TextAreaComponent::Unpark(const TextArea &textArea)
+{
+	m_bParked = false;
+
+	//same text and size, so the surfaces are still good, only where they get drawn changes
+	m_textArea = textArea;
+	m_textAreaRect = textArea.m_rect;
+	SetSize2DEntity(GetParent(), textArea.m_rect.get_size_vec2());
+	SetPos2DEntity(GetParent(), textArea.m_rect.get_top_left());
+
+	if (m_textArea.language != GetApp()->m_target_language)
+	{
+		//if the translation engine changed while we were parked, what we have isn't what a new one would show
+		string key = TranslationCache::MakeKey(GetApp()->GetTranslationEngine(), m_textArea.language, GetApp()->m_target_language,
+			GetTextToTranslate());
+
+		if (key != m_translationCacheKey)
+		{
+			m_rasterTokens[RASTER_TARGET_DEST].Cancel();
+			m_bDestRasterPending = false;
+			RequestTranslation();
+		}
+	}
+
+	if (m_textArea.m_bIsDialog && GetApp()->GetVar("check_autoplay_audio")->GetUINT32() != 0)
+	{
+		GetApp()->GetAutoPlayManager()->OnAddDialog(this);
+	}
+}
+
 bool TextAreaComponent::TranslatingToAsianLanguage()
 {
 	return IsAsianLanguage(GetApp()->m_target_language);
@@ -747,24 +944,16 @@ bool TextAreaComponent::TranslatingFromAsianLanguage()
 void TextAreaComponent::FitText(float *pHeightInOut, float widthMod, int trueCharCount)
 {
 
-	float bestHeightSoFar = *pHeightInOut;
-	float charWidth = 9999999.0f;
-	float verticalLinesAvailable = 0;
-	float canvasWidthTotalCharRoom = 0;
-
-	bool bFirstTime = true;
+	//The room we have for chars is (width / (height*widthMod)) * (rect height / height), so instead of shrinking by 1% and
+	//checking again until it fits, we can just solve for the biggest height directly
+	if (trueCharCount <= 0 || widthMod <= 0) return;
 	
-	while (trueCharCount > canvasWidthTotalCharRoom)
+	float area = m_textArea.m_rect.get_width() * m_textArea.m_rect.get_height();
+	float maxHeight = sqrt(area / (widthMod * float(trueCharCount)));
+
+	if (*pHeightInOut > maxHeight)
 	{
-		if (!bFirstTime)
-		{
-			//too big. Make it smaller and try again
-			*pHeightInOut -= ((*pHeightInOut) / 100.0f);
-		}
-		bFirstTime = false;
-		charWidth = *pHeightInOut * widthMod;
-		verticalLinesAvailable = m_textArea.m_rect.get_height() / *pHeightInOut;
-		canvasWidthTotalCharRoom = (m_textArea.m_rect.get_width() / charWidth)*verticalLinesAvailable;
+		*pHeightInOut = maxHeight;
 	}
 
 }
@@ -785,9 +974,9 @@ void TextAreaComponent::TweakForSending(const string &text, CL_Rectf &rect, floa
 	}
 	else
 	{
-		for (int i = 0; i < m_textArea.m_lines.size(); i++)
+		for (int i = 0; i < m_textArea.GetLineCount(); i++)
 		{
-			lines.push_back(m_textArea.m_lines[i].m_text);
+			lines.push_back(m_textArea.GetLineText(i));
 		}
 	}
 
@@ -849,14 +1038,9 @@ void TextAreaComponent::TweakForSending(const string &text, CL_Rectf &rect, floa
 		if (IsDialog(isTranslated))
 		{
 			//word wrap mode
+			//this is just a guess from the char count, RenderAsDialog does the real fitting starting from it
 			FitText(&height, widthMod, trueCharCount);
 
-			rtRectf textRect;
-			GetApp()->GetFreeTypeManager(GetApp()->m_target_language)->GetFont()->MeasureText(&textRect, (WCHAR*) &m_textArea.wideText.at(0), (int)m_textArea.wideText.size(), height, true);
-#ifdef _DEBUG
-			LogMsg("Rect: %s", PrintRect(textRect).c_str());
-#endif
-
 			//     Mr. Tanaka
 
 			if (height > m_textArea.m_averageTextHeight)
@@ -880,7 +1064,7 @@ void TextAreaComponent::TweakForSending(const string &text, CL_Rectf &rect, floa
 		height *= GetApp()->GetFreeTypeManager(m_textArea.language)->m_preTranslatedHeightMod;
 	}
 
-	//let's add extra space for no reason
+	//room for text that runs past the box.  It's only a limit, the surface is shrunk to what actually got drawn
 	float expanderRatio = 1.5f;
 	rect.set_height(rect.get_height()*expanderRatio);
 	rect.set_width(rect.get_width()*expanderRatio);
@@ -890,9 +1074,9 @@ vector<CL_Vec2f> TextAreaComponent::ComputeLocalLineOffsets()
 {
 	vector<CL_Vec2f> offsets;
 
-	for (int i = 0; i < m_textArea.m_lineStarts.size(); i++)
+	for (int i = 0; i < m_textArea.GetLineCount(); i++)
 	{
-		offsets.push_back(m_textArea.m_lineStarts[i]- m_textAreaRect.get_top_left());
+		offsets.push_back(m_textArea.GetLineStart(i)- m_textAreaRect.get_top_left());
 		//offsets.at(i).y += 20;
 		
 		assert(offsets.at(i).x >= 0 && offsets.at(i).y >= 0 &&  "Huh?  These shouldn't be negative");
@@ -917,38 +1101,17 @@ void TextAreaComponent::RenderLineByLine()
 	}
 	SAFE_DELETE(m_pDestLanguageSurf);
 
-	m_pDestLanguageSurf = GetApp()->GetFreeTypeManager(GetApp()->m_target_language)->GetFont()->TextToSurface(tempRect.get_size_vec2(), m_translatedString,
-		height, glColorBytes(0, 0, 0, 0), GetTextColor(IsDialog(true)), GetApp()->m_target_language == "ja",
-		&offsets, wordWrapX);
-}
-
-void TextAreaComponent::FitAndWordWrapToRect(const CL_Rectf &tempRect,  wstring &wtext, deque<wstring> &wlinesOut,
-	CL_Vec2f &wrappedSizeOut, bool bUseActualWidthForSpacing, float &pixelHeightOut)
-{
-	if (pixelHeightOut == 0)
-		pixelHeightOut = m_textArea.m_averageTextHeight;
-
-	wrappedSizeOut = CL_Vec2f(2000000, 200000);
-	bool bFirstTime = true;
-
-	while (wrappedSizeOut.y > (tempRect.get_height()*1.0f))
-	{
-
-		if (pixelHeightOut < 0)
-		{
-			assert(!"The heck");
-		}
-		if (!bFirstTime)
-		{
-			//make it smaller, it still doesn't fit
-			pixelHeightOut = pixelHeightOut *= 0.95f;
-		}
-		bFirstTime = false;
-		wlinesOut.clear();
-		//LogMsg("Trying size %.2f", pixelHeightOut);
-		GetApp()->GetFreeTypeManager(GetApp()->m_target_language)->GetFont()->MeasureTextAndAddByLinesIntoDeque(tempRect.get_size_vec2(), wtext, &wlinesOut,
-			pixelHeightOut, wrappedSizeOut, GetApp()->m_target_language == "ja");
-	}
+	TextRasterJobPtr pJob(new TextRasterJob);
+	pJob->m_pFont = GetApp()->GetFreeTypeManager(GetApp()->m_target_language)->GetFont();
+	utf8::utf8to16(m_translatedString.begin(), m_translatedString.end(), back_inserter(pJob->m_text));
+	pJob->m_surfaceSize = tempRect.get_size_vec2();
+	pJob->m_pixelHeight = height;
+	pJob->m_fgColor = GetTextColor(IsDialog(true));
+	pJob->m_bUseActualWidthForSpacing = GetApp()->m_target_language == "ja";
+	pJob->m_lineStarts = offsets;
+	pJob->m_bUseLineStarts = true;
+	pJob->m_wordWrapX = wordWrapX;
+	RasterizeAsync(RASTER_TARGET_DEST, pJob);
 }
 
 void TextAreaComponent::RenderAsDialog(float defaultFontHeightOrZeroForAuto)
@@ -956,195 +1119,38 @@ void TextAreaComponent::RenderAsDialog(float defaultFontHeightOrZeroForAuto)
 	//build version with word wrapping
  	CL_Rectf tempRect = m_textAreaRect;
 
-	vector<unsigned short> utf16line;
-	utf8::utf8to16(m_translatedString.begin(), m_translatedString.end(), back_inserter(utf16line));
+	TextRasterJobPtr pJob(new TextRasterJob);
+	pJob->m_pFont = GetApp()->GetFreeTypeManager(GetApp()->m_target_language)->GetFont();
+	utf8::utf8to16(m_translatedString.begin(), m_translatedString.end(), back_inserter(pJob->m_text));
 
-	deque<wstring> wlines;
-	wstring wtext(utf16line.begin(), utf16line.end());
-	
-	CL_Vec2f wrappedSize;
-	float pixelHeight = defaultFontHeightOrZeroForAuto;
+	//the word wrapping and size fitting happens on the worker too, it's the slow part
+	pJob->m_bFitToBoundsFirst = true;
+	pJob->m_fitBounds = tempRect.get_size_vec2();
+	pJob->m_pixelHeight = defaultFontHeightOrZeroForAuto;
+	if (pJob->m_pixelHeight == 0)
+		pJob->m_pixelHeight = m_textArea.m_averageTextHeight;
 
-	FitAndWordWrapToRect(tempRect, wtext, wlines, wrappedSize, GetApp()->m_target_language == "ja", pixelHeight);
-
-	//LogMsg("Final output size: %s", PrintVector2(wrappedSize));
-
-	//move deque into a single wide string
-	wstring finalSingle;
-	for (int i = 0; i < wlines.size(); i++)
-	{
-		finalSingle += wlines[i]+L"\n";
-	}
+	//twice the box is as far as it can spill over, the surface itself ends up only as big as the wrapped text
 	tempRect.bottom += tempRect.get_height();
 	tempRect.right += tempRect.get_width();
 
-	vector<uint16> vec (finalSingle.begin(), finalSingle.end());
-
-	//Render it at that size
-	m_pDestLanguageSurf = GetApp()->GetFreeTypeManager(GetApp()->m_target_language)->GetFont()->TextToSurface(tempRect.get_size_vec2(), vec,
-		pixelHeight, glColorBytes(0, 0, 0, 0), GetTextColor(IsDialog(true)), GetApp()->m_target_language == "ja",
-		NULL, 0);
-
-}
-
-bool TextAreaComponent::ReadTranslationFromJSONGoogleBasic(char *pData)
-{
-	m_bWaitingForTranslation = false;
-	cJSON *root = cJSON_Parse(pData);
-	cJSON *error = cJSON_GetObjectItemCaseSensitive(root, "error");
-	cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
-	cJSON *translations = cJSON_GetObjectItemCaseSensitive(data, "translations");
-	cJSON *translation;
-
-	if (error != NULL)
-	{
-		ShowQuickMessage("Error parsing json reply from google.  View error.txt!");
-		FILE *fp = fopen("error.txt", "wb");
-		fwrite(m_netHTTP.GetDownloadedData(), m_netHTTP.GetDownloadedBytes(), 1, fp);
-		fclose(fp);
-		return false;
-	}
-
-	cJSON_ArrayForEach(translation, translations)
-	{
-		cJSON *translatedText = cJSON_GetObjectItemCaseSensitive(translation, "translatedText");
-		if (m_pTextBox)
-			SetTextEntity(m_pTextBox, translatedText->valuestring);
-
-		SAFE_DELETE(m_pDestLanguageSurf);
-
-		float desiredHeight = m_textAreaRect.get_height();
-		m_translatedString = translatedText->valuestring;
-		float height = 0;
-		CL_Rectf tempRect = m_textAreaRect;
-		TweakForSending(m_translatedString, tempRect, height, true);
-
-		if (IsDialog(true))
-		{
-			RenderAsDialog(height);
-		}
-		else
-		{
-			RenderLineByLine();
-		}
-	}
-	
-	return true;
-}
-
-bool TextAreaComponent::ReadTranslationFromJSONGoogleAdvanced(char* pData)
-{
-	m_bWaitingForTranslation = false;
-	cJSON* root = cJSON_Parse(pData);
-	cJSON* translations = cJSON_GetObjectItemCaseSensitive(root, "translations");
-	cJSON* translation;
-
-	cJSON_ArrayForEach(translation, translations)
-	{
-		cJSON* translatedText = cJSON_GetObjectItemCaseSensitive(translation, "translatedText");
-		if (m_pTextBox)
-			SetTextEntity(m_pTextBox, translatedText->valuestring);
-
-		SAFE_DELETE(m_pDestLanguageSurf);
-
-		float desiredHeight = m_textAreaRect.get_height();
-		m_translatedString = translatedText->valuestring;
-		float height = 0;
-		CL_Rectf tempRect = m_textAreaRect;
-		TweakForSending(m_translatedString, tempRect, height, true);
-
-		if (IsDialog(true))
-		{
-			RenderAsDialog(height);
-		}
-		else
-		{
-			RenderLineByLine();
-		}
-	}
-
-	return true;
+	//Render it at most that size
+	pJob->m_surfaceSize = tempRect.get_size_vec2();
+	pJob->m_fgColor = GetTextColor(IsDialog(true));
+	pJob->m_bUseActualWidthForSpacing = GetApp()->m_target_language == "ja";
+	RasterizeAsync(RASTER_TARGET_DEST, pJob);
 }
 
-bool TextAreaComponent::ReadTranslationFromJSONDeepl(char* pData)
+void TextAreaComponent::OnTranslationReceived(const string &translation, bool bAddToCache)
 {
 	m_bWaitingForTranslation = false;
-	cJSON* root = cJSON_Parse(pData);
-	cJSON* error = cJSON_GetObjectItemCaseSensitive(root, "message");
-	//cJSON* data = cJSON_GetObjectItemCaseSensitive(root, "data");
-	cJSON* translations = cJSON_GetObjectItemCaseSensitive(root, "translations");
-	cJSON* translation;
-
-	if (m_netHTTP.GetDownloadedBytes() < 5)
-	{
-		ShowQuickMessage("Deepl sent a blank reply?  Probably bad API key!");
-		return false;
-	}
-
-	if (error != NULL)
-	{
-		ShowQuickMessage(string("Deepl says: ")+error->valuestring+" View error.txt!");
-		FILE* fp = fopen("error.txt", "wb");
-		fwrite(m_netHTTP.GetDownloadedData(), m_netHTTP.GetDownloadedBytes(), 1, fp);
-		fclose(fp);
-		return false;
-	}
-
-
-	cJSON_ArrayForEach(translation, translations)
-	{
-		cJSON* translatedText = cJSON_GetObjectItemCaseSensitive(translation, "text");
-		if (m_pTextBox)
-			SetTextEntity(m_pTextBox, translatedText->valuestring);
-
-		SAFE_DELETE(m_pDestLanguageSurf);
-
-		float desiredHeight = m_textAreaRect.get_height();
-		m_translatedString = translatedText->valuestring;
-
-	
-		float height = 0;
-		CL_Rectf tempRect = m_textAreaRect;
-		TweakForSending(m_translatedString , tempRect, height, true);
-
-		if (IsDialog(true))
-		{
-			RenderAsDialog(height);
-		}
-		else
-		{
-			RenderLineByLine();
-		}
-	}
-
-	return true;
-}
-
-
-bool TextAreaComponent::ReadTranslationFromJSONGpt(char* pData)
-{
-	m_bWaitingForTranslation = false;
-	cJSON* root = cJSON_Parse(pData);
-
-	// jsonResponse["choices"][0]["message"]["content"].get<std::string>();
-	cJSON* translation = cJSON_GetObjectItemCaseSensitive(root, "choices");
-	translation = cJSON_GetArrayItem(translation, 0)->child->next; // "message"
-	translation = translation->child->next; // "content"
-
-	if (m_netHTTP.GetDownloadedBytes() < 5)
-	{
-		ShowQuickMessage("Deepl sent a blank reply?  Probably bad API key!");
-		return false;
-	}
 
 	if (m_pTextBox)
-		SetTextEntity(m_pTextBox, translation->valuestring);
+		SetTextEntity(m_pTextBox, translation);
 
 	SAFE_DELETE(m_pDestLanguageSurf);
 
-	float desiredHeight = m_textAreaRect.get_height();
-	m_translatedString = translation->valuestring;
-
+	m_translatedString = translation;
 
 	float height = 0;
 	CL_Rectf tempRect = m_textAreaRect;
@@ -1159,17 +1165,45 @@ bool TextAreaComponent::ReadTranslationFromJSONGpt(char* pData)
 		RenderLineByLine();
 	}
 
-	return true;
+	//an empty one means the reply was missing it, don't make that stick around forever
+	if (bAddToCache && !m_translationCacheKey.empty() && !m_translatedString.empty())
+	{
+		GetApp()->GetTranslationCache()->Put(m_translationCacheKey, m_translatedString);
+	}
+}
+
+void TextAreaComponent::OnTranslationFailed()
+{
+	//the batcher already complained about it, just stop waiting so the status stuff doesn't hang
+	m_bWaitingForTranslation = false;
 }
 
 
-bool TextAreaComponent::ReadAudioFromJSON(char* pData)
+bool TextAreaComponent::ReadAudioFromJSON(CurlRequest *pRequest, vector<byte> *pAudioOut)
 {
-	cJSON* root = cJSON_Parse(pData);
-	cJSON* error = cJSON_GetObjectItemCaseSensitive(root, "error");
-	cJSON* data = cJSON_GetObjectItemCaseSensitive(root, "audioContent");
+	char *pData = (char*)pRequest->GetDownloadedData();
+
+	//pull the base64 out where it sits in the response, no tree and no copy of it
+	JsonPullReader r(pData);
+	const char *pAudio = NULL;
+	int audioLength = 0;
 
-	if (error != NULL)
+	if (r.BeginObject())
+	{
+		while (r.NextKey())
+		{
+			if (r.IsKey("audioContent"))
+			{
+				r.ReadRawString(&pAudio, &audioLength);
+			}
+			else
+			{
+				r.SkipValue();
+			}
+		}
+	}
+
+	if (!pAudio || audioLength == 0)
 	{
 		TextScanner s;
 		s.AppendFromMemoryAddress(pData);
@@ -1190,31 +1224,33 @@ bool TextAreaComponent::ReadAudioFromJSON(char* pData)
 
 		ShowQuickMessage(msg);
 		FILE* fp = fopen("error.txt", "wb");
-		fwrite(m_netAudioHTTP.GetDownloadedData(), m_netAudioHTTP.GetDownloadedBytes(), 1, fp);
+		fwrite(pRequest->GetDownloadedData(), pRequest->GetDownloadedBytes(), 1, fp);
 		fclose(fp);
 		return false;
 	}
 
-	if (!m_fileNameToRemove.empty())
-	{
-		RemoveFile(m_fileNameToRemove);
-	}
+	pAudioOut->resize(Base64DecodedMaxSize(audioLength));
 
-	string m_translatedString = data->valuestring;
-	string audioFile = base64_decode(m_translatedString.c_str(), m_translatedString.length());
-	
-	string fName = "temp_audio_" + toString(g_counter++)+".mp3";
-	FILE* fp = fopen(fName.c_str(), "wb");
-	fwrite(audioFile.c_str(), audioFile.length(), 1, fp);
-	fclose(fp);
+	Base64Decoder decoder;
+	pAudioOut->resize(decoder.Decode(pAudio, audioLength, &(*pAudioOut)[0]));
+	return !pAudioOut->empty();
+}
 
-	StopSoundIfItWasPlaying();
+void TextAreaComponent::PrefetchAudio()
+{
+	if (m_bAudioPrefetchStarted || IsDownloadingAudio()) return; //don't cut off something that was asked for to be played
+	m_bAudioPrefetchStarted = true;
+	RequestAudio(true, false, false);
+}
 
-	g_lastAudioHandle = m_audioHandle = GetAudioManager()->Play(fName, false, false, true, false);
-	m_fileNameToRemove = fName;
-	RemoveFile(fName);
+void TextAreaComponent::CancelAudioPrefetch()
+{
+	if (!m_bPlayAudioWhenItArrives)
+	{
+		ResetAudioChunks();
+	}
 
-	return true;
+	m_bAudioPrefetchStarted = false;
 }
 
 void TextAreaComponent::OnUpdate(VariantList *pVList)
@@ -1226,85 +1262,49 @@ void TextAreaComponent::OnUpdate(VariantList *pVList)
 		//m_smartCurl.Start();
 		bDidFirstTime = true;
 	}
+}
+
+void TextAreaComponent::OnAudioRequestFinished(CurlRequest *pRequest, int chunk)
+{
+	if (chunk >= (int)m_audioChunks.size() || pRequest != &m_audioChunks[chunk]->m_request) return; //shouldn't happen, Reset() stops the callback
 
-	m_netHTTP.Update();
+	TTSChunk *pChunk = m_audioChunks[chunk].get();
 
-	if (m_netHTTP.GetError() != NetHTTP::ERROR_NONE)
+	if (pRequest->GetError() != CurlRequest::ERROR_NONE)
 	{
 		//Big error, show message
-		LogMsg("NetHTTP error: %d", m_netHTTP.GetError());
+		LogMsg("TTS request error: %s", pRequest->GetErrorString().c_str());
+		pChunk->m_bFailed = true;
+		QueueArrivedAudioChunks(); //the ones after it can still play
+		return;
 	}
 
-	if (m_netHTTP.GetState() == NetHTTP::STATE_FINISHED)
-	{
 #ifdef _DEBUG
-		FILE *fp = fopen("language.json", "wb");
-		fwrite(m_netHTTP.GetDownloadedData(), m_netHTTP.GetDownloadedBytes(), 1, fp);
-		fclose(fp);
+	FILE* fp = fopen("audio.json", "wb");
+	fwrite(pRequest->GetDownloadedData(), pRequest->GetDownloadedBytes(), 1, fp);
+	fclose(fp);
 #endif
 
-		if (GetApp()->GetTranslationEngine() == TRANSLATION_ENGINE_GOOGLE)
-		{
-			if (!ReadTranslationFromJSONGoogleBasic((char*)m_netHTTP.GetDownloadedData()))
-			{
-				LogMsg("Error parsing json translation reply from google");
-			}
-		}
-		else if (GetApp()->GetTranslationEngine() == TRANSLATION_ENGINE_DEEPL)
-		{
-			if (!ReadTranslationFromJSONDeepl((char*)m_netHTTP.GetDownloadedData()))
-			{
-				LogMsg("Error parsing json translation reply from deepl");
-			}
-		}
-		else if (GetApp()->GetTranslationEngine() == TRANSLATION_ENGINE_GPT)
-		{
-			if (!ReadTranslationFromJSONGpt((char*)m_netHTTP.GetDownloadedData()))
-			{
-				LogMsg("Error parsing json translation reply from deepl");
-			}
-		}
-		else if (GetApp()->GetTranslationEngine() == TRANSLATION_ENGINE_GOOGLE_ADVANCED)
-		{
-			if (!ReadTranslationFromJSONGoogleAdvanced((char*)m_netHTTP.GetDownloadedData()))
-			{
-				LogMsg("Error parsing json translation reply from deepl");
-			}
-		}
-		
-		m_netHTTP.Reset(true);
-	}
-
-	m_netAudioHTTP.Update();
-
-	if (m_netAudioHTTP.GetError() != NetHTTP::ERROR_NONE)
+	SpeechBufferPtr pAudio = GetApp()->GetSpeechPlayer()->GetBuffer();
+	if (!ReadAudioFromJSON(pRequest, pAudio.get()))
 	{
-		//Big error, show message
-		LogMsg("m_netAudioHTTP error: %d", m_netAudioHTTP.GetError());
+		LogMsg("Error parsing json audio from google");
+		pChunk->m_bFailed = true;
+		QueueArrivedAudioChunks();
+		return;
 	}
 
-	if (m_netAudioHTTP.GetState() == NetHTTP::STATE_FINISHED)
-	{
-#ifdef _DEBUG
-		FILE* fp = fopen("audio.json", "wb");
-		fwrite(m_netAudioHTTP.GetDownloadedData(), m_netAudioHTTP.GetDownloadedBytes(), 1, fp);
-		fclose(fp);
-#endif
-
-		if (!ReadAudioFromJSON((char*)m_netAudioHTTP.GetDownloadedData()))
-		{
-			LogMsg("Error parsing json audio from google");
-		}
-		
-		m_netAudioHTTP.Reset(true);
-	}
+	pChunk->m_pAudio = pAudio;
+	pChunk->m_readyTime = std::chrono::steady_clock::now();
+	GetApp()->GetTTSCache()->Put(pChunk->m_key, &(*pAudio)[0], pAudio->size());
+	QueueArrivedAudioChunks();
 }
 
-void TextAreaComponent::DrawWordRectsForLine(LineInfo line)
+void TextAreaComponent::DrawWordRectsForLine(int line)
 {
-	for (int i = 0; i < line.m_words.size(); i++)
+	for (int i = 0; i < m_textArea.GetWordCount(line); i++)
 	{
-		DrawRect(line.m_words[i].m_rect, MAKE_RGBA(0, 0, 255, 200));
+		DrawRect(m_textArea.GetWordRect(line, i), MAKE_RGBA(0, 0, 255, 200));
 	}
 }
 
@@ -1312,7 +1312,7 @@ void TextAreaComponent::DrawHighlightRectIfAudioIsPlaying()
 {
 	uint32 lineColor = MAKE_RGBA(255, 0, 0, 255);
 
-	if (m_audioHandle != AUDIO_HANDLE_BLANK && GetAudioManager()->IsPlaying(m_audioHandle))
+	if (m_audioHandle != AUDIO_HANDLE_BLANK && GetApp()->GetSpeechPlayer()->IsPlaying(m_audioHandle))
 	{
 		DrawRect(m_textAreaRect, lineColor, 3.0f);
 	}
@@ -1326,6 +1326,8 @@ void TextAreaComponent::OnRender(VariantList *pVList)
 	GetApp()->GetFont(FONT_LARGE)->DrawScaled(20, GetScreenSizeYf() - 100, "" + toString(GetApp()->m_energy), 2.0f, MAKE_RGBA(255, 255, 255, 255));
 	*/
 
+	if (m_bParked) return;
+
 	if (GetApp()->IsHidingOverlays())
 	{
 		DrawHighlightRectIfAudioIsPlaying();
@@ -1337,9 +1339,9 @@ void TextAreaComponent::OnRender(VariantList *pVList)
 
 		if (GetBaseApp()->GetTouch(0)->IsDown())
 		{
-			for (int i = 0; i < m_textArea.m_lines.size(); i++)
+			for (int i = 0; i < m_textArea.GetLineCount(); i++)
 			{
-				DrawWordRectsForLine(m_textArea.m_lines[i]);
+				DrawWordRectsForLine(i);
 			}
 		}
 
@@ -1411,9 +1413,9 @@ void TextAreaComponent::OnRender(VariantList *pVList)
 	
 	//if (GetBaseApp()->GetTouch(0)->IsDown())
 	//{
-	//	for (int i = 0; i < m_textArea.m_lines.size(); i++)
+	//	for (int i = 0; i < m_textArea.GetLineCount(); i++)
 	//	{
-	//		DrawWordRectsForLine(m_textArea.m_lines[i]);
+	//		DrawWordRectsForLine(i);
 	//	}
 	//}
 	
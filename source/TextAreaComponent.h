@@ -12,8 +12,48 @@
 #pragma once
 
 #include "Entity/Component.h"
-#include "Network/NetHTTP.h"
+#include "CurlRequest.h"
 #include "GameLogicComponent.h"
+#include "WorkerPool.h"
+#include "SpeechPlayer.h"
+#include <chrono>
+
+class FreeTypeManager;
+
+//What a worker needs to rasterize one of our text surfaces without touching the component, which could be gone by then
+class TextRasterJob
+{
+public:
+
+	FreeTypeManager *m_pFont = NULL;
+	vector<unsigned short> m_text;
+	CL_Vec2f m_surfaceSize; //the most it can be, the surface is cut down to the text that was drawn
+	float m_pixelHeight = 0;
+	glColorBytes m_fgColor;
+	bool m_bUseActualWidthForSpacing = false;
+	vector<CL_Vec2f> m_lineStarts;
+	bool m_bUseLineStarts = false;
+	float m_wordWrapX = 0;
+	bool m_bFitToBoundsFirst = false; //dialog mode, word wrap and shrink it to fit m_fitBounds before rendering
+	CL_Vec2f m_fitBounds;
+
+	SoftSurface m_result; //already flipped, ready to upload
+	bool m_bOk = false;
+};
+
+typedef std::shared_ptr<TextRasterJob> TextRasterJobPtr;
+
+//One sentence of text to speech.  Long lines are split up so the first sentence can be playing while the rest download
+class TTSChunk
+{
+public:
+
+	string m_key; //TTSCache key
+	CurlRequest m_request;
+	SpeechBufferPtr m_pAudio; //decoded mp3, NULL until it's here
+	std::chrono::steady_clock::time_point m_readyTime;
+	bool m_bFailed = false;
+};
 
 
 class TextAreaComponent : public EntityComponent
@@ -23,35 +63,46 @@ public:
 	TextAreaComponent();
 	virtual ~TextAreaComponent();
 
-	void Init(TextArea textArea);
+	void Init(const TextArea &textArea);
 	virtual void OnAdd(Entity* pEnt);
 
 	void OnTouchStart(VariantList *pVList);
-	bool ReadTranslationFromJSONGoogleBasic(char *pData);
-	bool ReadTranslationFromJSONGoogleAdvanced(char* pData);
-	bool ReadTranslationFromJSONDeepl(char* pData);
-	bool ReadTranslationFromJSONGpt(char* pData);
+	void OnTranslationReceived(const string &translation, bool bAddToCache);
+	void OnTranslationFailed();
 	void OnUpdate(VariantList* pVList);
-	void DrawWordRectsForLine(LineInfo line);
+	void OnAudioRequestFinished(CurlRequest *pRequest, int chunk);
+	void DrawWordRectsForLine(int line);
 	void DrawHighlightRectIfAudioIsPlaying();
 	void OnRender(VariantList *pVList);
 	TextArea m_textArea;
-	void RequestAudio(bool bUseSrcLanguage, bool bShowMessage);
+	void RequestAudio(bool bUseSrcLanguage, bool bShowMessage, bool bPlay = true); //!bPlay just gets it ready
+	void PrefetchAudio(); //what AutoPlayManager will ask to hear, so it's here by then.  Only asks once
+	bool IsAudioPrefetchStarted() { return m_bAudioPrefetchStarted; }
+	void CancelAudioPrefetch();
 	bool IsStillPlayingOrPlanningToPlay();
 	bool IsDownloadingAudio();
+	int GetAudioRequestsInFlight(); //one per sentence still downloading
 	bool FinishedWithTranslation();
 	bool IsDialog(bool bIsTranslating);
 	string GetTranslatedText() { return m_translatedString; }
 
+	//Instead of being deleted when the text is cleared we can be parked (hidden, still holding our translation and surfaces)
+	//so the next scan can take us back if it finds the same text.  See GameLogicComponent::ReconcileTextAreas()
+	void Park();
+	bool IsParked() { return m_bParked; }
+	bool CanReuseFor(const TextArea &textArea); //same text, same size, built with the same settings
+	void Unpark(const TextArea &textArea); //shows us again, moved to wherever textArea is
+
 protected:
 
 	void StopSoundIfItWasPlaying();
-	bool ReadAudioFromJSON(char* pData);
-	void RequestTranslationGoogleBasic();
-	void RequestTranslationGoogleAdvanced();
-	void RequestTranslationDeepL();
-	void RequestTranslationGpt();
+	bool ReadAudioFromJSON(CurlRequest *pRequest, vector<byte> *pAudioOut);
+	bool HasFailedAudioChunk();
+	void ResetAudioChunks(); //cancels downloads, lets anything already playing finish
+	void StartPlayingAudioChunks();
+	void QueueArrivedAudioChunks();
 	void RequestTranslation();
+	string GetTextToTranslate();
 	glColorBytes GetTextColor(bool bIsDialog);
 	void OnSelected(VariantList* pVList);
 	void OnTargetLanguageChanged();
@@ -63,26 +114,44 @@ protected:
 	void TweakForSending(const string &text, CL_Rectf &rect, float &height, bool isTranslated);
 	vector<CL_Vec2f> ComputeLocalLineOffsets();
 	void RenderLineByLine();
-	void FitAndWordWrapToRect(const CL_Rectf &tempRect, wstring &wtext, deque<wstring> &wlinesOut, CL_Vec2f &wrappedSizeOut,
-		bool bUseActualWidthForSpacing, float &pixelHeightOut);
 	void RenderAsDialog(float defaultFontHeightOrZeroForAuto);
 	void BuildSourceLanguageSurface();
 
+	enum eRasterTarget
+	{
+		RASTER_TARGET_SOURCE,
+		RASTER_TARGET_DEST,
+
+		RASTER_TARGET_COUNT
+	};
+
+	void RasterizeAsync(eRasterTarget target, TextRasterJobPtr pJob);
+	void OnRasterFinished(eRasterTarget target, TextRasterJobPtr pJob);
+	static void RunRasterJob(TextRasterJob *pJob);
+
 	Entity *m_pTextBox = NULL;
-	NetHTTP m_netHTTP;
-	NetHTTP m_netAudioHTTP; //so we can request translations and audio at the same time
 	Surface *m_pSourceLanguageSurf = NULL;
 	Surface *m_pDestLanguageSurf = NULL;
 	string m_translatedString;
+	string m_translationCacheKey; //engine, languages and text of the last translation we asked for
 	CL_Vec2f *m_pPos2d;
 	CL_Vec2f *m_pSize2d;
 	CL_Rectf m_textAreaRect;
 	bool m_bWaitingForTranslation = true;
+	bool m_bDestRasterPending = false; //translation is in, but a worker is still rendering it
+	CancelToken m_rasterTokens[RASTER_TARGET_COUNT];
 	Entity* m_pSpeakerIconSrc;
 	Entity* m_pSpeakerIconDest;
 	AudioHandle m_audioHandle = AUDIO_HANDLE_BLANK;
-	string m_fileNameToRemove;
 	string m_lastTTSLanguageTarget;
+	vector<std::shared_ptr<TTSChunk> > m_audioChunks; //one per sentence, in the order they're read
+	string m_audioKey; //TTSCache keys of all of them, to know if it's the same audio we already asked for
+	int m_audioChunksQueued = 0; //how many have been given to the SpeechPlayer (or skipped because they failed)
+	std::chrono::steady_clock::time_point m_audioPlayRequestTime;
+	bool m_bPlayAudioWhenItArrives = false; //false if the chunks are only a prefetch
+	bool m_bAudioPrefetchStarted = false;
+	bool m_bParked = false;
+	int m_hintingWhenBuilt = -1; //eTextHinting, dialog or not changes how the translation is drawn
 };
 
 #endif // TextAreaComponent_h__
\ No newline at end of file
@@ -0,0 +1,539 @@
+#include "PlatformPrecomp.h"
+#include "TranslationBatcher.h"
+#include "TextAreaComponent.h"
+#include "App.h"
+#include "util/cJSON.h"
+#include "util/MiscUtils.h"
+
+TranslationBatcher::TranslationBatcher()
+{
+}
+
+TranslationBatcher::~TranslationBatcher()
+{
+	for (auto itor = m_batches.begin(); itor != m_batches.end(); itor++)
+	{
+		delete *itor;
+	}
+	m_batches.clear();
+}
+
+void TranslationBatcher::Add(TextAreaComponent *pComp, const string &textToTranslate)
+{
+	OnTextBoxRemoved(pComp); //if it was already waiting on something (target language changed?) forget that
+
+	PendingText p;
+	p.m_pComp = pComp;
+	p.m_text = textToTranslate;
+	p.m_bSendAlone = false;
+	m_pending.push_back(p);
+}
+
+void TranslationBatcher::OnTextBoxRemoved(TextAreaComponent *pComp)
+{
+	for (int i = 0; i < (int)m_pending.size(); i++)
+	{
+		if (m_pending[i].m_pComp == pComp)
+		{
+			m_pending.erase(m_pending.begin() + i);
+			i--;
+		}
+	}
+
+	//in flight ones just get ignored when they come back
+	for (auto itor = m_batches.begin(); itor != m_batches.end(); itor++)
+	{
+		for (int i = 0; i < (int)(*itor)->m_items.size(); i++)
+		{
+			if ((*itor)->m_items[i].m_pComp == pComp)
+			{
+				(*itor)->m_items[i].m_pComp = NULL;
+			}
+		}
+	}
+}
+
+//What each provider allows per request, with some slack.  Google v2 is 128 q's, v3 is 30k code points, DeepL is 50 texts
+//and 128 KB, for GPT we just keep it small enough that the reply fits comfortably
+void TranslationBatcher::GetEngineLimits(int engine, int *pMaxSegmentsOut, size_t *pMaxBytesOut)
+{
+	switch (engine)
+	{
+	case TRANSLATION_ENGINE_GOOGLE:
+		*pMaxSegmentsOut = 128;
+		*pMaxBytesOut = 30000;
+		break;
+	case TRANSLATION_ENGINE_GOOGLE_ADVANCED:
+		*pMaxSegmentsOut = 1024;
+		*pMaxBytesOut = 30000;
+		break;
+	case TRANSLATION_ENGINE_DEEPL:
+		*pMaxSegmentsOut = 50;
+		*pMaxBytesOut = 100 * 1024;
+		break;
+	default:
+		*pMaxSegmentsOut = 40;
+		*pMaxBytesOut = 8000;
+		break;
+	}
+}
+
+void TranslationBatcher::Flush()
+{
+	if (m_pending.empty()) return;
+
+	int engine = GetApp()->GetTranslationEngine();
+
+	if (engine == TRANSLATION_ENGINE_DEEPL && GetApp()->GetDeepLKey().empty())
+	{
+		ShowQuickMessage("Can't do deepl translation, API key missing");
+		for (int i = 0; i < (int)m_pending.size(); i++)
+		{
+			m_pending[i].m_pComp->OnTranslationFailed();
+		}
+		m_pending.clear();
+		return;
+	}
+
+	int maxSegments;
+	size_t maxBytes;
+	GetEngineLimits(engine, &maxSegments, &maxBytes);
+
+	Batch *pBatch = NULL;
+	size_t batchBytes = 0;
+	int batchCount = 0;
+
+	for (int i = 0; i < (int)m_pending.size(); i++)
+	{
+		PendingText &p = m_pending[i];
+
+		if (pBatch && (p.m_bSendAlone || (int)pBatch->m_items.size() >= maxSegments || batchBytes + p.m_text.length() > maxBytes))
+		{
+			StartBatch(pBatch);
+			pBatch = NULL;
+		}
+
+		if (!pBatch)
+		{
+			pBatch = new Batch;
+			pBatch->m_engine = engine;
+			pBatch->m_targetLanguage = GetApp()->m_target_language;
+			batchBytes = 0;
+			batchCount++;
+		}
+
+		pBatch->m_items.push_back(p);
+		batchBytes += p.m_text.length();
+
+		if (p.m_bSendAlone)
+		{
+			StartBatch(pBatch);
+			pBatch = NULL;
+		}
+	}
+
+	if (pBatch)
+	{
+		StartBatch(pBatch);
+	}
+
+	LogMsg("Sending %d texts to translate in %d request(s)", (int)m_pending.size(), batchCount);
+	m_pending.clear();
+}
+
+void TranslationBatcher::StartBatch(Batch *pBatch)
+{
+	switch (pBatch->m_engine)
+	{
+	case TRANSLATION_ENGINE_GOOGLE: StartGoogleBasic(pBatch); break;
+	case TRANSLATION_ENGINE_GOOGLE_ADVANCED: StartGoogleAdvanced(pBatch); break;
+	case TRANSLATION_ENGINE_DEEPL: StartDeepL(pBatch); break;
+	case TRANSLATION_ENGINE_GPT: StartGpt(pBatch); break;
+	default:
+		FailBatch(pBatch);
+		delete pBatch;
+		return;
+	}
+
+	pBatch->m_request.SetFinishedCallback(boost::bind(&TranslationBatcher::OnBatchFinished, this, pBatch, _1));
+	if (!pBatch->m_request.Start())
+	{
+		//the callback won't come, so nothing would ever tell the text boxes to stop waiting
+		LogMsg("Couldn't start the translation request: %s", pBatch->m_request.GetErrorString().c_str());
+		FailBatch(pBatch);
+		delete pBatch;
+		return;
+	}
+	m_batches.push_back(pBatch);
+}
+
+static void WriteRequestForDebugging(const string &postData)
+{
+#ifdef _DEBUG
+	//let's see what we're sending, write it to a txt file so notepad can read the kanji or whatever right
+	FILE* fp = fopen("translation_request.txt", "wb");
+	fwrite(postData.c_str(), postData.length(), 1, fp);
+	fclose(fp);
+#endif
+}
+
+static string PrintAndDeleteJSON(cJSON *root)
+{
+	char *pText = cJSON_Print(root);
+	string s(pText);
+	free(pText);
+	cJSON_Delete(root);
+	return s;
+}
+
+void TranslationBatcher::StartGoogleBasic(Batch *pBatch)
+{
+	string url = "https://translation.googleapis.com/language/translate/v2?key=" + GetApp()->GetGoogleKey();
+
+	//v2 takes as many q's as we want (well, up to 128), the translations come back in the same order
+	cJSON *q = cJSON_CreateArray();
+	for (int i = 0; i < (int)pBatch->m_items.size(); i++)
+	{
+		cJSON_AddItemToArray(q, cJSON_CreateString(pBatch->m_items[i].m_text.c_str()));
+	}
+
+	cJSON *root = cJSON_CreateObject();
+	cJSON_AddItemToObject(root, "q", q);
+	cJSON_AddItemToObject(root, "target", cJSON_CreateString(pBatch->m_targetLanguage.c_str()));
+	cJSON_AddItemToObject(root, "format", cJSON_CreateString("text"));
+	string postData = PrintAndDeleteJSON(root);
+	WriteRequestForDebugging(postData);
+
+	pBatch->m_request.Setup(url);
+	vector<string> headers;
+	headers.push_back("Content-Type: application/json; charset=utf-8");
+	pBatch->m_request.SetCustomHeaders(headers);
+	pBatch->m_request.AddBodyText(postData);
+}
+
+void TranslationBatcher::StartGoogleAdvanced(Batch *pBatch)
+{
+	string url = "https://translation.googleapis.com/v3/projects/compact-lacing-260204:translateText";
+
+	cJSON *contents = cJSON_CreateArray();
+	for (int i = 0; i < (int)pBatch->m_items.size(); i++)
+	{
+		cJSON_AddItemToArray(contents, cJSON_CreateString(pBatch->m_items[i].m_text.c_str()));
+	}
+
+	cJSON *root = cJSON_CreateObject();
+	cJSON_AddItemToObject(root, "contents", contents);
+	cJSON_AddItemToObject(root, "sourceLanguageCode", cJSON_CreateString("ja"));
+	cJSON_AddItemToObject(root, "targetLanguageCode", cJSON_CreateString(pBatch->m_targetLanguage.c_str()));
+	cJSON_AddItemToObject(root, "mimeType", cJSON_CreateString("text/plain"));
+	string postData = PrintAndDeleteJSON(root);
+	WriteRequestForDebugging(postData);
+
+	pBatch->m_request.Setup(url);
+	vector<string> headers;
+	headers.push_back("Content-Type: application/json");
+	headers.push_back("x-goog-user-project: compact-lacing-260204");
+	headers.push_back("Authorization: Bearer " + GetApp()->GetGoogleToken());
+	pBatch->m_request.SetCustomHeaders(headers);
+	pBatch->m_request.AddBodyText(postData);
+}
+
+void TranslationBatcher::StartDeepL(Batch *pBatch)
+{
+	//DeepL wants the text param repeated, one per thing to translate
+	pBatch->m_request.Setup(GetApp()->m_deepl_api_url + "/v2/translate");
+	pBatch->m_request.AddFormField("auth_key", GetApp()->GetDeepLKey());
+	for (int i = 0; i < (int)pBatch->m_items.size(); i++)
+	{
+		pBatch->m_request.AddFormField("text", pBatch->m_items[i].m_text);
+	}
+	pBatch->m_request.AddFormField("target_lang", ToUpperCaseString(pBatch->m_targetLanguage));
+}
+
+void TranslationBatcher::StartGpt(Batch *pBatch)
+{
+	string url = "https://api.openai.com/v1/chat/completions";
+	string prompt;
+	size_t textBytes = 0;
+
+	if (pBatch->m_items.size() == 1)
+	{
+		prompt = "Translate the following texts to English. Only response with translated texts.\n\n" + pBatch->m_items[0].m_text;
+		textBytes = pBatch->m_items[0].m_text.length();
+	}
+	else
+	{
+		//a JSON array in, a JSON array out, so we can tell which translation goes with which text area
+		cJSON *texts = cJSON_CreateArray();
+		for (int i = 0; i < (int)pBatch->m_items.size(); i++)
+		{
+			cJSON_AddItemToArray(texts, cJSON_CreateString(pBatch->m_items[i].m_text.c_str()));
+			textBytes += pBatch->m_items[i].m_text.length();
+		}
+		prompt = "Translate each string in the following JSON array to English. Only respond with a JSON array of the translated strings, "
+			"in the same order and with the same number of elements.\n\n" + PrintAndDeleteJSON(texts);
+	}
+
+	cJSON* userMessage = cJSON_CreateObject();
+	cJSON_AddItemToObject(userMessage, "role", cJSON_CreateString("user"));
+	cJSON_AddItemToObject(userMessage, "content", cJSON_CreateString(prompt.c_str()));
+	cJSON* messages = cJSON_CreateArray();
+	cJSON_AddItemToArray(messages, userMessage);
+	cJSON* root = cJSON_CreateObject();
+	cJSON_AddItemToObject(root, "model", cJSON_CreateString("gpt-4o-mini-2024-07-18"));
+	cJSON_AddItemToObject(root, "n", cJSON_CreateNumber(1));
+	cJSON_AddItemToObject(root, "messages", messages);
+	cJSON_AddItemToObject(root, "temperature", cJSON_CreateNumber(1));
+	//256 was plenty for one text area, give a batch room for all of them
+	cJSON_AddItemToObject(root, "max_tokens", cJSON_CreateNumber((double)rt_min(4096, 256 + (int)textBytes)));
+	cJSON_AddItemToObject(root, "top_p", cJSON_CreateNumber(1));
+	cJSON_AddItemToObject(root, "frequency_penalty", cJSON_CreateNumber(0));
+	cJSON_AddItemToObject(root, "presence_penalty", cJSON_CreateNumber(0));
+	cJSON* response_format = cJSON_CreateObject();
+	cJSON_AddItemToObject(response_format, "type", cJSON_CreateString("text"));
+	cJSON_AddItemToObject(root, "response_format", response_format);
+	string postData = PrintAndDeleteJSON(root);
+	WriteRequestForDebugging(postData);
+
+	pBatch->m_request.Setup(url);
+	vector<string> headers;
+	headers.push_back("Content-Type: application/json; charset=utf-8");
+	headers.push_back("Authorization: Bearer " + GetApp()->GetGptKey());
+	headers.push_back("Accept: application/json, text/plain");
+	pBatch->m_request.SetCustomHeaders(headers);
+	pBatch->m_request.AddBodyText(postData);
+}
+
+void TranslationBatcher::WriteErrorFile(Batch *pBatch)
+{
+	FILE *fp = fopen("error.txt", "wb");
+	if (!fp) return;
+	fwrite(pBatch->m_request.GetDownloadedData(), pBatch->m_request.GetDownloadedBytes(), 1, fp);
+	fclose(fp);
+}
+
+bool TranslationBatcher::ReadGoogleBasic(Batch *pBatch, vector<string> *pTranslationsOut)
+{
+	char *pData = (char*)pBatch->m_request.GetDownloadedData();
+	cJSON *root = cJSON_Parse(pData);
+	cJSON *error = cJSON_GetObjectItemCaseSensitive(root, "error");
+	cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
+	cJSON *translations = cJSON_GetObjectItemCaseSensitive(data, "translations");
+	cJSON *translation;
+
+	if (error != NULL || root == NULL)
+	{
+		ShowQuickMessage("Error parsing json reply from google.  View error.txt!");
+		WriteErrorFile(pBatch);
+		cJSON_Delete(root);
+		return false;
+	}
+
+	cJSON_ArrayForEach(translation, translations)
+	{
+		cJSON *translatedText = cJSON_GetObjectItemCaseSensitive(translation, "translatedText");
+		pTranslationsOut->push_back(cJSON_IsString(translatedText) ? translatedText->valuestring : "");
+	}
+
+	cJSON_Delete(root);
+	return true;
+}
+
+bool TranslationBatcher::ReadGoogleAdvanced(Batch *pBatch, vector<string> *pTranslationsOut)
+{
+	char *pData = (char*)pBatch->m_request.GetDownloadedData();
+	cJSON *root = cJSON_Parse(pData);
+	cJSON *translations = cJSON_GetObjectItemCaseSensitive(root, "translations");
+	cJSON *translation;
+
+	if (translations == NULL)
+	{
+		ShowQuickMessage("Error parsing json reply from google.  View error.txt!");
+		WriteErrorFile(pBatch);
+		cJSON_Delete(root);
+		return false;
+	}
+
+	cJSON_ArrayForEach(translation, translations)
+	{
+		cJSON *translatedText = cJSON_GetObjectItemCaseSensitive(translation, "translatedText");
+		pTranslationsOut->push_back(cJSON_IsString(translatedText) ? translatedText->valuestring : "");
+	}
+
+	cJSON_Delete(root);
+	return true;
+}
+
+bool TranslationBatcher::ReadDeepL(Batch *pBatch, vector<string> *pTranslationsOut)
+{
+	char *pData = (char*)pBatch->m_request.GetDownloadedData();
+	if (pBatch->m_request.GetDownloadedBytes() < 5)
+	{
+		ShowQuickMessage("Deepl sent a blank reply?  Probably bad API key!");
+		return false;
+	}
+
+	cJSON *root = cJSON_Parse(pData);
+	cJSON *error = cJSON_GetObjectItemCaseSensitive(root, "message");
+	cJSON *translations = cJSON_GetObjectItemCaseSensitive(root, "translations");
+	cJSON *translation;
+
+	if (error != NULL)
+	{
+		ShowQuickMessage(string("Deepl says: ") + (cJSON_IsString(error) ? error->valuestring : "") + " View error.txt!");
+		WriteErrorFile(pBatch);
+		cJSON_Delete(root);
+		return false;
+	}
+
+	cJSON_ArrayForEach(translation, translations)
+	{
+		cJSON *translatedText = cJSON_GetObjectItemCaseSensitive(translation, "text");
+		pTranslationsOut->push_back(cJSON_IsString(translatedText) ? translatedText->valuestring : "");
+	}
+
+	cJSON_Delete(root);
+	return true;
+}
+
+bool TranslationBatcher::ReadGpt(Batch *pBatch, vector<string> *pTranslationsOut)
+{
+	char *pData = (char*)pBatch->m_request.GetDownloadedData();
+	if (pBatch->m_request.GetDownloadedBytes() < 5)
+	{
+		ShowQuickMessage("GPT sent a blank reply?  Probably bad API key!");
+		return false;
+	}
+
+	// jsonResponse["choices"][0]["message"]["content"].get<std::string>();
+	cJSON *root = cJSON_Parse(pData);
+	cJSON *choice = cJSON_GetArrayItem(cJSON_GetObjectItemCaseSensitive(root, "choices"), 0);
+	cJSON *message = cJSON_GetObjectItemCaseSensitive(choice, "message");
+	cJSON *content = cJSON_GetObjectItemCaseSensitive(message, "content");
+
+	if (!cJSON_IsString(content))
+	{
+		ShowQuickMessage("Error parsing json reply from GPT.  View error.txt!");
+		WriteErrorFile(pBatch);
+		cJSON_Delete(root);
+		return false;
+	}
+
+	string reply = content->valuestring;
+	cJSON_Delete(root);
+
+	if (pBatch->m_items.size() == 1)
+	{
+		pTranslationsOut->push_back(reply);
+		return true;
+	}
+
+	//it sometimes wraps it in ```json or whatever, just grab the array
+	size_t start = reply.find('[');
+	size_t end = reply.rfind(']');
+	if (start == string::npos || end == string::npos || end < start) return true; //count won't match, caller deals with it
+
+	cJSON *array = cJSON_Parse(reply.substr(start, end - start + 1).c_str());
+	cJSON *item;
+	cJSON_ArrayForEach(item, array)
+	{
+		pTranslationsOut->push_back(cJSON_IsString(item) ? item->valuestring : "");
+	}
+	cJSON_Delete(array);
+	return true;
+}
+
+void TranslationBatcher::FailBatch(Batch *pBatch)
+{
+	for (int i = 0; i < (int)pBatch->m_items.size(); i++)
+	{
+		if (pBatch->m_items[i].m_pComp)
+		{
+			pBatch->m_items[i].m_pComp->OnTranslationFailed();
+		}
+	}
+}
+
+void TranslationBatcher::OnBatchFinished(Batch *pBatch, CurlRequest *pRequest)
+{
+	pBatch->m_bDone = true; //Update() deletes it, we're inside its callback right now
+
+	if (pRequest->GetError() != CurlRequest::ERROR_NONE)
+	{
+		//Big error, show message
+		LogMsg("Translation request error: %s", pRequest->GetErrorString().c_str());
+		FailBatch(pBatch);
+		return;
+	}
+
+#ifdef _DEBUG
+	FILE *fp = fopen("language.json", "wb");
+	fwrite(pRequest->GetDownloadedData(), pRequest->GetDownloadedBytes(), 1, fp);
+	fclose(fp);
+#endif
+
+	vector<string> translations;
+	bool bOk = false;
+
+	switch (pBatch->m_engine)
+	{
+	case TRANSLATION_ENGINE_GOOGLE: bOk = ReadGoogleBasic(pBatch, &translations); break;
+	case TRANSLATION_ENGINE_GOOGLE_ADVANCED: bOk = ReadGoogleAdvanced(pBatch, &translations); break;
+	case TRANSLATION_ENGINE_DEEPL: bOk = ReadDeepL(pBatch, &translations); break;
+	case TRANSLATION_ENGINE_GPT: bOk = ReadGpt(pBatch, &translations); break;
+	}
+
+	if (!bOk)
+	{
+		LogMsg("Error parsing json translation reply");
+		FailBatch(pBatch);
+		return;
+	}
+
+	if (translations.size() != pBatch->m_items.size())
+	{
+		LogMsg("Asked for %d translations but got %d back", (int)pBatch->m_items.size(), (int)translations.size());
+
+		if (pBatch->m_engine == TRANSLATION_ENGINE_GPT && pBatch->m_items.size() > 1)
+		{
+			//GPT merged or split something, ask again one at a time so nothing gets mismatched
+			for (int i = 0; i < (int)pBatch->m_items.size(); i++)
+			{
+				if (!pBatch->m_items[i].m_pComp) continue;
+				m_pending.push_back(pBatch->m_items[i]);
+				m_pending.back().m_bSendAlone = true;
+			}
+			return;
+		}
+
+		FailBatch(pBatch);
+		return;
+	}
+
+	for (int i = 0; i < (int)pBatch->m_items.size(); i++)
+	{
+		if (pBatch->m_items[i].m_pComp)
+		{
+			pBatch->m_items[i].m_pComp->OnTranslationReceived(translations[i], true);
+		}
+	}
+}
+
+void TranslationBatcher::Update()
+{
+	Flush();
+
+	//the requests finish through callbacks from the HTTPReactor, we just clean up after them here
+	for (auto itor = m_batches.begin(); itor != m_batches.end();)
+	{
+		if ((*itor)->m_bDone)
+		{
+			delete *itor;
+			itor = m_batches.erase(itor);
+		}
+		else
+		{
+			itor++;
+		}
+	}
+}
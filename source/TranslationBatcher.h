@@ -0,0 +1,63 @@
+//Each TextAreaComponent used to send its own translation request, so a busy screen with 25 text blocks meant 25 TLS
+//handshakes and round trips.  Now they Add() their text here and everything pending gets sent as one request to the
+//active engine (split up if it goes over what the provider allows per request), the results are handed back to each
+//component in order.
+
+#ifndef TranslationBatcher_h__
+#define TranslationBatcher_h__
+
+#include "CurlRequest.h"
+
+class TextAreaComponent;
+
+class TranslationBatcher
+{
+public:
+	TranslationBatcher();
+	virtual ~TranslationBatcher();
+
+	void Add(TextAreaComponent *pComp, const string &textToTranslate);
+	void Flush(); //sends whatever is pending right now, Update() does this too
+	void Update();
+	void OnTextBoxRemoved(TextAreaComponent *pComp); //so we don't hand results to a deleted component
+	int GetBatchesInFlight() { return (int)m_batches.size(); }
+
+protected:
+
+	struct PendingText
+	{
+		TextAreaComponent *m_pComp;
+		string m_text;
+		bool m_bSendAlone; //GPT gave us back the wrong number of lines, so this one gets its own request
+	};
+
+	struct Batch
+	{
+		int m_engine; //eTranslationEngine
+		string m_targetLanguage;
+		vector<PendingText> m_items;
+		CurlRequest m_request;
+		bool m_bDone = false;
+	};
+
+	void GetEngineLimits(int engine, int *pMaxSegmentsOut, size_t *pMaxBytesOut);
+	void StartBatch(Batch *pBatch);
+	void StartGoogleBasic(Batch *pBatch);
+	void StartGoogleAdvanced(Batch *pBatch);
+	void StartDeepL(Batch *pBatch);
+	void StartGpt(Batch *pBatch);
+
+	bool ReadGoogleBasic(Batch *pBatch, vector<string> *pTranslationsOut);
+	bool ReadGoogleAdvanced(Batch *pBatch, vector<string> *pTranslationsOut);
+	bool ReadDeepL(Batch *pBatch, vector<string> *pTranslationsOut);
+	bool ReadGpt(Batch *pBatch, vector<string> *pTranslationsOut);
+
+	void OnBatchFinished(Batch *pBatch, CurlRequest *pRequest);
+	void FailBatch(Batch *pBatch);
+	void WriteErrorFile(Batch *pBatch);
+
+	vector<PendingText> m_pending;
+	std::list<Batch*> m_batches;
+};
+
+#endif // TranslationBatcher_h__
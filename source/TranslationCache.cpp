@@ -0,0 +1,128 @@
+#include "PlatformPrecomp.h"
+#include "TranslationCache.h"
+#include "util/MiscUtils.h"
+
+TranslationCache::TranslationCache()
+{
+}
+
+TranslationCache::~TranslationCache()
+{
+	Kill();
+}
+
+bool TranslationCache::Init(string fileName, size_t maxDiskBytes, int maxMemoryEntries)
+{
+	Kill();
+	m_maxMemoryEntries = maxMemoryEntries;
+	return m_diskStore.Open(fileName, maxDiskBytes);
+}
+
+void TranslationCache::Kill()
+{
+	m_diskStore.Close();
+	m_lru.clear();
+	m_memoryIndex.clear();
+}
+
+string TranslationCache::MakeKey(int engine, const string &sourceLanguage, const string &destLanguage, const string &text)
+{
+	string key = toString(engine) + "|" + sourceLanguage + "|" + destLanguage + "|";
+	key.reserve(key.length() + text.length());
+
+	//collapse runs of spaces/tabs, drop \r and any whitespace at the start/end of each line.  UTF8 multibyte chars never
+	//contain these bytes so it's safe to do it bytewise
+	bool bPendingSpace = false;
+	bool bPendingNewLine = false;
+	bool bLineHasText = false;
+	bool bAnyText = false;
+
+	for (size_t i = 0; i < text.length(); i++)
+	{
+		char c = text[i];
+
+		if (c == ' ' || c == '\t' || c == '\r')
+		{
+			if (bLineHasText) bPendingSpace = true;
+			continue;
+		}
+
+		if (c == '\n')
+		{
+			bPendingSpace = false;
+			if (bAnyText) bPendingNewLine = true;
+			bLineHasText = false;
+			continue;
+		}
+
+		if (bPendingNewLine) key += '\n';
+		else if (bPendingSpace) key += ' ';
+		bPendingNewLine = bPendingSpace = false;
+
+		key += c;
+		bLineHasText = bAnyText = true;
+	}
+
+	return key;
+}
+
+void TranslationCache::AddToMemory(const string &key, const string &translation)
+{
+	if (m_maxMemoryEntries <= 0) return;
+
+	auto itor = m_memoryIndex.find(key);
+	if (itor != m_memoryIndex.end())
+	{
+		m_lru.erase(itor->second);
+		m_memoryIndex.erase(itor);
+	}
+
+	m_lru.push_front(std::make_pair(key, translation));
+	m_memoryIndex[key] = m_lru.begin();
+
+	while ((int)m_lru.size() > m_maxMemoryEntries)
+	{
+		m_memoryIndex.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+}
+
+bool TranslationCache::Get(const string &key, string *pTranslationOut)
+{
+	if (!m_diskStore.IsOpen()) return false; //disabled
+	auto itor = m_memoryIndex.find(key);
+	if (itor != m_memoryIndex.end())
+	{
+		m_lru.splice(m_lru.begin(), m_lru, itor->second);
+		*pTranslationOut = itor->second->second;
+		m_hits++;
+		return true;
+	}
+
+	if (m_diskStore.Get(key, pTranslationOut))
+	{
+		AddToMemory(key, *pTranslationOut);
+		m_hits++;
+		m_diskHits++;
+		return true;
+	}
+
+	m_misses++;
+	return false;
+}
+
+void TranslationCache::Put(const string &key, const string &translation)
+{
+	if (!m_diskStore.IsOpen()) return;
+	AddToMemory(key, translation);
+	m_diskStore.Put(key, translation);
+}
+
+void TranslationCache::LogStats()
+{
+	uint32 total = m_hits + m_misses;
+	if (total == 0) return;
+
+	LogMsg("Translation cache: %d hits (%d from disk), %d misses, %.1f%% hit rate.  %d entries on disk (%d KB)", m_hits, m_diskHits, m_misses,
+		100.0f * (float)m_hits / (float)total, (int)m_diskStore.GetEntryCount(), (int)(m_diskStore.GetFileBytes() / 1024));
+}
@@ -0,0 +1,46 @@
+//Games show the same menu labels and dialog over and over, so remember what we got back from the translation engines.
+//A small LRU in memory in front of a BlobStore on disk, so hits survive restarts.
+
+#ifndef TranslationCache_h__
+#define TranslationCache_h__
+
+#include "BlobStore.h"
+
+const int C_TRANSLATION_CACHE_MEMORY_ENTRIES = 2000; //the rest stay on disk, which is mapped anyway
+
+class TranslationCache
+{
+public:
+	TranslationCache();
+	virtual ~TranslationCache();
+
+	bool Init(string fileName, size_t maxDiskBytes, int maxMemoryEntries);
+	void Kill();
+
+	//engine is an eTranslationEngine, the text is normalized so whitespace differences from the OCR don't matter
+	static string MakeKey(int engine, const string &sourceLanguage, const string &destLanguage, const string &text);
+
+	bool Get(const string &key, string *pTranslationOut);
+	void Put(const string &key, const string &translation);
+
+	uint32 GetHits() { return m_hits; }
+	uint32 GetMisses() { return m_misses; }
+	void LogStats();
+
+protected:
+
+	typedef std::list<std::pair<string, string> > LRUList;
+
+	void AddToMemory(const string &key, const string &translation);
+
+	LRUList m_lru; //front is most recently used
+	std::unordered_map<string, LRUList::iterator> m_memoryIndex;
+	int m_maxMemoryEntries = 0;
+	BlobStore m_diskStore;
+
+	uint32 m_hits = 0;
+	uint32 m_diskHits = 0;
+	uint32 m_misses = 0;
+};
+
+#endif // TranslationCache_h__
@@ -10,7 +10,7 @@
 #ifndef UpdateChecker_h__
 #define UpdateChecker_h__
 
-#include "Network/NetHTTP.h"
+#include "CurlRequest.h"
 
 class UpdateChecker
 {
@@ -19,10 +19,12 @@ public:
 	virtual ~UpdateChecker();
 
 	void CheckForUpdate();
-	void Update();
 
 protected:
-	NetHTTP m_netHTTP;
+
+	void OnUpdateCheckFinished(CurlRequest *pRequest);
+
+	CurlRequest m_request;
 
 private:
 };
@@ -0,0 +1,174 @@
+#include "PlatformPrecomp.h"
+#include "WatchModeManager.h"
+#include "App.h"
+#include "GameLogicComponent.h"
+#include "WinDragRect.h"
+#include <chrono>
+
+#ifndef WDA_EXCLUDEFROMCAPTURE
+#define WDA_EXCLUDEFROMCAPTURE 0x00000011 //only in newer SDKs, works on Windows 10 2004 and up
+#endif
+
+//how long after starting a scan before we trust that our overlay is up and take a new baseline, only used if the overlay
+//couldn't be excluded from capture
+const unsigned int C_WATCH_MODE_REBASELINE_DELAY_MS = 1500;
+
+extern HWND g_hWnd;
+void TurnOffRenderDisplay(VariantList* pVList);
+
+WatchModeManager::WatchModeManager()
+{
+	m_captureSource.SetDownsample(C_WATCH_MODE_DOWNSAMPLE);
+}
+
+WatchModeManager::~WatchModeManager()
+{
+}
+
+void WatchModeManager::SetEnabled(bool bEnabled)
+{
+	if (bEnabled == m_bEnabled) return;
+
+	if (!bEnabled)
+	{
+		m_bEnabled = false;
+		m_bScanPending = false;
+		m_captureSource.Kill();
+		SetExcludedFromCapture(false);
+		ShowQuickMessage("Watch mode off");
+		return;
+	}
+
+	if (!GetApp()->IsInputDesktop())
+	{
+		ShowQuickMessage("Watch mode only works when capturing the desktop");
+		return;
+	}
+
+	if (!GetApp()->m_usedSubAreaScan)
+	{
+		ShowQuickMessage("Drag a rect to scan first, watch mode keeps rescanning that area");
+		return;
+	}
+
+	m_detector.Reset(); //so it scans once right away, then only when something changes
+	m_detector.SetStableFramesRequired(GetApp()->m_watch_mode_stable_frames);
+	SetExcludedFromCapture(true);
+	m_bRebaselinePending = false;
+	m_nextSampleTick = 0;
+	m_bEnabled = true;
+	ShowQuickMessage("Watch mode on, will rescan when the text changes");
+}
+
+void WatchModeManager::SetExcludedFromCapture(bool bExclude)
+{
+	//Hides our window from BitBlt (it still shows on screen), so the overlay doesn't count as a change and scans don't OCR it
+	if (bExclude)
+	{
+		m_bExcludedFromCapture = SetWindowDisplayAffinity(g_hWnd, WDA_EXCLUDEFROMCAPTURE) != 0;
+		if (!m_bExcludedFromCapture)
+		{
+			LogMsg("Couldn't exclude our window from capture (needs Windows 10 2004 or newer), watch mode will work around the overlay");
+		}
+	}
+	else
+	{
+		SetWindowDisplayAffinity(g_hWnd, WDA_NONE);
+		m_bExcludedFromCapture = false;
+	}
+}
+
+void WatchModeManager::Update()
+{
+	if (!m_bEnabled) return;
+
+	unsigned int tick = GetSystemTimeTick();
+	if (tick < m_nextSampleTick) return;
+	m_nextSampleTick = tick + (unsigned int)rt_max(GetApp()->m_watch_mode_interval_ms, 10);
+
+	if (GetApp()->GetCaptureMode() == CAPTURE_MODE_DRAGRECT) return; //they're picking a new area
+	if (GetApp()->GetGameLogicComponent()->IsScanning()) return; //let the one we started finish first
+
+	if (m_bScanPending)
+	{
+		//we closed the old overlay last time, now we can go
+		if (GetApp()->GetCaptureMode() == CAPTURE_MODE_WAITING)
+		{
+			m_bScanPending = false;
+			StartScan();
+		}
+		return;
+	}
+
+	Sample();
+}
+
+void WatchModeManager::Sample()
+{
+#ifdef _DEBUG
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#endif
+
+	WinDragRect *pRect = GetApp()->m_pWinDragRect;
+	CaptureFrame frame;
+
+	if (!m_captureSource.Capture(pRect->m_last_window_pos_x, pRect->m_last_window_pos_y, pRect->m_last_capture_width,
+		pRect->m_last_capture_height, &frame))
+	{
+		return;
+	}
+
+	bool bScan = false;
+
+	if (m_bRebaselinePending)
+	{
+		//our overlay is in the samples, so whatever the area looks like with it up is the new normal
+		if (GetSystemTimeTick() >= m_rebaselineTick)
+		{
+			m_detector.SetBaseline(frame);
+			m_bRebaselinePending = false;
+		}
+	}
+	else
+	{
+		bScan = m_detector.AddFrame(frame);
+	}
+
+#ifdef _DEBUG
+	m_debugSampleMS += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if (++m_debugSampleCount == 100)
+	{
+		LogMsg("Watch mode: %.3f ms per sample (%d x %d)", m_debugSampleMS / m_debugSampleCount, frame.m_width, frame.m_height);
+		m_debugSampleCount = 0;
+		m_debugSampleMS = 0;
+	}
+#endif
+
+	if (!bScan) return;
+
+	LogMsg("Watch mode: %d of %d tiles changed and settled, rescanning", m_detector.GetChangedTileCount(), m_detector.GetTileCount());
+
+	if (GetApp()->GetCaptureMode() == CAPTURE_MODE_SHOWING)
+	{
+		//close what's showing now, the scan starts next sample once it's gone
+		TurnOffRenderDisplay(NULL);
+		m_bScanPending = true;
+		return;
+	}
+
+	StartScan();
+}
+
+void WatchModeManager::StartScan()
+{
+	if (GetApp()->GetCaptureMode() != CAPTURE_MODE_WAITING) return;
+
+	GetApp()->SetupLastRectAreaUsed();
+	GetApp()->ScanSubArea();
+
+	if (!m_bExcludedFromCapture)
+	{
+		m_bRebaselinePending = true;
+		m_rebaselineTick = GetSystemTimeTick() + C_WATCH_MODE_REBASELINE_DELAY_MS;
+	}
+}
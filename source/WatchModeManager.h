@@ -0,0 +1,44 @@
+//Watch mode keeps an eye on the last drag rect and rescans it by itself when the text changes, handy for visual novels
+//where you'd otherwise be hitting the hotkey every few seconds.  It grabs a shrunk down copy of the rect every so often
+//and lets FrameChangeDetector decide when it's changed and settled.  Nothing is sent anywhere while the area stays the same.
+
+#ifndef WatchModeManager_h__
+#define WatchModeManager_h__
+
+#include "WinDesktopCapture.h"
+#include "FrameChangeDetector.h"
+
+const int C_WATCH_MODE_DOWNSAMPLE = 4; //a 1080p rect gets sampled at 480x270
+
+class WatchModeManager
+{
+public:
+
+	WatchModeManager();
+	virtual ~WatchModeManager();
+
+	void SetEnabled(bool bEnabled);
+	bool IsEnabled() { return m_bEnabled; }
+	void Toggle() { SetEnabled(!m_bEnabled); }
+	void Update(); //call every frame, it only samples every watch_mode_interval_ms
+
+protected:
+
+	void Sample();
+	void StartScan();
+	void SetExcludedFromCapture(bool bExclude);
+
+	bool m_bEnabled = false;
+	unsigned int m_nextSampleTick = 0;
+	GDICaptureSource m_captureSource; //its own small DIB, separate from the full size one scans use
+	FrameChangeDetector m_detector;
+	bool m_bScanPending = false; //waiting for the last scan's overlay to close before starting the next one
+	bool m_bExcludedFromCapture = false; //if false our own overlay shows up in the samples and we have to work around it
+	bool m_bRebaselinePending = false;
+	unsigned int m_rebaselineTick = 0;
+
+	int m_debugSampleCount = 0;
+	float m_debugSampleMS = 0;
+};
+
+#endif // WatchModeManager_h__
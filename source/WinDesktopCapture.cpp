@@ -1,70 +1,181 @@
 #include "PlatformPrecomp.h"
 #include "WinDesktopCapture.h"
+#include "PixelConvert.h"
 
-WinDesktopCapture::WinDesktopCapture()
+GDICaptureSource::GDICaptureSource()
 {
 }
 
-WinDesktopCapture::~WinDesktopCapture()
+GDICaptureSource::~GDICaptureSource()
 {
+	Kill();
 }
 
-
-bool WinDesktopCapture::Capture(int x, int y, int width, int height)
+bool GDICaptureSource::InitDIBSection(HDC hdcScreen, int width, int height)
 {
-	LogMsg("Doing capture at %d:%d of size %d, %d", x, y, width, height);
+	Kill();
 
+	m_hMemDC = CreateCompatibleDC(hdcScreen); // create a device context to use yourself
+	if (!m_hMemDC)
+	{
+		LogError("CreateCompatibleDC failed!");
+		return false;
+	}
 
-	HDC hdc = GetDC(NULL); // get the desktop device context
-	if (!hdc) LogError("GetDC failed");
+	//32 bit so there is no weird stride to deal with, and a positive height so it's bottom up like GetDIBits used to give us
+	BITMAPINFO bmi;
+	ZeroMemory(&bmi, sizeof(bmi));
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = width;
+	bmi.bmiHeader.biHeight = height;
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+
+	m_hDIB = CreateDIBSection(hdcScreen, &bmi, DIB_RGB_COLORS, (void**)&m_pDIBPixels, NULL, 0);
+	if (!m_hDIB || !m_pDIBPixels)
+	{
+		LogError("CreateDIBSection failed!");
+		Kill();
+		return false;
+	}
 
-	HDC hDest = CreateCompatibleDC(hdc); // create a device context to use yourself
-	if (!hDest) LogError("CreateCompatibleDC failed!");
+	// use the device context with the bitmap
+	m_hOldBitmap = SelectObject(m_hMemDC, m_hDIB);
+	if (!m_hOldBitmap)
+	{
+		LogError("Error with SelectObject");
+		Kill();
+		return false;
+	}
 
+	m_width = width;
+	m_height = height;
+	return true;
+}
 
-	HBITMAP hbDesktop = CreateCompatibleBitmap(hdc, width, height);
-	if (!hbDesktop) LogError("CreateCompatibleBitmap failed!");
+bool GDICaptureSource::Capture(int x, int y, int width, int height, CaptureFrame *pFrameOut)
+{
+	HDC hdc = GetDC(NULL); // get the desktop device context
+	if (!hdc)
+	{
+		LogError("GetDC failed");
+		return false;
+	}
 
-	// use the previously created device context with the bitmap
-	HGDIOBJ temp = SelectObject(hDest, hbDesktop);
+	int destWidth = rt_max(1, width / m_downsample);
+	int destHeight = rt_max(1, height / m_downsample);
 
-	if (!temp)
+	if (!m_hDIB || destWidth != m_width || destHeight != m_height)
 	{
-		LogError("Error with SelectObject");
+		LogMsg("Creating capture DIB section of %d, %d", destWidth, destHeight);
+		if (!InitDIBSection(hdc, destWidth, destHeight))
+		{
+			ReleaseDC(NULL, hdc);
+			return false;
+		}
 	}
+
 	// copy from the desktop device context to the bitmap device context
-	// call this once per 'frame'
-	if (!BitBlt(hDest, 0, 0, width, height, hdc, x, y, SRCCOPY))
+	bool bOk;
+	if (m_downsample > 1)
+	{
+		//COLORONCOLOR just drops pixels, no filtering, which is the fast way and all we need for spotting changes
+		SetStretchBltMode(m_hMemDC, COLORONCOLOR);
+		bOk = StretchBlt(m_hMemDC, 0, 0, destWidth, destHeight, hdc, x, y, width, height, SRCCOPY) != 0;
+	}
+	else
+	{
+		bOk = BitBlt(m_hMemDC, 0, 0, width, height, hdc, x, y, SRCCOPY) != 0;
+	}
+
+	if (!bOk)
 	{
 		LogError("Failed to blit");
 	}
 
+	// release the desktop context you got..
+	ReleaseDC(NULL, hdc);
 
-	//copy it to our own soft surface.  We're using RGBA otherwise GetDIBits will use a weird stride that is.. bad.  Very bad.
-	m_captureSoftSurfaceRGBA.Init(width, height, SoftSurface::SURFACE_RGBA);
-	
-	BMPImageHeader header = m_captureSoftSurfaceRGBA.BuildBitmapHeader();
-	GetDIBits(hdc, hbDesktop, 0, height, m_captureSoftSurfaceRGBA.GetPixelData(), (LPBITMAPINFO) &header, DIB_RGB_COLORS);
-	
-	//m_captureSoftSurfaceRGBA.FillColor(glColorBytes(255, 0, 0, 255));
+	if (!bOk) return false;
 
-	m_captureSoftSurface.Init(width, height, SoftSurface::SURFACE_RGB);
+	GdiFlush(); //GDI can batch things up, make sure the blit is really done before we read the bits ourselves
 
-	m_captureSoftSurface.Blit(0, 0, &m_captureSoftSurfaceRGBA);
-	m_captureSoftSurface.FlipRedAndBlue();
-	m_captureSurface.InitFromSoftSurface(&m_captureSoftSurface);
-	m_captureSurface.FillColor(glColorBytes(0, 0, 0, 255));
+	pFrameOut->m_pPixels = m_pDIBPixels;
+	pFrameOut->m_width = destWidth;
+	pFrameOut->m_height = destHeight;
+	pFrameOut->m_pitch = destWidth * 4;
+	pFrameOut->m_format = PIXEL_FORMAT_BGRA;
+	pFrameOut->m_bBottomUp = true;
+	return true;
+}
 
-	//	m_captureSurface.HardKill();
-	//m_captureSoftSurface.FillColor(glColorBytes(255, 0, 0, 255));
-	// ..delete the bitmap you were using to capture frames..
-	DeleteObject(hbDesktop);
+void GDICaptureSource::Kill()
+{
+	if (m_hMemDC && m_hOldBitmap)
+	{
+		SelectObject(m_hMemDC, m_hOldBitmap);
+	}
+	m_hOldBitmap = NULL;
 
-	// after the recording is done, release the desktop context you got..
-	ReleaseDC(NULL, hdc);
+	if (m_hDIB)
+	{
+		DeleteObject(m_hDIB); //also frees m_pDIBPixels
+		m_hDIB = NULL;
+	}
+	m_pDIBPixels = NULL;
+
+	if (m_hMemDC)
+	{
+		DeleteDC(m_hMemDC);
+		m_hMemDC = NULL;
+	}
+
+	m_width = m_height = 0;
+}
+
+WinDesktopCapture::WinDesktopCapture()
+{
+}
+
+WinDesktopCapture::~WinDesktopCapture()
+{
+	SAFE_DELETE(m_pCaptureSource);
+}
+
+void WinDesktopCapture::SetCaptureSource(CaptureSource *pSource)
+{
+	SAFE_DELETE(m_pCaptureSource);
+	m_pCaptureSource = pSource;
+}
 
-	// ..and delete the context you created
-	DeleteDC(hDest);
+void WinDesktopCapture::Kill()
+{
+	if (m_pCaptureSource) m_pCaptureSource->Kill();
+	m_captureSoftSurface.Kill();
+}
+
+bool WinDesktopCapture::Capture(int x, int y, int width, int height)
+{
+	LogMsg("Doing capture at %d:%d of size %d, %d", x, y, width, height);
+
+	if (!m_pCaptureSource)
+	{
+		m_pCaptureSource = new GDICaptureSource;
+	}
+
+	CaptureFrame frame;
+	if (!m_pCaptureSource->Capture(x, y, width, height, &frame))
+	{
+		return false;
+	}
+
+	//BGRA -> RGB in one go, used to be a Blit and then a FlipRedAndBlue.  We keep it bottom up, which is what GL wants anyway
+	ConvertPixelsToSurface(frame.m_pPixels, frame.m_pitch, frame.m_format, frame.m_width, frame.m_height, !frame.m_bBottomUp,
+		&m_captureSoftSurface, SoftSurface::SURFACE_RGB);
+
+	m_captureSurface.InitFromSoftSurface(&m_captureSoftSurface);
+	m_captureSurface.FillColor(glColorBytes(0, 0, 0, 255));
 
 	return true;
 }
\ No newline at end of file
@@ -13,6 +13,35 @@
 
 #include "Renderer/SoftSurface.h"
 #include "Renderer/Surface.h"
+#include "CaptureSource.h"
+
+//Grabs the desktop with BitBlt into a DIB section that we keep around, so rescanning the same rect doesn't create and
+//destroy a DC and bitmap and then GetDIBits a copy out each time.  We read the DIB's pixels directly.
+class GDICaptureSource : public CaptureSource
+{
+public:
+
+	GDICaptureSource();
+	virtual ~GDICaptureSource();
+
+	virtual bool Capture(int x, int y, int width, int height, CaptureFrame *pFrameOut);
+	virtual void Kill();
+
+	//Lets GDI shrink it as it copies (1/factor in each direction), the frame you get back is the smaller size
+	void SetDownsample(int factor) { m_downsample = rt_max(1, factor); }
+
+protected:
+
+	bool InitDIBSection(HDC hdcScreen, int width, int height);
+
+	HDC m_hMemDC = NULL;
+	HBITMAP m_hDIB = NULL;
+	HGDIOBJ m_hOldBitmap = NULL;
+	byte *m_pDIBPixels = NULL;
+	int m_width = 0;
+	int m_height = 0;
+	int m_downsample = 1;
+};
 
 class WinDesktopCapture
 {
@@ -20,14 +49,16 @@ public:
 	WinDesktopCapture();
 	virtual ~WinDesktopCapture();
 	bool Capture(int x, int y, int width, int height);
+	void SetCaptureSource(CaptureSource *pSource); //we take ownership, NULL goes back to grabbing the desktop
+	void Kill(); //frees the cached capture buffers, they'll be recreated on the next Capture()
 
-	SoftSurface * GetSoftSurface() { return &m_captureSoftSurface; }
+	SoftSurface * GetSoftSurface() { return &m_captureSoftSurface; } //RGB, bottom row first
 	Surface * GetSurface() { return &m_captureSurface; }
 
 protected:
 
-	SoftSurface m_captureSoftSurface;
-	SoftSurface m_captureSoftSurfaceRGBA;
+	CaptureSource *m_pCaptureSource = NULL;
+	SoftSurface m_captureSoftSurface; //reused as long as the capture size stays the same
 	Surface m_captureSurface;
 
 private:
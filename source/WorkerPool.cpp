@@ -0,0 +1,168 @@
+#include "PlatformPrecomp.h"
+#include "WorkerPool.h"
+#include <cstdarg>
+
+static std::atomic<WorkerPool*> g_pLogPool(NULL);
+static std::thread::id g_mainThreadID = std::this_thread::get_id(); //replaced by Init(), which is called from the main thread
+
+void LogMsgFromAnyThread(const char *pFormat, ...)
+{
+	char buffer[2048];
+	va_list args;
+	va_start(args, pFormat);
+	vsnprintf(buffer, sizeof(buffer), pFormat, args);
+	va_end(args);
+	buffer[sizeof(buffer) - 1] = 0;
+
+	WorkerPool *pPool = g_pLogPool;
+	if (!pPool || std::this_thread::get_id() == g_mainThreadID)
+	{
+		LogMsg("%s", buffer);
+		return;
+	}
+
+	string msg = buffer;
+	pPool->PostToMainThread([msg]() { LogMsg("%s", msg.c_str()); });
+}
+
+WorkerPool::WorkerPool()
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+	Kill();
+}
+
+bool WorkerPool::Init(int threadCount)
+{
+	Kill();
+
+	if (threadCount <= 0)
+	{
+		//leave a core for the main thread, and a scan doesn't have enough stages at once to use more than a few
+		threadCount = (int)std::thread::hardware_concurrency() - 1;
+		threadCount = rt_max(1, rt_min(threadCount, 4));
+	}
+
+	g_mainThreadID = std::this_thread::get_id();
+	g_pLogPool = this;
+
+	m_bQuit = false;
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_threads.push_back(std::thread(&WorkerPool::WorkerThreadProc, this));
+	}
+
+	LogMsg("WorkerPool started %d threads", threadCount);
+	return true;
+}
+
+void WorkerPool::Kill()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_bQuit = true;
+		m_jobs.clear();
+	}
+	m_jobCondition.notify_all();
+
+	for (int i = 0; i < (int)m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+
+	WorkerPool *pThis = this;
+	g_pLogPool.compare_exchange_strong(pThis, NULL); //anything logged after this just logs right there
+
+	std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+	m_mainThreadJobs.clear();
+}
+
+void WorkerPool::AddJob(WorkerJob job)
+{
+	if (m_threads.empty())
+	{
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_jobs.push_back(job);
+	}
+	m_jobCondition.notify_one();
+}
+
+void WorkerPool::AddJobMustFinish(WorkerJob job)
+{
+	if (m_threads.empty())
+	{
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_mustFinishJobs.push_back(job);
+	}
+	m_jobCondition.notify_one();
+}
+
+void WorkerPool::PostToMainThread(WorkerJob job)
+{
+	std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+	m_mainThreadJobs.push_back(job);
+}
+
+void WorkerPool::Update()
+{
+	vector<WorkerJob> jobs;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+		jobs.swap(m_mainThreadJobs);
+	}
+
+	//run without the lock held, these often kick off the next stage which posts more
+	for (int i = 0; i < (int)jobs.size(); i++)
+	{
+		jobs[i]();
+	}
+}
+
+int WorkerPool::GetQueuedJobCount()
+{
+	std::lock_guard<std::mutex> lock(m_jobMutex);
+	return (int)(m_jobs.size() + m_mustFinishJobs.size());
+}
+
+void WorkerPool::WorkerThreadProc()
+{
+	while (true)
+	{
+		WorkerJob job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_jobMutex);
+			m_jobCondition.wait(lock, [this]() { return m_bQuit || !m_jobs.empty() || !m_mustFinishJobs.empty(); });
+
+			//when quitting, keep going until these are all done
+			if (!m_mustFinishJobs.empty())
+			{
+				job = m_mustFinishJobs.front();
+				m_mustFinishJobs.pop_front();
+			}
+			else
+			{
+				if (m_bQuit) return;
+
+				job = m_jobs.front();
+				m_jobs.pop_front();
+			}
+		}
+
+		job();
+	}
+}
@@ -0,0 +1,67 @@
+//A few worker threads for the CPU heavy parts of a scan (jpg encoding, parsing, rasterizing text) so the main thread
+//doesn't stall.  Jobs must not touch GL or entities, when they're done they post a callback that runs on the main thread
+//during Update() to do that part.
+
+#ifndef WorkerPool_h__
+#define WorkerPool_h__
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+
+typedef std::function<void()> WorkerJob;
+
+//LogMsg isn't thread safe, anything that can run in a job logs with this instead.  From the main thread it just logs,
+//from anywhere else it's posted to the pool that was last Init()'d and shows up during its next Update()
+void LogMsgFromAnyThread(const char *pFormat, ...);
+
+//Copies share the same flag, so hand a copy to the job and keep one to cancel it with.  Jobs check it between steps,
+//nothing gets interrupted midway
+class CancelToken
+{
+public:
+	CancelToken() : m_pCanceled(std::make_shared<std::atomic<bool> >(false)) {}
+
+	void Cancel() { *m_pCanceled = true; }
+	bool IsCanceled() const { return *m_pCanceled; }
+
+protected:
+	std::shared_ptr<std::atomic<bool> > m_pCanceled;
+};
+
+class WorkerPool
+{
+public:
+	WorkerPool();
+	virtual ~WorkerPool();
+
+	bool Init(int threadCount); //0 means pick something based on how many cores there are
+	void Kill(); //waits on jobs that are running and AddJobMustFinish() ones, other queued jobs and any main thread callbacks are dropped
+
+	void AddJob(WorkerJob job); //runs on a worker thread, or right away if Init() wasn't called
+	void AddJobMustFinish(WorkerJob job); //same, but Kill() waits for it even if it hasn't started.  For saving files, not touching the app
+	void PostToMainThread(WorkerJob job); //safe to call from any thread, runs during the next Update()
+	void Update(); //call from the main thread
+
+	int GetThreadCount() { return (int)m_threads.size(); }
+	int GetQueuedJobCount();
+
+protected:
+
+	void WorkerThreadProc();
+
+	vector<std::thread> m_threads;
+	std::deque<WorkerJob> m_jobs;
+	std::deque<WorkerJob> m_mustFinishJobs;
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobCondition;
+	bool m_bQuit = false;
+
+	vector<WorkerJob> m_mainThreadJobs;
+	std::mutex m_mainThreadMutex;
+};
+
+#endif // WorkerPool_h__